@@ -0,0 +1,49 @@
+#ifndef ACCESS_ADVICE_H
+#define ACCESS_ADVICE_H
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+/**
+ * 访问模式提示 - 告知内核即将如何访问文件数据
+ */
+enum class AccessAdvice {
+    Normal,      // 默认预读策略
+    Sequential,  // 顺序访问，加大预读
+    Random,      // 随机访问，关闭预读
+    WillNeed,    // 即将访问，提前读入
+    DontNeed     // 不再访问，可以释放页缓存
+};
+
+/**
+ * 通过posix_fadvise向内核提示对已打开文件的访问方式
+ * Sequential/Random只影响该文件描述符上的预读，WillNeed/DontNeed作用于整个文件的页缓存。
+ * 提示只是建议，失败时忽略；不支持posix_fadvise的平台上不做任何事
+ * @param fd 文件描述符
+ * @param advice 访问模式
+ * @param offset 起始偏移
+ * @param length 长度，0表示到文件末尾
+ */
+inline void adviseDescriptor(int fd, AccessAdvice advice, uint64_t offset = 0, uint64_t length = 0) {
+#if !defined(_WIN32) && defined(POSIX_FADV_NORMAL)
+    int flag = POSIX_FADV_NORMAL;
+    switch (advice) {
+        case AccessAdvice::Normal: flag = POSIX_FADV_NORMAL; break;
+        case AccessAdvice::Sequential: flag = POSIX_FADV_SEQUENTIAL; break;
+        case AccessAdvice::Random: flag = POSIX_FADV_RANDOM; break;
+        case AccessAdvice::WillNeed: flag = POSIX_FADV_WILLNEED; break;
+        case AccessAdvice::DontNeed: flag = POSIX_FADV_DONTNEED; break;
+    }
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), flag);
+#else
+    (void)fd;
+    (void)advice;
+    (void)offset;
+    (void)length;
+#endif
+}
+
+#endif // ACCESS_ADVICE_H
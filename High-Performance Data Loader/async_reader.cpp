@@ -0,0 +1,1075 @@
+#include "async_reader.h"
+#include "direct_io.h"
+#include "buffer_pool.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// io_uring的OPENAT/READ操作需要5.6及以上的内核头文件
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_FEAT_CUR_PERSONALITY)
+#define HPDL_HAVE_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace {
+
+std::runtime_error readError(const std::string& path, int error) {
+    return std::runtime_error("Failed to read file: " + path + " - " + strerror(error));
+}
+
+// 直接I/O模式下每个对齐缓冲区的大小
+constexpr size_t kDirectBufferSize = 256 * 1024;
+
+} // namespace
+
+// PreadFileReader实现
+
+struct PreadFileReader::Impl {
+    Impl(size_t num_threads, bool direct_io) : pool(num_threads) {
+        if (direct_io) {
+            // 每个线程同一时刻只占用一个对齐缓冲区
+            direct_pool = std::make_unique<DirectIOBufferPool>(kDirectBufferSize, pool.size());
+        }
+    }
+
+    std::unique_ptr<DirectIOBufferPool> direct_pool;
+    ThreadPool pool;
+};
+
+PreadFileReader::PreadFileReader(size_t num_threads, bool direct_io)
+    : impl_(std::make_unique<Impl>(num_threads, direct_io)) {}
+
+PreadFileReader::~PreadFileReader() = default;
+
+std::vector<std::future<std::vector<unsigned char>>> PreadFileReader::submitBatch(
+    const std::vector<ReadRequest>& requests) {
+    std::vector<std::future<std::vector<unsigned char>>> results;
+    results.reserve(requests.size());
+    DirectIOBufferPool* direct_pool = impl_->direct_pool.get();
+    for (const auto& request : requests) {
+        results.push_back(impl_->pool.enqueue([request, direct_pool]() {
+            return PreadFileReader::read(request, direct_pool);
+        }));
+    }
+    return results;
+}
+
+std::vector<std::future<PooledBuffer>> PreadFileReader::submitBatchPooled(const std::vector<ReadRequest>& requests) {
+    std::vector<std::future<PooledBuffer>> results;
+    results.reserve(requests.size());
+    DirectIOBufferPool* direct_pool = impl_->direct_pool.get();
+    for (const auto& request : requests) {
+        results.push_back(impl_->pool.enqueue([request, direct_pool]() {
+            return PreadFileReader::readPooled(request, direct_pool);
+        }));
+    }
+    return results;
+}
+
+std::future<size_t> PreadFileReader::submitInto(const ReadRequest& request, unsigned char* buffer) {
+    if (request.length == ReadRequest::kToEnd) {
+        throw std::runtime_error("readInto requires an explicit length: " + request.path);
+    }
+    DirectIOBufferPool* direct_pool = impl_->direct_pool.get();
+    return impl_->pool.enqueue([request, buffer, direct_pool]() {
+        return PreadFileReader::readInto(request, buffer, direct_pool);
+    });
+}
+
+#ifndef _WIN32
+namespace {
+
+// 打开待读取的文件，direct_pool非空时尝试以O_DIRECT方式打开
+int openForRead(const std::string& path, DirectIOBufferPool* direct_pool, bool& direct) {
+    direct = false;
+    if (direct_pool) {
+        return DirectIO::open(path, direct);
+    }
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path + " - " + strerror(errno));
+    }
+    return fd;
+}
+
+// 读取前按请求设置文件描述符上的预读策略
+void adviseBeforeRead(int fd, const ReadRequest& request) {
+    if (request.advice == AccessAdvice::Sequential || request.advice == AccessAdvice::Random) {
+        adviseDescriptor(fd, request.advice, request.offset,
+                         request.length == ReadRequest::kToEnd ? 0 : request.length);
+    }
+}
+
+// 流式读取：读取完成后把读过的范围从页缓存中逐出
+void dropAfterRead(int fd, const ReadRequest& request, size_t done) {
+    if (request.drop_behind && done > 0) {
+        adviseDescriptor(fd, AccessAdvice::DontNeed, request.offset, done);
+    }
+}
+
+// 从已打开的文件读取区间到dst，返回实际读取的字节数；出错时抛出异常，不关闭fd
+size_t readOpened(int fd, bool direct, const ReadRequest& request, unsigned char* dst, size_t size,
+                  DirectIOBufferPool* direct_pool) {
+    if (direct) {
+        return DirectIO::readAt(fd, request.offset, dst, size, *direct_pool);
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, dst + done, size - done, static_cast<off_t>(request.offset + done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw readError(request.path, errno);
+        }
+        if (n == 0) {
+            // 文件比预期短（到达文件末尾）
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return done;
+}
+
+} // namespace
+#endif
+
+namespace {
+
+// 读取文件（或区间）到Buffer中，Buffer为std::vector<unsigned char>或PooledBuffer
+template<class Buffer>
+Buffer readToBuffer(const ReadRequest& request, DirectIOBufferPool* direct_pool) {
+#ifdef _WIN32
+    (void)direct_pool;
+    FILE* file = fopen(request.path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + request.path);
+    }
+
+    _fseeki64(file, 0, SEEK_END);
+    uint64_t file_size = static_cast<uint64_t>(_ftelli64(file));
+    uint64_t available = file_size > request.offset ? file_size - request.offset : 0;
+    size_t size = static_cast<size_t>(std::min<uint64_t>(available, request.length));
+
+    Buffer buffer;
+    buffer.resize(size);
+    _fseeki64(file, static_cast<__int64>(request.offset), SEEK_SET);
+    size_t bytes_read = fread(buffer.data(), 1, size, file);
+    fclose(file);
+    buffer.resize(bytes_read);
+    return buffer;
+#else
+    bool direct = false;
+    int fd = openForRead(request.path, direct_pool, direct);
+    adviseBeforeRead(fd, request);
+
+    Buffer buffer;
+    try {
+        // 无论是否指定了长度，都按文件实际大小分配，避免为超出末尾的请求分配过多内存
+        struct stat stat_buf;
+        if (fstat(fd, &stat_buf) < 0) {
+            throw readError(request.path, errno);
+        }
+        uint64_t file_size = static_cast<uint64_t>(stat_buf.st_size);
+        uint64_t available = file_size > request.offset ? file_size - request.offset : 0;
+        size_t size = static_cast<size_t>(std::min<uint64_t>(available, request.length));
+
+        buffer.resize(size);
+        buffer.resize(readOpened(fd, direct, request, buffer.data(), size, direct_pool));
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    dropAfterRead(fd, request, buffer.size());
+    close(fd);
+    return buffer;
+#endif
+}
+
+} // namespace
+
+std::vector<unsigned char> PreadFileReader::read(const ReadRequest& request, DirectIOBufferPool* direct_pool) {
+    return readToBuffer<std::vector<unsigned char>>(request, direct_pool);
+}
+
+PooledBuffer PreadFileReader::readPooled(const ReadRequest& request, DirectIOBufferPool* direct_pool) {
+    return readToBuffer<PooledBuffer>(request, direct_pool);
+}
+
+size_t PreadFileReader::readInto(const ReadRequest& request, unsigned char* buffer, DirectIOBufferPool* direct_pool) {
+    if (request.length == ReadRequest::kToEnd) {
+        throw std::runtime_error("readInto requires an explicit length: " + request.path);
+    }
+#ifdef _WIN32
+    (void)direct_pool;
+    FILE* file = fopen(request.path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + request.path);
+    }
+    _fseeki64(file, static_cast<__int64>(request.offset), SEEK_SET);
+    size_t bytes_read = fread(buffer, 1, request.length, file);
+    fclose(file);
+    return bytes_read;
+#else
+    bool direct = false;
+    int fd = openForRead(request.path, direct_pool, direct);
+    adviseBeforeRead(fd, request);
+    size_t done = 0;
+    try {
+        done = readOpened(fd, direct, request, buffer, request.length, direct_pool);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    dropAfterRead(fd, request, done);
+    close(fd);
+    return done;
+#endif
+}
+
+// IoUringFileReader实现
+
+#ifdef HPDL_HAVE_IO_URING
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// 完成线程退出信号的user_data
+constexpr uint64_t kShutdownTag = 0;
+
+// 单次READ操作的最大长度（sqe中的len是32位）
+constexpr size_t kMaxReadChunk = size_t(1) << 30;
+
+} // namespace
+
+/**
+ * 单个读取请求的状态：先OPENAT，再一次或多次READ，完成后关闭文件并兑现promise
+ * 派生类决定数据读到哪里以及通过什么类型的promise交付
+ */
+struct IoUringFileReader::Operation {
+    virtual ~Operation() = default;
+
+    /**
+     * 按文件实际可读的字节数准备目标区域
+     * @return 目标区域的起始地址，至少size字节
+     */
+    virtual unsigned char* allocate(size_t size) = 0;
+
+    /**
+     * 以读取的前done个字节兑现promise
+     */
+    virtual void fulfil(size_t done) = 0;
+
+    /**
+     * 以异常兑现promise
+     */
+    virtual void fail(std::exception_ptr error) = 0;
+
+    /**
+     * 是否读入调用方的缓冲区；这类请求在内核交还缓冲区之前不能以异常结束
+     */
+    virtual bool borrowsDestination() const { return false; }
+
+    ReadRequest request;
+    unsigned char* data = nullptr;
+    size_t size = 0;
+    int fd = -1;
+    size_t done = 0;
+    bool opening = true;
+
+    // 已由abandon()放弃，由Ring::mutex保护；之后的完成事件只回收资源，不再提交READ
+    bool abandoned = false;
+
+    // 读入调用方缓冲区的请求被放弃时的异常，等到其完成事件被处理后再交付
+    std::exception_ptr deferred_error;
+
+    // 直接I/O状态：是否以O_DIRECT打开、占用的对齐缓冲区及本次读取的对齐信息
+    bool direct = false;
+    DirectIOBufferPool::Lease lease;
+    size_t skew = 0;
+    size_t span = 0;
+};
+
+/**
+ * 读入自有缓冲区的请求，Buffer为std::vector<unsigned char>或PooledBuffer
+ */
+template<class Buffer>
+struct IoUringFileReader::BufferOperation : IoUringFileReader::Operation {
+    unsigned char* allocate(size_t bytes) override {
+        buffer.resize(bytes);
+        return buffer.data();
+    }
+
+    void fulfil(size_t bytes) override {
+        buffer.resize(bytes);
+        promise.set_value(std::move(buffer));
+    }
+
+    void fail(std::exception_ptr error) override {
+        promise.set_exception(error);
+    }
+
+    Buffer buffer;
+    std::promise<Buffer> promise;
+};
+
+/**
+ * 读入调用方缓冲区的请求
+ */
+struct IoUringFileReader::IntoOperation : IoUringFileReader::Operation {
+    unsigned char* allocate(size_t) override {
+        return destination;
+    }
+
+    void fulfil(size_t bytes) override {
+        promise.set_value(bytes);
+    }
+
+    void fail(std::exception_ptr error) override {
+        promise.set_exception(error);
+    }
+
+    bool borrowsDestination() const override {
+        return true;
+    }
+
+    unsigned char* destination = nullptr;
+    std::promise<size_t> promise;
+};
+
+/**
+ * io_uring环 - 提交队列、完成队列的映射以及在途请求计数
+ */
+struct IoUringFileReader::Ring {
+    int fd = -1;
+
+    void* sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void* cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_entries = 0;
+
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    // 保护提交队列的填充与提交
+    std::mutex sq_mutex;
+
+    // 在途请求数量，限制为depth，保证提交队列和完成队列都不会溢出
+    std::mutex mutex;
+    std::condition_variable capacity;
+    size_t in_flight = 0;
+    size_t depth = 0;
+
+    // 完成线程
+    std::thread reaper;
+
+    // 直接I/O缓冲池，每个在途请求一个缓冲区；registered表示已注册到io_uring
+    bool direct_io = false;
+    std::unique_ptr<DirectIOBufferPool> direct_pool;
+    bool registered = false;
+
+    // 在途请求，由mutex保护
+    std::unordered_set<Operation*> operations;
+
+    // io_uring_enter出现致命错误后broken为true，之后的请求改由fallback读取，均由mutex保护。
+    // 出错时内核可能仍持有在途请求的缓冲区，这些请求转入abandoned，处理完其完成事件后才释放
+    bool broken = false;
+    std::unique_ptr<PreadFileReader> fallback;
+    std::unordered_set<Operation*> abandoned;
+
+    Ring(unsigned entries, bool direct) : direct_io(direct) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = ioUringSetup(entries, &params);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + strerror(errno));
+        }
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            teardown();
+            throw std::runtime_error("Failed to map io_uring submission queue");
+        }
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                teardown();
+                throw std::runtime_error("Failed to map io_uring completion queue");
+            }
+        }
+
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            teardown();
+            throw std::runtime_error("Failed to map io_uring submission entries");
+        }
+
+        char* sq = static_cast<char*>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+
+        char* cq = static_cast<char*>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        depth = sq_entries;
+
+        if (direct_io) {
+            direct_pool = std::make_unique<DirectIOBufferPool>(kDirectBufferSize, depth);
+
+            // 注册缓冲区可以省去每次读取时的页固定开销；受RLIMIT_MEMLOCK限制时退回普通READ
+            std::vector<iovec> iovecs(depth);
+            for (size_t i = 0; i < depth; ++i) {
+                iovecs[i].iov_base = direct_pool->buffer(i);
+                iovecs[i].iov_len = direct_pool->bufferSize();
+            }
+            registered = ioUringRegister(fd, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                         static_cast<unsigned>(iovecs.size())) >= 0;
+        }
+    }
+
+    ~Ring() {
+        // 完成线程无法继续收割时才会剩下被放弃的请求；关闭环之后内核不再持有它们的缓冲区
+        teardown();
+        for (Operation* op : abandoned) {
+            if (op->fd >= 0) {
+                close(op->fd);
+            }
+            if (op->deferred_error) {
+                op->fail(op->deferred_error);
+            }
+            delete op;
+        }
+    }
+
+    void teardown() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+            sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_size);
+        }
+        cq_ptr = MAP_FAILED;
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_size);
+            sq_ptr = MAP_FAILED;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    /**
+     * 获取一个空闲的提交队列项（调用方需持有sq_mutex）
+     * 在途请求数量不超过队列长度，且每次填充后立即提交，因此总有空闲项
+     */
+    io_uring_sqe* nextSqe(unsigned& tail) {
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        ++tail;
+        return sqe;
+    }
+
+    /**
+     * 发布并提交已填充的提交队列项（调用方需持有sq_mutex）
+     * 出现致命错误时撤回内核尚未取走的项，它们不会产生完成事件
+     * @param withdrawn 输出参数，被撤回的请求
+     * @throws std::runtime_error io_uring_enter失败时抛出
+     */
+    void submit(unsigned tail, unsigned count, std::vector<Operation*>& withdrawn) {
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+        while (count > 0) {
+            int ret = ioUringEnter(fd, count, 0, 0);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                int error = errno;
+                // 未设置SQPOLL时内核只在io_uring_enter中读取sq_tail，回退sq_tail即可撤回这些项
+                unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+                for (unsigned i = head; i != tail; ++i) {
+                    uint64_t user_data = sqes[i & *sq_mask].user_data;
+                    if (user_data != kShutdownTag) {
+                        withdrawn.push_back(reinterpret_cast<Operation*>(user_data));
+                    }
+                }
+                __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + strerror(error));
+            }
+            count -= static_cast<unsigned>(ret);
+        }
+    }
+
+    void prepareOpen(io_uring_sqe* sqe, Operation* op) {
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(op->request.path.c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC | (op->direct ? O_DIRECT : 0);
+        sqe->user_data = reinterpret_cast<uint64_t>(op);
+    }
+
+    /**
+     * 为请求准备下一个操作：打开阶段重新提交OPENAT，否则提交READ
+     */
+    void prepare(io_uring_sqe* sqe, Operation* op) {
+        if (op->opening) {
+            prepareOpen(sqe, op);
+        } else {
+            prepareRead(sqe, op);
+        }
+    }
+
+    void prepareRead(io_uring_sqe* sqe, Operation* op) {
+        if (op->lease) {
+            // 直接I/O：按块对齐读入缓冲区，完成后再截取需要的部分
+            uint64_t position = op->request.offset + op->done;
+            size_t aligned_position = DirectIOBufferPool::alignDown(position);
+            op->skew = static_cast<size_t>(position - aligned_position);
+            op->span = std::min(op->lease.size(),
+                                DirectIOBufferPool::alignUp(op->skew + (op->size - op->done)));
+
+            sqe->opcode = registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            sqe->fd = op->fd;
+            sqe->addr = reinterpret_cast<uint64_t>(op->lease.data());
+            sqe->len = static_cast<uint32_t>(op->span);
+            sqe->off = aligned_position;
+            sqe->buf_index = static_cast<uint16_t>(op->lease.index());
+            sqe->user_data = reinterpret_cast<uint64_t>(op);
+            return;
+        }
+
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = op->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(op->data + op->done);
+        sqe->len = static_cast<uint32_t>(std::min(op->size - op->done, kMaxReadChunk));
+        sqe->off = op->request.offset + op->done;
+        sqe->user_data = reinterpret_cast<uint64_t>(op);
+    }
+
+    /**
+     * 结束一个请求并释放在途名额
+     */
+    void finish(Operation* op, std::exception_ptr error) {
+        if (op->fd >= 0) {
+            if (!error) {
+                dropAfterRead(op->fd, op->request, op->done);
+            }
+            close(op->fd);
+            op->fd = -1;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (operations.erase(op) == 0) {
+                // 已被abandon()放弃，本次完成事件之后内核不再持有它
+                lock.unlock();
+                retire(op);
+                return;
+            }
+            --in_flight;
+        }
+        if (error) {
+            op->fail(error);
+        } else {
+            op->fulfil(op->done);
+        }
+        delete op;
+        capacity.notify_all();
+    }
+
+    /**
+     * 环出现致命错误：放弃所有在途请求，之后的请求改由pread读取（调用方需持有sq_mutex）
+     * 持有sq_mutex保证完成线程不会在放弃之后再为这些请求提交READ。
+     * 读入自有缓冲区的请求立即以error结束，缓冲区随对象留在abandoned中；读入调用方缓冲区的请求
+     * 等到其完成事件被处理（retire()）后再以error结束，调用方在此之前不会释放缓冲区。
+     * 被撤回的请求不在内核中，立即结束并释放
+     * @param withdrawn submit()撤回的请求
+     */
+    void abandon(const std::exception_ptr& error, const std::vector<Operation*>& withdrawn) {
+        std::vector<Operation*> unsubmitted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!broken) {
+                broken = true;
+                fallback = std::make_unique<PreadFileReader>(std::clamp<size_t>(depth, 1, 16), direct_io);
+            }
+            in_flight -= operations.size();
+            for (Operation* op : operations) {
+                op->abandoned = true;
+                if (std::find(withdrawn.begin(), withdrawn.end(), op) != withdrawn.end()) {
+                    unsubmitted.push_back(op);
+                } else if (op->borrowsDestination()) {
+                    op->deferred_error = error;
+                    abandoned.insert(op);
+                } else {
+                    // 在锁内结束：完成线程可能随时处理其完成事件并释放对象
+                    op->fail(error);
+                    abandoned.insert(op);
+                }
+            }
+            operations.clear();
+        }
+        for (Operation* op : unsubmitted) {
+            if (op->fd >= 0) {
+                close(op->fd);
+            }
+            op->fail(error);
+            delete op;
+        }
+        capacity.notify_all();
+    }
+
+    /**
+     * 释放一个被放弃的请求，调用时内核已不再持有它（只由完成线程调用）
+     */
+    void retire(Operation* op) {
+        if (op->fd >= 0) {
+            close(op->fd);
+            op->fd = -1;
+        }
+        op->lease = DirectIOBufferPool::Lease();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            abandoned.erase(op);
+        }
+        if (op->deferred_error) {
+            op->fail(op->deferred_error);
+        }
+        delete op;
+    }
+
+    /**
+     * 处理一个完成事件
+     * @return 需要继续提交READ的请求，如果请求已结束则返回nullptr
+     */
+    Operation* complete(const io_uring_cqe& cqe) {
+        Operation* op = reinterpret_cast<Operation*>(cqe.user_data);
+        int res = cqe.res;
+
+        bool dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            dropped = op->abandoned;
+        }
+        if (dropped) {
+            // 已被放弃：只回收文件和对齐缓冲区，不再分配或读取
+            if (op->opening && res >= 0) {
+                close(res);
+            }
+            retire(op);
+            return nullptr;
+        }
+
+        if (op->opening) {
+            if (res == -EINVAL && op->direct) {
+                // 文件系统不支持O_DIRECT，改为普通方式重新打开
+                op->direct = false;
+                return op;
+            }
+            if (res < 0) {
+                finish(op, std::make_exception_ptr(std::runtime_error(
+                    "Failed to open file: " + op->request.path + " - " + strerror(-res))));
+                return nullptr;
+            }
+            op->fd = res;
+            op->opening = false;
+            adviseBeforeRead(op->fd, op->request);
+
+            // 按文件实际大小截断请求，区间读取不会为超出末尾的部分分配内存
+            struct stat stat_buf;
+            if (fstat(op->fd, &stat_buf) < 0) {
+                finish(op, std::make_exception_ptr(readError(op->request.path, errno)));
+                return nullptr;
+            }
+            uint64_t file_size = static_cast<uint64_t>(stat_buf.st_size);
+            uint64_t available = file_size > op->request.offset ? file_size - op->request.offset : 0;
+            size_t size = static_cast<size_t>(std::min<uint64_t>(available, op->request.length));
+            op->size = size;
+            op->data = op->allocate(size);
+            if (size == 0) {
+                finish(op, nullptr);
+                return nullptr;
+            }
+            if (op->direct) {
+                // 在途请求不超过缓冲区数量，因此总能租到缓冲区
+                op->lease = direct_pool->tryAcquire();
+            }
+            return op;
+        }
+
+        if (res == -EINTR || res == -EAGAIN) {
+            return op;
+        }
+        if (res < 0) {
+            finish(op, std::make_exception_ptr(readError(op->request.path, -res)));
+            return nullptr;
+        }
+        if (op->lease) {
+            size_t n = static_cast<size_t>(res);
+            if (n <= op->skew) {
+                // 到达文件末尾
+                finish(op, nullptr);
+                return nullptr;
+            }
+            size_t useful = std::min(n - op->skew, op->size - op->done);
+            memcpy(op->data + op->done, op->lease.data() + op->skew, useful);
+            op->done += useful;
+            if (n < op->span || op->done == op->size) {
+                // 读到了文件末尾的不完整块，或已读完
+                finish(op, nullptr);
+                return nullptr;
+            }
+            return op;
+        }
+
+        if (res == 0) {
+            // 文件比预期短（到达文件末尾）
+            finish(op, nullptr);
+            return nullptr;
+        }
+
+        op->done += static_cast<size_t>(res);
+        if (op->done < op->size) {
+            return op;
+        }
+        finish(op, nullptr);
+        return nullptr;
+    }
+
+    /**
+     * 按可用名额分块提交请求，每块只需一次io_uring_enter
+     * @param count 请求数量
+     * @param make 创建第i个请求的操作对象
+     * @param submit_fallback 环损坏后把从第i个开始的请求交给回退读取器
+     */
+    template<class Result, class Make, class Fallback>
+    std::vector<std::future<Result>> submitAll(size_t count, Make make, Fallback submit_fallback) {
+        std::vector<std::future<Result>> results;
+        results.reserve(count);
+
+        size_t next = 0;
+        while (next < count) {
+            size_t chunk;
+            std::vector<Operation*> ops;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                capacity.wait(lock, [this] {
+                    return broken || in_flight < depth;
+                });
+                if (broken) {
+                    // 环已损坏，剩余的请求由pread读取
+                    for (auto& result : submit_fallback(*fallback, next)) {
+                        results.push_back(std::move(result));
+                    }
+                    break;
+                }
+                chunk = std::min(count - next, depth - in_flight);
+                in_flight += chunk;
+                for (size_t i = 0; i < chunk; ++i) {
+                    auto* op = make(next + i);
+                    op->direct = direct_io;
+                    results.push_back(op->promise.get_future());
+                    operations.insert(op);
+                    ops.push_back(op);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(sq_mutex);
+                unsigned tail = *sq_tail;
+                for (Operation* op : ops) {
+                    prepareOpen(nextSqe(tail), op);
+                }
+                std::vector<Operation*> withdrawn;
+                try {
+                    submit(tail, static_cast<unsigned>(chunk), withdrawn);
+                } catch (const std::runtime_error&) {
+                    // 按致命错误处理：在途请求以异常结束，剩余的请求由pread读取
+                    abandon(std::current_exception(), withdrawn);
+                }
+            }
+            next += chunk;
+        }
+        return results;
+    }
+
+    /**
+     * 完成线程：收割完成事件，并为需要继续读取的请求提交READ
+     * 收到退出信号后继续收割，直到被放弃的请求都已交还
+     */
+    void reap() {
+        std::vector<Operation*> pending_reads;
+        std::vector<Operation*> dropped;
+        bool shutdown = false;
+
+        while (true) {
+            if (shutdown) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (abandoned.empty()) {
+                    break;
+                }
+            }
+            int ret = ioUringEnter(fd, 0, 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0 && errno != EINTR) {
+                // 无法继续等待完成事件：放弃在途请求后退出，避免忙等或使调用方永远等待；
+                // 读入调用方缓冲区的请求在关闭环时结束
+                std::lock_guard<std::mutex> lock(sq_mutex);
+                abandon(std::make_exception_ptr(
+                    std::runtime_error(std::string("io_uring_enter failed: ") + strerror(errno))), {});
+                break;
+            }
+
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            pending_reads.clear();
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                if (cqe.user_data == kShutdownTag) {
+                    shutdown = true;
+                    continue;
+                }
+                if (Operation* op = complete(cqe)) {
+                    pending_reads.push_back(op);
+                }
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+            if (!pending_reads.empty()) {
+                std::lock_guard<std::mutex> lock(sq_mutex);
+                dropped.clear();
+                {
+                    // complete()之后可能已被abandon()放弃，这些请求不再提交READ
+                    std::lock_guard<std::mutex> state_lock(mutex);
+                    auto live = std::partition(pending_reads.begin(), pending_reads.end(), [](Operation* op) {
+                        return !op->abandoned;
+                    });
+                    dropped.assign(live, pending_reads.end());
+                    pending_reads.erase(live, pending_reads.end());
+                }
+                for (Operation* op : dropped) {
+                    retire(op);
+                }
+                if (pending_reads.empty()) {
+                    continue;
+                }
+                unsigned sq_tail_local = *sq_tail;
+                for (Operation* op : pending_reads) {
+                    prepare(nextSqe(sq_tail_local), op);
+                }
+                std::vector<Operation*> withdrawn;
+                try {
+                    submit(sq_tail_local, static_cast<unsigned>(pending_reads.size()), withdrawn);
+                } catch (const std::runtime_error&) {
+                    // 继续收割已在内核中的请求，它们的完成事件到达后才释放
+                    abandon(std::current_exception(), withdrawn);
+                }
+            }
+        }
+    }
+};
+
+IoUringFileReader::IoUringFileReader(size_t queue_depth, bool direct_io)
+    : ring_(std::make_unique<Ring>(static_cast<unsigned>(std::max<size_t>(queue_depth, 1)), direct_io)) {
+    Ring* ring = ring_.get();
+    ring->reaper = std::thread([ring]() {
+        ring->reap();
+    });
+}
+
+IoUringFileReader::~IoUringFileReader() {
+    // 等待所有在途请求完成，再通过NOP通知完成线程退出
+    {
+        std::unique_lock<std::mutex> lock(ring_->mutex);
+        ring_->capacity.wait(lock, [this] {
+            return ring_->in_flight == 0;
+        });
+    }
+    try {
+        std::lock_guard<std::mutex> lock(ring_->sq_mutex);
+        unsigned tail = *ring_->sq_tail;
+        io_uring_sqe* sqe = ring_->nextSqe(tail);
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = kShutdownTag;
+        std::vector<Operation*> withdrawn;
+        ring_->submit(tail, 1, withdrawn);
+    } catch (const std::runtime_error&) {
+        // io_uring_enter已不可用，完成线程等待完成事件时同样会失败并退出
+    }
+    ring_->reaper.join();
+}
+
+std::vector<std::future<std::vector<unsigned char>>> IoUringFileReader::submitBatch(
+    const std::vector<ReadRequest>& requests) {
+    return ring_->submitAll<std::vector<unsigned char>>(
+        requests.size(),
+        [&](size_t i) {
+            auto* op = new BufferOperation<std::vector<unsigned char>>();
+            op->request = requests[i];
+            return op;
+        },
+        [&](PreadFileReader& fallback, size_t first) {
+            return fallback.submitBatch(
+                std::vector<ReadRequest>(requests.begin() + static_cast<std::ptrdiff_t>(first), requests.end()));
+        });
+}
+
+std::vector<std::future<PooledBuffer>> IoUringFileReader::submitBatchPooled(const std::vector<ReadRequest>& requests) {
+    return ring_->submitAll<PooledBuffer>(
+        requests.size(),
+        [&](size_t i) {
+            auto* op = new BufferOperation<PooledBuffer>();
+            op->request = requests[i];
+            return op;
+        },
+        [&](PreadFileReader& fallback, size_t first) {
+            return fallback.submitBatchPooled(
+                std::vector<ReadRequest>(requests.begin() + static_cast<std::ptrdiff_t>(first), requests.end()));
+        });
+}
+
+std::future<size_t> IoUringFileReader::submitInto(const ReadRequest& request, unsigned char* buffer) {
+    if (request.length == ReadRequest::kToEnd) {
+        throw std::runtime_error("readInto requires an explicit length: " + request.path);
+    }
+    auto results = ring_->submitAll<size_t>(
+        1,
+        [&](size_t) {
+            auto* op = new IntoOperation();
+            op->request = request;
+            op->destination = buffer;
+            return op;
+        },
+        [&](PreadFileReader& fallback, size_t) {
+            std::vector<std::future<size_t>> result;
+            result.push_back(fallback.submitInto(request, buffer));
+            return result;
+        });
+    return std::move(results.front());
+}
+
+bool IoUringFileReader::isSupported() {
+    static const bool supported = []() {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = ioUringSetup(2, &params);
+        if (fd < 0) {
+            return false;
+        }
+
+        // 通过PROBE确认内核支持OPENAT和READ操作
+        const unsigned num_ops = 256;
+        std::vector<unsigned char> storage(sizeof(io_uring_probe) + num_ops * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        bool ok = ioUringRegister(fd, IORING_REGISTER_PROBE, probe, num_ops) >= 0;
+        for (unsigned op : {unsigned(IORING_OP_OPENAT), unsigned(IORING_OP_READ), unsigned(IORING_OP_NOP)}) {
+            ok = ok && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        }
+        close(fd);
+        return ok;
+    }();
+    return supported;
+}
+
+#else // !HPDL_HAVE_IO_URING
+
+struct IoUringFileReader::Ring {};
+
+IoUringFileReader::IoUringFileReader(size_t, bool) {
+    throw std::runtime_error("io_uring is not available on this platform");
+}
+
+IoUringFileReader::~IoUringFileReader() = default;
+
+std::vector<std::future<std::vector<unsigned char>>> IoUringFileReader::submitBatch(
+    const std::vector<ReadRequest>&) {
+    throw std::runtime_error("io_uring is not available on this platform");
+}
+
+std::vector<std::future<PooledBuffer>> IoUringFileReader::submitBatchPooled(const std::vector<ReadRequest>&) {
+    throw std::runtime_error("io_uring is not available on this platform");
+}
+
+std::future<size_t> IoUringFileReader::submitInto(const ReadRequest&, unsigned char*) {
+    throw std::runtime_error("io_uring is not available on this platform");
+}
+
+bool IoUringFileReader::isSupported() {
+    return false;
+}
+
+#endif // HPDL_HAVE_IO_URING
+
+// AsyncFileReader实现
+
+std::unique_ptr<AsyncFileReader> AsyncFileReader::create(size_t queue_depth, bool direct_io) {
+    if (IoUringFileReader::isSupported()) {
+        try {
+            return std::make_unique<IoUringFileReader>(queue_depth, direct_io);
+        } catch (const std::exception&) {
+            // 例如受到资源限制，回退到pread
+        }
+    }
+    return std::make_unique<PreadFileReader>(std::clamp<size_t>(queue_depth, 1, 16), direct_io);
+}
@@ -0,0 +1,199 @@
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <cstddef>
+#include <cstdint>
+#include "access_advice.h"
+#include "buffer_pool.h"
+
+class DirectIOBufferPool;
+
+/**
+ * 读取请求 - 描述对一个文件（或文件中一段区间）的读取
+ */
+struct ReadRequest {
+    // 表示一直读到文件末尾的长度
+    static constexpr size_t kToEnd = static_cast<size_t>(-1);
+
+    // 文件路径
+    std::string path;
+
+    // 起始偏移
+    uint64_t offset = 0;
+
+    // 读取长度，kToEnd表示读到文件末尾
+    size_t length = kToEnd;
+
+    // 读取前对文件描述符设置的访问模式，只有Sequential和Random有意义
+    AccessAdvice advice = AccessAdvice::Normal;
+
+    // 读取完成后是否把读过的范围从页缓存中逐出（流式读取，每个字节只读一次）
+    bool drop_behind = false;
+};
+
+/**
+ * 异步文件读取接口 - 批量提交读取请求，由后台完成并通过future返回结果
+ */
+class AsyncFileReader {
+public:
+    virtual ~AsyncFileReader() = default;
+
+    /**
+     * 批量提交读取请求
+     * 同一批请求尽量通过一次系统调用提交
+     * @param requests 读取请求列表
+     * @return 与请求一一对应的结果future，读取失败时future中保存异常
+     */
+    virtual std::vector<std::future<std::vector<unsigned char>>> submitBatch(
+        const std::vector<ReadRequest>& requests) = 0;
+
+    /**
+     * 提交单个读取请求
+     * @param request 读取请求
+     * @return 结果future
+     */
+    std::future<std::vector<unsigned char>> submit(const ReadRequest& request) {
+        std::vector<ReadRequest> requests{request};
+        return std::move(submitBatch(requests).front());
+    }
+
+    /**
+     * 批量提交读取请求，结果读入池化缓冲区
+     * @param requests 读取请求列表
+     * @return 与请求一一对应的结果future，读取失败时future中保存异常
+     */
+    virtual std::vector<std::future<PooledBuffer>> submitBatchPooled(const std::vector<ReadRequest>& requests) = 0;
+
+    /**
+     * 提交单个读取请求，结果读入池化缓冲区
+     * @param request 读取请求
+     * @return 结果future
+     */
+    std::future<PooledBuffer> submitPooled(const ReadRequest& request) {
+        std::vector<ReadRequest> requests{request};
+        return std::move(submitBatchPooled(requests).front());
+    }
+
+    /**
+     * 提交读取请求，把区间读入调用方提供的缓冲区
+     * @param request 读取请求，length不能为kToEnd
+     * @param buffer 目标缓冲区，长度至少为request.length，在future就绪之前必须保持有效
+     * @return 实际读取的字节数，到达文件末尾时小于request.length
+     * @throws std::runtime_error request.length为kToEnd时抛出
+     */
+    virtual std::future<size_t> submitInto(const ReadRequest& request, unsigned char* buffer) = 0;
+
+    /**
+     * 获取后端名称
+     * @return 后端名称，例如"io_uring"或"pread"
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * 创建可用的最佳后端：优先使用io_uring，不可用时回退到pread
+     * @param queue_depth 同时在途的最大请求数量
+     * @param direct_io 是否使用O_DIRECT绕过页缓存
+     * @return 异步读取器实例
+     */
+    static std::unique_ptr<AsyncFileReader> create(size_t queue_depth = 64, bool direct_io = false);
+};
+
+/**
+ * 基于io_uring的异步读取器
+ * 每个请求依次提交OPENAT和READ操作，由单个完成线程收割完成事件并推进后续操作，
+ * 因此少量线程即可让NVMe设备保持较深的队列。
+ * 直接I/O模式下，每个在途请求占用一个对齐缓冲区，缓冲池注册到io_uring后使用READ_FIXED读取。
+ * io_uring_enter出现致命错误时，在途请求以异常结束，之后的请求改由内部的PreadFileReader读取
+ */
+class IoUringFileReader : public AsyncFileReader {
+public:
+    /**
+     * 构造函数
+     * @param queue_depth 同时在途的最大请求数量
+     * @param direct_io 是否使用O_DIRECT绕过页缓存
+     * @throws std::runtime_error 当前系统不支持io_uring时抛出
+     */
+    explicit IoUringFileReader(size_t queue_depth = 64, bool direct_io = false);
+    ~IoUringFileReader() override;
+
+    IoUringFileReader(const IoUringFileReader&) = delete;
+    IoUringFileReader& operator=(const IoUringFileReader&) = delete;
+
+    std::vector<std::future<std::vector<unsigned char>>> submitBatch(
+        const std::vector<ReadRequest>& requests) override;
+    std::vector<std::future<PooledBuffer>> submitBatchPooled(const std::vector<ReadRequest>& requests) override;
+    std::future<size_t> submitInto(const ReadRequest& request, unsigned char* buffer) override;
+    const char* name() const override { return "io_uring"; }
+
+    /**
+     * 检查当前系统是否支持本读取器所需的io_uring功能
+     * @return 如果支持则返回true
+     */
+    static bool isSupported();
+
+private:
+    struct Ring;
+    struct Operation;
+    template<class Buffer>
+    struct BufferOperation;
+    struct IntoOperation;
+
+    // io_uring环及在途请求状态，实现细节位于async_reader.cpp
+    std::unique_ptr<Ring> ring_;
+};
+
+/**
+ * 基于pread的读取器 - io_uring不可用时的回退实现
+ * 请求由内部线程池中的线程同步完成
+ */
+class PreadFileReader : public AsyncFileReader {
+public:
+    /**
+     * 构造函数
+     * @param num_threads 执行读取的线程数量
+     * @param direct_io 是否使用O_DIRECT绕过页缓存
+     */
+    explicit PreadFileReader(size_t num_threads = 4, bool direct_io = false);
+    ~PreadFileReader() override;
+
+    std::vector<std::future<std::vector<unsigned char>>> submitBatch(
+        const std::vector<ReadRequest>& requests) override;
+    std::vector<std::future<PooledBuffer>> submitBatchPooled(const std::vector<ReadRequest>& requests) override;
+    std::future<size_t> submitInto(const ReadRequest& request, unsigned char* buffer) override;
+    const char* name() const override { return "pread"; }
+
+    /**
+     * 同步读取文件（或区间）
+     * @param request 读取请求
+     * @param direct_pool 非空时使用O_DIRECT，经由该缓冲池读取
+     * @return 读取的数据
+     */
+    static std::vector<unsigned char> read(const ReadRequest& request, DirectIOBufferPool* direct_pool = nullptr);
+
+    /**
+     * 同步读取区间到调用方提供的缓冲区
+     * @param request 读取请求，length不能为kToEnd
+     * @param buffer 目标缓冲区，长度至少为request.length
+     * @param direct_pool 非空时使用O_DIRECT，经由该缓冲池读取
+     * @return 实际读取的字节数，到达文件末尾时小于request.length
+     */
+    static size_t readInto(const ReadRequest& request, unsigned char* buffer, DirectIOBufferPool* direct_pool = nullptr);
+
+    /**
+     * 同步读取文件（或区间）到池化缓冲区
+     * @param request 读取请求
+     * @param direct_pool 非空时使用O_DIRECT，经由该缓冲池读取
+     * @return 读取的数据，缓冲区释放后回到缓冲池
+     */
+    static PooledBuffer readPooled(const ReadRequest& request, DirectIOBufferPool* direct_pool = nullptr);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+#endif // ASYNC_READER_H
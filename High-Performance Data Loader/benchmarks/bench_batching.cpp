@@ -0,0 +1,174 @@
+#include "sampler.h"
+#include "packing.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/**
+ * 性能测试：变长序列的批次划分方式对比
+ * 用法：bench_batching [样本数] [每批词元预算] [打乱窗口] [打包行长度]
+ *
+ * 样本长度（词元数）服从对数正态分布并截断到[8, 2048]，与网页文本类语料的长度分布相近。
+ * 对比固定大小的随机批次（批次大小取预算除以平均长度，使平均批次规模相同）和BucketBatchSampler：
+ * - 补齐比例：补齐的词元占批次补齐后总词元数的比例
+ * - 最大批次：补齐后词元最多的批次，决定显存峰值
+ * 再对比把每个批次用SequencePacker打包进固定长度的行（First-Fit Decreasing和Best-Fit Decreasing）
+ * 与补齐到批次内最大长度的补齐比例，以及打包实际张量的耗时
+ */
+
+struct BatchStats {
+    size_t batches = 0;
+    size_t tokens = 0;
+    size_t padded = 0;
+    size_t max_padded = 0;
+};
+
+static BatchStats measure(const std::vector<std::vector<size_t>>& batches, const std::vector<size_t>& lengths) {
+    BatchStats stats;
+    for (const auto& batch : batches) {
+        size_t max_length = 0;
+        for (size_t index : batch) {
+            max_length = std::max(max_length, lengths[index]);
+            stats.tokens += lengths[index];
+        }
+        const size_t padded = max_length * batch.size();
+        stats.padded += padded;
+        stats.max_padded = std::max(stats.max_padded, padded);
+        ++stats.batches;
+    }
+    return stats;
+}
+
+static void report(const std::string& label, const BatchStats& stats, double seconds) {
+    std::cout << "  " << std::left << std::setw(30) << label << std::right << std::setw(8) << stats.batches
+              << " batches   padding " << std::setw(5) << std::fixed << std::setprecision(1)
+              << 100.0 * static_cast<double>(stats.padded - stats.tokens) / static_cast<double>(stats.padded)
+              << "%   max batch " << std::setw(7) << stats.max_padded << " tokens   " << std::setprecision(1)
+              << seconds * 1e3 << " ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t budget = argc > 2 ? std::stoul(argv[2]) : 16384;
+    size_t window = argc > 3 ? std::stoul(argv[3]) : 8192;
+    size_t row_length = argc > 4 ? std::stoul(argv[4]) : 2048;
+
+    std::mt19937_64 rng(1);
+    std::lognormal_distribution<double> distribution(5.0, 0.9);
+    std::vector<size_t> lengths(count);
+    size_t total = 0;
+    for (auto& length : lengths) {
+        length = std::clamp<size_t>(static_cast<size_t>(distribution(rng)), 8, 2048);
+        total += length;
+    }
+    const size_t batch_size = std::max<size_t>(1, budget * count / total);
+    std::cout << "=== " << count << " samples, mean length " << total / count << " tokens, budget " << budget
+              << " tokens ===" << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> order = RandomSampler(count, 42).indices(0);
+    std::vector<std::vector<size_t>> fixed;
+    for (size_t begin = 0; begin < count; begin += batch_size) {
+        fixed.emplace_back(order.begin() + begin, order.begin() + std::min(count, begin + batch_size));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    report("fixed batch of " + std::to_string(batch_size), measure(fixed, lengths),
+           std::chrono::duration<double>(end - start).count());
+
+    BucketBatchOptions options;
+    options.window = window;
+    start = std::chrono::high_resolution_clock::now();
+    auto bucketed = BucketBatchSampler(lengths, budget, 42, options).batches(0);
+    end = std::chrono::high_resolution_clock::now();
+    report("bucketed, window " + std::to_string(window), measure(bucketed, lengths),
+           std::chrono::duration<double>(end - start).count());
+
+    options.boundaries = {32, 64, 128, 256, 512, 1024};
+    start = std::chrono::high_resolution_clock::now();
+    bucketed = BucketBatchSampler(lengths, budget, 42, options).batches(0);
+    end = std::chrono::high_resolution_clock::now();
+    report("bucketed, 7 power-of-2 buckets", measure(bucketed, lengths),
+           std::chrono::duration<double>(end - start).count());
+
+    // 打包时随机批次按长度之和不超过预算划分，每批约为budget / row_length行；
+    // 不分桶，长短混合的批次更容易填满各行
+    std::vector<std::vector<size_t>> summed(1);
+    size_t summed_tokens = 0;
+    for (size_t index : order) {
+        if (!summed.back().empty() && summed_tokens + lengths[index] > budget) {
+            summed.emplace_back();
+            summed_tokens = 0;
+        }
+        summed.back().push_back(index);
+        summed_tokens += lengths[index];
+    }
+
+    std::cout << std::endl << "Packing into rows of " << row_length << " tokens:" << std::endl;
+    for (const auto& [label, batches] : {std::make_pair(std::string("fixed"), &fixed),
+                                         std::make_pair(std::string("sum-budget random"), &summed)}) {
+        for (PackingStrategy strategy : {PackingStrategy::FirstFit, PackingStrategy::BestFit}) {
+            PackingOptions packing;
+            packing.row_length = row_length;
+            packing.strategy = strategy;
+            SequencePacker packer(packing);
+
+            size_t rows = 0;
+            size_t tokens = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (const auto& batch : *batches) {
+                std::vector<size_t> batch_lengths;
+                batch_lengths.reserve(batch.size());
+                for (size_t index : batch) {
+                    batch_lengths.push_back(lengths[index]);
+                    tokens += lengths[index];
+                }
+                rows += packer.plan(batch_lengths).size();
+            }
+            end = std::chrono::high_resolution_clock::now();
+            std::cout << "  " << std::left << std::setw(30)
+                      << label + (strategy == PackingStrategy::FirstFit ? ", FFD" : ", BFD") << std::right
+                      << std::setw(8) << rows << " rows      padding " << std::setw(5) << std::setprecision(1)
+                      << 100.0 * static_cast<double>(rows * row_length - tokens) /
+                             static_cast<double>(rows * row_length)
+                      << "%   plan " << std::chrono::duration<double>(end - start).count() * 1e3 << " ms"
+                      << std::endl;
+        }
+    }
+
+    // 打包实际的int32张量（包括复制词元、生成位置和片段编号）
+    std::vector<TensorData> samples;
+    std::vector<const TensorData*> pointers;
+    size_t packed_tokens = 0;
+    const size_t sample_batches = std::min<size_t>(summed.size(), 2000);
+    for (size_t b = 0; b < sample_batches; ++b) {
+        for (size_t index : summed[b]) {
+            samples.emplace_back(DType::Int32, TensorData::Shape{static_cast<int64_t>(lengths[index])});
+            packed_tokens += lengths[index];
+        }
+    }
+    for (auto& sample : samples) {
+        sample.fill(1);
+        pointers.push_back(&sample);
+    }
+    PackingOptions packing;
+    packing.row_length = row_length;
+    SequencePacker packer(packing);
+    size_t offset = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < sample_batches; ++b) {
+        std::vector<const TensorData*> batch(pointers.begin() + static_cast<std::ptrdiff_t>(offset),
+                                             pointers.begin() + static_cast<std::ptrdiff_t>(offset + summed[b].size()));
+        offset += summed[b].size();
+        TensorMap packed = packer.pack(batch);
+        (void)packed;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "  pack() on " << sample_batches << " batches: " << std::setprecision(1) << seconds * 1e3
+              << " ms, " << static_cast<double>(packed_tokens) / seconds / 1e6 << " M tokens/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "storage.h"
+#include "file_io.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * 性能测试：冷缓存下直接I/O与带缓冲读取的吞吐量对比
+ * 用法：bench_direct_io [数据目录] [文件数量] [单个文件大小(MB)]
+ *
+ * 每轮读取前用POSIX_FADV_DONTNEED把测试文件逐出页缓存（不需要root权限），
+ * 读取后用mincore统计仍留在页缓存中的比例，以观察对页缓存的占用
+ */
+
+namespace fs = std::filesystem;
+
+// 生成测试文件（已存在且大小一致时复用）
+static std::vector<std::string> prepareFiles(const std::string& dir, size_t count, size_t size) {
+    fs::create_directories(dir);
+    std::vector<std::string> paths;
+    std::mt19937_64 rng(42);
+    std::vector<unsigned char> data(size);
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string path = dir + "/sample_" + std::to_string(i) + ".bin";
+        paths.push_back(path);
+        if (fs::exists(path) && fs::file_size(path) == size) {
+            continue;
+        }
+        for (auto& byte : data) {
+            byte = static_cast<unsigned char>(rng());
+        }
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+            throw std::runtime_error("Failed to write " + path);
+        }
+        fclose(file);
+    }
+    return paths;
+}
+
+// 将文件逐出页缓存
+static void dropFromPageCache(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// 统计文件在页缓存中的驻留比例
+static double residentFraction(const std::vector<std::string>& paths) {
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t resident = 0;
+    size_t total = 0;
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat stat_buf;
+        fstat(fd, &stat_buf);
+        size_t size = static_cast<size_t>(stat_buf.st_size);
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                std::vector<unsigned char> pages((size + page_size - 1) / page_size);
+                if (mincore(mapped, size, pages.data()) == 0) {
+                    for (unsigned char page : pages) {
+                        resident += page & 1;
+                    }
+                }
+                total += pages.size();
+                munmap(mapped, size);
+            }
+        }
+        close(fd);
+    }
+    return total ? static_cast<double>(resident) / total : 0.0;
+}
+
+struct Result {
+    double seconds;
+    size_t bytes;
+    double resident;
+};
+
+template<class ReadAll>
+static Result run(const std::vector<std::string>& paths, ReadAll read_all) {
+    dropFromPageCache(paths);
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t bytes = read_all();
+    auto end = std::chrono::high_resolution_clock::now();
+    return Result{std::chrono::duration<double>(end - start).count(), bytes, residentFraction(paths)};
+}
+
+static size_t readWithStorage(LocalStorage& storage, const std::vector<std::string>& paths, size_t window) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (i % window == 0) {
+            size_t end = std::min(paths.size(), i + window);
+            storage.prefetch(std::vector<std::string>(paths.begin() + i, paths.begin() + end));
+        }
+        bytes += storage.readFilePooled(paths[i]).size();
+    }
+    return bytes;
+}
+
+static void report(const std::string& name, const Result& result) {
+    double mb = result.bytes / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(28) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << mb / result.seconds << " MB/s"
+              << std::setw(12) << std::setprecision(1) << result.resident * 100.0 << " % cached"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp/hpdl_bench_direct_io";
+    size_t count = argc > 2 ? std::stoul(argv[2]) : 32;
+    size_t size_mb = argc > 3 ? std::stoul(argv[3]) : 8;
+
+    std::cout << "=== Direct I/O vs buffered reads (cold cache) ===" << std::endl;
+    std::cout << count << " files x " << size_mb << " MB in " << dir << std::endl;
+
+    auto paths = prepareFiles(dir, count, size_mb * 1024 * 1024);
+
+    LocalStorage buffered(64, 256, false);
+    LocalStorage direct(64, 256, true);
+    std::cout << "Reader backend: " << buffered.getReaderName() << std::endl << std::endl;
+
+    const size_t window = 16;
+    report("LocalStorage buffered", run(paths, [&] { return readWithStorage(buffered, paths, window); }));
+    report("LocalStorage direct", run(paths, [&] { return readWithStorage(direct, paths, window); }));
+
+    report("FileIO::readFile", run(paths, [&] {
+        size_t bytes = 0;
+        for (const auto& path : paths) {
+            bytes += FileIO::readFile(path).size();
+        }
+        return bytes;
+    }));
+    report("FileIO::readFileDirect", run(paths, [&] {
+        size_t bytes = 0;
+        for (const auto& path : paths) {
+            bytes += FileIO::readFileDirect(path).size();
+        }
+        return bytes;
+    }));
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "storage.h"
+#include "fake_hdfs_server.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstring>
+
+/**
+ * 性能测试：HDFSStorage对本地HDFS替身（WebHDFS，1个名称节点 + 3个数据节点）的读取吞吐量
+ * 用法：bench_hdfs [大文件大小(MB)] [每连接带宽(MB/s)] [请求延迟(ms)] [块大小(MB)]
+ *
+ * 替身的每个节点按连接限速并为每个请求加上固定延迟；每次OPEN先访问名称节点，再重定向到数据节点：
+ * 1. 大文件：分段并发数和分段大小对单个文件读取吞吐量的影响，以及各数据节点分担的字节数
+ * 2. 小文件：多线程读取大量小文件时，连接复用与每个请求新建连接（含握手延迟）的对比
+ */
+
+static std::unique_ptr<HDFSStorage> makeStorage(const FakeHdfsServer& server, size_t part_size, size_t concurrency) {
+    HDFSConfig config;
+    config.user = "bench";
+    config.part_size = part_size;
+    config.max_concurrency = concurrency;
+    auto storage = std::make_unique<HDFSStorage>("127.0.0.1", server.port(), config);
+    if (!storage->connect()) {
+        throw std::runtime_error("Failed to connect to " + server.endpoint());
+    }
+    return storage;
+}
+
+static void benchLargeFile(FakeHdfsServer& server, const std::string& expected, size_t part_mb, size_t concurrency) {
+    auto storage = makeStorage(server, part_mb << 20, concurrency);
+    server.resetStats();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    PooledBuffer data = storage->readFilePooled(server.uri() + "/bench/large.bin");
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    if (data.size() != expected.size() || memcmp(data.data(), expected.data(), expected.size()) != 0) {
+        throw std::runtime_error("Data mismatch reading large.bin");
+    }
+    FakeHdfsServer::Stats stats = server.stats();
+    std::cout << "  part " << std::setw(3) << part_mb << " MB, concurrency " << std::setw(2) << concurrency
+              << std::setw(10) << std::fixed << std::setprecision(1) << expected.size() / (1024.0 * 1024.0) / seconds
+              << " MB/s" << std::setw(6) << stats.redirects << " opens" << std::setw(6) << stats.connections
+              << " connections   datanode share";
+    for (uint64_t bytes : stats.datanode_bytes) {
+        std::cout << std::setw(5) << std::setprecision(0) << 100.0 * bytes / expected.size() << "%";
+    }
+    std::cout << std::endl;
+}
+
+static void benchSmallFiles(FakeHdfsServer& server, size_t count, size_t threads, const char* label) {
+    auto storage = makeStorage(server, 8 << 20, 1);
+    server.resetStats();
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> bytes{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                bytes += storage->readFilePooled("/bench/small/" + std::to_string(i) + ".bin").size();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    FakeHdfsServer::Stats stats = server.stats();
+    HttpClient::Stats client = storage->httpStats();
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(0) << count / seconds << " files/s" << std::setw(10) << std::setprecision(1)
+              << bytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::setw(8) << stats.connections
+              << " connections" << std::setw(6) << client.retries << " retries" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t file_mb = argc > 1 ? std::stoul(argv[1]) : 256;
+    size_t bandwidth_mb = argc > 2 ? std::stoul(argv[2]) : 50;
+    int latency_ms = argc > 3 ? std::stoi(argv[3]) : 5;
+    size_t block_mb = argc > 4 ? std::stoul(argv[4]) : 32;
+
+    FakeHdfsServer::Options options;
+    options.datanodes = 3;
+    options.replication = 2;
+    options.block_size = static_cast<uint64_t>(block_mb) << 20;
+    options.latency_ms = latency_ms;
+    options.bandwidth = bandwidth_mb << 20;
+
+    std::cout << "=== HDFSStorage against local fake WebHDFS (1 namenode, " << options.datanodes
+              << " datanodes) ===" << std::endl;
+    std::cout << "per-connection bandwidth " << bandwidth_mb << " MB/s, request latency " << latency_ms
+              << " ms, block size " << block_mb << " MB" << std::endl << std::endl;
+
+    // 1. 大文件
+    {
+        FakeHdfsServer server(options);
+        std::string data(file_mb << 20, '\0');
+        std::mt19937_64 rng(42);
+        for (size_t i = 0; i + 8 <= data.size(); i += 8) {
+            uint64_t value = rng();
+            memcpy(&data[i], &value, 8);
+        }
+        server.putFile("/bench/large.bin", data);
+        server.start();
+
+        auto storage = makeStorage(server, 8 << 20, 1);
+        std::vector<BlockLocation> blocks = storage->getBlockLocations(server.uri() + "/bench/large.bin");
+        std::cout << "Large file (" << file_mb << " MB, " << blocks.size() << " blocks, first block on";
+        for (const auto& host : blocks.empty() ? std::vector<std::string>() : blocks.front().hosts) {
+            std::cout << " " << host;
+        }
+        std::cout << "), readFilePooled:" << std::endl;
+
+        for (size_t concurrency : {1, 4, 8, 16}) {
+            benchLargeFile(server, data, 8, concurrency);
+        }
+        for (size_t part_mb : {2, 32}) {
+            benchLargeFile(server, data, part_mb, 8);
+        }
+    }
+
+    // 2. 小文件：每个新连接额外等待两个往返，模拟TCP握手和认证
+    {
+        const size_t count = 2000;
+        const size_t threads = 16;
+        std::string data(32 * 1024, 'x');
+
+        std::cout << std::endl << count << " small files (32 KB), " << threads << " threads:" << std::endl;
+        for (bool reuse : {true, false}) {
+            FakeHdfsServer::Options small_options = options;
+            small_options.connect_latency_ms = 2 * latency_ms;
+            small_options.keep_alive = reuse;
+            FakeHdfsServer server(small_options);
+            for (size_t i = 0; i < count; ++i) {
+                server.putFile("/bench/small/" + std::to_string(i) + ".bin", data);
+            }
+            server.start();
+            benchSmallFiles(server, count, threads, reuse ? "keep-alive" : "new connection each");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "data_loader.h"
+#include "hedged_storage.h"
+#include "fault_injecting_storage.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+
+/**
+ * 性能测试：对冲与重试对长尾延迟存储上批次延迟的影响
+ * 用法：bench_hedging [样本数] [慢请求概率] [失败概率]
+ *
+ * 本地小文件包装在FaultInjectingStorage中：正常读取约2ms，少数读取100ms，少数读取暂时失败。
+ * 分别测量不做处理（失败的样本被丢弃）、只重试、重试加对冲三种方式下每个批次的等待时间
+ */
+
+namespace fs = std::filesystem;
+
+static const size_t kBatchSize = 64;
+static const size_t kLoaderThreads = 16;
+static const size_t kSampleSize = 4096;
+
+static std::vector<std::string> prepareFiles(const std::string& dir, size_t count) {
+    fs::create_directories(dir);
+    std::vector<std::string> paths;
+    std::string data(kSampleSize, 'x');
+    for (size_t i = 0; i < count; ++i) {
+        std::string path = dir + "/" + std::to_string(i) + ".bin";
+        if (!fs::exists(path) || fs::file_size(path) != kSampleSize) {
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+                throw std::runtime_error("Failed to write " + path);
+            }
+            fclose(file);
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(static_cast<size_t>(p * values.size()), values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+enum class Mode { None, Retry, Hedge };
+
+static void run(const std::vector<std::string>& paths, const FaultProfile& profile, Mode mode, const char* label) {
+    DataLoader loader(paths, kBatchSize, kLoaderThreads, 2, 256, 0);
+
+    auto faulty = std::make_unique<FaultInjectingStorage>(std::make_unique<LocalStorage>(), profile);
+    FaultInjectingStorage* faults = faulty.get();
+    HedgedStorage* hedged = nullptr;
+    if (mode == Mode::None) {
+        loader.setStorage(std::move(faulty));
+    } else {
+        HedgingPolicy hedging;
+        hedging.enabled = mode == Mode::Hedge;
+        auto storage = std::make_unique<HedgedStorage>(std::move(faulty), hedging, RetryPolicy(), 4 * kLoaderThreads);
+        hedged = storage.get();
+        loader.setStorage(std::move(storage));
+    }
+
+    // 不做处理时，失败的样本以空数据项代替并计数
+    std::atomic<size_t> dropped{0};
+    Storage* storage = loader.getStorage();
+    loader.setLoaderFunction([storage, &dropped](const std::string& path) -> std::unique_ptr<DataItem> {
+        try {
+            PooledBuffer data = storage->readFilePooled(path);
+            return std::make_unique<TextData>(std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        } catch (const TransientStorageError&) {
+            ++dropped;
+            return std::make_unique<TextData>(std::string());
+        }
+    });
+
+    std::vector<double> waits;
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    while (auto batch = loader.getNextBatch()) {
+        auto now = std::chrono::steady_clock::now();
+        waits.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+        last = now;
+    }
+    double seconds = std::chrono::duration<double>(last - start).count();
+
+    std::cout << "  " << std::left << std::setw(14) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << percentile(waits, 0.5) << std::setw(8) << percentile(waits, 0.99)
+              << std::setw(8) << *std::max_element(waits.begin(), waits.end()) << std::setw(9)
+              << std::setprecision(2) << seconds << std::setw(9) << dropped.load() << std::setw(9)
+              << faults->stats().failures;
+    if (hedged) {
+        HedgedStorage::Stats stats = hedged->stats();
+        std::cout << std::setw(9) << stats.retries << std::setw(9) << stats.hedges << std::setw(7)
+                  << stats.hedge_wins;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 8192;
+    FaultProfile profile;
+    profile.slow_probability = argc > 2 ? std::stod(argv[2]) : 0.01;
+    profile.failure_probability = argc > 3 ? std::stod(argv[3]) : 0.01;
+
+    std::vector<std::string> paths = prepareFiles("/tmp/hpdl_bench_hedging", count);
+
+    std::cout << "=== Batch latency with slow and failing reads ===" << std::endl;
+    std::cout << count << " samples, batch " << kBatchSize << ", " << kLoaderThreads << " loader threads, "
+              << "read ~" << profile.latency.count() / 1000.0 << " ms, " << profile.slow_probability * 100
+              << "% at " << profile.slow_latency.count() / 1000.0 << " ms, " << profile.failure_probability * 100
+              << "% failing" << std::endl << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "policy" << std::right << std::setw(8) << "p50ms"
+              << std::setw(8) << "p99ms" << std::setw(8) << "maxms" << std::setw(9) << "total s" << std::setw(9)
+              << "dropped" << std::setw(9) << "injected" << std::setw(9) << "retries" << std::setw(9) << "hedges"
+              << std::setw(7) << "wins" << std::endl;
+
+    run(paths, profile, Mode::None, "none");
+    run(paths, profile, Mode::Retry, "retry");
+    run(paths, profile, Mode::Hedge, "retry+hedge");
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "image_ops.h"
+#include "data_loader.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+/**
+ * 性能测试：图像预处理内核在各级SIMD指令上的吞吐量
+ * 用法：bench_image_ops [源图宽度] [源图高度] [输出边长] [迭代次数]
+ *
+ * 1. 单个内核：HWC转CHW并归一化、CHW原地归一化、双线性缩放、裁剪、水平翻转、融合的裁剪+缩放+翻转+归一化，
+ *    依次强制使用标量、SSE4.1、AVX2、AVX-512实现（只测试CPU支持的级别）
+ * 2. 完整预处理（RandomResizedCrop + 水平翻转 + ImageNet归一化，输出CHW float）：
+ *    逐像素手写循环、逐步调用内核（产生中间图像）和融合内核的对比
+ */
+
+static double timeIt(size_t iterations, const std::function<void(size_t)>& fn) {
+    fn(0);  // 预热
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / iterations;
+}
+
+static void report(const std::string& label, double seconds, double pixels) {
+    std::cout << "  " << std::left << std::setw(12) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << seconds * 1e6 << " us" << std::setw(10) << pixels / seconds / 1e6
+              << " Mpix/s" << std::endl;
+}
+
+// 业务代码中常见的写法：逐像素计算源坐标、双线性插值并写入CHW输出
+static void naivePipeline(const ImageData& image, const CropRect& rect, int size, bool flip, float* out) {
+    const unsigned char* data = image.getData();
+    const int width = image.getWidth();
+    const int channels = image.getChannels();
+    const float mean[3] = {0.485f, 0.456f, 0.406f};
+    const float stddev[3] = {0.229f, 0.224f, 0.225f};
+    for (int c = 0; c < channels; ++c) {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int px = flip ? size - 1 - x : x;
+                float sx = std::max(0.0f, (px + 0.5f) * rect.width / size - 0.5f);
+                float sy = std::max(0.0f, (y + 0.5f) * rect.height / size - 0.5f);
+                int x0 = std::min(static_cast<int>(sx), rect.width - 1);
+                int y0 = std::min(static_cast<int>(sy), rect.height - 1);
+                int x1 = std::min(x0 + 1, rect.width - 1);
+                int y1 = std::min(y0 + 1, rect.height - 1);
+                float wx = sx - x0;
+                float wy = sy - y0;
+                auto at = [&](int xx, int yy) {
+                    return static_cast<float>(data[((rect.y + yy) * width + rect.x + xx) * channels + c]);
+                };
+                float top = at(x0, y0) + wx * (at(x1, y0) - at(x0, y0));
+                float bottom = at(x0, y1) + wx * (at(x1, y1) - at(x0, y1));
+                float value = (top + wy * (bottom - top)) / 255.0f;
+                out[(static_cast<size_t>(c) * size + y) * size + x] = (value - mean[c]) / stddev[c];
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int width = argc > 1 ? std::stoi(argv[1]) : 640;
+    int height = argc > 2 ? std::stoi(argv[2]) : 480;
+    int size = argc > 3 ? std::stoi(argv[3]) : 224;
+    size_t iterations = argc > 4 ? std::stoul(argv[4]) : 200;
+    const int channels = 3;
+
+    PooledBuffer pixels(static_cast<size_t>(width) * height * channels);
+    std::mt19937_64 rng(42);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels.data()[i] = static_cast<unsigned char>(rng());
+    }
+    ImageData image(width, height, channels, std::move(pixels));
+    ImageView src(image);
+
+    const double src_pixels = static_cast<double>(width) * height;
+    const double out_pixels = static_cast<double>(size) * size;
+    const CropRect center = ImageOps::centerCrop(width, height, size, size);
+    const CropRect half = ImageOps::centerCrop(width, height, width / 2, height / 2);
+    const Normalization norm = Normalization::imagenet();
+
+    std::vector<float> chw(static_cast<size_t>(channels) * width * height);
+    std::vector<float> out(static_cast<size_t>(channels) * size * size);
+    std::vector<unsigned char> bytes(static_cast<size_t>(width) * height * channels);
+
+    const SimdLevel detected = ImageOps::detectedSimdLevel();
+    std::cout << "=== Image kernels, " << width << "x" << height << "x" << channels << " source, " << size << "x"
+              << size << " output, best level " << ImageOps::simdLevelName(detected) << " ===" << std::endl;
+
+    struct Kernel {
+        const char* name;
+        double pixels;
+        std::function<void(size_t)> run;
+    };
+    std::vector<Kernel> kernels = {
+        {"toChw + normalize (full image)", src_pixels,
+         [&](size_t) { ImageOps::toChw(src, chw.data(), norm); }},
+        {"normalize in place (full image CHW)", src_pixels,
+         [&](size_t) { ImageOps::normalize(chw.data(), channels, static_cast<size_t>(width) * height, norm); }},
+        {"resize (full image -> output)", out_pixels,
+         [&](size_t) { ImageOps::resize(src, bytes.data(), size, size); }},
+        {"crop copy (center output)", out_pixels,
+         [&](size_t) { ImageOps::crop(src, center, bytes.data()); }},
+        {"flipHorizontal (full image)", src_pixels,
+         [&](size_t) { ImageOps::flipHorizontal(src, bytes.data()); }},
+        {"cropResizeToChw (half crop, flip, normalize)", out_pixels,
+         [&](size_t) { ImageOps::cropResizeToChw(src, half, size, size, true, out.data(), norm); }},
+    };
+    for (const auto& kernel : kernels) {
+        std::cout << std::endl << kernel.name << ":" << std::endl;
+        for (int level = 0; level <= static_cast<int>(detected); ++level) {
+            SimdLevel used = ImageOps::setSimdLevel(static_cast<SimdLevel>(level));
+            report(ImageOps::simdLevelName(used), timeIt(iterations, kernel.run), kernel.pixels);
+        }
+    }
+    ImageOps::setSimdLevel(detected);
+
+    // 完整预处理：每次迭代使用不同的随机裁剪区域和翻转
+    std::vector<CropRect> rects(64);
+    for (auto& rect : rects) {
+        rect = ImageOps::randomResizedCrop(width, height, rng);
+    }
+    std::vector<unsigned char> cropped(bytes.size());
+    std::vector<unsigned char> resized(static_cast<size_t>(size) * size * channels);
+    std::vector<unsigned char> flipped(resized.size());
+
+    std::cout << std::endl << "RandomResizedCrop + flip + normalize -> " << channels << "x" << size << "x" << size
+              << " float:" << std::endl;
+    double naive = timeIt(iterations, [&](size_t i) {
+        naivePipeline(image, rects[i % rects.size()], size, i % 2 == 1, out.data());
+    });
+    report("naive loop", naive, out_pixels);
+    double steps = timeIt(iterations, [&](size_t i) {
+        const CropRect& rect = rects[i % rects.size()];
+        ImageOps::crop(src, rect, cropped.data());
+        ImageView crop_view(cropped.data(), rect.width, rect.height, channels);
+        ImageOps::resize(crop_view, resized.data(), size, size);
+        ImageView resized_view(resized.data(), size, size, channels);
+        if (i % 2 == 1) {
+            ImageOps::flipHorizontal(resized_view, flipped.data());
+            resized_view = ImageView(flipped.data(), size, size, channels);
+        }
+        ImageOps::toChw(resized_view, out.data(), norm);
+    });
+    report("step by step", steps, out_pixels);
+    double fused = timeIt(iterations, [&](size_t i) {
+        ImageOps::cropResizeToChw(src, rects[i % rects.size()], size, size, i % 2 == 1, out.data(), norm);
+    });
+    report("fused", fused, out_pixels);
+    std::cout << "  fused speedup: " << std::setprecision(1) << naive / fused << "x over naive loop, "
+              << steps / fused << "x over step by step" << std::endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "storage.h"
+#include "file_io.h"
+#include "line_reader.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * 性能测试：流式行读取与整个文件读入字符串的吞吐量和内存占用对比
+ * 用法：bench_line_reader [文件路径] [文件大小(MB)] [窗口大小(MB)]
+ *
+ * 每种方式在单独的子进程中运行，以子进程的峰值RSS衡量内存占用；
+ * 每次运行前用POSIX_FADV_DONTNEED把测试文件逐出页缓存
+ */
+
+namespace fs = std::filesystem;
+
+// 生成测试文件：长度随机的JSON行（已存在且大小一致时复用）
+static void prepareFile(const std::string& path, size_t size) {
+    if (fs::exists(path) && fs::file_size(path) == size) {
+        return;
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create " + path);
+    }
+    std::mt19937_64 rng(42);
+    std::string line;
+    size_t written = 0;
+    for (size_t id = 0; written < size; ++id) {
+        line = "{\"id\": " + std::to_string(id) + ", \"text\": \"";
+        line.append(20 + rng() % 480, static_cast<char>('a' + id % 26));
+        line += "\"}\n";
+        if (written + line.size() > size) {
+            line.resize(size - written);
+            line.back() = '\n';
+        }
+        if (fwrite(line.data(), 1, line.size(), file) != line.size()) {
+            throw std::runtime_error("Failed to write " + path);
+        }
+        written += line.size();
+    }
+    fclose(file);
+}
+
+static void dropFromPageCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// 把整个文本切分为行，返回行数并累计字节数
+static size_t splitLines(std::string_view text, size_t& bytes) {
+    size_t lines = 0;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        bytes += line.size();
+        ++lines;
+        if (end == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(end + 1);
+    }
+    return lines;
+}
+
+struct Result {
+    double seconds;
+    size_t lines;
+    size_t bytes;
+    long peak_rss_kb;
+};
+
+// 在子进程中运行，避免前一种方式的内存峰值影响后一种方式
+template<class Count>
+static Result runIsolated(const std::string& path, Count count) {
+    dropFromPageCache(path);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        Result result{};
+        auto start = std::chrono::high_resolution_clock::now();
+        result.lines = count(result.bytes);
+        auto end = std::chrono::high_resolution_clock::now();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+    close(fds[1]);
+    Result result{};
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (got != static_cast<ssize_t>(sizeof(result)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error("benchmark child failed");
+    }
+    result.peak_rss_kb = usage.ru_maxrss;
+    return result;
+}
+
+static void report(const std::string& name, const Result& result) {
+    double mb = result.bytes / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(30) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << mb / result.seconds << " MB/s"
+              << std::setw(12) << result.lines << " lines"
+              << std::setw(10) << result.peak_rss_kb / 1024 << " MB peak RSS"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/hpdl_bench_lines.jsonl";
+    size_t size_mb = argc > 2 ? std::stoul(argv[2]) : 1024;
+    size_t window_mb = argc > 3 ? std::stoul(argv[3]) : 4;
+
+    std::cout << "=== Streaming line reader vs readTextFile (cold cache) ===" << std::endl;
+    std::cout << size_mb << " MB in " << path << ", window " << window_mb << " MB" << std::endl << std::endl;
+    prepareFile(path, size_mb * 1024 * 1024);
+
+    report("FileIO::readTextFile", runIsolated(path, [&](size_t& bytes) {
+        std::string text = FileIO::readTextFile(path);
+        return splitLines(text, bytes);
+    }));
+    report("LocalStorage::readTextFile", runIsolated(path, [&](size_t& bytes) {
+        LocalStorage storage;
+        std::string text = storage.readTextFile(path);
+        return splitLines(text, bytes);
+    }));
+    report("LineReader", runIsolated(path, [&](size_t& bytes) {
+        LocalStorage storage;
+        LineReader reader(path, &storage, window_mb << 20);
+        return reader.forEach([&bytes](std::string_view line) {
+            bytes += line.size();
+        });
+    }));
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "storage.h"
+#include "metadata_cache.h"
+#include "fake_s3_server.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdio>
+
+/**
+ * 性能测试：元数据缓存对每轮逐个查询文件大小的开销的影响
+ * 用法：bench_metadata_cache [本地文件数] [S3对象数] [S3请求延迟ms]
+ *
+ * 1. 本地存储：每轮对每个文件调用一次getFileSize()，共3轮
+ * 2. 本地S3替身：同样的查询，以及先用prefetchMetadata()并行查询整个数据集
+ */
+
+namespace fs = std::filesystem;
+
+static const char* kAccessKey = "AKIDBENCHMARK";
+static const char* kSecretKey = "bench-secret-key";
+static const size_t kEpochs = 3;
+
+static std::vector<std::string> prepareFiles(const std::string& dir, size_t count) {
+    fs::create_directories(dir);
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < count; ++i) {
+        std::string path = dir + "/" + std::to_string(i) + ".bin";
+        if (!fs::exists(path)) {
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file) {
+                throw std::runtime_error("Failed to write " + path);
+            }
+            fputs("sample", file);
+            fclose(file);
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// 逐轮查询所有文件的大小，返回每轮的耗时（毫秒）
+static std::vector<double> queryEpochs(Storage& storage, const std::vector<std::string>& paths) {
+    std::vector<double> times;
+    for (size_t epoch = 0; epoch < kEpochs; ++epoch) {
+        auto start = std::chrono::steady_clock::now();
+        size_t total = 0;
+        for (const auto& path : paths) {
+            total += storage.getFileSize(path);
+        }
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (total == 0) {
+            throw std::runtime_error("Unexpected empty dataset");
+        }
+    }
+    return times;
+}
+
+static void report(const char* label, const std::vector<double>& times, const MetadataCachingStorage* cache) {
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1);
+    for (double time : times) {
+        std::cout << std::setw(10) << time;
+    }
+    if (cache) {
+        std::cout << std::setw(10) << std::setprecision(3) << cache->stats().hitRate();
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t local_count = argc > 1 ? std::stoul(argv[1]) : 50000;
+    size_t s3_count = argc > 2 ? std::stoul(argv[2]) : 1000;
+    int latency_ms = argc > 3 ? std::stoi(argv[3]) : 2;
+
+    std::cout << "=== getFileSize() per sample, " << kEpochs << " epochs (ms per epoch, hit rate) ===" << std::endl;
+
+    // 1. 本地存储
+    {
+        std::vector<std::string> paths = prepareFiles("/tmp/hpdl_bench_metadata", local_count);
+        std::cout << std::endl << "Local storage, " << local_count << " files:" << std::endl;
+
+        LocalStorage local;
+        report("uncached", queryEpochs(local, paths), nullptr);
+
+        MetadataCachingStorage cached(std::make_unique<LocalStorage>());
+        report("cached", queryEpochs(cached, paths), &cached);
+    }
+
+    // 2. 本地S3替身
+    {
+        FakeS3Server::Options options;
+        options.bucket = "bench";
+        options.access_key = kAccessKey;
+        options.secret_key = kSecretKey;
+        options.latency_ms = latency_ms;
+        FakeS3Server server(options);
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < s3_count; ++i) {
+            server.putObject("meta/" + std::to_string(i), "sample");
+            paths.push_back("s3://bench/meta/" + std::to_string(i));
+        }
+        server.start();
+
+        S3Config config;
+        config.endpoint = server.endpoint();
+        config.path_style = true;
+        config.access_key = kAccessKey;
+        config.secret_key = kSecretKey;
+        std::cout << std::endl << "Fake S3 (" << latency_ms << " ms per request), " << s3_count << " objects:"
+                  << std::endl;
+
+        auto s3 = StorageFactory::createS3Storage("bench", config);
+        if (!s3->connect()) {
+            throw std::runtime_error("Failed to connect to " + server.endpoint());
+        }
+        report("uncached", queryEpochs(*s3, paths), nullptr);
+
+        MetadataCachingStorage cached(StorageFactory::createS3Storage("bench", config));
+        static_cast<S3Storage&>(cached.inner()).connect();
+        report("cached", queryEpochs(cached, paths), &cached);
+
+        MetadataCachingStorage prefetched(StorageFactory::createS3Storage("bench", config));
+        static_cast<S3Storage&>(prefetched.inner()).connect();
+        auto start = std::chrono::steady_clock::now();
+        prefetched.prefetchMetadata(paths, 32);
+        double prefetch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        report("prefetchMetadata(32)", queryEpochs(prefetched, paths), &prefetched);
+        std::cout << "  (prefetchMetadata took " << std::fixed << std::setprecision(1) << prefetch_ms << " ms)"
+                  << std::endl;
+    }
+    return 0;
+}
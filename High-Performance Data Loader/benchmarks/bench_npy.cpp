@@ -0,0 +1,123 @@
+#include "npy.h"
+#include "file_io.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * 性能测试：NPY特征文件的读取方式对比
+ * 用法：bench_npy [文件路径] [行数] [每行元素数] [抽取的行数]
+ *
+ * 测试文件是形状{行数, 每行元素数}的float32数组，每种方式运行前用POSIX_FADV_DONTNEED把文件逐出页缓存：
+ * 1. 整个文件：readFile读入vector后复制到张量，与映射为张量视图后遍历全部元素
+ * 2. 随机抽取少量行（模拟打乱后的一个批次）：读入整个文件后复制这些行，与NpyDataset按行取视图；
+ *    映射只读入被访问行所在的页面
+ */
+
+namespace fs = std::filesystem;
+
+static void dropFromPageCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static double timeCold(const std::string& path, const std::function<void()>& fn) {
+    dropFromPageCache(path);
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static float sum(const float* data, size_t count) {
+    float total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+static void report(const std::string& label, double seconds, double checksum) {
+    std::cout << "  " << std::left << std::setw(34) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2) << seconds * 1e3 << " ms   (checksum " << std::setprecision(0) << checksum
+              << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "bench_features.npy";
+    size_t rows = argc > 2 ? std::stoul(argv[2]) : 65536;
+    size_t dim = argc > 3 ? std::stoul(argv[3]) : 1024;
+    size_t picks = argc > 4 ? std::stoul(argv[4]) : 256;
+
+    const TensorData::Shape shape = {static_cast<int64_t>(rows), static_cast<int64_t>(dim)};
+    const size_t expected = NpyFormat::makeHeader(DType::Float32, shape).size() + rows * dim * sizeof(float);
+    if (!fs::exists(path) || fs::file_size(path) != expected) {
+        TensorData features(DType::Float32, shape);
+        float* data = features.getDataAs<float>();
+        for (size_t i = 0; i < rows * dim; ++i) {
+            data[i] = static_cast<float>(i % 7);
+        }
+        NpyFormat::save(path, features);
+    }
+    std::cout << "=== " << path << ": float32" << TensorData::shapeString(shape) << ", "
+              << expected / (1 << 20) << " MB ===" << std::endl;
+
+    std::cout << std::endl << "Whole file:" << std::endl;
+    double checksum = 0;
+    double copy_time = timeCold(path, [&] {
+        std::vector<unsigned char> bytes = FileIO::readFile(path);
+        NpyHeader header = NpyFormat::parseHeader(bytes.data(), bytes.size());
+        TensorData tensor = TensorData::copyOf(reinterpret_cast<const float*>(bytes.data() + header.data_offset),
+                                               header.shape);
+        checksum = sum(tensor.getDataAs<float>(), tensor.getNumElements());
+    });
+    report("readFile + copy + sum", copy_time, checksum);
+    double view_time = timeCold(path, [&] {
+        const TensorData tensor = NpyFormat::load(path, AccessAdvice::Sequential);
+        checksum = sum(tensor.getDataAs<float>(), tensor.getNumElements());
+    });
+    report("mapped view + sum", view_time, checksum);
+
+    std::mt19937_64 rng(42);
+    std::vector<size_t> indices(picks);
+    for (auto& index : indices) {
+        index = rng() % rows;
+    }
+
+    std::cout << std::endl << picks << " random rows:" << std::endl;
+    copy_time = timeCold(path, [&] {
+        std::vector<unsigned char> bytes = FileIO::readFile(path);
+        NpyHeader header = NpyFormat::parseHeader(bytes.data(), bytes.size());
+        const float* data = reinterpret_cast<const float*>(bytes.data() + header.data_offset);
+        checksum = 0;
+        for (size_t index : indices) {
+            TensorData row = TensorData::copyOf(data + index * dim, {static_cast<int64_t>(dim)});
+            checksum += sum(row.getDataAs<float>(), dim);
+        }
+    });
+    report("readFile + copy rows + sum", copy_time, checksum);
+    view_time = timeCold(path, [&] {
+        NpyDataset dataset;
+        dataset.addFile(path);
+        checksum = 0;
+        for (size_t index : indices) {
+            const TensorData row = dataset.row(index);
+            checksum += sum(row.getDataAs<float>(), dim);
+        }
+    });
+    report("NpyDataset row views + sum", view_time, checksum);
+    std::cout << "  speedup: " << std::setprecision(1) << copy_time / view_time << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "philox.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include <functional>
+
+/**
+ * 性能测试：预处理线程中随机数据增强的随机数来源对比
+ * 用法：bench_rng [样本数] [每个样本的随机数个数] [线程数]
+ *
+ * 模拟每个样本抽取若干个随机数（裁剪位置、翻转、颜色抖动等），在线程池上并行处理全部样本：
+ * 1. rand()：glibc内部加锁，结果与调度有关
+ * 2. 共享的std::mt19937_64加互斥锁：线程之间串行化，结果与调度有关
+ * 3. 每个样本用(种子, 轮次, 索引)构造std::mt19937_64：可复现，但每个样本都要初始化312个字的状态
+ * 4. 每个样本构造PhiloxRng：可复现，构造只设置计数器和密钥
+ * 每种方式输出全部随机数之和作为校验值，可复现的方式在不同线程数下校验值相同
+ */
+
+static void report(const std::string& label, double seconds, size_t samples, uint64_t checksum) {
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::setw(9) << std::fixed
+              << std::setprecision(2) << seconds * 1e3 << " ms  " << std::setw(8) << std::setprecision(1)
+              << static_cast<double>(samples) / seconds / 1e6 << " M samples/s   (checksum " << checksum << ")"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t draws = argc > 2 ? std::stoul(argv[2]) : 8;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : 4;
+
+    ThreadPool pool(threads);
+    const uint64_t seed = 42;
+    const size_t epoch = 3;
+    std::cout << "=== " << samples << " samples, " << draws << " draws per sample, " << threads
+              << " threads ===" << std::endl;
+
+    auto run = [&](const std::string& label, const std::function<uint64_t(size_t)>& sample) {
+        std::vector<uint64_t> sums(samples);
+        auto start = std::chrono::high_resolution_clock::now();
+        pool.parallel_for(0, samples, 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                sums[i] = sample(i);
+            }
+        });
+        auto end = std::chrono::high_resolution_clock::now();
+        uint64_t checksum = 0;
+        for (uint64_t sum : sums) {
+            checksum += sum;
+        }
+        report(label, std::chrono::duration<double>(end - start).count(), samples, checksum);
+    };
+
+    std::srand(static_cast<unsigned>(seed));
+    run("rand()", [&](size_t) {
+        uint64_t sum = 0;
+        for (size_t d = 0; d < draws; ++d) {
+            sum += static_cast<uint64_t>(std::rand());
+        }
+        return sum;
+    });
+
+    std::mt19937_64 shared(seed);
+    std::mutex shared_mutex;
+    run("shared mt19937_64 + mutex", [&](size_t) {
+        uint64_t sum = 0;
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        for (size_t d = 0; d < draws; ++d) {
+            sum += shared() >> 32;
+        }
+        return sum;
+    });
+
+    run("per-sample mt19937_64 (seed_seq)", [&](size_t index) {
+        std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(epoch), static_cast<uint32_t>(index),
+                          static_cast<uint32_t>(static_cast<uint64_t>(index) >> 32)};
+        std::mt19937_64 rng(seq);
+        uint64_t sum = 0;
+        for (size_t d = 0; d < draws; ++d) {
+            sum += rng() >> 32;
+        }
+        return sum;
+    });
+
+    run("per-sample PhiloxRng", [&](size_t index) {
+        PhiloxRng rng(seed, index, static_cast<uint32_t>(epoch));
+        uint64_t sum = 0;
+        for (size_t d = 0; d < draws; ++d) {
+            sum += rng();
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "storage.h"
+#include "fake_s3_server.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstring>
+
+/**
+ * 性能测试：S3Storage对本地S3替身的读取吞吐量
+ * 用法：bench_s3 [大对象大小(MB)] [每连接带宽(MB/s)] [请求延迟(ms)]
+ *
+ * 替身服务器按连接限速并为每个请求加上固定延迟，模拟S3单连接带宽有限、首字节延迟高的特点：
+ * 1. 大对象：分段并发数和分段大小对单个对象读取吞吐量的影响
+ * 2. 小对象：多线程读取大量小对象时，连接复用与每个请求新建连接（含握手延迟）的对比
+ */
+
+static const char* kAccessKey = "AKIDBENCHMARK";
+static const char* kSecretKey = "bench-secret-key";
+
+static std::unique_ptr<S3Storage> makeStorage(const FakeS3Server& server, size_t part_size, size_t concurrency) {
+    S3Config config;
+    config.endpoint = server.endpoint();
+    config.path_style = true;
+    config.access_key = kAccessKey;
+    config.secret_key = kSecretKey;
+    config.part_size = part_size;
+    config.max_concurrency = concurrency;
+    auto storage = std::make_unique<S3Storage>("bench", config);
+    if (!storage->connect()) {
+        throw std::runtime_error("Failed to connect to " + server.endpoint());
+    }
+    return storage;
+}
+
+static void benchLargeObject(FakeS3Server& server, const std::string& expected, size_t part_mb, size_t concurrency) {
+    auto storage = makeStorage(server, part_mb << 20, concurrency);
+    server.resetStats();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    PooledBuffer data = storage->readFilePooled("s3://bench/large.bin");
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    if (data.size() != expected.size() || memcmp(data.data(), expected.data(), expected.size()) != 0) {
+        throw std::runtime_error("Data mismatch reading large.bin");
+    }
+    FakeS3Server::Stats stats = server.stats();
+    std::cout << "  part " << std::setw(3) << part_mb << " MB, concurrency " << std::setw(2) << concurrency
+              << std::setw(10) << std::fixed << std::setprecision(1) << expected.size() / (1024.0 * 1024.0) / seconds
+              << " MB/s" << std::setw(8) << stats.requests << " requests" << std::setw(6) << stats.connections
+              << " connections" << std::endl;
+}
+
+static void benchSmallObjects(FakeS3Server& server, size_t count, size_t threads, const char* label) {
+    auto storage = makeStorage(server, 8 << 20, 1);
+    server.resetStats();
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> bytes{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                bytes += storage->readFilePooled("s3://bench/small/" + std::to_string(i) + ".bin").size();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    FakeS3Server::Stats stats = server.stats();
+    HttpClient::Stats client = storage->httpStats();
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(0) << count / seconds << " objects/s" << std::setw(10) << std::setprecision(1)
+              << bytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::setw(8) << stats.connections
+              << " connections" << std::setw(6) << client.retries << " retries" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t object_mb = argc > 1 ? std::stoul(argv[1]) : 256;
+    size_t bandwidth_mb = argc > 2 ? std::stoul(argv[2]) : 50;
+    int latency_ms = argc > 3 ? std::stoi(argv[3]) : 10;
+
+    FakeS3Server::Options options;
+    options.bucket = "bench";
+    options.access_key = kAccessKey;
+    options.secret_key = kSecretKey;
+    options.latency_ms = latency_ms;
+    options.bandwidth = bandwidth_mb << 20;
+
+    std::cout << "=== S3Storage against local fake S3 ===" << std::endl;
+    std::cout << "per-connection bandwidth " << bandwidth_mb << " MB/s, request latency " << latency_ms << " ms"
+              << std::endl << std::endl;
+
+    // 1. 大对象
+    {
+        FakeS3Server server(options);
+        std::string data(object_mb << 20, '\0');
+        std::mt19937_64 rng(42);
+        for (size_t i = 0; i + 8 <= data.size(); i += 8) {
+            uint64_t value = rng();
+            memcpy(&data[i], &value, 8);
+        }
+        server.putObject("large.bin", data);
+        server.start();
+
+        std::cout << "Large object (" << object_mb << " MB), readFilePooled:" << std::endl;
+        for (size_t concurrency : {1, 4, 8, 16}) {
+            benchLargeObject(server, data, 8, concurrency);
+        }
+        for (size_t part_mb : {2, 32}) {
+            benchLargeObject(server, data, part_mb, 8);
+        }
+    }
+
+    // 2. 小对象：每个新连接额外等待两个往返，模拟TCP和TLS握手
+    {
+        const size_t count = 2000;
+        const size_t threads = 16;
+        std::string data(32 * 1024, 'x');
+
+        std::cout << std::endl << count << " small objects (32 KB), " << threads << " threads:" << std::endl;
+        for (bool reuse : {true, false}) {
+            FakeS3Server::Options small_options = options;
+            small_options.connect_latency_ms = 2 * latency_ms;
+            small_options.keep_alive = reuse;
+            FakeS3Server server(small_options);
+            for (size_t i = 0; i < count; ++i) {
+                server.putObject("small/" + std::to_string(i) + ".bin", data);
+            }
+            server.start();
+            benchSmallObjects(server, count, threads, reuse ? "keep-alive" : "new connection each");
+        }
+    }
+
+    return 0;
+}
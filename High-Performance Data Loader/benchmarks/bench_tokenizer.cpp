@@ -0,0 +1,306 @@
+#include "tokenizer.h"
+#include "file_io.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+
+/**
+ * 性能测试：分词吞吐量（词元/秒）
+ * 用法：bench_tokenizer [语料文件] [语料大小MB] [线程数]
+ *
+ * 语料文件不存在时生成一个合成语料（词频服从Zipf分布的英文式文本，每行一个文档）；
+ * WordPiece词表和BPE合并规则都从语料的前4MB训练得到，不需要外部的词表文件。
+ * 1. 预切分在标量、SSE4.1、AVX2、AVX-512实现下的吞吐量
+ * 2. WordPiece和字节级BPE在关闭和开启单词缓存时的单线程吞吐量
+ * 3. 多个线程共享一个分词器时的吞吐量
+ */
+
+namespace fs = std::filesystem;
+
+static void prepareCorpus(const std::string& path, size_t size) {
+    if (fs::exists(path)) {
+        return;
+    }
+    std::mt19937_64 rng(42);
+    const char* syllables[] = {"ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo", "ze", "an", "ber", "con",
+                               "dis", "ing", "tion", "ly", "pre", "ment", "est", "er", "qu", "th", "str", "ou"};
+    std::vector<std::string> words(30000);
+    for (auto& word : words) {
+        size_t count = 1 + rng() % 4;
+        for (size_t i = 0; i < count; ++i) {
+            word += syllables[rng() % (sizeof(syllables) / sizeof(syllables[0]))];
+        }
+    }
+    // Zipf分布：第k个词的概率与1/k成正比
+    std::vector<double> weights(words.size());
+    for (size_t k = 0; k < words.size(); ++k) {
+        weights[k] = 1.0 / static_cast<double>(k + 1);
+    }
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    const char* punctuation[] = {",", ".", "!", "?", ";"};
+
+    std::string text;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create " + path);
+    }
+    size_t written = 0;
+    while (written < size) {
+        text.clear();
+        size_t sentences = 1 + rng() % 6;
+        for (size_t s = 0; s < sentences; ++s) {
+            size_t length = 4 + rng() % 20;
+            for (size_t i = 0; i < length; ++i) {
+                std::string word = words[pick(rng)];
+                if (i == 0) {
+                    word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                }
+                text += word;
+                text += i + 1 < length ? (rng() % 10 == 0 ? ", " : " ") : punctuation[rng() % 5];
+            }
+            text += ' ';
+        }
+        text.back() = '\n';
+        fwrite(text.data(), 1, text.size(), file);
+        written += text.size();
+    }
+    fclose(file);
+}
+
+static std::vector<std::string_view> splitLines(const std::string& text) {
+    std::vector<std::string_view> lines;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        lines.emplace_back(text.data() + begin, end - begin);
+        begin = end + 1;
+    }
+    return lines;
+}
+
+// 统计预切分后的单词频率，键为单词（前面有空格时加上'Ġ'对应的字节）
+static std::vector<std::pair<std::string, size_t>> countWords(std::string_view text, bool mark_space) {
+    std::vector<PreTokenizer::Piece> pieces;
+    PreTokenizer::split(text, pieces);
+    std::unordered_map<std::string, size_t> counts;
+    for (const auto& piece : pieces) {
+        std::string word(text.substr(piece.offset, piece.length));
+        if (mark_space && piece.space_before) {
+            word.insert(word.begin(), ' ');
+        }
+        ++counts[word];
+    }
+    std::vector<std::pair<std::string, size_t>> sorted(counts.begin(), counts.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return sorted;
+}
+
+// WordPiece词表：所有字节、高频完整单词和高频词尾
+static std::unique_ptr<Tokenizer> trainWordPiece(std::string_view sample) {
+    std::vector<std::string> vocab = {"[PAD]", "[UNK]", "[CLS]", "[SEP]"};
+    for (int c = 33; c < 127; ++c) {
+        vocab.push_back(std::string(1, static_cast<char>(c)));
+        vocab.push_back("##" + std::string(1, static_cast<char>(c)));
+    }
+    auto words = countWords(sample, false);
+    std::unordered_map<std::string, size_t> suffixes;
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i < 6000) {
+            if (words[i].first.size() > 1) {
+                vocab.push_back(words[i].first);
+            }
+        } else {
+            for (size_t length = 2; length <= 5 && length < words[i].first.size(); ++length) {
+                suffixes[words[i].first.substr(words[i].first.size() - length)] += words[i].second;
+                suffixes[words[i].first.substr(0, length)] += words[i].second;
+            }
+        }
+    }
+    std::vector<std::pair<std::string, size_t>> pieces(suffixes.begin(), suffixes.end());
+    std::sort(pieces.begin(), pieces.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    for (size_t i = 0; i < std::min<size_t>(pieces.size(), 4000); ++i) {
+        vocab.push_back("##" + pieces[i].first);
+        vocab.push_back(pieces[i].first);
+    }
+    std::sort(vocab.begin() + 4, vocab.end());
+    vocab.erase(std::unique(vocab.begin() + 4, vocab.end()), vocab.end());
+    TokenizerOptions options;
+    options.lowercase = true;
+    return std::make_unique<WordPieceTokenizer>(std::move(vocab), options);
+}
+
+// 字节级BPE：在高频单词上按相邻符号对的频率贪心训练
+static std::unique_ptr<Tokenizer> trainBpe(std::string_view sample, size_t num_merges, size_t cache_words) {
+    std::vector<std::string> vocab;
+    std::unordered_map<std::string, int32_t> ids;
+    auto idOf = [&](const std::string& token) {
+        auto it = ids.find(token);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        ids.emplace(token, static_cast<int32_t>(vocab.size()));
+        vocab.push_back(token);
+        return static_cast<int32_t>(vocab.size() - 1);
+    };
+    for (int byte = 0; byte < 256; ++byte) {
+        idOf(BpeTokenizer::byteSymbol(static_cast<unsigned char>(byte)));
+    }
+
+    auto counted = countWords(sample, true);
+    counted.resize(std::min<size_t>(counted.size(), 8000));
+    std::vector<std::vector<int32_t>> words;
+    std::vector<size_t> freqs;
+    for (const auto& entry : counted) {
+        std::vector<int32_t> symbols;
+        for (char c : entry.first) {
+            symbols.push_back(idOf(BpeTokenizer::byteSymbol(static_cast<unsigned char>(c))));
+        }
+        words.push_back(std::move(symbols));
+        freqs.push_back(entry.second);
+    }
+
+    std::vector<std::pair<std::string, std::string>> merges;
+    for (size_t m = 0; m < num_merges; ++m) {
+        std::unordered_map<uint64_t, size_t> pairs;
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (size_t i = 0; i + 1 < words[w].size(); ++i) {
+                pairs[static_cast<uint64_t>(words[w][i]) << 32 | static_cast<uint32_t>(words[w][i + 1])] += freqs[w];
+            }
+        }
+        if (pairs.empty()) {
+            break;
+        }
+        auto best = std::max_element(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second < b.second : a.first > b.first;
+        });
+        int32_t left = static_cast<int32_t>(best->first >> 32);
+        int32_t right = static_cast<int32_t>(best->first & 0xFFFFFFFF);
+        merges.emplace_back(vocab[left], vocab[right]);
+        int32_t merged = idOf(vocab[left] + vocab[right]);
+        for (auto& symbols : words) {
+            for (size_t i = 0; i + 1 < symbols.size(); ++i) {
+                if (symbols[i] == left && symbols[i + 1] == right) {
+                    symbols[i] = merged;
+                    symbols.erase(symbols.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+                }
+            }
+        }
+    }
+    TokenizerOptions options;
+    options.cache_words = cache_words;
+    return std::make_unique<BpeTokenizer>(std::move(vocab), merges, options);
+}
+
+// 在threads个线程上编码所有行，返回秒数并输出词元总数
+static double encodeAll(const Tokenizer& tokenizer, const std::vector<std::string_view>& lines, size_t threads,
+                        size_t& tokens) {
+    std::vector<size_t> counts(threads, 0);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::vector<int32_t> ids;
+            for (size_t i = t; i < lines.size(); i += threads) {
+                ids.clear();
+                tokenizer.encode(lines[i], ids);
+                counts[t] += ids.size();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    tokens = 0;
+    for (size_t count : counts) {
+        tokens += count;
+    }
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void report(const std::string& label, double seconds, double bytes, size_t tokens) {
+    std::cout << "  " << std::left << std::setw(26) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << bytes / seconds / (1 << 20) << " MB/s";
+    if (tokens > 0) {
+        std::cout << std::setw(9) << tokens / seconds / 1e6 << " M tokens/s";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "bench_corpus.txt";
+    size_t size_mb = argc > 2 ? std::stoul(argv[2]) : 64;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : std::max(2u, std::thread::hardware_concurrency());
+
+    prepareCorpus(path, size_mb << 20);
+    const std::string corpus = FileIO::readTextFile(path);
+    const std::vector<std::string_view> lines = splitLines(corpus);
+    const double bytes = static_cast<double>(corpus.size());
+    const std::string_view sample(corpus.data(), std::min<size_t>(corpus.size(), 4 << 20));
+    std::cout << "=== " << path << ": " << corpus.size() / (1 << 20) << " MB, " << lines.size() << " lines ==="
+              << std::endl;
+
+    std::cout << std::endl << "Pre-tokenization:" << std::endl;
+    const SimdLevel best = PreTokenizer::simdLevel();
+    std::vector<PreTokenizer::Piece> pieces;
+    for (int level = 0; level <= static_cast<int>(best); ++level) {
+        SimdLevel used = PreTokenizer::setSimdLevel(static_cast<SimdLevel>(level));
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t count = 0;
+        for (auto line : lines) {
+            pieces.clear();
+            PreTokenizer::split(line, pieces);
+            count += pieces.size();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        report(ImageOps::simdLevelName(used), std::chrono::duration<double>(end - start).count(), bytes, count);
+    }
+    PreTokenizer::setSimdLevel(best);
+
+    auto wordpiece = trainWordPiece(sample);
+    auto bpe = trainBpe(sample, 2000, 0);
+    auto bpe_cached = trainBpe(sample, 2000, TokenizerOptions().cache_words);
+    TokenizerOptions uncached;
+    uncached.lowercase = true;
+    uncached.cache_words = 0;
+    std::vector<std::string> wordpiece_vocab;
+    for (size_t id = 0; id < wordpiece->vocabSize(); ++id) {
+        wordpiece_vocab.push_back(wordpiece->idToToken(static_cast<int32_t>(id)));
+    }
+    WordPieceTokenizer wordpiece_uncached(wordpiece_vocab, uncached);
+    std::cout << std::endl << "Encoding, 1 thread (WordPiece vocab " << wordpiece->vocabSize() << ", BPE vocab "
+              << bpe->vocabSize() << "):" << std::endl;
+
+    size_t tokens = 0;
+    double seconds = encodeAll(wordpiece_uncached, lines, 1, tokens);
+    report("WordPiece, no cache", seconds, bytes, tokens);
+    seconds = encodeAll(*wordpiece, lines, 1, tokens);
+    report("WordPiece, word cache", seconds, bytes, tokens);
+    seconds = encodeAll(*bpe, lines, 1, tokens);
+    report("byte-level BPE, no cache", seconds, bytes, tokens);
+    double single = encodeAll(*bpe_cached, lines, 1, tokens);
+    report("byte-level BPE, word cache", single, bytes, tokens);
+
+    std::cout << std::endl << "Encoding, " << threads << " threads sharing one tokenizer:" << std::endl;
+    seconds = encodeAll(*wordpiece, lines, threads, tokens);
+    report("WordPiece, word cache", seconds, bytes, tokens);
+    seconds = encodeAll(*bpe_cached, lines, threads, tokens);
+    report("byte-level BPE, word cache", seconds, bytes, tokens);
+    std::cout << "  BPE scaling: " << std::setprecision(2) << single / seconds << "x on " << threads << " threads"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,589 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/**
+ * 缓冲池 - 按大小分级复用样本数据的内存
+ * 每个样本都要分配读取缓冲区、像素数据和数据项对象本身，并在消费后释放；
+ * 高负载下malloc/free会成为热点，长时间运行后内存碎片也会使RSS持续增长。
+ * 缓冲池把请求大小向上取整到大小等级（每个2的幂之间分4级，浪费不超过25%），
+ * 释放的缓冲区按等级缓存起来供后续分配复用：
+ * - 线程本地缓存：同一线程上的分配和释放不需要加锁
+ * - 全局缓存：跨线程流动的缓冲区（例如加载线程分配、消费线程释放）经由全局缓存复用
+ * 超过kMaxPooledSize的请求直接向系统申请，不做缓存
+ */
+class BufferPool {
+public:
+    // 缓冲区的对齐单位，满足SIMD指令的对齐要求
+    static constexpr size_t kAlignment = 64;
+
+    // 最小的大小等级
+    static constexpr size_t kMinSize = 64;
+
+    // 参与缓存的最大缓冲区大小
+    static constexpr size_t kMaxPooledSize = size_t(64) << 20;
+
+    // 每个线程本地缓存中单个等级的容量上限（按字节和按个数）；
+    // 大缓冲区通常在加载线程分配、在消费线程释放，只在本地缓存少量，其余经由全局缓存流回加载线程
+    static constexpr size_t kThreadCacheBytes = size_t(2) << 20;
+    static constexpr size_t kThreadCacheCount = 64;
+
+    /**
+     * 缓冲池统计信息
+     */
+    struct Stats {
+        uint64_t allocations = 0;         // 分配次数
+        uint64_t reused = 0;              // 其中由缓存的缓冲区满足的次数
+        uint64_t thread_cache_hits = 0;   // 其中由线程本地缓存满足的次数
+        uint64_t system_allocations = 0;  // 向系统申请内存的次数
+        uint64_t system_frees = 0;        // 把内存归还给系统的次数
+        size_t buffers_in_use = 0;        // 正在使用的缓冲区数量
+        size_t bytes_in_use = 0;          // 正在使用的字节数（按等级大小计）
+        size_t buffers_cached = 0;        // 缓存中的空闲缓冲区数量
+        size_t bytes_cached = 0;          // 缓存中的空闲字节数
+
+        /**
+         * 复用率
+         * @return 由缓存满足的分配所占的比例
+         */
+        double reuseRate() const {
+            return allocations ? static_cast<double>(reused) / allocations : 0.0;
+        }
+    };
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * 进程级共享缓冲池
+     * 有意不析构：线程退出时需要把线程本地缓存归还到缓冲池，此时静态对象可能已被销毁
+     */
+    static BufferPool& shared() {
+        static BufferPool* pool = new BufferPool();
+        return *pool;
+    }
+
+    /**
+     * 分配内存
+     * @param size 请求大小
+     * @return 按kAlignment对齐、至少classSize(size)字节的内存
+     */
+    void* allocate(size_t size) {
+        size_t capacity = classSize(size);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        buffers_in_use_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_add(capacity, std::memory_order_relaxed);
+
+        if (capacity <= kMaxPooledSize) {
+            size_t index = classIndex(size);
+
+            std::vector<void*>& local = threadCache().lists[index];
+            if (!local.empty()) {
+                void* ptr = local.back();
+                local.pop_back();
+                thread_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+                takeFromCache(capacity);
+                return ptr;
+            }
+
+            Bin& bin = bins_[index];
+            {
+                std::lock_guard<std::mutex> lock(bin.mutex);
+                if (!bin.free.empty()) {
+                    void* ptr = bin.free.back();
+                    bin.free.pop_back();
+                    global_cached_bytes_ -= capacity;
+                    takeFromCache(capacity);
+                    return ptr;
+                }
+            }
+        }
+
+        system_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return allocateAligned(capacity);
+    }
+
+    /**
+     * 释放内存，缓冲区进入缓存以便复用
+     * @param ptr allocate()返回的指针，可以为空
+     * @param size 分配时的请求大小（或同一等级内的任意大小，例如classSize()的结果）
+     */
+    void deallocate(void* ptr, size_t size) {
+        if (!ptr) {
+            return;
+        }
+        size_t capacity = classSize(size);
+        buffers_in_use_.fetch_sub(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(capacity, std::memory_order_relaxed);
+
+        if (capacity <= kMaxPooledSize) {
+            size_t index = classIndex(size);
+
+            std::vector<void*>& local = threadCache().lists[index];
+            if (local.size() < threadCacheLimit(capacity)) {
+                local.push_back(ptr);
+                putIntoCache(capacity);
+                return;
+            }
+
+            Bin& bin = bins_[index];
+            {
+                std::lock_guard<std::mutex> lock(bin.mutex);
+                if (global_cached_bytes_ + capacity <= max_cached_bytes_) {
+                    bin.free.push_back(ptr);
+                    global_cached_bytes_ += capacity;
+                    putIntoCache(capacity);
+                    return;
+                }
+            }
+        }
+
+        system_frees_.fetch_add(1, std::memory_order_relaxed);
+        freeAligned(ptr);
+    }
+
+    /**
+     * 设置全局缓存的容量上限，超出部分在释放时直接归还给系统
+     * @param bytes 上限（字节）
+     */
+    void setMaxCachedBytes(size_t bytes) {
+        max_cached_bytes_ = bytes;
+    }
+
+    /**
+     * 把全局缓存中的空闲缓冲区全部归还给系统
+     * 线程本地缓存不受影响，可以在各线程上调用flushThreadCache()
+     * @return 归还的字节数
+     */
+    size_t trim() {
+        size_t released = 0;
+        for (size_t index = 0; index < kNumClasses; ++index) {
+            size_t capacity = classSizeAt(index);
+            std::vector<void*> free_list;
+            {
+                std::lock_guard<std::mutex> lock(bins_[index].mutex);
+                free_list.swap(bins_[index].free);
+                global_cached_bytes_ -= free_list.size() * capacity;
+            }
+            for (void* ptr : free_list) {
+                takeFromCache(capacity);
+                system_frees_.fetch_add(1, std::memory_order_relaxed);
+                freeAligned(ptr);
+                released += capacity;
+            }
+        }
+        return released;
+    }
+
+    /**
+     * 把当前线程的本地缓存归还到全局缓存
+     * 线程退出时会自动调用
+     */
+    void flushThreadCache() {
+        flush(threadCache());
+    }
+
+    /**
+     * 获取统计信息
+     * 各项计数分别读取，并发分配时彼此之间可能略有偏差
+     */
+    Stats stats() const {
+        Stats stats;
+        stats.allocations = allocations_.load(std::memory_order_relaxed);
+        stats.thread_cache_hits = thread_cache_hits_.load(std::memory_order_relaxed);
+        stats.system_allocations = system_allocations_.load(std::memory_order_relaxed);
+        stats.reused = stats.allocations > stats.system_allocations
+                     ? stats.allocations - stats.system_allocations : 0;
+        stats.system_frees = system_frees_.load(std::memory_order_relaxed);
+        stats.buffers_in_use = buffers_in_use_.load(std::memory_order_relaxed);
+        stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+        stats.buffers_cached = buffers_cached_.load(std::memory_order_relaxed);
+        stats.bytes_cached = bytes_cached_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * 获取请求大小对应的等级大小（即实际分配的容量）
+     * @param size 请求大小
+     * @return 等级大小，超过kMaxPooledSize时按kAlignment取整
+     */
+    static size_t classSize(size_t size) {
+        if (size > kMaxPooledSize) {
+            return (size + kAlignment - 1) / kAlignment * kAlignment;
+        }
+        return classSizeAt(classIndex(size));
+    }
+
+private:
+    // 大小等级：kMinSize，之后每个2的幂之间分4级，直到kMaxPooledSize
+    static size_t classIndex(size_t size) {
+        if (size <= kMinSize) {
+            return 0;
+        }
+        size_t n = size - 1;
+        size_t bit = highestBit(n);
+        size_t sub = (n >> (bit - 2)) & 3;
+        return (bit - kMinShift) * 4 + sub + 1;
+    }
+
+    static size_t classSizeAt(size_t index) {
+        if (index == 0) {
+            return kMinSize;
+        }
+        size_t bit = (index - 1) / 4 + kMinShift;
+        size_t sub = (index - 1) % 4;
+        return (4 + sub + 1) << (bit - 2);
+    }
+
+    static size_t highestBit(size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return sizeof(unsigned long long) * 8 - 1 - static_cast<size_t>(__builtin_clzll(value));
+#else
+        size_t bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    static size_t threadCacheLimit(size_t capacity) {
+        return std::min(kThreadCacheCount, kThreadCacheBytes / capacity);
+    }
+
+    static constexpr size_t kMinShift = 6;
+    static constexpr size_t kNumClasses = (26 - kMinShift) * 4 + 1;
+    static_assert(kMinSize == size_t(1) << kMinShift, "kMinSize must match kMinShift");
+    static_assert(kMaxPooledSize == size_t(1) << 26, "kNumClasses must match kMaxPooledSize");
+
+    // 线程本地缓存，线程退出时归还到全局缓存
+    struct ThreadCache {
+        std::vector<void*> lists[kNumClasses];
+
+        ~ThreadCache() {
+            BufferPool::shared().flush(*this);
+        }
+    };
+
+    // 一个大小等级的全局空闲列表
+    struct alignas(64) Bin {
+        std::mutex mutex;
+        std::vector<void*> free;
+    };
+
+    BufferPool() = default;
+
+    static ThreadCache& threadCache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    void flush(ThreadCache& cache) {
+        for (size_t index = 0; index < kNumClasses; ++index) {
+            std::vector<void*>& local = cache.lists[index];
+            if (local.empty()) {
+                continue;
+            }
+            size_t capacity = classSizeAt(index);
+            Bin& bin = bins_[index];
+            std::lock_guard<std::mutex> lock(bin.mutex);
+            for (void* ptr : local) {
+                if (global_cached_bytes_ + capacity <= max_cached_bytes_) {
+                    bin.free.push_back(ptr);
+                    global_cached_bytes_ += capacity;
+                } else {
+                    takeFromCache(capacity);
+                    system_frees_.fetch_add(1, std::memory_order_relaxed);
+                    freeAligned(ptr);
+                }
+            }
+            local.clear();
+        }
+    }
+
+    void putIntoCache(size_t capacity) {
+        buffers_cached_.fetch_add(1, std::memory_order_relaxed);
+        bytes_cached_.fetch_add(capacity, std::memory_order_relaxed);
+    }
+
+    void takeFromCache(size_t capacity) {
+        buffers_cached_.fetch_sub(1, std::memory_order_relaxed);
+        bytes_cached_.fetch_sub(capacity, std::memory_order_relaxed);
+    }
+
+    static void* allocateAligned(size_t size) {
+#ifdef _WIN32
+        void* ptr = _aligned_malloc(size, kAlignment);
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, kAlignment, size) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    static void freeAligned(void* ptr) {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+    Bin bins_[kNumClasses];
+
+    // 全局缓存的字节数及上限；global_cached_bytes_只在持有某个Bin的锁时修改
+    std::atomic<size_t> global_cached_bytes_{0};
+    std::atomic<size_t> max_cached_bytes_{size_t(1) << 30};
+
+    // 统计计数
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> thread_cache_hits_{0};
+    std::atomic<uint64_t> system_allocations_{0};
+    std::atomic<uint64_t> system_frees_{0};
+    std::atomic<size_t> buffers_in_use_{0};
+    std::atomic<size_t> bytes_in_use_{0};
+    std::atomic<size_t> buffers_cached_{0};
+    std::atomic<size_t> bytes_cached_{0};
+};
+
+/**
+ * 池化缓冲区 - 从共享缓冲池租用的字节缓冲区，析构时归还
+ * 可以代替std::vector<unsigned char>或std::unique_ptr<unsigned char[]>保存样本数据，
+ * 批次释放时其中的缓冲区即回到缓冲池，供后续样本复用
+ */
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+
+    /**
+     * 构造函数
+     * @param size 缓冲区大小，内容未初始化
+     */
+    explicit PooledBuffer(size_t size) {
+        if (size > 0) {
+            data_ = static_cast<unsigned char*>(BufferPool::shared().allocate(size));
+            size_ = size;
+            capacity_ = BufferPool::classSize(size);
+        }
+    }
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    PooledBuffer(PooledBuffer&& other) noexcept
+        : data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+    }
+
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.capacity_ = 0;
+        }
+        return *this;
+    }
+
+    ~PooledBuffer() {
+        reset();
+    }
+
+    /**
+     * 复制一段数据到新的池化缓冲区
+     * @param data 源数据
+     * @param size 数据大小
+     * @return 池化缓冲区
+     */
+    static PooledBuffer copyOf(const void* data, size_t size) {
+        PooledBuffer buffer(size);
+        if (size > 0) {
+            memcpy(buffer.data(), data, size);
+        }
+        return buffer;
+    }
+
+    unsigned char* data() { return data_; }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    unsigned char* begin() { return data_; }
+    unsigned char* end() { return data_ + size_; }
+    const unsigned char* begin() const { return data_; }
+    const unsigned char* end() const { return data_ + size_; }
+
+    unsigned char& operator[](size_t index) { return data_[index]; }
+    const unsigned char& operator[](size_t index) const { return data_[index]; }
+
+    /**
+     * 调整大小，保留原有内容
+     * 不超过容量时不会重新分配
+     * @param size 新的大小
+     */
+    void resize(size_t size) {
+        if (size <= capacity_) {
+            size_ = size;
+            return;
+        }
+        PooledBuffer larger(size);
+        if (size_ > 0) {
+            memcpy(larger.data(), data_, size_);
+        }
+        *this = std::move(larger);
+    }
+
+    /**
+     * 把缓冲区归还到缓冲池
+     */
+    void reset() {
+        if (data_) {
+            BufferPool::shared().deallocate(data_, capacity_);
+            data_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        }
+    }
+
+private:
+    unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+/**
+ * 内存竞技场 - 在池化的内存块上顺序分配，统一释放
+ * 适合大量生命周期相同的小对象，例如一个批次的文本切片或元数据：
+ * 分配只是移动指针，reset()或析构时所有内存块一起归还到缓冲池。
+ * 竞技场不是线程安全的，应当每个线程（或每个批次）使用各自的实例
+ */
+class Arena {
+public:
+    /**
+     * 构造函数
+     * @param block_size 每个内存块的大小，超过一半块大小的分配单独占用一个块
+     */
+    explicit Arena(size_t block_size = 64 * 1024) : block_size_(std::max<size_t>(block_size, BufferPool::kMinSize)) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    /**
+     * 分配内存
+     * @param size 大小
+     * @param alignment 对齐要求，必须是2的幂且不超过BufferPool::kAlignment
+     * @return 未初始化的内存，在reset()或竞技场析构前有效
+     */
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        if (alignment > BufferPool::kAlignment || (alignment & (alignment - 1)) != 0) {
+            throw std::invalid_argument("Unsupported arena alignment");
+        }
+
+        if (size > block_size_ / 2) {
+            // 大块单独分配，不打断当前块的顺序分配
+            large_blocks_.emplace_back(size);
+            bytes_used_ += size;
+            return large_blocks_.back().data();
+        }
+
+        size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (blocks_.empty() || offset + size > blocks_.back().size()) {
+            blocks_.emplace_back(block_size_);
+            offset = 0;
+        }
+        offset_ = offset + size;
+        bytes_used_ += size;
+        return blocks_.back().data() + offset;
+    }
+
+    /**
+     * 在竞技场中构造对象
+     * 竞技场不会调用析构函数，因此只允许平凡析构的类型
+     */
+    template<class T, class... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects must be trivially destructible");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * 复制字符串到竞技场
+     * @param text 源字符串
+     * @return 指向竞技场中副本的视图
+     */
+    std::string_view copyString(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        char* ptr = static_cast<char*>(allocate(text.size(), 1));
+        memcpy(ptr, text.data(), text.size());
+        return std::string_view(ptr, text.size());
+    }
+
+    /**
+     * 释放所有分配，内存块归还到缓冲池
+     */
+    void reset() {
+        blocks_.clear();
+        large_blocks_.clear();
+        offset_ = 0;
+        bytes_used_ = 0;
+    }
+
+    /**
+     * 已分配的字节数
+     */
+    size_t bytesUsed() const { return bytes_used_; }
+
+    /**
+     * 占用的内存块总字节数
+     */
+    size_t bytesReserved() const {
+        size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.capacity();
+        }
+        for (const auto& block : large_blocks_) {
+            total += block.capacity();
+        }
+        return total;
+    }
+
+private:
+    size_t block_size_;
+    std::vector<PooledBuffer> blocks_;
+    std::vector<PooledBuffer> large_blocks_;
+    size_t offset_ = 0;
+    size_t bytes_used_ = 0;
+};
+
+#endif // BUFFER_POOL_H
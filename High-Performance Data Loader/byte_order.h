@@ -0,0 +1,39 @@
+#ifndef BYTE_ORDER_H
+#define BYTE_ORDER_H
+
+#include <cstdint>
+
+/**
+ * 小端序编解码 - 用于分片、清单等二进制文件格式
+ * 逐字节组装，与主机字节序和对齐无关；在小端平台上编译器会将其优化为一次读写
+ */
+
+inline void putU32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline void putU64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline uint32_t getU32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+inline uint64_t getU64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+#endif // BYTE_ORDER_H
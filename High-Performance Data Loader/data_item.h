@@ -0,0 +1,35 @@
+#ifndef DATA_ITEM_H
+#define DATA_ITEM_H
+
+#include "buffer_pool.h"
+#include <memory>
+#include <cstddef>
+
+/**
+ * 数据项基类 - 所有可加载数据的抽象基类
+ */
+class DataItem {
+public:
+    virtual ~DataItem() = default;
+
+    /**
+     * 创建数据项的副本，DataLoader用它把数据项放入缓存以及从缓存中取出
+     * 副本与原数据项互不影响；引用只读数据（例如映射文件）时可以共享而不复制
+     * @return 副本，不支持拷贝的类型返回空，这类数据项不会被缓存
+     */
+    virtual std::unique_ptr<DataItem> clone() const {
+        return nullptr;
+    }
+
+    // 数据项对象本身也从缓冲池分配，避免每个样本一次malloc/free；
+    // 析构函数是虚函数，释放时传入的是实际类型的大小
+    static void* operator new(size_t size) {
+        return BufferPool::shared().allocate(size);
+    }
+
+    static void operator delete(void* ptr, size_t size) {
+        BufferPool::shared().deallocate(ptr, size);
+    }
+};
+
+#endif // DATA_ITEM_H
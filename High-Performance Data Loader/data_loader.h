@@ -4,8 +4,18 @@
 #include "thread_pool.h"
 #include "cache.h"
 #include "storage.h"
+#include "storage_router.h"
+#include "file_io.h"
+#include "buffer_pool.h"
+#include "sampler.h"
+#include "path_table.h"
+#include "data_item.h"
+#include "tensor.h"
+#include "philox.h"
 #include <vector>
 #include <queue>
+#include <deque>
+#include <map>
 #include <string>
 #include <mutex>
 #include <condition_variable>
@@ -14,47 +24,147 @@
 #include <atomic>
 #include <future>
 #include <optional>
-
-/**
- * 数据项基类 - 所有可加载数据的抽象基类
- */
-class DataItem {
-public:
-    virtual ~DataItem() = default;
-};
+#include <exception>
+#include <cstring>
+#include <algorithm>
 
 /**
  * 图像数据项 - 用于存储图像数据
+ * 图像是形状为{height, width, channels}的uint8张量（HWC布局），
+ * 像素数据可以由对象自己持有（普通内存或池化缓冲区），也可以是内存映射文件中的只读切片（零拷贝）
  */
-class ImageData : public DataItem {
+class ImageData : public TensorData {
 public:
     ImageData(int width, int height, int channels, std::unique_ptr<unsigned char[]> data)
-        : width_(width), height_(height), channels_(channels), data_(std::move(data)) {}
+        : ImageData(width, height, channels, std::shared_ptr<unsigned char[]>(std::move(data))) {}
+    
+    /**
+     * 构造持有池化缓冲区的图像，图像销毁（例如批次释放）时缓冲区回到缓冲池
+     * @param buffer 像素数据，大小至少为width * height * channels
+     */
+    ImageData(int width, int height, int channels, PooledBuffer buffer)
+        : TensorData(DType::UInt8, imageShape(width, height, channels), std::move(buffer)) {}
+    
+    /**
+     * 构造引用映射文件切片的图像，不复制像素数据
+     * @param view 像素数据所在的映射区间，大小至少为width * height * channels
+     */
+    ImageData(int width, int height, int channels, MappedBuffer view)
+        : TensorData(DType::UInt8, imageShape(width, height, channels), std::move(view)) {}
+    
+    /**
+     * 由形状为{height, width, channels}的连续uint8张量构造图像
+     * @throws std::invalid_argument 元素类型、维数或布局不符合时抛出
+     */
+    explicit ImageData(TensorData tensor) : TensorData(std::move(tensor)) {
+        if (getDType() != DType::UInt8 || getNumDims() != 3 || !isContiguous()) {
+            throw std::invalid_argument("ImageData requires a contiguous uint8 HWC tensor, got " +
+                                        std::string(dtypeName(getDType())) + shapeString(getShape()));
+        }
+    }
+    
+    int getWidth() const { return static_cast<int>(getShape()[1]); }
+    int getHeight() const { return static_cast<int>(getShape()[0]); }
+    int getChannels() const { return static_cast<int>(getShape()[2]); }
+    size_t getSize() const { return getByteSize(); }
+    
+    /**
+     * 获取可写的像素数据
+     * 如果当前引用的是只读映射，首次调用时会复制一份私有数据（写时复制）
+     */
+    unsigned char* getData() {
+        return static_cast<unsigned char*>(TensorData::getData());
+    }
     
-    int getWidth() const { return width_; }
-    int getHeight() const { return height_; }
-    int getChannels() const { return channels_; }
-    unsigned char* getData() { return data_.get(); }
-    const unsigned char* getData() const { return data_.get(); }
+    const unsigned char* getData() const {
+        return static_cast<const unsigned char*>(TensorData::getData());
+    }
+    
+    std::unique_ptr<DataItem> clone() const override {
+        return std::make_unique<ImageData>(duplicate());
+    }
     
 private:
-    int width_;
-    int height_;
-    int channels_;
-    std::unique_ptr<unsigned char[]> data_;
+    ImageData(int width, int height, int channels, const std::shared_ptr<unsigned char[]>& data)
+        : TensorData(DType::UInt8, imageShape(width, height, channels), static_cast<void*>(data.get()), data) {}
+    
+    static Shape imageShape(int width, int height, int channels) {
+        return {height, width, channels};
+    }
 };
 
 /**
  * 文本数据项 - 用于存储文本数据
+ * 文本可以由对象自己持有，也可以是内存映射文件中的只读切片（零拷贝）
  */
 class TextData : public DataItem {
 public:
-    explicit TextData(std::string text) : text_(std::move(text)) {}
+    explicit TextData(std::string text) : text_(std::move(text)), materialized_(true) {}
+    
+    /**
+     * 构造引用映射文件切片的文本，不复制数据
+     * @param view 文本所在的映射区间
+     */
+    explicit TextData(MappedBuffer view) : view_(std::move(view)), materialized_(false) {}
     
-    const std::string& getText() const { return text_; }
+    /**
+     * 获取文本内容
+     * 引用映射文件时，首次调用会把文本复制到std::string中；只读访问请使用getTextView()
+     */
+    const std::string& getText() const {
+        if (!materialized_) {
+            text_.assign(view_.asStringView());
+            materialized_ = true;
+        }
+        return text_;
+    }
+    
+    /**
+     * 获取文本内容的只读视图，不复制数据
+     */
+    std::string_view getTextView() const {
+        return materialized_ ? std::string_view(text_) : view_.asStringView();
+    }
+    
+    /**
+     * 是否引用映射文件
+     */
+    bool isView() const { return view_.file() != nullptr; }
+    
+    /**
+     * 获取引用的映射区间，仅在isView()为true时有效
+     */
+    const MappedBuffer& getView() const { return view_; }
+    
+    /**
+     * 创建副本，引用映射文件的文本只需共享映射
+     */
+    std::unique_ptr<DataItem> clone() const override {
+        if (isView()) {
+            return std::make_unique<TextData>(view_);
+        }
+        return std::make_unique<TextData>(text_);
+    }
     
 private:
-    std::string text_;
+    mutable std::string text_;
+    MappedBuffer view_;
+    mutable bool materialized_;
+};
+
+/**
+ * 预处理上下文 - 预处理函数处理一个数据项时可用的信息
+ */
+struct ProcessingContext {
+    // 数据索引（数据路径表中的下标）
+    size_t index;
+
+    // 加载轮次，与传给采样器的轮次相同
+    size_t epoch;
+
+    // 该数据项专用的随机数生成器，由(种子, 轮次, 数据索引)派生：不与其他线程共享，不需要加锁；
+    // 同一轮中同一个数据项总是得到相同的随机数，与线程数和处理顺序无关
+    PhiloxRng rng;
 };
 
 /**
@@ -78,23 +188,50 @@ public:
         size_t num_processor_threads = 4,
         size_t buffer_size = 100,
         size_t cache_capacity = 100
+    ) : DataLoader(PathTable(data_paths), batch_size, num_loader_threads, num_processor_threads, buffer_size, cache_capacity) {
+    }
+    
+    /**
+     * 构造函数
+     * 路径表只共享底层存储，不拷贝路径，适合数千万个数据项的数据集
+     * @param data_paths 数据文件路径表
+     * @param batch_size 批处理大小
+     * @param num_loader_threads 数据加载线程数量
+     * @param num_processor_threads 数据预处理线程数量
+     * @param buffer_size 缓冲区大小
+     * @param cache_capacity 缓存容量，0表示不使用缓存
+     */
+    DataLoader(
+        PathTable data_paths,
+        size_t batch_size,
+        size_t num_loader_threads = 4,
+        size_t num_processor_threads = 4,
+        size_t buffer_size = 100,
+        size_t cache_capacity = 100
     ) : 
-        data_paths_(data_paths),
+        data_paths_(std::move(data_paths)),
         batch_size_(batch_size),
         current_index_(0),
         done_loading_(false),
         buffer_size_(buffer_size),
+        started_(false),
+        prefetch_depth_(0),
+        prefetch_next_(0),
+        hint_depth_(0),
+        hint_next_(0),
+        streaming_(false),
+        items_remaining_(0),
+        epoch_(0),
         cache_capacity_(cache_capacity),
-        loader_pool_(num_loader_threads),
+        storage_(std::make_unique<StorageRouter>()),
         processor_pool_(num_processor_threads),
-        storage_(StorageFactory::createStorageForPath(data_paths.empty() ? "" : data_paths[0]))
+        loader_pool_(num_loader_threads)
     {
         if (cache_capacity > 0) {
-            data_cache_ = std::make_unique<LRUCache<std::string, std::unique_ptr<DataItem>>>(cache_capacity);
+            data_cache_ = std::make_unique<LRUCache<std::string, std::shared_ptr<DataItem>>>(cache_capacity);
         }
         
-        // 启动数据加载过程
-        startLoading();
+        // 数据加载过程在第一次获取批次时启动，以便先设置加载和预处理函数
     }
     
     /**
@@ -134,6 +271,7 @@ public:
 
     /**
      * 设置存储接口
+     * 默认的存储为StorageRouter：路径可以混合本地、"s3://"和"hdfs://"，远程存储在进程内的所有加载器之间共享
      * @param storage 存储接口实例
      */
     void setStorage(std::unique_ptr<Storage> storage) {
@@ -148,6 +286,109 @@ public:
         return storage_.get();
     }
     
+    /**
+     * 获取数据预处理线程池
+     * 预处理函数可以在该线程池上调用parallel_for或使用TaskGroup，
+     * 将单个大样本的处理拆分到多个线程上
+     * @return 预处理线程池
+     */
+    ThreadPool& getProcessorPool() {
+        return processor_pool_;
+    }
+    
+    /**
+     * 在运行时调整加载和预处理线程数量
+     * 同一进程中运行多个数据加载器时，可以据此重新分配CPU
+     * @param num_loader_threads 数据加载线程数量
+     * @param num_processor_threads 数据预处理线程数量
+     */
+    void resizeThreads(size_t num_loader_threads, size_t num_processor_threads) {
+        loader_pool_.resize(num_loader_threads);
+        processor_pool_.resize(num_processor_threads);
+    }
+    
+    /**
+     * 设置工作线程的空闲超时时间，超时后线程进入停车状态
+     * @param idle_timeout 空闲超时时间，0表示不停车
+     */
+    void setIdleTimeout(std::chrono::milliseconds idle_timeout) {
+        loader_pool_.set_idle_timeout(idle_timeout);
+        processor_pool_.set_idle_timeout(idle_timeout);
+    }
+    
+    /**
+     * 设置预取深度
+     * 开启后，加载第i个数据时会通过Storage::prefetch()批量提交第i到i+depth个路径的读取，
+     * 加载函数通过getStorage()->readFilePooled()或readFile()读取时即可直接取用预取结果（前者不需要复制）
+     * @param depth 预取的路径数量，0表示不预取
+     */
+    void setPrefetchDepth(size_t depth) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        prefetch_depth_ = depth;
+    }
+    
+    /**
+     * 设置预读提示深度
+     * 开启后，加载第i个数据时会对第i+1到i+depth个路径发出WillNeed提示，
+     * 内核在后台把这些文件读入页缓存；与setPrefetchDepth()相比不占用读取队列和内存
+     * @param depth 提示的路径数量，0表示不提示
+     */
+    void setReadaheadHints(size_t depth) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        hint_depth_ = depth;
+    }
+    
+    /**
+     * 设置读取数据时的访问模式
+     * 未设置时根据采样器决定：顺序和分片采样使用Sequential，随机采样使用Random
+     * @param pattern 访问模式，Normal、Sequential或Random
+     */
+    void setAccessPattern(AccessAdvice pattern) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        access_pattern_ = pattern;
+    }
+    
+    /**
+     * 开启或关闭流式读取：每个文件读取后即从页缓存中逐出，适合只遍历一遍的超大数据集
+     * 设置从下一次开始加载时生效
+     * @param enabled 是否开启
+     */
+    void setStreaming(bool enabled) {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        streaming_ = enabled;
+    }
+    
+    /**
+     * 设置采样器，决定每一轮的数据访问顺序
+     * 新的顺序从下一次开始加载（首次getNextBatch()或reset()）时生效
+     * @param sampler 采样器，其size()必须与数据路径数量一致；为空时按顺序访问
+     */
+    void setSampler(std::shared_ptr<Sampler> sampler) {
+        if (sampler && sampler->size() != data_paths_.size()) {
+            throw std::invalid_argument("Sampler size does not match number of data paths");
+        }
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        sampler_ = std::move(sampler);
+        batch_sampler_.reset();
+    }
+    
+    /**
+     * 设置批次采样器，由采样器同时决定访问顺序和批次划分，例如按词元数预算分桶的BucketBatchSampler
+     * 设置后getNextBatch()返回的批次与采样器的划分一致，构造时的batch_size不再起作用；
+     * 批次内的数据项按采样器给出的顺序排列，批次之间按全部数据项就绪的先后返回。
+     * 加载或预处理失败的数据项从所在批次中去掉。
+     * 新的划分从下一次开始加载时生效；再调用setSampler()则恢复固定大小的批次
+     * @param sampler 批次采样器，其size()必须与数据路径数量一致；为空时恢复顺序访问
+     */
+    void setBatchSampler(std::shared_ptr<BatchSampler> sampler) {
+        if (sampler && sampler->size() != data_paths_.size()) {
+            throw std::invalid_argument("Sampler size does not match number of data paths");
+        }
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        sampler_ = sampler;
+        batch_sampler_ = std::move(sampler);
+    }
+    
     /**
      * 设置缓存容量
      * @param capacity 缓存容量，0表示不使用缓存
@@ -156,7 +397,7 @@ public:
         cache_capacity_ = capacity;
         if (capacity > 0) {
             if (!data_cache_) {
-                data_cache_ = std::make_unique<LRUCache<std::string, std::unique_ptr<DataItem>>>(capacity);
+                data_cache_ = std::make_unique<LRUCache<std::string, std::shared_ptr<DataItem>>>(capacity);
             } else {
                 data_cache_->set_capacity(capacity);
             }
@@ -190,14 +431,56 @@ public:
      * @param processor_fn 数据预处理函数
      */
     void setProcessorFunction(std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>)> processor_fn) {
+        if (!processor_fn) {
+            processor_fn_ = nullptr;
+            return;
+        }
+        processor_fn_ = [fn = std::move(processor_fn)](std::unique_ptr<DataItem> item, ProcessingContext&) {
+            return fn(std::move(item));
+        };
+    }
+    
+    /**
+     * 设置接受预处理上下文的数据预处理函数
+     * 随机数据增强应当使用context.rng，而不是rand()或共享的随机数引擎：
+     * 每个数据项有独立的生成器，预处理线程之间不竞争，结果可以逐位复现
+     * @param processor_fn 数据预处理函数
+     */
+    void setProcessorFunction(
+        std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>, ProcessingContext&)> processor_fn) {
         processor_fn_ = std::move(processor_fn);
     }
     
+    /**
+     * 设置随机种子，预处理上下文中的随机数生成器由它、轮次和数据索引派生
+     * 应当在开始加载前设置；通常与采样器使用相同的种子
+     * @param seed 随机种子，默认为0
+     */
+    void setSeed(uint64_t seed) {
+        seed_ = seed;
+    }
+    
+    /**
+     * 设置批次拼接（collate）函数，供getNextCollatedBatch()使用
+     * @param collate_fn 把一个批次的数据项拼接为一个数据项的函数，为空时使用collateBatch()
+     */
+    void setCollateFunction(std::function<std::unique_ptr<DataItem>(std::vector<std::unique_ptr<DataItem>>)> collate_fn) {
+        collate_fn_ = std::move(collate_fn);
+    }
+    
     /**
      * 获取下一个批次的数据
      * @return 数据批次，如果没有更多数据则返回空
      */
     std::optional<std::vector<std::unique_ptr<DataItem>>> getNextBatch() {
+        if (!started_.exchange(true)) {
+            startLoading();
+        }
+        
+        if (!batch_first_.empty()) {
+            return getNextPlannedBatch();
+        }
+        
         std::vector<std::unique_ptr<DataItem>> batch;
         batch.reserve(batch_size_);
         
@@ -210,12 +493,29 @@ public:
                 }
                 return std::nullopt;
             }
-            batch.push_back(std::move(*item));
+            batch.push_back(std::move(item->data));
         }
         
         return batch;
     }
     
+    /**
+     * 获取下一个批次并拼接为一个数据项
+     * 默认的拼接函数把TensorData（包括ImageData）沿新的第0维拼接为形状{N, ...}的TensorData，
+     * 把TensorMap逐字段拼接；数据量较大时在预处理线程池上并行复制
+     * @return 拼接结果，如果没有更多数据则返回空
+     */
+    std::unique_ptr<DataItem> getNextCollatedBatch() {
+        auto batch = getNextBatch();
+        if (!batch) {
+            return nullptr;
+        }
+        if (collate_fn_) {
+            return collate_fn_(std::move(*batch));
+        }
+        return collateBatch(*batch, &processor_pool_);
+    }
+    
     /**
      * 停止数据加载器
      */
@@ -232,7 +532,7 @@ public:
     void reset() {
         stop();
         
-        { // 清空缓冲区
+        { // 清空缓冲区，并使上一轮尚未完成的任务失效
             std::lock_guard<std::mutex> lock_loaded(loaded_mutex_);
             std::lock_guard<std::mutex> lock_processed(processed_mutex_);
             
@@ -242,12 +542,19 @@ public:
             while (!processed_queue_.empty()) {
                 processed_queue_.pop();
             }
+            dropped_positions_.clear();
+            
+            ++epoch_;
+            error_ = nullptr;
         }
         
         current_index_ = 0;
         done_loading_ = false;
+        pending_batches_.clear();
+        ready_batches_.clear();
         
         // 重新启动加载过程
+        started_ = true;
         startLoading();
     }
     
@@ -259,9 +566,17 @@ public:
         return data_paths_.size();
     }
     
+    /**
+     * 获取数据文件路径表
+     * @return 路径表，下标即采样器返回的数据索引
+     */
+    const PathTable& getPaths() const {
+        return data_paths_;
+    }
+    
 private:
-    // 数据文件路径列表
-    std::vector<std::string> data_paths_;
+    // 数据文件路径表
+    PathTable data_paths_;
     
     // 批处理大小
     size_t batch_size_;
@@ -275,17 +590,73 @@ private:
     // 缓冲区大小
     size_t buffer_size_;
     
-    // 数据加载线程池
-    ThreadPool loader_pool_;
+    // 加载过程是否已启动
+    std::atomic<bool> started_;
     
-    // 数据预处理线程池
-    ThreadPool processor_pool_;
+    // 预取深度及下一个尚未预取的访问位置，由prefetch_mutex_保护
+    std::mutex prefetch_mutex_;
+    size_t prefetch_depth_;
+    size_t prefetch_next_;
+    
+    // 预读提示深度及下一个尚未提示的访问位置，由prefetch_mutex_保护
+    size_t hint_depth_;
+    size_t hint_next_;
+    
+    // 访问模式（未设置时由采样器决定）及是否流式读取，由prefetch_mutex_保护
+    std::optional<AccessAdvice> access_pattern_;
+    bool streaming_;
+    
+    // 采样器，由prefetch_mutex_保护；为空时按顺序访问
+    std::shared_ptr<Sampler> sampler_;
+    
+    // 批次采样器（与sampler_指向同一个对象），由prefetch_mutex_保护；为空时批次大小固定
+    std::shared_ptr<BatchSampler> batch_sampler_;
+    
+    // 本轮尚未交付（或丢弃）的数据项数量，由processed_mutex_保护
+    size_t items_remaining_;
+    
+    // 按批次采样器划分时，本轮被丢弃的数据项的访问位置，由processed_mutex_保护
+    bool track_dropped_ = false;
+    std::vector<size_t> dropped_positions_;
+    
+    /**
+     * 等待凑齐的批次：按访问位置排列的槽位及尚未到达的数据项数量
+     */
+    struct PendingBatch {
+        std::vector<std::unique_ptr<DataItem>> slots;
+        size_t missing = 0;
+    };
+    
+    // 以下成员只由消费者线程（getNextBatch()和reset()）访问
+    // 本轮各批次在访问顺序中的起始位置，最后一个元素为访问位置总数；为空时批次大小固定
+    std::vector<size_t> batch_first_;
+    
+    // 批次编号 -> 已到达部分数据项的批次
+    std::map<size_t, PendingBatch> pending_batches_;
+    
+    // 已凑齐、尚未返回的批次
+    std::deque<std::vector<std::unique_ptr<DataItem>>> ready_batches_;
+    
+    // 加载轮次，reset()时递增，用于丢弃上一轮遗留任务的结果
+    std::atomic<size_t> epoch_;
+    
+    // 加载或预处理过程中的第一个异常，由processed_mutex_保护
+    std::exception_ptr error_;
+    
+    /**
+     * 队列中的数据项及其在本轮中的访问位置和数据索引
+     */
+    struct QueuedItem {
+        size_t position;
+        size_t index;
+        std::unique_ptr<DataItem> data;
+    };
     
     // 加载后的数据队列
-    std::queue<std::unique_ptr<DataItem>> loaded_queue_;
+    std::queue<QueuedItem> loaded_queue_;
     
     // 预处理后的数据队列
-    std::queue<std::unique_ptr<DataItem>> processed_queue_;
+    std::queue<QueuedItem> processed_queue_;
     
     // 用于保护加载队列的互斥锁
     std::mutex loaded_mutex_;
@@ -303,171 +674,411 @@ private:
     std::function<std::unique_ptr<DataItem>(const std::string&)> loader_fn_;
     
     // 数据预处理函数
-    std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>)> processor_fn_;
+    std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>, ProcessingContext&)> processor_fn_;
+    
+    // 预处理上下文中随机数生成器的种子
+    std::atomic<uint64_t> seed_{0};
+    
+    // 批次拼接函数
+    std::function<std::unique_ptr<DataItem>(std::vector<std::unique_ptr<DataItem>>)> collate_fn_;
     
     // 数据缓存
     size_t cache_capacity_;
-    std::unique_ptr<LRUCache<std::string, std::unique_ptr<DataItem>>> data_cache_;
+    std::unique_ptr<LRUCache<std::string, std::shared_ptr<DataItem>>> data_cache_;
     
     // 存储接口
     std::unique_ptr<Storage> storage_;
     
+    // 线程池放在最后声明，保证析构时先于队列和互斥锁等成员停止，
+    // 剩余任务不会访问已销毁的成员
+    
+    // 数据预处理线程池
+    // 在加载线程池之前声明，使加载线程池先析构：加载任务会向预处理线程池提交任务
+    ThreadPool processor_pool_;
+    
+    // 数据加载线程池
+    ThreadPool loader_pool_;
+    
     /**
      * 开始数据加载过程
      */
     void startLoading() {
-        // 提交加载任务到加载线程池
-        for (size_t i = 0; i < data_paths_.size(); ++i) {
-            const auto& path = data_paths_[i];
-            loader_pool_.enqueue([this, path]() {
-                this->loadData(path);
-            });
+        const size_t epoch = epoch_;
+        
+        // 本轮的访问顺序由各个任务共享，reset()生成新顺序时不影响上一轮遗留的任务
+        std::shared_ptr<const std::vector<size_t>> order;
+        AccessAdvice pattern;
+        bool streaming;
+        batch_first_.clear();
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex_);
+            prefetch_next_ = 0;
+            hint_next_ = 0;
+            if (batch_sampler_) {
+                // 批次依次连接为访问顺序，记录每个批次的起始位置（跳过空批次）
+                std::vector<size_t> flat;
+                flat.reserve(data_paths_.size());
+                for (const auto& batch : batch_sampler_->batches(epoch)) {
+                    if (!batch.empty()) {
+                        batch_first_.push_back(flat.size());
+                        flat.insert(flat.end(), batch.begin(), batch.end());
+                    }
+                }
+                if (!batch_first_.empty()) {
+                    batch_first_.push_back(flat.size());
+                }
+                order = std::make_shared<const std::vector<size_t>>(std::move(flat));
+            } else {
+                order = std::make_shared<const std::vector<size_t>>(
+                    sampler_ ? sampler_->indices(epoch) : SequentialSampler(data_paths_.size()).indices(epoch));
+            }
+            pattern = access_pattern_.value_or(sampler_ ? sampler_->accessPattern() : AccessAdvice::Sequential);
+            streaming = streaming_;
+        }
+        {
+            std::lock_guard<std::mutex> lock(processed_mutex_);
+            items_remaining_ = order->size();
+            track_dropped_ = !batch_first_.empty();
+            dropped_positions_.clear();
         }
         
-        // 启动预处理任务
-        for (size_t i = 0; i < processor_pool_.size(); ++i) {
-            processor_pool_.enqueue([this]() {
-                this->processData();
+        // 把访问模式告知存储，由存储向内核发出相应的预读提示
+        storage_->setAccessPattern(pattern);
+        storage_->setStreaming(streaming);
+        
+        // 提交加载任务到加载线程池，每个加载完成的数据项再提交一个预处理任务
+        for (size_t position = 0; position < order->size(); ++position) {
+            loader_pool_.enqueue([this, position, order, epoch]() {
+                this->loadData(position, *order, epoch);
             });
         }
     }
     
+    /**
+     * 计算需要补充的预取（或提示）窗口
+     * 窗口消耗过半时才补充，使每次提交都是一批路径
+     * @param first 窗口的起始访问位置
+     * @param count 窗口大小
+     * @param total 本轮的访问位置总数
+     * @param next 下一个尚未提交的访问位置，补充后更新
+     * @param begin 输出参数，需要提交的起始位置
+     * @param end 输出参数，需要提交的结束位置
+     * @return 需要补充时返回true
+     */
+    static bool nextWindow(size_t first, size_t count, size_t total, size_t& next, size_t& begin, size_t& end) {
+        if (count == 0) {
+            return false;
+        }
+        begin = std::max(next, first);
+        end = std::min(total, first + count);
+        if (begin >= end || (begin > first && begin - first > count / 2)) {
+            return false;
+        }
+        next = end;
+        return true;
+    }
+    
+    /**
+     * 为即将加载的数据提交预取和预读提示
+     * @param position 当前加载的访问位置
+     * @param order 本轮的访问顺序
+     */
+    void prefetchAhead(size_t position, const std::vector<size_t>& order) {
+        std::vector<std::string> prefetch_paths;
+        std::vector<std::string> hint_paths;
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex_);
+            size_t begin;
+            size_t end;
+            
+            // 预取窗口包含当前位置，当前数据的读取也会取用预取结果
+            if (nextWindow(position, prefetch_depth_ ? prefetch_depth_ + 1 : 0, order.size(), prefetch_next_, begin, end)) {
+                for (size_t i = begin; i < end; ++i) {
+                    prefetch_paths.push_back(data_paths_[order[i]]);
+                }
+            }
+            if (nextWindow(position + 1, hint_depth_, order.size(), hint_next_, begin, end)) {
+                for (size_t i = begin; i < end; ++i) {
+                    hint_paths.push_back(data_paths_[order[i]]);
+                }
+            }
+        }
+        if (!hint_paths.empty()) {
+            storage_->advise(hint_paths, AccessAdvice::WillNeed);
+        }
+        if (!prefetch_paths.empty()) {
+            storage_->prefetch(prefetch_paths);
+        }
+    }
+    
+    /**
+     * 记录一个被丢弃的数据项（加载或预处理失败）
+     * @param epoch 数据项所属的加载轮次
+     * @param position 数据项在本轮中的访问位置
+     * @param error 失败原因，可以为空
+     */
+    void dropItem(size_t epoch, size_t position, std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(processed_mutex_);
+            if (epoch != epoch_) {
+                return;
+            }
+            --items_remaining_;
+            if (track_dropped_) {
+                dropped_positions_.push_back(position);
+            }
+            if (error && !error_) {
+                error_ = error;
+            }
+        }
+        processed_condition_.notify_all();
+    }
+    
     /**
      * 加载数据
-     * @param path 数据文件路径
+     * @param position 本轮中的访问位置
+     * @param order 本轮的访问顺序，order[position]为数据索引
+     * @param epoch 提交任务时的加载轮次
      */
-    void loadData(const std::string& path) {
-        if (!loader_fn_) {
-            throw std::runtime_error("Loader function not set");
+    void loadData(size_t position, const std::vector<size_t>& order, size_t epoch) {
+        if (done_loading_ || epoch != epoch_) {
+            return;
         }
         
+        std::string path = data_paths_[order[position]];
         std::unique_ptr<DataItem> data;
         
-        // 检查是否有缓存可用且数据在缓存中
-        if (data_cache_) {
-            auto cached_data = data_cache_->get(path);
-            if (cached_data) {
-                // 缓存命中，使用缓存的数据
-                data = std::make_unique<DataItem>(**cached_data);
-            } else {
-                // 缓存未命中，加载数据并放入缓存
-                data = loader_fn_(path);
+        try {
+            prefetchAhead(position, order);
+            
+            if (!loader_fn_) {
+                throw std::runtime_error("Loader function not set");
+            }
+            
+            // 检查是否有缓存可用且数据在缓存中
+            if (data_cache_) {
+                auto cached_data = data_cache_->get(path);
+                if (cached_data) {
+                    // 缓存命中，使用缓存数据的副本
+                    data = (*cached_data)->clone();
+                }
                 
-                // 注意：这里需要创建数据的副本放入缓存，因为原始数据会被移动到队列中
-                // 在实际应用中，可能需要根据数据类型实现深拷贝
-                if (auto* image_data = dynamic_cast<ImageData*>(data.get())) {
-                    // 为图像数据创建副本
-                    auto cached_image = std::make_unique<ImageData>(
-                        image_data->getWidth(),
-                        image_data->getHeight(),
-                        image_data->getChannels(),
-                        std::make_unique<unsigned char[]>(image_data->getWidth() * image_data->getHeight() * image_data->getChannels())
-                    );
-                    memcpy(cached_image->getData(), image_data->getData(), 
-                           cached_image->getWidth() * cached_image->getHeight() * cached_image->getChannels());
-                    data_cache_->put(path, std::move(cached_image));
-                } else if (auto* text_data = dynamic_cast<TextData*>(data.get())) {
-                    // 为文本数据创建副本
-                    auto cached_text = std::make_unique<TextData>(text_data->getText());
-                    data_cache_->put(path, std::move(cached_text));
-                } else {
-                    // 对于未知类型，直接缓存（如果支持拷贝）
-                    try {
-                        data_cache_->put(path, std::make_unique<DataItem>(*data));
-                    } catch (const std::exception&) {
-                        // 如果拷贝失败，忽略缓存
+                if (!data) {
+                    // 缓存未命中，加载数据并放入缓存
+                    data = loader_fn_(path);
+                    
+                    // 原始数据会被移动到队列中，因此放入缓存的是副本；
+                    // 不支持拷贝的类型不缓存
+                    if (data) {
+                        if (auto cached = data->clone()) {
+                            data_cache_->put(path, std::shared_ptr<DataItem>(std::move(cached)));
+                        }
                     }
                 }
+            } else {
+                // 没有使用缓存，直接加载数据
+                data = loader_fn_(path);
             }
-        } else {
-            // 没有使用缓存，直接加载数据
-            data = loader_fn_(path);
+        } catch (...) {
+            dropItem(epoch, position, std::current_exception());
+            return;
+        }
+        
+        if (!data) {
+            dropItem(epoch, position, nullptr);
+            return;
         }
         
         {
             std::unique_lock<std::mutex> lock(loaded_mutex_);
             
             // 如果缓冲区已满，等待
-            loaded_condition_.wait(lock, [this] {
-                return this->loaded_queue_.size() < this->buffer_size_ || this->done_loading_;
+            loaded_condition_.wait(lock, [this, epoch] {
+                return this->loaded_queue_.size() < this->buffer_size_ || this->done_loading_ || epoch != this->epoch_;
             });
             
-            if (!done_loading_) {
-                loaded_queue_.push(std::move(data));
+            if (done_loading_ || epoch != epoch_) {
+                return;
             }
+            loaded_queue_.push({position, order[position], std::move(data)});
         }
         
-        // 通知预处理线程有新数据可用
-        loaded_condition_.notify_one();
+        // 为新数据提交一个预处理任务；预处理线程不再常驻循环，
+        // 空闲时可以执行预处理函数通过parallel_for拆分出的子任务
+        processor_pool_.enqueue([this]() {
+            this->processData();
+        });
     }
     
     /**
-     * 处理数据
+     * 处理加载队列中的一个数据项
      */
     void processData() {
-        while (!done_loading_ || !loaded_queue_.empty()) {
-            std::unique_ptr<DataItem> data;
+        std::unique_ptr<DataItem> data;
+        size_t position;
+        size_t index;
+        size_t epoch;
+        
+        { // 获取加载的数据
+            std::lock_guard<std::mutex> lock(loaded_mutex_);
             
-            { // 获取加载的数据
-                std::unique_lock<std::mutex> lock(loaded_mutex_);
-                
-                loaded_condition_.wait(lock, [this] {
-                    return !this->loaded_queue_.empty() || this->done_loading_;
-                });
-                
-                if (loaded_queue_.empty()) {
-                    continue;
-                }
-                
-                data = std::move(loaded_queue_.front());
-                loaded_queue_.pop();
+            if (loaded_queue_.empty()) {
+                // 该数据项已在reset()中被清除
+                return;
             }
             
-            loaded_condition_.notify_one();
-            
-            // 进行数据预处理
+            position = loaded_queue_.front().position;
+            index = loaded_queue_.front().index;
+            data = std::move(loaded_queue_.front().data);
+            loaded_queue_.pop();
+            epoch = epoch_;
+        }
+        
+        loaded_condition_.notify_one();
+        
+        // 进行数据预处理
+        try {
             if (processor_fn_) {
-                data = processor_fn_(std::move(data));
+                ProcessingContext context{index, epoch, PhiloxRng(seed_, index, static_cast<uint32_t>(epoch))};
+                data = processor_fn_(std::move(data), context);
             }
+        } catch (...) {
+            dropItem(epoch, position, std::current_exception());
+            return;
+        }
+        
+        if (!data) {
+            dropItem(epoch, position, nullptr);
+            return;
+        }
+        
+        { // 将处理后的数据放入队列
+            std::unique_lock<std::mutex> lock(processed_mutex_);
             
-            { // 将处理后的数据放入队列
-                std::unique_lock<std::mutex> lock(processed_mutex_);
-                
-                processed_condition_.wait(lock, [this] {
-                    return this->processed_queue_.size() < this->buffer_size_ || this->done_loading_;
-                });
-                
-                if (!done_loading_) {
-                    processed_queue_.push(std::move(data));
-                }
-            }
+            processed_condition_.wait(lock, [this, epoch] {
+                return this->processed_queue_.size() < this->buffer_size_ || this->done_loading_ || epoch != this->epoch_;
+            });
             
-            processed_condition_.notify_one();
+            if (done_loading_ || epoch != epoch_) {
+                return;
+            }
+            processed_queue_.push({position, index, std::move(data)});
         }
+        
+        // 消费者和等待空位的预处理任务共用同一个条件变量，需要全部唤醒
+        processed_condition_.notify_all();
     }
     
     /**
      * 获取下一个数据项
-     * @return 下一个数据项，如果没有更多数据则返回空
+     * 如果加载或预处理过程中出现异常，将在此处重新抛出
+     * @param dropped 不为空时，同时取出已被丢弃的数据项的访问位置；有被丢弃的数据项时不等待新的数据项
+     * @return 下一个数据项，如果没有更多数据（或只取出了被丢弃的位置）则返回空
      */
-    std::optional<std::unique_ptr<DataItem>> getNextItem() {
+    std::optional<QueuedItem> getNextItem(std::vector<size_t>* dropped = nullptr) {
         std::unique_lock<std::mutex> lock(processed_mutex_);
         
-        processed_condition_.wait(lock, [this] {
-            return !this->processed_queue_.empty() || this->done_loading_;
+        processed_condition_.wait(lock, [this, dropped] {
+            return !this->processed_queue_.empty() || this->done_loading_ ||
+                   this->items_remaining_ == 0 || this->error_ ||
+                   (dropped && !this->dropped_positions_.empty());
         });
         
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+        
+        if (dropped) {
+            dropped->swap(dropped_positions_);
+        }
+        
         if (processed_queue_.empty()) {
             return std::nullopt;
         }
         
         auto item = std::move(processed_queue_.front());
         processed_queue_.pop();
+        --items_remaining_;
+        lock.unlock();
         
-        processed_condition_.notify_one();
+        processed_condition_.notify_all();
         
         return item;
     }
+    
+    /**
+     * 按批次采样器的划分获取下一个批次
+     * 到达的数据项放入所属批次的槽位，最先凑齐的批次最先返回；
+     * 所有数据项都已交付或丢弃后，按批次顺序返回仍缺少（被丢弃的）数据项的批次
+     * @return 数据批次，如果没有更多数据则返回空
+     */
+    std::optional<std::vector<std::unique_ptr<DataItem>>> getNextPlannedBatch() {
+        std::vector<size_t> dropped;
+        while (ready_batches_.empty()) {
+            auto item = getNextItem(&dropped);
+            for (size_t position : dropped) {
+                placeItem(position, nullptr);
+            }
+            if (item) {
+                placeItem(item->position, std::move(item->data));
+            } else if (dropped.empty()) {
+                // 本轮已结束
+                for (auto& entry : pending_batches_) {
+                    completeBatch(entry.second);
+                }
+                pending_batches_.clear();
+                break;
+            }
+            dropped.clear();
+        }
+        
+        if (ready_batches_.empty()) {
+            return std::nullopt;
+        }
+        auto batch = std::move(ready_batches_.front());
+        ready_batches_.pop_front();
+        return batch;
+    }
+    
+    /**
+     * 把到达（或被丢弃）的数据项放入所属批次，批次凑齐时移入ready_batches_
+     * @param position 数据项在本轮中的访问位置
+     * @param data 数据项，被丢弃时为空
+     */
+    void placeItem(size_t position, std::unique_ptr<DataItem> data) {
+        const size_t batch = static_cast<size_t>(
+            std::upper_bound(batch_first_.begin(), batch_first_.end(), position) - batch_first_.begin()) - 1;
+        auto it = pending_batches_.find(batch);
+        if (it == pending_batches_.end()) {
+            const size_t count = batch_first_[batch + 1] - batch_first_[batch];
+            it = pending_batches_.emplace(batch, PendingBatch()).first;
+            it->second.slots.resize(count);
+            it->second.missing = count;
+        }
+        it->second.slots[position - batch_first_[batch]] = std::move(data);
+        if (--it->second.missing == 0) {
+            completeBatch(it->second);
+            pending_batches_.erase(it);
+        }
+    }
+    
+    /**
+     * 把批次中已到达的数据项按顺序移入ready_batches_，全部被丢弃的批次不返回
+     */
+    void completeBatch(PendingBatch& pending) {
+        std::vector<std::unique_ptr<DataItem>> batch;
+        batch.reserve(pending.slots.size());
+        for (auto& slot : pending.slots) {
+            if (slot) {
+                batch.push_back(std::move(slot));
+            }
+        }
+        if (!batch.empty()) {
+            ready_batches_.push_back(std::move(batch));
+        }
+    }
 };
 
 #endif // DATA_LOADER_H
\ No newline at end of file
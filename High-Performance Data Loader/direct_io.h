@@ -0,0 +1,274 @@
+#ifndef DIRECT_IO_H
+#define DIRECT_IO_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/**
+ * 直接I/O缓冲池 - 管理一组按块对齐、可重复使用的读缓冲区
+ * O_DIRECT要求用户缓冲区、文件偏移和读取长度都按逻辑块对齐，
+ * 池中的缓冲区满足这些要求，并且可以整体注册到io_uring（READ_FIXED）
+ */
+class DirectIOBufferPool {
+public:
+    // 缓冲区、偏移和长度的对齐单位，覆盖常见设备的逻辑块大小
+    static constexpr size_t kAlignment = 4096;
+
+    /**
+     * 租用的缓冲区 - 析构时自动归还到缓冲池
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept : pool_(other.pool_), index_(other.index_) {
+            other.pool_ = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool_ = other.pool_;
+                index_ = other.index_;
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+        ~Lease() {
+            release();
+        }
+
+        unsigned char* data() const { return pool_->buffer(index_); }
+        size_t size() const { return pool_->bufferSize(); }
+        size_t index() const { return index_; }
+        explicit operator bool() const { return pool_ != nullptr; }
+
+    private:
+        friend class DirectIOBufferPool;
+        Lease(DirectIOBufferPool* pool, size_t index) : pool_(pool), index_(index) {}
+
+        void release() {
+            if (pool_) {
+                pool_->giveBack(index_);
+                pool_ = nullptr;
+            }
+        }
+
+        DirectIOBufferPool* pool_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    /**
+     * 构造函数
+     * @param buffer_size 每个缓冲区的大小，向上取整到kAlignment的倍数
+     * @param count 缓冲区数量
+     */
+    DirectIOBufferPool(size_t buffer_size, size_t count)
+        : buffer_size_(alignUp(std::max<size_t>(buffer_size, kAlignment))) {
+        count = std::max<size_t>(count, 1);
+        storage_ = allocateAligned(buffer_size_ * count);
+        free_.reserve(count);
+        for (size_t i = count; i > 0; --i) {
+            free_.push_back(i - 1);
+        }
+        count_ = count;
+    }
+
+    DirectIOBufferPool(const DirectIOBufferPool&) = delete;
+    DirectIOBufferPool& operator=(const DirectIOBufferPool&) = delete;
+
+    ~DirectIOBufferPool() {
+        freeAligned(storage_);
+    }
+
+    /**
+     * 租用一个缓冲区，没有空闲缓冲区时阻塞等待
+     * @return 租用的缓冲区
+     */
+    Lease acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        available_.wait(lock, [this] {
+            return !free_.empty();
+        });
+        size_t index = free_.back();
+        free_.pop_back();
+        return Lease(this, index);
+    }
+
+    /**
+     * 尝试租用一个缓冲区，不阻塞
+     * @return 租用的缓冲区，没有空闲缓冲区时返回空租约
+     */
+    Lease tryAcquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            return Lease();
+        }
+        size_t index = free_.back();
+        free_.pop_back();
+        return Lease(this, index);
+    }
+
+    unsigned char* buffer(size_t index) const { return storage_ + index * buffer_size_; }
+    size_t bufferSize() const { return buffer_size_; }
+    size_t count() const { return count_; }
+
+    /**
+     * 进程级共享缓冲池，供FileIO::readFileDirect等同步接口使用
+     */
+    static DirectIOBufferPool& shared() {
+        static DirectIOBufferPool pool(1 << 20, 8);
+        return pool;
+    }
+
+    static size_t alignDown(uint64_t value) {
+        return static_cast<size_t>(value / kAlignment * kAlignment);
+    }
+
+    static size_t alignUp(uint64_t value) {
+        return static_cast<size_t>((value + kAlignment - 1) / kAlignment * kAlignment);
+    }
+
+private:
+    static unsigned char* allocateAligned(size_t size) {
+#ifdef _WIN32
+        void* ptr = _aligned_malloc(size, kAlignment);
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, kAlignment, size) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<unsigned char*>(ptr);
+    }
+
+    static void freeAligned(unsigned char* ptr) {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+    void giveBack(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(index);
+        }
+        available_.notify_one();
+    }
+
+    size_t buffer_size_;
+    size_t count_ = 0;
+    unsigned char* storage_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<size_t> free_;
+};
+
+/**
+ * 直接I/O工具类 - 绕过页缓存读取文件
+ * 数据从设备直接读入对齐的缓冲池，再复制到调用方的内存中，不会挤占页缓存；
+ * 文件系统不支持O_DIRECT（例如tmpfs）或平台不支持时自动回退到普通读取
+ */
+class DirectIO {
+public:
+    /**
+     * 打开文件用于直接读取
+     * @param file_path 文件路径
+     * @param direct 输出参数，文件是否以O_DIRECT方式打开
+     * @return 文件描述符
+     */
+    static int open(const std::string& file_path, bool& direct) {
+#if defined(_WIN32)
+        (void)file_path;
+        direct = false;
+        throw std::runtime_error("Direct I/O is not supported on this platform");
+#else
+#ifdef O_DIRECT
+        int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (fd >= 0) {
+            direct = true;
+            return fd;
+        }
+        if (errno != EINVAL) {
+            throw std::runtime_error("Failed to open file: " + file_path + " - " + strerror(errno));
+        }
+#endif
+        direct = false;
+        int buffered_fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (buffered_fd < 0) {
+            throw std::runtime_error("Failed to open file: " + file_path + " - " + strerror(errno));
+        }
+        return buffered_fd;
+#endif
+    }
+
+    /**
+     * 从以O_DIRECT方式打开的文件中读取任意区间
+     * 读取按块对齐进行，非对齐的起始偏移和文件末尾的不完整块都会被正确截取
+     * @param fd 文件描述符
+     * @param offset 起始偏移
+     * @param dst 目标内存，长度至少为length
+     * @param length 读取长度
+     * @param pool 对齐缓冲池
+     * @return 实际读取的字节数，到达文件末尾时小于length
+     */
+    static size_t readAt(int fd, uint64_t offset, unsigned char* dst, size_t length, DirectIOBufferPool& pool) {
+#if defined(_WIN32)
+        (void)fd; (void)offset; (void)dst; (void)length; (void)pool;
+        throw std::runtime_error("Direct I/O is not supported on this platform");
+#else
+        DirectIOBufferPool::Lease buffer = pool.acquire();
+        size_t done = 0;
+        while (done < length) {
+            uint64_t position = offset + done;
+            size_t aligned_position = DirectIOBufferPool::alignDown(position);
+            size_t skew = static_cast<size_t>(position - aligned_position);
+            size_t span = std::min(buffer.size(), DirectIOBufferPool::alignUp(skew + (length - done)));
+
+            ssize_t n = pread(fd, buffer.data(), span, static_cast<off_t>(aligned_position));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Direct read failed: ") + strerror(errno));
+            }
+            if (static_cast<size_t>(n) <= skew) {
+                // 到达文件末尾
+                break;
+            }
+
+            size_t useful = std::min(static_cast<size_t>(n) - skew, length - done);
+            memcpy(dst + done, buffer.data() + skew, useful);
+            done += useful;
+            if (static_cast<size_t>(n) < span) {
+                // 读到了文件末尾的不完整块
+                break;
+            }
+        }
+        return done;
+#endif
+    }
+};
+
+#endif // DIRECT_IO_H
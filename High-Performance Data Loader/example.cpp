@@ -1,6 +1,7 @@
 #include "data_loader.h"
 #include "file_io.h"
 #include "storage.h"
+#include "image_ops.h"
 #include <iostream>
 #include <chrono>
 
@@ -18,11 +19,13 @@ std::unique_ptr<DataItem> loadImage(const std::string& path) {
     int width = 640;
     int height = 480;
     int channels = 3;
-    auto data = std::make_unique<unsigned char[]>(width * height * channels);
+    // 像素数据使用池化缓冲区，批次释放后缓冲区回到缓冲池供后续样本复用
+    PooledBuffer data(width * height * channels);
     
-    // 填充一些随机数据作为示例
+    // 填充一些随机数据作为示例；生成器由路径派生，同一路径总是得到相同的内容
+    PhiloxRng rng(/*seed=*/0, std::hash<std::string>{}(path));
     for (int i = 0; i < width * height * channels; ++i) {
-        data[i] = static_cast<unsigned char>(rand() % 256);
+        data[i] = static_cast<unsigned char>(rng());
     }
     
     return std::make_unique<ImageData>(width, height, channels, std::move(data));
@@ -39,8 +42,8 @@ std::unique_ptr<DataItem> loadText(const std::string& path) {
     return std::make_unique<TextData>(text);
 }
 
-// 模拟图像预处理函数
-std::unique_ptr<DataItem> preprocessImage(std::unique_ptr<DataItem> item) {
+// 模拟图像预处理函数：随机缩放裁剪，随机数来自预处理上下文，结果与线程数无关
+std::unique_ptr<DataItem> preprocessImage(std::unique_ptr<DataItem> item, ProcessingContext& context) {
     // 将DataItem转换为ImageData
     auto* image_data = dynamic_cast<ImageData*>(item.get());
     if (!image_data) {
@@ -52,9 +55,27 @@ std::unique_ptr<DataItem> preprocessImage(std::unique_ptr<DataItem> item) {
               << image_data->getHeight() << "x" 
               << image_data->getChannels() << std::endl;
     
-    // 在实际应用中，这里会进行resize、crop、normalization等操作
-    // 这里简单返回原图像（实际应用中可能会返回处理后的新图像）
-    return item;
+    // 随机选取裁剪区域并缩放到224x224，裁剪和缩放在一次遍历中完成
+    CropRect rect = ImageOps::randomResizedCrop(image_data->getWidth(), image_data->getHeight(), context.rng);
+    return ImageOps::cropResize(*image_data, rect, 224, 224);
+}
+
+// 图像水平翻转：按行拆分到线程池上并行执行，演示单个大样本的样本内并行
+void flipImageHorizontally(ImageData& image, ThreadPool& pool) {
+    const size_t width = image.getWidth();
+    const size_t channels = image.getChannels();
+    unsigned char* data = image.getData();
+    
+    pool.parallel_for(0, image.getHeight(), 16, [=](size_t row_begin, size_t row_end) {
+        for (size_t y = row_begin; y < row_end; ++y) {
+            unsigned char* row = data + y * width * channels;
+            for (size_t x = 0; x < width / 2; ++x) {
+                for (size_t c = 0; c < channels; ++c) {
+                    std::swap(row[x * channels + c], row[(width - 1 - x) * channels + c]);
+                }
+            }
+        }
+    });
 }
 
 // 模拟文本预处理函数
@@ -92,7 +113,14 @@ int main() {
     // 创建带有缓存的图像数据加载器
     DataLoader image_loader(image_paths, 4, 4, 4, 20, 50); // 缓存容量设为50
     image_loader.setLoaderFunction(loadImage);
-    image_loader.setProcessorFunction(preprocessImage);
+    image_loader.setSeed(42);
+    image_loader.setProcessorFunction([&image_loader](std::unique_ptr<DataItem> item, ProcessingContext& context) {
+        item = preprocessImage(std::move(item), context);
+        if (context.rng.bernoulli(0.5)) {
+            flipImageHorizontally(static_cast<ImageData&>(*item), image_loader.getProcessorPool());
+        }
+        return item;
+    });
     
     // 计时开始
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -153,6 +181,13 @@ int main() {
               << "x faster" << std::endl;
     std::cout << "Final cache size: " << image_loader.getCacheSize() << " items" << std::endl;
     
+    // 缓冲池统计：第二遍的样本缓冲区大多复用第一遍释放的内存
+    BufferPool::Stats pool_stats = BufferPool::shared().stats();
+    std::cout << "Buffer pool: " << pool_stats.allocations << " allocations, "
+              << pool_stats.reuseRate() * 100.0 << "% reused, "
+              << pool_stats.buffers_in_use << " buffers in use, "
+              << pool_stats.bytes_cached / 1024 << " KB cached" << std::endl;
+    
     // 清空缓存示例
     image_loader.clearCache();
     std::cout << "After clearing cache: " << image_loader.getCacheSize() << " items" << std::endl;
@@ -202,7 +237,7 @@ int main() {
     std::cout << "\nTesting HDFS Storage..." << std::endl;
     
     // 创建HDFS存储实例
-    auto hdfs_storage = StorageFactory::createHDFSStorage("hdfs-namenode", 9000);
+    auto hdfs_storage = StorageFactory::createHDFSStorage("hdfs-namenode", 9870);
     
     // 连接到HDFS存储
     if (hdfs_storage->connect()) {
@@ -211,7 +246,7 @@ int main() {
         // 创建HDFS文件路径列表
         std::vector<std::string> hdfs_image_paths;
         for (int i = 0; i < 5; ++i) {
-            hdfs_image_paths.push_back("hdfs://hdfs-namenode:9000/images/image_" + std::to_string(i) + ".jpg");
+            hdfs_image_paths.push_back("hdfs://hdfs-namenode:9870/images/image_" + std::to_string(i) + ".jpg");
         }
         
         // 创建使用HDFS存储的数据加载器
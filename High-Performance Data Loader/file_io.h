@@ -5,10 +5,18 @@
 #include <vector>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <string_view>
+#include <algorithm>
+#include "direct_io.h"
+#include "access_advice.h"
 
 #ifdef _WIN32
 #include <windows.h>
+#include <sys/stat.h>
 #else
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -18,50 +26,126 @@
 #include <string.h>
 #endif
 
+class MappedBuffer;
+
 /**
- * 文件I/O工具类 - 提供高性能的文件读取功能
+ * 内存映射文件 - 持有文件映射，最后一个引用释放时解除映射
+ * 通过MappedFile::open()创建，总是由shared_ptr管理，
+ * 从中切出的MappedBuffer共享映射的所有权
  */
-class FileIO {
+class MappedFile {
 public:
     /**
-     * 读取整个文件到内存
+     * 映射文件
      * @param file_path 文件路径
-     * @return 文件内容的内存缓冲区
+     * @param copy_on_write 为true时映射为写时复制（私有可写），写入不会影响文件
+     * @return 映射文件实例
      */
-    static std::vector<unsigned char> readFile(const std::string& file_path) {
-        FILE* file = fopen(file_path.c_str(), "rb");
-        if (!file) {
-            throw std::runtime_error("Failed to open file: " + file_path);
+    static std::shared_ptr<MappedFile> open(const std::string& file_path, bool copy_on_write = false) {
+        return std::shared_ptr<MappedFile>(new MappedFile(file_path, copy_on_write));
+    }
+    
+    /**
+     * 禁止拷贝构造函数
+     */
+    MappedFile(const MappedFile&) = delete;
+    
+    /**
+     * 禁止赋值操作符
+     */
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    /**
+     * 析构函数 - 解除映射
+     */
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_) {
+            UnmapViewOfFile(data_);
         }
+        if (mapping_) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+        }
+#else
+        if (data_) {
+            munmap(data_, size_);
+        }
+#endif
+    }
+    
+    /**
+     * 获取映射的数据
+     * @return 数据指针，空文件返回nullptr
+     */
+    const unsigned char* data() const {
+        return data_;
+    }
+    
+    /**
+     * 获取映射大小
+     * @return 文件大小（字节）
+     */
+    size_t size() const {
+        return size_;
+    }
+    
+    /**
+     * 获取映射文件的路径
+     * @return 文件路径
+     */
+    const std::string& path() const {
+        return path_;
+    }
+    
+    /**
+     * 向内核提供映射区间的访问模式提示
+     * @param advice 访问模式
+     * @param offset 区间起始偏移
+     * @param length 区间长度，超出文件末尾的部分会被截断
+     */
+    void advise(AccessAdvice advice, size_t offset = 0, size_t length = static_cast<size_t>(-1)) const {
+#ifdef _WIN32
+        // Windows没有等价的madvise，忽略提示
+        (void)advice;
+        (void)offset;
+        (void)length;
+#else
+        if (!data_ || offset >= size_) {
+            return;
+        }
+        length = std::min(length, size_ - offset);
         
-        // 获取文件大小
-        fseek(file, 0, SEEK_END);
-        long file_size = ftell(file);
-        fseek(file, 0, SEEK_SET);
-        
-        // 分配缓冲区
-        std::vector<unsigned char> buffer(file_size);
+        // madvise要求起始地址按页对齐
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t aligned_offset = offset / page_size * page_size;
+        length += offset - aligned_offset;
         
-        // 读取文件内容
-        size_t bytes_read = fread(buffer.data(), 1, file_size, file);
-        if (bytes_read != static_cast<size_t>(file_size)) {
-            fclose(file);
-            throw std::runtime_error("Failed to read entire file: " + file_path);
+        int flag = MADV_NORMAL;
+        switch (advice) {
+            case AccessAdvice::Normal: flag = MADV_NORMAL; break;
+            case AccessAdvice::Sequential: flag = MADV_SEQUENTIAL; break;
+            case AccessAdvice::Random: flag = MADV_RANDOM; break;
+            case AccessAdvice::WillNeed: flag = MADV_WILLNEED; break;
+            case AccessAdvice::DontNeed: flag = MADV_DONTNEED; break;
         }
-        
-        fclose(file);
-        return buffer;
+        madvise(data_ + aligned_offset, length, flag);
+#endif
     }
     
     /**
-     * 使用内存映射读取文件
-     * @param file_path 文件路径
-     * @return 内存映射的文件内容
+     * 获取整个文件的只读视图
+     * @param self 指向本映射的shared_ptr，视图共享其所有权
+     * @return 只读视图
      */
-    static std::shared_ptr<unsigned char[]> mmapFile(const std::string& file_path, size_t& out_size) {
+    static MappedBuffer buffer(const std::shared_ptr<const MappedFile>& self);
+    
+private:
+    MappedFile(const std::string& file_path, bool copy_on_write) : path_(file_path) {
 #ifdef _WIN32
-        // Windows实现
-        HANDLE hFile = CreateFileA(
+        file_ = CreateFileA(
             file_path.c_str(),
             GENERIC_READ,
             FILE_SHARE_READ,
@@ -71,94 +155,253 @@ public:
             NULL
         );
         
-        if (hFile == INVALID_HANDLE_VALUE) {
+        if (file_ == INVALID_HANDLE_VALUE) {
             throw std::runtime_error("Failed to open file: " + file_path);
         }
         
-        // 获取文件大小
-        DWORD file_size_low = GetFileSize(hFile, NULL);
-        if (file_size_low == INVALID_FILE_SIZE) {
-            CloseHandle(hFile);
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size)) {
+            CloseHandle(file_);
             throw std::runtime_error("Failed to get file size: " + file_path);
         }
+        size_ = static_cast<size_t>(file_size.QuadPart);
+        if (size_ == 0) {
+            return;
+        }
         
-        out_size = static_cast<size_t>(file_size_low);
-        
-        // 创建文件映射
-        HANDLE hMapping = CreateFileMappingA(
-            hFile,
-            NULL,
-            PAGE_READONLY,
-            0,
-            0,
-            NULL
-        );
-        
-        if (!hMapping) {
-            CloseHandle(hFile);
+        mapping_ = CreateFileMappingA(file_, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+        if (!mapping_) {
+            CloseHandle(file_);
             throw std::runtime_error("Failed to create file mapping: " + file_path);
         }
         
-        // 映射视图
-        void* mapped_data = MapViewOfFile(
-            hMapping,
-            FILE_MAP_READ,
-            0,
-            0,
-            0
-        );
-        
-        if (!mapped_data) {
-            CloseHandle(hMapping);
-            CloseHandle(hFile);
+        data_ = static_cast<unsigned char*>(MapViewOfFile(mapping_, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+        if (!data_) {
+            CloseHandle(mapping_);
+            CloseHandle(file_);
             throw std::runtime_error("Failed to map view of file: " + file_path);
         }
-        
-        // 复制映射的数据到堆内存
-        auto buffer = std::shared_ptr<unsigned char[]>(new unsigned char[out_size]);
-        memcpy(buffer.get(), mapped_data, out_size);
-        
-        // 清理资源
-        UnmapViewOfFile(mapped_data);
-        CloseHandle(hMapping);
-        CloseHandle(hFile);
-        
-        return buffer;
 #else
-        // POSIX实现
-        int fd = open(file_path.c_str(), O_RDONLY);
+        int fd = ::open(file_path.c_str(), O_RDONLY);
         if (fd < 0) {
             throw std::runtime_error("Failed to open file: " + file_path + " - " + strerror(errno));
         }
         
-        // 获取文件大小
         struct stat stat_buf;
         if (fstat(fd, &stat_buf) < 0) {
             close(fd);
             throw std::runtime_error("Failed to get file size: " + file_path + " - " + strerror(errno));
         }
+        size_ = static_cast<size_t>(stat_buf.st_size);
         
-        out_size = static_cast<size_t>(stat_buf.st_size);
+        // 空文件无法映射，保持data_为空
+        if (size_ > 0) {
+            int prot = copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
+            void* mapped_data = mmap(NULL, size_, prot, MAP_PRIVATE, fd, 0);
+            if (mapped_data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Failed to mmap file: " + file_path + " - " + strerror(errno));
+            }
+            data_ = static_cast<unsigned char*>(mapped_data);
+        }
         
-        // 内存映射
-        void* mapped_data = mmap(NULL, out_size, PROT_READ, MAP_PRIVATE, fd, 0);
-        if (mapped_data == MAP_FAILED) {
-            close(fd);
-            throw std::runtime_error("Failed to mmap file: " + file_path + " - " + strerror(errno));
+        // 映射建立后文件描述符不再需要
+        close(fd);
+#endif
+    }
+    
+    std::string path_;
+    unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = NULL;
+#endif
+};
+
+/**
+ * 映射缓冲区 - 内存映射文件中一段区间的只读视图
+ * 持有映射的共享所有权，因此可以在映射调用返回后继续使用，
+ * 拷贝和切片都不会复制数据
+ */
+class MappedBuffer {
+public:
+    MappedBuffer() = default;
+    
+    /**
+     * 构造函数
+     * @param file 映射文件
+     * @param offset 区间起始偏移
+     * @param length 区间长度
+     */
+    MappedBuffer(std::shared_ptr<const MappedFile> file, size_t offset, size_t length)
+        : file_(std::move(file)) {
+        if (!file_ || offset > file_->size() || length > file_->size() - offset) {
+            throw std::out_of_range("MappedBuffer range exceeds mapped file");
+        }
+        data_ = file_->data() ? file_->data() + offset : nullptr;
+        size_ = length;
+    }
+    
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const unsigned char* begin() const { return data_; }
+    const unsigned char* end() const { return data_ + size_; }
+    unsigned char operator[](size_t index) const { return data_[index]; }
+    
+    /**
+     * 获取底层映射文件
+     * @return 映射文件，默认构造的缓冲区返回空
+     */
+    const std::shared_ptr<const MappedFile>& file() const {
+        return file_;
+    }
+    
+    /**
+     * 切出子区间，与本缓冲区共享映射
+     * @param offset 相对于本缓冲区的起始偏移
+     * @param length 子区间长度，默认到缓冲区末尾
+     * @return 子区间视图
+     */
+    MappedBuffer subspan(size_t offset, size_t length = static_cast<size_t>(-1)) const {
+        if (offset > size_) {
+            throw std::out_of_range("MappedBuffer subspan offset out of range");
+        }
+        length = std::min(length, size_ - offset);
+        MappedBuffer result;
+        result.file_ = file_;
+        result.data_ = data_ ? data_ + offset : nullptr;
+        result.size_ = length;
+        return result;
+    }
+    
+    /**
+     * 以字符串视图的形式访问数据
+     * @return 字符串视图
+     */
+    std::string_view asStringView() const {
+        return std::string_view(reinterpret_cast<const char*>(data_), size_);
+    }
+    
+    /**
+     * 向内核提供本区间的访问模式提示
+     * @param advice 访问模式
+     */
+    void advise(AccessAdvice advice) const {
+        if (file_ && data_) {
+            file_->advise(advice, static_cast<size_t>(data_ - file_->data()), size_);
+        }
+    }
+    
+private:
+    std::shared_ptr<const MappedFile> file_;
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+inline MappedBuffer MappedFile::buffer(const std::shared_ptr<const MappedFile>& self) {
+    return MappedBuffer(self, 0, self->size());
+}
+
+/**
+ * 文件I/O工具类 - 提供高性能的文件读取功能
+ */
+class FileIO {
+public:
+    /**
+     * 读取整个文件到内存
+     * @param file_path 文件路径
+     * @return 文件内容的内存缓冲区
+     */
+    static std::vector<unsigned char> readFile(const std::string& file_path) {
+        FILE* file = fopen(file_path.c_str(), "rb");
+        if (!file) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        
+        // 获取文件大小（64位，超过2GB的文件也能正确读取）
+        size_t file_size = openedFileSize(file, file_path);
+        
+        // 分配缓冲区
+        std::vector<unsigned char> buffer(file_size);
+        
+        // 读取文件内容
+        size_t bytes_read = fread(buffer.data(), 1, file_size, file);
+        if (bytes_read != file_size) {
+            fclose(file);
+            throw std::runtime_error("Failed to read entire file: " + file_path);
         }
         
-        // 复制映射的数据到堆内存
-        auto buffer = std::shared_ptr<unsigned char[]>(new unsigned char[out_size]);
-        memcpy(buffer.get(), mapped_data, out_size);
+        fclose(file);
+        return buffer;
+    }
+    
+    /**
+     * 使用直接I/O读取整个文件，数据不经过页缓存
+     * 文件系统或平台不支持O_DIRECT时退化为普通读取
+     * @param file_path 文件路径
+     * @return 文件内容的内存缓冲区
+     */
+    static std::vector<unsigned char> readFileDirect(const std::string& file_path) {
+#ifdef _WIN32
+        return readFile(file_path);
+#else
+        bool direct = false;
+        int fd = DirectIO::open(file_path, direct);
         
-        // 清理资源
-        munmap(mapped_data, out_size);
+        struct stat stat_buf;
+        if (fstat(fd, &stat_buf) < 0) {
+            close(fd);
+            throw std::runtime_error("Failed to get file size: " + file_path + " - " + strerror(errno));
+        }
+        
+        std::vector<unsigned char> buffer(static_cast<size_t>(stat_buf.st_size));
+        size_t bytes_read = 0;
+        try {
+            bytes_read = DirectIO::readAt(fd, 0, buffer.data(), buffer.size(), DirectIOBufferPool::shared());
+        } catch (const std::exception&) {
+            close(fd);
+            throw;
+        }
         close(fd);
         
+        buffer.resize(bytes_read);
         return buffer;
 #endif
     }
     
+    /**
+     * 使用内存映射读取文件
+     * 返回的缓冲区直接指向写时复制的映射，不复制文件内容；
+     * 映射在最后一个引用释放时解除
+     * @param file_path 文件路径
+     * @param out_size 输出文件大小
+     * @return 内存映射的文件内容
+     */
+    static std::shared_ptr<unsigned char[]> mmapFile(const std::string& file_path, size_t& out_size) {
+        std::shared_ptr<MappedFile> mapping = MappedFile::open(file_path, true);
+        out_size = mapping->size();
+        
+        // 写时复制映射是可写的，写入只影响本进程的私有页
+        unsigned char* data = const_cast<unsigned char*>(mapping->data());
+        return std::shared_ptr<unsigned char[]>(mapping, data);
+    }
+    
+    /**
+     * 以只读方式映射文件，不复制数据
+     * @param file_path 文件路径
+     * @param advice 映射建立后立即应用的访问模式提示
+     * @return 整个文件的只读视图
+     */
+    static MappedBuffer mapFile(const std::string& file_path, AccessAdvice advice = AccessAdvice::Normal) {
+        std::shared_ptr<const MappedFile> mapping = MappedFile::open(file_path);
+        if (advice != AccessAdvice::Normal) {
+            mapping->advise(advice);
+        }
+        return MappedFile::buffer(mapping);
+    }
+    
     /**
      * 检查文件是否存在
      * @param file_path 文件路径
@@ -215,28 +458,54 @@ public:
 #endif
     }
     
+    /**
+     * 向内核提示将如何访问文件（posix_fadvise）
+     * 适用于WillNeed（提前读入页缓存）和DontNeed（从页缓存中逐出）；
+     * Sequential/Random只对同一个文件描述符上的读取有效，应在读取时通过ReadRequest::advice指定
+     * @param file_path 文件路径
+     * @param advice 访问模式
+     * @param offset 起始偏移
+     * @param length 长度，0表示到文件末尾
+     * @return 文件能够打开时返回true
+     */
+    static bool adviseFile(const std::string& file_path, AccessAdvice advice, uint64_t offset = 0, uint64_t length = 0) {
+#ifdef _WIN32
+        (void)advice;
+        (void)offset;
+        (void)length;
+        return fileExists(file_path);
+#else
+        int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        adviseDescriptor(fd, advice, offset, length);
+        close(fd);
+        return true;
+#endif
+    }
+    
     /**
      * 读取文本文件
      * @param file_path 文件路径
      * @return 文件内容的字符串
      */
     static std::string readTextFile(const std::string& file_path) {
-        FILE* file = fopen(file_path.c_str(), "r");
+        // 以二进制方式读取，文本模式下的换行转换会使读取字节数与文件大小不一致
+        FILE* file = fopen(file_path.c_str(), "rb");
         if (!file) {
             throw std::runtime_error("Failed to open file: " + file_path);
         }
         
         // 获取文件大小
-        fseek(file, 0, SEEK_END);
-        long file_size = ftell(file);
-        fseek(file, 0, SEEK_SET);
+        size_t file_size = openedFileSize(file, file_path);
         
         // 分配缓冲区
         std::string buffer(file_size, '\0');
         
         // 读取文件内容
         size_t bytes_read = fread(&buffer[0], 1, file_size, file);
-        if (bytes_read != static_cast<size_t>(file_size)) {
+        if (bytes_read != file_size) {
             fclose(file);
             throw std::runtime_error("Failed to read entire file: " + file_path);
         }
@@ -244,6 +513,37 @@ public:
         fclose(file);
         return buffer;
     }
+
+private:
+    /**
+     * 获取已打开文件的大小
+     * 使用64位的fstat代替ftell，后者返回long，在Windows以及32位平台上无法表示超过2GB的文件
+     * @param file 已打开的文件，出错时会被关闭
+     * @param file_path 文件路径，用于错误信息
+     * @return 文件大小（字节）
+     */
+    static size_t openedFileSize(FILE* file, const std::string& file_path) {
+#ifdef _WIN32
+        struct _stat64 stat_buf;
+        if (_fstat64(_fileno(file), &stat_buf) != 0) {
+            fclose(file);
+            throw std::runtime_error("Failed to get file size: " + file_path);
+        }
+#else
+        struct stat stat_buf;
+        if (fstat(fileno(file), &stat_buf) < 0) {
+            int error = errno;
+            fclose(file);
+            throw std::runtime_error("Failed to get file size: " + file_path + " - " + strerror(error));
+        }
+#endif
+        uint64_t file_size = static_cast<uint64_t>(stat_buf.st_size);
+        if (file_size > static_cast<uint64_t>(SIZE_MAX)) {
+            fclose(file);
+            throw std::runtime_error("File too large to read into memory: " + file_path);
+        }
+        return static_cast<size_t>(file_size);
+    }
 };
 
 #endif // FILE_IO_H
\ No newline at end of file
@@ -0,0 +1,514 @@
+#include "storage.h"
+#include "json.h"
+#include "sigv4.h"
+#include "thread_pool.h"
+#include <cstdlib>
+
+namespace {
+
+// readFilePooled()第一个请求读取的字节数，不超过part_size
+constexpr size_t kProbeBytes = 1 << 20;
+
+// 跟随重定向的最大次数；WebHDFS的OPEN只有名称节点到数据节点的一次重定向
+constexpr int kMaxRedirects = 4;
+
+std::string environment(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? value : "";
+}
+
+} // namespace
+
+// HDFSStorage实现
+
+HDFSStorage::HDFSStorage(
+    const std::string& namenode,
+    int port
+) : HDFSStorage(namenode, port, HDFSConfig()) {}
+
+HDFSStorage::HDFSStorage(const std::string& namenode, int port, const HDFSConfig& config)
+    : namenode_(namenode), port_(port), config_(config), connected_(false) {
+    if (config_.user.empty() && config_.delegation_token.empty()) {
+        config_.user = environment("HADOOP_USER_NAME");
+    }
+    if (config_.endpoint.empty()) {
+        std::string host = namenode_.find(':') != std::string::npos ? "[" + namenode_ + "]" : namenode_;
+        config_.endpoint = "http://" + host + ":" + std::to_string(port_);
+    }
+
+    HttpOptions options;
+    options.max_connections = config_.max_connections;
+    options.timeout_ms = config_.timeout_ms;
+    options.verify_tls = config_.verify_tls;
+    client_ = std::make_unique<HttpClient>(config_.endpoint, options);
+
+    config_.part_size = std::max<size_t>(config_.part_size, 64 * 1024);
+    config_.max_concurrency = std::max<size_t>(config_.max_concurrency, 1);
+    pool_ = std::make_unique<ThreadPool>(std::max<size_t>(config_.max_concurrency - 1, 1));
+}
+
+HDFSStorage::~HDFSStorage() {
+    if (connected_) {
+        disconnect();
+    }
+}
+
+bool HDFSStorage::connect() {
+    try {
+        HttpResponse response = send(requestTarget("/", "GETFILESTATUS"));
+        connected_ = response.status == 200;
+    } catch (const std::runtime_error&) {
+        connected_ = false;
+    }
+    return connected_;
+}
+
+void HDFSStorage::disconnect() {
+    client_->closeIdle();
+    std::lock_guard<std::mutex> lock(datanodes_mutex_);
+    for (auto& entry : datanodes_) {
+        entry.second->closeIdle();
+    }
+    connected_ = false;
+}
+
+bool HDFSStorage::isConnected() const {
+    return connected_;
+}
+
+void HDFSStorage::requireConnected() const {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to HDFS");
+    }
+}
+
+HttpClient::Stats HDFSStorage::httpStats() const {
+    HttpClient::Stats total = client_->stats();
+    std::lock_guard<std::mutex> lock(datanodes_mutex_);
+    for (const auto& entry : datanodes_) {
+        HttpClient::Stats stats = entry.second->stats();
+        total.requests += stats.requests;
+        total.connections_opened += stats.connections_opened;
+        total.retries += stats.retries;
+    }
+    return total;
+}
+
+std::string HDFSStorage::hdfsPath(const std::string& file_path) const {
+    if (file_path.compare(0, 7, "hdfs://") == 0) {
+        size_t slash = file_path.find('/', 7);
+        std::string authority = file_path.substr(7, slash == std::string::npos ? std::string::npos : slash - 7);
+        if (authority != namenode_ && authority != namenode_ + ":" + std::to_string(port_)) {
+            throw std::runtime_error("Path " + file_path + " is not on namenode " + namenode_ + ":" +
+                                     std::to_string(port_));
+        }
+        return slash == std::string::npos ? "/" : file_path.substr(slash);
+    }
+    return file_path.compare(0, 1, "/") == 0 ? file_path : "/" + file_path;
+}
+
+std::string HDFSStorage::requestTarget(const std::string& path, const std::string& op, const std::string& query) const {
+    std::string target = "/webhdfs/v1" + uriEncode(path, false) + "?op=" + op;
+    if (!config_.delegation_token.empty()) {
+        target += "&delegation=" + uriEncode(config_.delegation_token);
+    } else if (!config_.user.empty()) {
+        target += "&user.name=" + uriEncode(config_.user);
+    }
+    if (!query.empty()) {
+        target += "&" + query;
+    }
+    return target;
+}
+
+HttpClient& HDFSStorage::clientFor(const std::string& base_url) {
+    if (base_url == config_.endpoint) {
+        return *client_;
+    }
+    std::lock_guard<std::mutex> lock(datanodes_mutex_);
+    std::unique_ptr<HttpClient>& client = datanodes_[base_url];
+    if (!client) {
+        HttpOptions options;
+        options.max_connections = config_.max_connections;
+        options.timeout_ms = config_.timeout_ms;
+        options.verify_tls = config_.verify_tls;
+        try {
+            client = std::make_unique<HttpClient>(base_url, options);
+        } catch (...) {
+            datanodes_.erase(base_url);
+            throw;
+        }
+    }
+    return *client;
+}
+
+HttpResponse HDFSStorage::send(const std::string& target, unsigned char* buffer, size_t capacity, size_t* received) {
+    HttpClient* client = client_.get();
+    std::string current = target;
+    for (int redirects = 0;; ++redirects) {
+        HttpResponse response;
+        // 连接失败、超时和连接中断都可能是暂时的；响应格式错误等其他错误原样抛出，不会被重试
+        try {
+            if (buffer) {
+                response = client->requestInto("GET", current, {}, buffer, capacity, *received);
+            } else {
+                response = client->request("GET", current, {});
+            }
+        } catch (const HttpTransportError& e) {
+            throw TransientStorageError(e.what());
+        }
+
+        const std::string* location = response.header("location");
+        if (response.status < 300 || response.status >= 400 || !location || redirects == kMaxRedirects) {
+            return response;
+        }
+
+        // 重定向到数据节点：Location是带数据节点地址的完整URL，使用该数据节点的连接池
+        size_t scheme = location->find("://");
+        if (scheme == std::string::npos) {
+            current = *location;
+            continue;
+        }
+        size_t path_start = location->find('/', scheme + 3);
+        client = &clientFor(location->substr(0, path_start));
+        current = path_start == std::string::npos ? "/" : location->substr(path_start);
+    }
+}
+
+void HDFSStorage::throwError(const std::string& operation, const std::string& path,
+                             const HttpResponse& response) const {
+    std::string message = operation + " hdfs://" + namenode_ + ":" + std::to_string(port_) + path +
+                          " failed: HTTP " + std::to_string(response.status);
+
+    // 错误响应体：{"RemoteException":{"exception":"...","javaClassName":"...","message":"..."}}
+    std::string exception;
+    try {
+        JsonValue remote = JsonValue::parse(response.body)["RemoteException"];
+        if (const JsonValue* name = remote.find("exception")) {
+            exception = name->asString();
+            message += " " + exception;
+        }
+        if (const JsonValue* detail = remote.find("message")) {
+            message += ": " + detail->asString();
+        }
+    } catch (const std::runtime_error&) {
+        // 响应体不是WebHDFS的错误格式（例如代理返回的HTML页面）
+    }
+
+    // 限流、服务端错误、备用名称节点（HA切换期间）和名称节点要求重试的错误可以重试
+    if (response.status == 429 || response.status >= 500 || exception == "StandbyException" ||
+        exception == "RetriableException") {
+        throw TransientStorageError(message);
+    }
+    throw std::runtime_error(message);
+}
+
+bool HDFSStorage::status(const std::string& path, FileStatus* file_status) {
+    HttpResponse response = send(requestTarget(path, "GETFILESTATUS"));
+    if (response.status == 404) {
+        return false;
+    }
+    if (response.status != 200) {
+        throwError("GETFILESTATUS", path, response);
+    }
+    if (file_status) {
+        try {
+            const JsonValue json = JsonValue::parse(response.body)["FileStatus"];
+            file_status->directory = json["type"].asString() == "DIRECTORY";
+            file_status->length = json["length"].asUint();
+            const JsonValue* block_size = json.find("blockSize");
+            file_status->block_size = block_size ? block_size->asUint() : 0;
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("Invalid GETFILESTATUS response for " + path + ": " + e.what());
+        }
+    }
+    return true;
+}
+
+size_t HDFSStorage::openRange(const std::string& path, uint64_t offset, unsigned char* buffer, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    std::string query = "offset=" + std::to_string(offset) + "&length=" + std::to_string(length);
+    size_t received = 0;
+    HttpResponse response = send(requestTarget(path, "OPEN", query), buffer, length, &received);
+    if (response.status == 200) {
+        return received;
+    }
+    if (response.status == 404) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+    if (response.status >= 400 && response.status < 500) {
+        // 起点超出文件末尾时数据节点返回4xx（不同版本为400或403），与本地读取一致地返回0字节
+        FileStatus file_status;
+        if (status(path, &file_status) && !file_status.directory && offset >= file_status.length) {
+            return 0;
+        }
+    }
+    throwError("OPEN", path, response);
+}
+
+size_t HDFSStorage::openRangeParallel(const std::string& path, uint64_t offset, unsigned char* buffer, size_t length,
+                                      const FileStatus* known_status) {
+    if (length <= config_.part_size) {
+        return openRange(path, offset, buffer, length);
+    }
+
+    // 分段需要知道文件长度和块大小
+    FileStatus file_status;
+    if (known_status) {
+        file_status = *known_status;
+    } else if (!status(path, &file_status)) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+    if (file_status.directory) {
+        throw std::runtime_error("HDFS path is a directory: " + path);
+    }
+    if (offset >= file_status.length) {
+        return 0;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, file_status.length - offset));
+
+    // 分段在数据块边界处切开，每个分段由一个数据节点提供；按（块内序号，块号）排列，
+    // 使同时进行的请求分散到不同的块上，从而分散到不同的数据节点
+    struct Part {
+        size_t begin;       // 相对于offset的起点
+        size_t size;
+        uint64_t block;     // 所在的数据块
+        size_t index;       // 在块内的序号
+    };
+    std::vector<Part> parts;
+    uint64_t block_size = file_status.block_size;
+    uint64_t end = offset + length;
+    for (uint64_t pos = offset; pos < end;) {
+        uint64_t block = block_size ? pos / block_size : 0;
+        uint64_t block_end = block_size ? (block + 1) * block_size : end;
+        uint64_t part_end = std::min({end, block_end, pos + config_.part_size});
+        size_t index = parts.empty() || parts.back().block != block ? 0 : parts.back().index + 1;
+        parts.push_back({static_cast<size_t>(pos - offset), static_cast<size_t>(part_end - pos), block, index});
+        pos = part_end;
+    }
+    if (parts.size() == 1) {
+        return openRange(path, offset, buffer, length);
+    }
+    std::vector<size_t> order(parts.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&parts](size_t a, size_t b) {
+        return parts[a].index != parts[b].index ? parts[a].index < parts[b].index : parts[a].block < parts[b].block;
+    });
+
+    // 最多max_concurrency个任务依次领取分段，各段直接写入缓冲区中对应的位置；
+    // 调用线程在wait()中也执行任务，因此线程池只需max_concurrency - 1个线程参与
+    std::vector<size_t> received(parts.size(), 0);
+    std::atomic<size_t> next{0};
+    {
+        ThreadPool::TaskGroup group(*pool_);
+        size_t tasks = std::min(parts.size(), config_.max_concurrency);
+        for (size_t task = 0; task < tasks; ++task) {
+            group.run([this, &path, &parts, &order, &received, &next, offset, buffer]() {
+                for (size_t i = next++; i < order.size(); i = next++) {
+                    const Part& part = parts[order[i]];
+                    received[order[i]] = openRange(path, offset + part.begin, buffer + part.begin, part.size);
+                }
+            });
+        }
+        group.wait();
+    }
+
+    // 文件在读取期间被截短时，总长度为第一个不完整分段之前（含）的字节数
+    size_t total = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        total += received[i];
+        if (received[i] < parts[i].size) {
+            break;
+        }
+    }
+    return total;
+}
+
+size_t HDFSStorage::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+    requireConnected();
+    return openRangeParallel(hdfsPath(file_path), offset, buffer, length);
+}
+
+std::vector<unsigned char> HDFSStorage::readRange(const std::string& file_path, uint64_t offset, size_t length) {
+    requireConnected();
+    std::string path = hdfsPath(file_path);
+    if (length > config_.part_size) {
+        // 先得到文件长度，避免为超出文件末尾的部分分配内存
+        FileStatus file_status;
+        if (!status(path, &file_status)) {
+            throw std::runtime_error("HDFS file not found: " + path);
+        }
+        length = static_cast<size_t>(std::min<uint64_t>(length, file_status.length > offset ? file_status.length - offset : 0));
+        std::vector<unsigned char> data(length);
+        data.resize(openRangeParallel(path, offset, data.data(), length, &file_status));
+        return data;
+    }
+    std::vector<unsigned char> data(length);
+    data.resize(openRange(path, offset, data.data(), length));
+    return data;
+}
+
+PooledBuffer HDFSStorage::readFilePooled(const std::string& file_path) {
+    requireConnected();
+    std::string path = hdfsPath(file_path);
+
+    // 第一个请求不带文件大小，小文件一次OPEN即可读完，不需要先发GETFILESTATUS；
+    // 读满kProbeBytes时再查询文件长度和块大小，其余部分按块并行读取
+    size_t probe = std::min(config_.part_size, kProbeBytes);
+    PooledBuffer first(probe);
+    size_t received = openRange(path, 0, first.data(), probe);
+    if (received < probe) {
+        first.resize(received);
+        return first;
+    }
+
+    FileStatus file_status;
+    if (!status(path, &file_status)) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+    if (file_status.length <= received) {
+        first.resize(static_cast<size_t>(file_status.length));
+        return first;
+    }
+
+    PooledBuffer buffer(static_cast<size_t>(file_status.length));
+    memcpy(buffer.data(), first.data(), received);
+    first = PooledBuffer();
+    size_t rest = openRangeParallel(path, received, buffer.data() + received,
+                                    static_cast<size_t>(file_status.length) - received, &file_status);
+    buffer.resize(received + rest);
+    return buffer;
+}
+
+std::vector<unsigned char> HDFSStorage::readFile(const std::string& file_path) {
+    PooledBuffer buffer = readFilePooled(file_path);
+    return std::vector<unsigned char>(buffer.begin(), buffer.end());
+}
+
+std::string HDFSStorage::readTextFile(const std::string& file_path) {
+    PooledBuffer buffer = readFilePooled(file_path);
+    return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+bool HDFSStorage::fileExists(const std::string& file_path) {
+    requireConnected();
+    FileStatus file_status;
+    return status(hdfsPath(file_path), &file_status) && !file_status.directory;
+}
+
+size_t HDFSStorage::getFileSize(const std::string& file_path) {
+    requireConnected();
+    std::string path = hdfsPath(file_path);
+    FileStatus file_status;
+    if (!status(path, &file_status)) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+    return static_cast<size_t>(file_status.length);
+}
+
+std::vector<std::string> HDFSStorage::listFiles(const std::string& dir_path) {
+    requireConnected();
+    std::string path = hdfsPath(dir_path);
+
+    // 返回的路径沿用调用方的写法："hdfs://<授权部分>/..."或文件系统内的绝对路径
+    std::string prefix;
+    if (dir_path.compare(0, 7, "hdfs://") == 0) {
+        prefix = dir_path.substr(0, dir_path.find('/', 7));
+    }
+    std::string base = prefix + (path.back() == '/' ? path : path + "/");
+
+    std::vector<std::string> files;
+    auto collect = [&](const JsonValue& statuses) {
+        for (const JsonValue& entry : statuses.asArray()) {
+            const std::string& name = entry["pathSuffix"].asString();
+            if (!name.empty() && entry["type"].asString() == "FILE") {
+                files.push_back(base + name);
+            }
+        }
+    };
+
+    // LISTSTATUS_BATCH分页返回（每页大小由dfs.ls.limit决定），通过startAfter翻页；
+    // 不支持该操作的旧版本名称节点返回400，此时用LISTSTATUS一次取回
+    std::string start_after;
+    while (true) {
+        std::string query = start_after.empty() ? "" : "startAfter=" + uriEncode(start_after);
+        HttpResponse response = send(requestTarget(path, "LISTSTATUS_BATCH", query));
+        if (response.status == 400 && start_after.empty()) {
+            response = send(requestTarget(path, "LISTSTATUS"));
+            if (response.status != 200) {
+                throwError("LISTSTATUS", path, response);
+            }
+            try {
+                collect(JsonValue::parse(response.body)["FileStatuses"]["FileStatus"]);
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error("Invalid LISTSTATUS response for " + path + ": " + e.what());
+            }
+            return files;
+        }
+        if (response.status != 200) {
+            throwError("LISTSTATUS_BATCH", path, response);
+        }
+
+        try {
+            const JsonValue listing = JsonValue::parse(response.body)["DirectoryListing"];
+            const JsonValue& statuses = listing["partialListing"]["FileStatuses"]["FileStatus"];
+            collect(statuses);
+            if (listing["remainingEntries"].asUint() == 0 || statuses.size() == 0) {
+                return files;
+            }
+            start_after = statuses[statuses.size() - 1]["pathSuffix"].asString();
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("Invalid LISTSTATUS_BATCH response for " + path + ": " + e.what());
+        }
+    }
+}
+
+std::vector<BlockLocation> HDFSStorage::getBlockLocations(const std::string& file_path) {
+    requireConnected();
+    std::string path = hdfsPath(file_path);
+    HttpResponse response = send(requestTarget(path, "GETFILEBLOCKLOCATIONS"));
+    if (response.status == 404) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+
+    std::vector<BlockLocation> blocks;
+    if (response.status == 200) {
+        try {
+            const JsonValue locations = JsonValue::parse(response.body)["BlockLocations"]["BlockLocation"];
+            for (const JsonValue& entry : locations.asArray()) {
+                BlockLocation block;
+                block.offset = entry["offset"].asUint();
+                block.length = entry["length"].asUint();
+                if (const JsonValue* hosts = entry.find("hosts")) {
+                    for (const JsonValue& host : hosts->asArray()) {
+                        block.hosts.push_back(host.asString());
+                    }
+                }
+                blocks.push_back(std::move(block));
+            }
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("Invalid GETFILEBLOCKLOCATIONS response for " + path + ": " + e.what());
+        }
+        return blocks;
+    }
+    if (response.status != 400) {
+        throwError("GETFILEBLOCKLOCATIONS", path, response);
+    }
+
+    // 名称节点不支持GETFILEBLOCKLOCATIONS（Hadoop 3.3之前），只能按块大小划分，没有主机信息
+    FileStatus file_status;
+    if (!status(path, &file_status)) {
+        throw std::runtime_error("HDFS file not found: " + path);
+    }
+    uint64_t block_size = file_status.block_size ? file_status.block_size : file_status.length;
+    for (uint64_t offset = 0; offset < file_status.length; offset += block_size) {
+        BlockLocation block;
+        block.offset = offset;
+        block.length = std::min(block_size, file_status.length - offset);
+        blocks.push_back(std::move(block));
+    }
+    return blocks;
+}
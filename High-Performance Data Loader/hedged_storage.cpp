@@ -0,0 +1,277 @@
+#include "hedged_storage.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <optional>
+#include <random>
+#include <thread>
+#include <cstring>
+
+namespace {
+
+// 每记录这么多个样本重新计算一次分位数
+constexpr size_t kRecomputeInterval = 32;
+
+// 在max_hedge_ratio之外允许的额外请求数，读取数较少时也能对冲
+constexpr double kHedgeBurst = 10.0;
+
+/**
+ * 一次读取的所有请求共享的状态，请求可能比调用方活得更久
+ */
+template<class T>
+struct Race {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::optional<T> result;
+    std::exception_ptr error;
+    size_t pending = 0;
+    size_t winner = 0;
+};
+
+/**
+ * 退避时间的随机数，每个线程独立
+ */
+uint64_t jitterRandom() {
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    return rng();
+}
+
+} // namespace
+
+HedgedStorage::LatencyTracker::LatencyTracker(const HedgingPolicy& policy)
+    : policy_(policy), samples_(std::max<size_t>(policy.window, 1)),
+      delay_us_(policy.initial_delay.count()) {
+}
+
+void HedgedStorage::LatencyTracker::record(std::chrono::microseconds latency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_[next_] = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(latency.count(), 0), UINT32_MAX));
+    next_ = (next_ + 1) % samples_.size();
+    ++count_;
+    if (count_ < policy_.min_samples || count_ % kRecomputeInterval != 0) {
+        return;
+    }
+
+    std::vector<uint32_t> sorted(samples_.begin(), samples_.begin() + std::min(count_, samples_.size()));
+    double percentile = std::min(std::max(policy_.percentile, 0.0), 1.0);
+    size_t index = std::min(static_cast<size_t>(percentile * sorted.size()), sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    int64_t delay = std::min<int64_t>(std::max<int64_t>(sorted[index], policy_.min_delay.count()),
+                                      policy_.max_delay.count());
+    delay_us_.store(delay, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds HedgedStorage::LatencyTracker::delay() const {
+    return std::chrono::microseconds(delay_us_.load(std::memory_order_relaxed));
+}
+
+HedgedStorage::HedgedStorage(std::unique_ptr<Storage> inner, const HedgingPolicy& hedging,
+                             const RetryPolicy& retry, size_t threads)
+    : inner_(std::move(inner)), hedging_(hedging), retry_(retry),
+      whole_latency_(hedging_), range_latency_(hedging_) {
+    if (!inner_) {
+        throw std::runtime_error("HedgedStorage requires an inner storage");
+    }
+    if (hedging_.enabled) {
+        pool_ = std::make_unique<ThreadPool>(threads);
+    }
+}
+
+HedgedStorage::~HedgedStorage() = default;
+
+template<class F>
+auto HedgedStorage::withRetry(F&& fn) -> decltype(fn()) {
+    std::chrono::microseconds backoff = retry_.initial_backoff;
+    for (size_t attempt = 1;; ++attempt) {
+        try {
+            return fn();
+        } catch (const TransientStorageError&) {
+            if (attempt >= retry_.max_attempts) {
+                throw;
+            }
+        }
+        retries_.fetch_add(1, std::memory_order_relaxed);
+
+        // full jitter：在[0, backoff]内随机等待
+        auto limit = static_cast<uint64_t>(std::max<int64_t>(backoff.count(), 0));
+        std::this_thread::sleep_for(std::chrono::microseconds(limit ? jitterRandom() % (limit + 1) : 0));
+        backoff = std::min(retry_.max_backoff, std::chrono::microseconds(static_cast<int64_t>(
+                                                   backoff.count() * std::max(retry_.multiplier, 1.0))));
+    }
+}
+
+bool HedgedStorage::hedgeAllowed() const {
+    double budget = hedging_.max_hedge_ratio * reads_.load(std::memory_order_relaxed) + kHedgeBurst;
+    return hedges_.load(std::memory_order_relaxed) + 1 <= budget;
+}
+
+template<class T>
+T HedgedStorage::hedged(LatencyTracker& tracker, std::function<T()> attempt) {
+    reads_.fetch_add(1, std::memory_order_relaxed);
+    if (!pool_) {
+        try {
+            return withRetry(attempt);
+        } catch (...) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    auto race = std::make_shared<Race<T>>();
+    auto launch = [this, race, attempt, &tracker](size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            ++race->pending;
+        }
+        pool_->enqueue([this, race, attempt, &tracker, index]() {
+            auto start = std::chrono::steady_clock::now();
+            std::optional<T> value;
+            std::exception_ptr error;
+            try {
+                value.emplace(withRetry(attempt));
+                tracker.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(race->mutex);
+            if (value && !race->result) {
+                race->result = std::move(value);
+                race->winner = index;
+            } else if (error && !race->error) {
+                race->error = error;
+            }
+            --race->pending;
+            race->done.notify_all();
+        });
+    };
+
+    launch(0);
+    size_t launched = 1;
+    std::chrono::microseconds delay = tracker.delay();
+    auto finished = [&race]() { return race->result.has_value() || race->pending == 0; };
+
+    std::unique_lock<std::mutex> lock(race->mutex);
+    while (!finished()) {
+        if (launched > hedging_.max_hedges || !hedgeAllowed()) {
+            race->done.wait(lock, finished);
+            break;
+        }
+        if (race->done.wait_for(lock, delay, finished)) {
+            break;
+        }
+        // 超过截止时间仍未完成，发出额外请求，之前的请求继续进行
+        lock.unlock();
+        hedges_.fetch_add(1, std::memory_order_relaxed);
+        launch(launched++);
+        lock.lock();
+    }
+
+    if (!race->result) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        std::rethrow_exception(race->error);
+    }
+    if (race->winner > 0) {
+        hedge_wins_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::move(*race->result);
+}
+
+std::vector<unsigned char> HedgedStorage::readFile(const std::string& file_path) {
+    std::shared_ptr<Storage> inner = inner_;
+    return hedged<std::vector<unsigned char>>(whole_latency_, [inner, file_path]() {
+        return inner->readFile(file_path);
+    });
+}
+
+std::vector<unsigned char> HedgedStorage::readRange(const std::string& file_path, uint64_t offset, size_t length) {
+    std::shared_ptr<Storage> inner = inner_;
+    return hedged<std::vector<unsigned char>>(range_latency_, [inner, file_path, offset, length]() {
+        return inner->readRange(file_path, offset, length);
+    });
+}
+
+size_t HedgedStorage::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+    if (!pool_) {
+        reads_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            return withRetry([&]() { return inner_->readInto(file_path, offset, buffer, length); });
+        } catch (...) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    // 被对冲掉的请求可能在调用返回后才完成，不能让它写入调用方的缓冲区
+    std::shared_ptr<Storage> inner = inner_;
+    PooledBuffer data = hedged<PooledBuffer>(range_latency_, [inner, file_path, offset, length]() {
+        PooledBuffer data(length);
+        data.resize(inner->readInto(file_path, offset, data.data(), length));
+        return data;
+    });
+    if (!data.empty()) {
+        memcpy(buffer, data.data(), data.size());
+    }
+    return data.size();
+}
+
+PooledBuffer HedgedStorage::readFilePooled(const std::string& file_path) {
+    std::shared_ptr<Storage> inner = inner_;
+    return hedged<PooledBuffer>(whole_latency_, [inner, file_path]() {
+        return inner->readFilePooled(file_path);
+    });
+}
+
+std::string HedgedStorage::readTextFile(const std::string& file_path) {
+    std::shared_ptr<Storage> inner = inner_;
+    return hedged<std::string>(whole_latency_, [inner, file_path]() {
+        return inner->readTextFile(file_path);
+    });
+}
+
+bool HedgedStorage::fileExists(const std::string& file_path) {
+    return withRetry([&]() { return inner_->fileExists(file_path); });
+}
+
+size_t HedgedStorage::getFileSize(const std::string& file_path) {
+    return withRetry([&]() { return inner_->getFileSize(file_path); });
+}
+
+std::vector<std::string> HedgedStorage::listFiles(const std::string& dir_path) {
+    return withRetry([&]() { return inner_->listFiles(dir_path); });
+}
+
+void HedgedStorage::prefetch(const std::vector<std::string>& paths) {
+    inner_->prefetch(paths);
+}
+
+void HedgedStorage::setAccessPattern(AccessAdvice pattern) {
+    inner_->setAccessPattern(pattern);
+}
+
+void HedgedStorage::setStreaming(bool enabled) {
+    inner_->setStreaming(enabled);
+}
+
+void HedgedStorage::advise(const std::vector<std::string>& paths, AccessAdvice advice) {
+    inner_->advise(paths, advice);
+}
+
+std::vector<BlockLocation> HedgedStorage::getBlockLocations(const std::string& file_path) {
+    return withRetry([&]() { return inner_->getBlockLocations(file_path); });
+}
+
+HedgedStorage::Stats HedgedStorage::stats() const {
+    Stats stats;
+    stats.reads = reads_.load(std::memory_order_relaxed);
+    stats.hedges = hedges_.load(std::memory_order_relaxed);
+    stats.hedge_wins = hedge_wins_.load(std::memory_order_relaxed);
+    stats.retries = retries_.load(std::memory_order_relaxed);
+    stats.failures = failures_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::chrono::microseconds HedgedStorage::hedgeDelay(bool ranged) const {
+    return ranged ? range_latency_.delay() : whole_latency_.delay();
+}
@@ -0,0 +1,178 @@
+#ifndef HEDGED_STORAGE_H
+#define HEDGED_STORAGE_H
+
+#include "storage.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 对冲读取策略
+ * 读取在截止时间内没有完成时，再发出一个相同的请求，取先完成的结果。
+ * 截止时间取最近读取延迟的分位数（例如p95），因此只有最慢的少数请求会被对冲
+ */
+struct HedgingPolicy {
+    // 是否启用对冲，关闭时只做重试
+    bool enabled = true;
+
+    // 截止时间取最近读取延迟的该分位数
+    double percentile = 0.95;
+
+    // 统计延迟的最近读取数量
+    size_t window = 1024;
+
+    // 样本少于min_samples时使用initial_delay作为截止时间
+    size_t min_samples = 32;
+    std::chrono::microseconds initial_delay = std::chrono::milliseconds(50);
+
+    // 截止时间的上下限
+    std::chrono::microseconds min_delay = std::chrono::milliseconds(1);
+    std::chrono::microseconds max_delay = std::chrono::seconds(2);
+
+    // 每次读取最多发出的额外请求数
+    size_t max_hedges = 1;
+
+    // 额外请求数占读取数的比例上限，后端整体变慢时避免请求量成倍增加
+    double max_hedge_ratio = 0.1;
+};
+
+/**
+ * 重试策略 - 对TransientStorageError做带上限的指数退避重试
+ * 第n次重试前等待[0, min(max_backoff, initial_backoff * multiplier^(n-1))]内的随机时间（full jitter），
+ * 避免大量请求在同一时刻重试
+ */
+struct RetryPolicy {
+    // 最多尝试次数（包括第一次），1表示不重试
+    size_t max_attempts = 4;
+
+    // 退避时间的初始值、增长倍数和上限
+    std::chrono::microseconds initial_backoff = std::chrono::milliseconds(10);
+    double multiplier = 2.0;
+    std::chrono::microseconds max_backoff = std::chrono::seconds(1);
+};
+
+/**
+ * 对冲与重试存储 - 包装另一个存储，降低慢请求和暂时性错误对批次延迟的影响
+ * getNextBatch()要等批次中的每个样本都加载完，远程存储上少数慢请求（p99.9延迟可达中位数的数十倍）
+ * 会拖慢整个批次。读取操作（readFile、readFilePooled、readTextFile、readRange、readInto）在内部线程池上
+ * 执行并按HedgingPolicy对冲；所有操作遇到TransientStorageError时按RetryPolicy重试。
+ * 整个文件读取和区间读取分别统计延迟。
+ * 被对冲掉的请求不能取消，会在后台完成后丢弃结果；readInto()的每个请求读入各自的缓冲区，
+ * 胜出的结果再复制到调用方的缓冲区
+ */
+class HedgedStorage : public Storage {
+public:
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t reads = 0;        // 读取操作数
+        size_t hedges = 0;       // 发出的额外请求数
+        size_t hedge_wins = 0;   // 额外请求先完成的次数
+        size_t retries = 0;      // 重试次数
+        size_t failures = 0;     // 最终失败的读取操作数
+    };
+
+    /**
+     * 构造函数
+     * @param inner 被包装的存储
+     * @param hedging 对冲策略
+     * @param retry 重试策略
+     * @param threads 执行读取请求的线程数，应不小于同时读取的线程数的两倍
+     */
+    explicit HedgedStorage(std::unique_ptr<Storage> inner, const HedgingPolicy& hedging = HedgingPolicy(),
+                           const RetryPolicy& retry = RetryPolicy(), size_t threads = 32);
+
+    ~HedgedStorage() override;
+
+    std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
+    bool fileExists(const std::string& file_path) override;
+    size_t getFileSize(const std::string& file_path) override;
+    std::string readTextFile(const std::string& file_path) override;
+    std::vector<std::string> listFiles(const std::string& dir_path) override;
+    void prefetch(const std::vector<std::string>& paths) override;
+    void setAccessPattern(AccessAdvice pattern) override;
+    void setStreaming(bool enabled) override;
+    void advise(const std::vector<std::string>& paths, AccessAdvice advice) override;
+    std::vector<BlockLocation> getBlockLocations(const std::string& file_path) override;
+
+    /**
+     * 获取被包装的存储
+     */
+    Storage& inner() { return *inner_; }
+
+    /**
+     * 获取统计信息
+     */
+    Stats stats() const;
+
+    /**
+     * 获取当前的对冲截止时间
+     * @param ranged true为区间读取，false为整个文件读取
+     */
+    std::chrono::microseconds hedgeDelay(bool ranged) const;
+
+private:
+    /**
+     * 最近读取延迟的滑动窗口，分位数每记录一定数量的样本后重新计算一次
+     */
+    class LatencyTracker {
+    public:
+        explicit LatencyTracker(const HedgingPolicy& policy);
+        void record(std::chrono::microseconds latency);
+        std::chrono::microseconds delay() const;
+
+    private:
+        const HedgingPolicy& policy_;
+        mutable std::mutex mutex_;
+        std::vector<uint32_t> samples_;
+        size_t next_ = 0;
+        size_t count_ = 0;
+        std::atomic<int64_t> delay_us_;
+    };
+
+    /**
+     * 执行一次读取，超过截止时间后发出额外请求，返回先成功的结果
+     * @param tracker 该类读取的延迟统计
+     * @param attempt 读取函数，可能在多个线程上同时执行，不能引用调用方栈上的数据
+     */
+    template<class T>
+    T hedged(LatencyTracker& tracker, std::function<T()> attempt);
+
+    /**
+     * 按重试策略执行函数
+     */
+    template<class F>
+    auto withRetry(F&& fn) -> decltype(fn());
+
+    /**
+     * 是否还可以发出额外请求（受max_hedge_ratio限制）
+     */
+    bool hedgeAllowed() const;
+
+    std::shared_ptr<Storage> inner_;
+    HedgingPolicy hedging_;
+    RetryPolicy retry_;
+    LatencyTracker whole_latency_;
+    LatencyTracker range_latency_;
+
+    std::atomic<size_t> reads_{0};
+    std::atomic<size_t> hedges_{0};
+    std::atomic<size_t> hedge_wins_{0};
+    std::atomic<size_t> retries_{0};
+    std::atomic<size_t> failures_{0};
+
+    // 最后声明，最先析构：等待后台请求完成后再析构它们用到的成员
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+#endif // HEDGED_STORAGE_H
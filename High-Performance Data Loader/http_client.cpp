@@ -0,0 +1,627 @@
+#include "http_client.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef HPDL_HAVE_OPENSSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#endif
+
+namespace {
+
+/**
+ * 连接在收到任何响应数据之前被对端关闭
+ * 复用的keep-alive连接可能已被服务器超时关闭，此时可以安全地在新连接上重试
+ */
+class ConnectionClosed : public HttpTransportError {
+public:
+    using HttpTransportError::HttpTransportError;
+};
+
+std::string lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+#ifdef HPDL_HAVE_OPENSSL
+std::string tlsError(const std::string& what) {
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return what;
+    }
+    char buffer[256];
+    ERR_error_string_n(code, buffer, sizeof(buffer));
+    return what + ": " + buffer;
+}
+#endif
+
+} // namespace
+
+#ifndef _WIN32
+
+/**
+ * 一个到服务器的连接，带接收缓冲区
+ */
+class HttpClient::Connection {
+public:
+    Connection(const std::string& host, const std::string& port, int timeout_ms, void* tls_context) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* addresses = nullptr;
+        int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+        if (error != 0) {
+            // 只有DNS暂时不可用才值得重试，主机名不存在等错误是确定性的
+            std::string message = "Failed to resolve " + host + ": " + gai_strerror(error);
+            if (error == EAI_AGAIN) {
+                throw HttpTransportError(message);
+            }
+            throw std::runtime_error(message);
+        }
+
+        std::string last_error = "no address";
+        for (struct addrinfo* address = addresses; address && fd_ < 0; address = address->ai_next) {
+            int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd < 0) {
+                last_error = strerror(errno);
+                continue;
+            }
+            if (connectWithTimeout(fd, address->ai_addr, address->ai_addrlen, timeout_ms, last_error)) {
+                fd_ = fd;
+            } else {
+                close(fd);
+            }
+        }
+        freeaddrinfo(addresses);
+        if (fd_ < 0) {
+            throw HttpTransportError("Failed to connect to " + host + ":" + port + ": " + last_error);
+        }
+
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (tls_context) {
+            startTls(host, tls_context);
+        }
+    }
+
+    ~Connection() {
+#ifdef HPDL_HAVE_OPENSSL
+        if (ssl_) {
+            SSL_free(ssl_);
+        }
+#endif
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    /**
+     * 是否已收到本次响应的数据，之后发生的错误不能再重试
+     */
+    bool receivedAny() const { return received_any_; }
+
+    void beginRequest() { received_any_ = false; }
+
+    void writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written;
+#ifdef HPDL_HAVE_OPENSSL
+            if (ssl_) {
+                written = SSL_write(ssl_, data, static_cast<int>(std::min<size_t>(size, 1 << 30)));
+                if (written <= 0) {
+                    throw ConnectionClosed(tlsError("TLS write failed"));
+                }
+            } else
+#endif
+            {
+                written = send(fd_, data, size, MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EPIPE || errno == ECONNRESET) {
+                        throw ConnectionClosed(std::string("Connection closed: ") + strerror(errno));
+                    }
+                    throw HttpTransportError(std::string("send failed: ") + strerror(errno));
+                }
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    /**
+     * 读取一行（以CRLF结尾，返回的内容不含CRLF）
+     */
+    std::string readLine() {
+        std::string line;
+        while (true) {
+            if (pos_ == end_) {
+                fill();
+            }
+            const char* start = buffer_ + pos_;
+            const char* newline = static_cast<const char*>(memchr(start, '\n', end_ - pos_));
+            if (newline) {
+                line.append(start, newline - start);
+                pos_ += static_cast<size_t>(newline - start) + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return line;
+            }
+            line.append(start, end_ - pos_);
+            pos_ = end_;
+            if (line.size() > 64 * 1024) {
+                throw std::runtime_error("HTTP header line too long");
+            }
+        }
+    }
+
+    /**
+     * 读取恰好size个字节；缓冲区中的数据取完后直接接收到目标内存，不经过中间缓冲区
+     */
+    void readExact(void* destination, size_t size) {
+        unsigned char* out = static_cast<unsigned char*>(destination);
+        size_t buffered = std::min(size, end_ - pos_);
+        memcpy(out, buffer_ + pos_, buffered);
+        pos_ += buffered;
+        out += buffered;
+        size -= buffered;
+        while (size > 0) {
+            size_t got = receive(out, size);
+            if (got == 0) {
+                throw HttpTransportError("Connection closed in the middle of a response");
+            }
+            out += got;
+            size -= got;
+        }
+    }
+
+    /**
+     * 读取剩余的数据直到连接关闭
+     */
+    void readUntilClose(std::string& output) {
+        while (true) {
+            output.append(buffer_ + pos_, end_ - pos_);
+            pos_ = 0;
+            end_ = receive(buffer_, sizeof(buffer_));
+            if (end_ == 0) {
+                return;
+            }
+        }
+    }
+
+private:
+    static bool connectWithTimeout(int fd, const struct sockaddr* address, socklen_t length, int timeout_ms,
+                                   std::string& error) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int result = ::connect(fd, address, length);
+        if (result != 0 && errno == EINPROGRESS) {
+            struct pollfd poll_fd;
+            poll_fd.fd = fd;
+            poll_fd.events = POLLOUT;
+            result = poll(&poll_fd, 1, timeout_ms);
+            if (result == 0) {
+                error = "connect timed out";
+                return false;
+            }
+            int socket_error = 0;
+            socklen_t size = sizeof(socket_error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &socket_error, &size);
+            if (result < 0 || socket_error != 0) {
+                error = strerror(result < 0 ? errno : socket_error);
+                return false;
+            }
+        } else if (result != 0) {
+            error = strerror(errno);
+            return false;
+        }
+        fcntl(fd, F_SETFL, flags);
+        return true;
+    }
+
+    void startTls(const std::string& host, void* tls_context) {
+#ifdef HPDL_HAVE_OPENSSL
+        ssl_ = SSL_new(static_cast<SSL_CTX*>(tls_context));
+        if (!ssl_) {
+            throw std::runtime_error(tlsError("SSL_new failed"));
+        }
+        SSL_set_fd(ssl_, fd_);
+        SSL_set_tlsext_host_name(ssl_, host.c_str());
+        if (SSL_CTX_get_verify_mode(static_cast<SSL_CTX*>(tls_context)) != SSL_VERIFY_NONE) {
+            SSL_set1_host(ssl_, host.c_str());
+        }
+        if (SSL_connect(ssl_) != 1) {
+            throw std::runtime_error(tlsError("TLS handshake with " + host + " failed"));
+        }
+#else
+        (void)host;
+        (void)tls_context;
+#endif
+    }
+
+    void fill() {
+        pos_ = 0;
+        end_ = receive(buffer_, sizeof(buffer_));
+        if (end_ == 0) {
+            if (!received_any_) {
+                throw ConnectionClosed("Connection closed before response");
+            }
+            throw HttpTransportError("Connection closed in the middle of a response");
+        }
+    }
+
+    size_t receive(void* destination, size_t size) {
+        while (true) {
+            ssize_t got;
+#ifdef HPDL_HAVE_OPENSSL
+            if (ssl_) {
+                got = SSL_read(ssl_, destination, static_cast<int>(std::min<size_t>(size, 1 << 30)));
+                if (got <= 0) {
+                    int error = SSL_get_error(ssl_, static_cast<int>(got));
+                    if (error == SSL_ERROR_ZERO_RETURN) {
+                        return 0;
+                    }
+                    if (error == SSL_ERROR_SYSCALL && !received_any_) {
+                        throw ConnectionClosed("Connection closed before response");
+                    }
+                    throw HttpTransportError(tlsError("TLS read failed"));
+                }
+                received_any_ = true;
+                return static_cast<size_t>(got);
+            }
+#endif
+            got = recv(fd_, destination, size, 0);
+            if (got >= 0) {
+                received_any_ = received_any_ || got > 0;
+                return static_cast<size_t>(got);
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                throw HttpTransportError("HTTP response timed out");
+            }
+            if (errno == ECONNRESET && !received_any_) {
+                throw ConnectionClosed("Connection reset before response");
+            }
+            throw HttpTransportError(std::string("recv failed: ") + strerror(errno));
+        }
+    }
+
+    int fd_ = -1;
+#ifdef HPDL_HAVE_OPENSSL
+    SSL* ssl_ = nullptr;
+#endif
+    bool received_any_ = false;
+
+    // 接收缓冲区，只用于状态行、头部和chunked编码的分块头；大块响应体直接接收到目标内存
+    char buffer_[16 * 1024];
+    size_t pos_ = 0;
+    size_t end_ = 0;
+};
+
+#else // _WIN32
+
+class HttpClient::Connection {
+public:
+    Connection(const std::string&, const std::string&, int, void*) {
+        throw std::runtime_error("HttpClient is not supported on this platform");
+    }
+    bool receivedAny() const { return false; }
+    void beginRequest() {}
+    void writeAll(const char*, size_t) {}
+    std::string readLine() { return ""; }
+    void readExact(void*, size_t) {}
+    void readUntilClose(std::string&) {}
+};
+
+#endif // _WIN32
+
+// HttpClient实现
+
+HttpClient::HttpClient(const std::string& base_url, const HttpOptions& options) : options_(options) {
+    if (options_.max_connections == 0) {
+        options_.max_connections = 1;
+    }
+
+    std::string rest;
+    if (base_url.compare(0, 7, "http://") == 0) {
+        rest = base_url.substr(7);
+    } else if (base_url.compare(0, 8, "https://") == 0) {
+        rest = base_url.substr(8);
+        tls_ = true;
+    } else {
+        throw std::runtime_error("Unsupported URL (expected http:// or https://): " + base_url);
+    }
+    rest = rest.substr(0, rest.find('/'));
+
+    // 主机和端口，支持"[::1]:9000"形式的IPv6地址
+    size_t colon = std::string::npos;
+    if (!rest.empty() && rest[0] == '[') {
+        size_t bracket = rest.find(']');
+        if (bracket == std::string::npos) {
+            throw std::runtime_error("Invalid URL: " + base_url);
+        }
+        host_ = rest.substr(1, bracket - 1);
+        if (bracket + 1 < rest.size() && rest[bracket + 1] == ':') {
+            colon = bracket + 1;
+        }
+    } else {
+        colon = rest.find(':');
+        host_ = rest.substr(0, colon);
+    }
+    port_ = colon == std::string::npos ? (tls_ ? "443" : "80") : rest.substr(colon + 1);
+    if (host_.empty() || port_.empty()) {
+        throw std::runtime_error("Invalid URL: " + base_url);
+    }
+    host_header_ = rest;
+    if (colon != std::string::npos && port_ == (tls_ ? "443" : "80")) {
+        host_header_ = rest.substr(0, colon);
+    }
+
+    if (tls_) {
+#ifdef HPDL_HAVE_OPENSSL
+        SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+        if (!context) {
+            throw std::runtime_error(tlsError("SSL_CTX_new failed"));
+        }
+        SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+        if (options_.verify_tls) {
+            SSL_CTX_set_default_verify_paths(context);
+            SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+        }
+        tls_context_ = context;
+#else
+        throw std::runtime_error("https is not available: built without OpenSSL");
+#endif
+    }
+}
+
+HttpClient::~HttpClient() {
+    closeIdle();
+#ifdef HPDL_HAVE_OPENSSL
+    if (tls_context_) {
+        SSL_CTX_free(static_cast<SSL_CTX*>(tls_context_));
+    }
+#endif
+}
+
+void HttpClient::closeIdle() {
+    std::deque<std::unique_ptr<Connection>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle.swap(idle_);
+        open_connections_ -= idle.size();
+    }
+    available_.notify_all();
+}
+
+HttpClient::Stats HttpClient::stats() const {
+    Stats stats;
+    stats.requests = requests_.load();
+    stats.connections_opened = connections_opened_.load();
+    stats.retries = retries_.load();
+    return stats;
+}
+
+std::unique_ptr<HttpClient::Connection> HttpClient::acquire(bool& reused) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        available_.wait(lock, [this]() {
+            return !idle_.empty() || open_connections_ < options_.max_connections;
+        });
+        if (!idle_.empty()) {
+            std::unique_ptr<Connection> connection = std::move(idle_.back());
+            idle_.pop_back();
+            reused = true;
+            return connection;
+        }
+        ++open_connections_;
+    }
+
+    reused = false;
+    try {
+        auto connection = std::make_unique<Connection>(host_, port_, options_.timeout_ms, tls_context_);
+        ++connections_opened_;
+        return connection;
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --open_connections_;
+        }
+        available_.notify_one();
+        throw;
+    }
+}
+
+void HttpClient::release(std::unique_ptr<Connection> connection, bool reusable) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reusable) {
+            idle_.push_back(std::move(connection));
+        } else {
+            --open_connections_;
+        }
+    }
+    available_.notify_one();
+    // 不可复用的连接在离开作用域时（锁外）关闭
+}
+
+HttpResponse HttpClient::request(const std::string& method, const std::string& target, const Headers& headers,
+                                 const std::string& body) {
+    size_t received = 0;
+    return execute(method, target, headers, body, nullptr, 0, received);
+}
+
+HttpResponse HttpClient::requestInto(const std::string& method, const std::string& target, const Headers& headers,
+                                     unsigned char* buffer, size_t capacity, size_t& received) {
+    return execute(method, target, headers, "", buffer, capacity, received);
+}
+
+HttpResponse HttpClient::execute(const std::string& method, const std::string& target, const Headers& headers,
+                                 const std::string& body, unsigned char* buffer, size_t capacity, size_t& received) {
+    std::string head = method + " " + target + " HTTP/1.1\r\n";
+    bool has_host = false;
+    for (const auto& header : headers) {
+        has_host = has_host || lowercase(header.first) == "host";
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    if (!has_host) {
+        head += "Host: " + host_header_ + "\r\n";
+    }
+    if (!body.empty() || method == "PUT" || method == "POST") {
+        head += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    head += "\r\n";
+    bool head_request = method == "HEAD";
+
+    for (int attempt = 0;; ++attempt) {
+        bool reused = false;
+        std::unique_ptr<Connection> connection = acquire(reused);
+        HttpResponse response;
+        received = 0;
+        bool keep_alive = true;
+        try {
+            connection->beginRequest();
+            connection->writeAll(head.data(), head.size());
+            if (!body.empty()) {
+                connection->writeAll(body.data(), body.size());
+            }
+
+            // 状态行和头部
+            std::string line = connection->readLine();
+            if (line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+                throw std::runtime_error("Malformed HTTP status line: " + line);
+            }
+            keep_alive = line.compare(0, 8, "HTTP/1.0") != 0;
+            response.status = std::stoi(line.substr(9, 3));
+            while (!(line = connection->readLine()).empty()) {
+                size_t colon = line.find(':');
+                if (colon == std::string::npos) {
+                    continue;
+                }
+                response.headers.emplace_back(lowercase(line.substr(0, colon)), trim(line.substr(colon + 1)));
+            }
+            if (const std::string* value = response.header("connection")) {
+                std::string connection_value = lowercase(*value);
+                if (connection_value == "close") {
+                    keep_alive = false;
+                } else if (connection_value == "keep-alive") {
+                    keep_alive = true;
+                }
+            }
+
+            // 响应体：2xx且调用方提供了缓冲区时直接写入缓冲区，否则保存到response.body
+            bool into_buffer = buffer && response.status >= 200 && response.status < 300;
+            auto consume = [&](size_t size) {
+                if (into_buffer) {
+                    if (size > capacity - received) {
+                        keep_alive = false;
+                        throw std::runtime_error("HTTP response body larger than the buffer");
+                    }
+                    connection->readExact(buffer + received, size);
+                    received += size;
+                } else {
+                    size_t old_size = response.body.size();
+                    response.body.resize(old_size + size);
+                    connection->readExact(&response.body[old_size], size);
+                }
+            };
+
+            bool no_body = head_request || response.status == 204 || response.status == 304 ||
+                           (response.status >= 100 && response.status < 200);
+            const std::string* transfer_encoding = response.header("transfer-encoding");
+            const std::string* content_length = response.header("content-length");
+            if (no_body) {
+            } else if (transfer_encoding && lowercase(*transfer_encoding).find("chunked") != std::string::npos) {
+                while (true) {
+                    size_t chunk = std::stoull(connection->readLine(), nullptr, 16);
+                    if (chunk == 0) {
+                        // 跳过尾部头部直到空行
+                        while (!connection->readLine().empty()) {
+                        }
+                        break;
+                    }
+                    consume(chunk);
+                    connection->readLine();
+                }
+            } else if (content_length) {
+                consume(std::stoull(*content_length));
+            } else {
+                // 没有长度信息，响应体持续到连接关闭
+                keep_alive = false;
+                std::string rest;
+                connection->readUntilClose(rest);
+                if (into_buffer) {
+                    if (rest.size() > capacity) {
+                        throw std::runtime_error("HTTP response body larger than the buffer");
+                    }
+                    memcpy(buffer, rest.data(), rest.size());
+                    received = rest.size();
+                } else {
+                    response.body = std::move(rest);
+                }
+            }
+        } catch (const ConnectionClosed&) {
+            // 失效的复用连接被丢弃后重试；池中可能还有其他失效的空闲连接，重试次数以连接数为上限，
+            // 新建的连接上的失败不再重试
+            bool retry = reused && !connection->receivedAny() && static_cast<size_t>(attempt) < options_.max_connections;
+            release(std::move(connection), false);
+            if (!retry) {
+                throw;
+            }
+            ++retries_;
+            continue;
+        } catch (const std::invalid_argument&) {
+            release(std::move(connection), false);
+            throw std::runtime_error("Malformed HTTP response from " + host_header_);
+        } catch (const std::out_of_range&) {
+            release(std::move(connection), false);
+            throw std::runtime_error("Malformed HTTP response from " + host_header_);
+        } catch (...) {
+            release(std::move(connection), false);
+            throw;
+        }
+
+        release(std::move(connection), keep_alive);
+        ++requests_;
+        return response;
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * 传输层错误 - 连接失败、超时或连接中断，与服务器是否正确实现HTTP无关，稍后重试可能成功
+ * 响应格式错误、响应体超过缓冲区等确定性的错误仍以std::runtime_error抛出
+ */
+class HttpTransportError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * HTTP响应
+ */
+struct HttpResponse {
+    // 状态码
+    int status = 0;
+
+    // 响应头部，名称为小写
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    // 响应体；requestInto()成功时为空，内容已写入调用方的缓冲区
+    std::string body;
+
+    /**
+     * 查找响应头部
+     * @param name 小写的头部名称
+     * @return 头部值，不存在时返回nullptr
+     */
+    const std::string* header(const std::string& name) const {
+        for (const auto& entry : headers) {
+            if (entry.first == name) {
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * HTTP客户端选项
+ */
+struct HttpOptions {
+    // 同时打开的最大连接数，达到上限时请求等待空闲连接
+    size_t max_connections = 64;
+
+    // 连接、发送和接收的超时时间（毫秒）
+    int timeout_ms = 30000;
+
+    // 是否校验服务器的TLS证书
+    bool verify_tls = true;
+};
+
+/**
+ * 带连接池的HTTP/1.1客户端 - 面向同一个服务器的大量并发请求
+ * 连接在请求结束后放回池中复用（keep-alive），避免每个请求一次TCP（和TLS）握手；
+ * 复用的连接可能已被服务器关闭，此时丢弃该连接并自动重试。
+ * 支持Content-Length和chunked两种响应体编码；requestInto()把响应体直接接收到调用方的缓冲区。
+ * https需要在构建时找到OpenSSL（HPDL_HAVE_OPENSSL），Windows上暂不支持
+ */
+class HttpClient {
+public:
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * 连接池统计
+     */
+    struct Stats {
+        size_t requests = 0;            // 完成的请求数
+        size_t connections_opened = 0;  // 新建的连接数
+        size_t retries = 0;             // 因复用的连接失效而重试的次数
+    };
+
+    /**
+     * 构造函数，不立即建立连接
+     * @param base_url 服务器地址，例如"http://127.0.0.1:9000"或"https://s3.us-east-1.amazonaws.com"
+     * @param options 客户端选项
+     * @throws std::runtime_error 地址无效或不支持https时抛出
+     */
+    explicit HttpClient(const std::string& base_url, const HttpOptions& options = HttpOptions());
+
+    /**
+     * 析构函数，关闭所有连接，调用时不能有进行中的请求
+     */
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    /**
+     * 发送请求并读取完整的响应
+     * @param method HTTP方法
+     * @param target 请求目标（已编码的路径和查询字符串）
+     * @param headers 请求头部，未包含Host时自动添加
+     * @param body 请求体
+     * @return 响应
+     * @throws HttpTransportError 连接失败、超时或连接中断时抛出
+     * @throws std::runtime_error 响应格式错误时抛出
+     */
+    HttpResponse request(const std::string& method, const std::string& target, const Headers& headers,
+                         const std::string& body = "");
+
+    /**
+     * 发送请求，把2xx响应的响应体直接接收到调用方的缓冲区
+     * 其他状态码的响应体仍保存在HttpResponse::body中
+     * @param method HTTP方法
+     * @param target 请求目标
+     * @param headers 请求头部
+     * @param buffer 目标缓冲区
+     * @param capacity 缓冲区大小
+     * @param received 输出参数，写入缓冲区的字节数
+     * @return 响应
+     * @throws HttpTransportError 连接失败、超时或连接中断时抛出
+     * @throws std::runtime_error 响应格式错误或响应体超过缓冲区大小时抛出
+     */
+    HttpResponse requestInto(const std::string& method, const std::string& target, const Headers& headers,
+                             unsigned char* buffer, size_t capacity, size_t& received);
+
+    /**
+     * 获取Host头部的值（非默认端口时包含端口）
+     */
+    const std::string& hostHeader() const { return host_header_; }
+
+    /**
+     * 是否使用TLS
+     */
+    bool tls() const { return tls_; }
+
+    /**
+     * 关闭所有空闲连接
+     */
+    void closeIdle();
+
+    /**
+     * 获取连接池统计
+     */
+    Stats stats() const;
+
+private:
+    class Connection;
+
+    /**
+     * 取出一个空闲连接，没有时新建；连接数达到上限时等待
+     * @param reused 输出参数，取出的连接是否被复用
+     */
+    std::unique_ptr<Connection> acquire(bool& reused);
+
+    /**
+     * 归还连接，不可复用的连接直接关闭
+     */
+    void release(std::unique_ptr<Connection> connection, bool reusable);
+
+    HttpResponse execute(const std::string& method, const std::string& target, const Headers& headers,
+                         const std::string& body, unsigned char* buffer, size_t capacity, size_t& received);
+
+    HttpOptions options_;
+    bool tls_ = false;
+    std::string host_;
+    std::string port_;
+    std::string host_header_;
+
+    // TLS上下文（SSL_CTX*），所有连接共享
+    void* tls_context_ = nullptr;
+
+    // 空闲连接按后进先出复用，刚用过的连接最不可能已被服务器关闭
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<std::unique_ptr<Connection>> idle_;
+    size_t open_connections_ = 0;
+
+    std::atomic<size_t> requests_{0};
+    std::atomic<size_t> connections_opened_{0};
+    std::atomic<size_t> retries_{0};
+};
+
+#endif // HTTP_CLIENT_H
@@ -0,0 +1,872 @@
+#include "image_ops.h"
+#include "data_loader.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HPDL_HAVE_X86_SIMD 1
+#endif
+
+namespace {
+
+// SIMD实现支持的最大通道数，更多通道的图像使用标量实现
+constexpr int kMaxSimdChannels = 4;
+
+inline unsigned char roundToByte(float value) {
+    return static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, std::nearbyint(value))));
+}
+
+/**
+ * 各级指令共用的内核接口，每一级实现一组
+ */
+struct Kernels {
+    // 纵向插值：out[i] = r0[i] + wy * (r1[i] - r0[i])
+    void (*blendRows)(const unsigned char* r0, const unsigned char* r1, float wy, float* out, size_t n);
+
+    // 横向插值，输出uint8：out[j] = round(row[idx[j]] + w[j] * (row[idx[j] + next] - row[idx[j]]))
+    void (*interpolateBytes)(const float* row, const int32_t* idx, const float* weight, int next,
+                             unsigned char* out, size_t n);
+
+    // 横向插值，输出float并做仿射变换：out[j] = (row[idx[j]] + w[j] * (row[idx[j] + next] - row[idx[j]])) * a + b
+    void (*interpolateFloats)(const float* row, const int32_t* idx, const float* weight, int next,
+                              float a, float b, float* out, size_t n);
+
+    // 一行HWC像素拆分到各通道平面并做仿射变换：dst[c * plane + x] = src[x * channels + c] * a[c] + b[c]
+    void (*rowToPlanes)(const unsigned char* src, int width, int channels, const float* a, const float* b,
+                        float* dst, size_t plane);
+
+    // 原地仿射变换：data[i] = data[i] * a + b
+    void (*affine)(float* data, size_t n, float a, float b);
+
+    // 一行像素左右镜像
+    void (*flipRow)(const unsigned char* src, int width, int channels, unsigned char* dst);
+};
+
+// 标量实现
+
+void blendRowsScalar(const unsigned char* r0, const unsigned char* r1, float wy, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        float a = r0[i];
+        out[i] = a + wy * (static_cast<float>(r1[i]) - a);
+    }
+}
+
+void interpolateBytesScalar(const float* row, const int32_t* idx, const float* weight, int next,
+                            unsigned char* out, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        float a = row[idx[j]];
+        out[j] = roundToByte(a + weight[j] * (row[idx[j] + next] - a));
+    }
+}
+
+void interpolateFloatsScalar(const float* row, const int32_t* idx, const float* weight, int next,
+                             float a, float b, float* out, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        float v = row[idx[j]];
+        out[j] = (v + weight[j] * (row[idx[j] + next] - v)) * a + b;
+    }
+}
+
+void rowToPlanesScalar(const unsigned char* src, int width, int channels, const float* a, const float* b,
+                       float* dst, size_t plane) {
+    for (int c = 0; c < channels; ++c) {
+        float* out = dst + c * plane;
+        for (int x = 0; x < width; ++x) {
+            out[x] = static_cast<float>(src[static_cast<size_t>(x) * channels + c]) * a[c] + b[c];
+        }
+    }
+}
+
+void affineScalar(float* data, size_t n, float a, float b) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = data[i] * a + b;
+    }
+}
+
+void flipRowScalar(const unsigned char* src, int width, int channels, unsigned char* dst) {
+    for (int x = 0; x < width; ++x) {
+        memcpy(dst + static_cast<size_t>(width - 1 - x) * channels, src + static_cast<size_t>(x) * channels,
+               channels);
+    }
+}
+
+const Kernels kScalarKernels = {
+    blendRowsScalar, interpolateBytesScalar, interpolateFloatsScalar, rowToPlanesScalar, affineScalar, flipRowScalar
+};
+
+#ifdef HPDL_HAVE_X86_SIMD
+/**
+ * pshufb掩码表
+ * deinterleave[c][ch]：从一个16字节块中取出前4个像素的第ch个通道，放到低4个字节
+ * flip[c]：反转16字节块中前16 / c个像素的顺序
+ */
+struct ShuffleMasks {
+    alignas(16) unsigned char deinterleave[kMaxSimdChannels + 1][kMaxSimdChannels][16];
+    alignas(16) unsigned char flip[kMaxSimdChannels + 1][16];
+
+    ShuffleMasks() {
+        memset(deinterleave, 0x80, sizeof(deinterleave));
+        memset(flip, 0x80, sizeof(flip));
+        for (int c = 1; c <= kMaxSimdChannels; ++c) {
+            for (int ch = 0; ch < c; ++ch) {
+                for (int k = 0; k < 4; ++k) {
+                    deinterleave[c][ch][k] = static_cast<unsigned char>(k * c + ch);
+                }
+            }
+            int pixels = 16 / c;
+            for (int k = 0; k < pixels; ++k) {
+                for (int ch = 0; ch < c; ++ch) {
+                    flip[c][(pixels - 1 - k) * c + ch] = static_cast<unsigned char>(k * c + ch);
+                }
+            }
+        }
+    }
+};
+
+const ShuffleMasks kMasks;
+
+// SSE4.1实现
+
+__attribute__((target("sse4.1")))
+void blendRowsSse4(const unsigned char* r0, const unsigned char* r1, float wy, float* out, size_t n) {
+    const __m128 w = _mm_set1_ps(wy);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0 + i));
+        __m128i x1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1 + i));
+        __m128 a0 = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(x0));
+        __m128 a1 = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(x0, 4)));
+        __m128 b0 = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(x1));
+        __m128 b1 = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(x1, 4)));
+        _mm_storeu_ps(out + i, _mm_add_ps(a0, _mm_mul_ps(w, _mm_sub_ps(b0, a0))));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(a1, _mm_mul_ps(w, _mm_sub_ps(b1, a1))));
+    }
+    blendRowsScalar(r0 + i, r1 + i, wy, out + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 interpolate4(const float* row, const int32_t* idx, const float* weight, int next) {
+    __m128 a = _mm_setr_ps(row[idx[0]], row[idx[1]], row[idx[2]], row[idx[3]]);
+    __m128 b = _mm_setr_ps(row[idx[0] + next], row[idx[1] + next], row[idx[2] + next], row[idx[3] + next]);
+    return _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(weight), _mm_sub_ps(b, a)));
+}
+
+__attribute__((target("sse4.1")))
+void interpolateBytesSse4(const float* row, const int32_t* idx, const float* weight, int next,
+                          unsigned char* out, size_t n) {
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128i v = _mm_cvtps_epi32(interpolate4(row, idx + j, weight + j, next));
+        v = _mm_packus_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        int32_t bytes = _mm_cvtsi128_si32(v);
+        memcpy(out + j, &bytes, 4);
+    }
+    interpolateBytesScalar(row, idx + j, weight + j, next, out + j, n - j);
+}
+
+__attribute__((target("sse4.1")))
+void interpolateFloatsSse4(const float* row, const int32_t* idx, const float* weight, int next,
+                           float a, float b, float* out, size_t n) {
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vb = _mm_set1_ps(b);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128 v = interpolate4(row, idx + j, weight + j, next);
+        _mm_storeu_ps(out + j, _mm_add_ps(_mm_mul_ps(v, va), vb));
+    }
+    interpolateFloatsScalar(row, idx + j, weight + j, next, a, b, out + j, n - j);
+}
+
+__attribute__((target("sse4.1")))
+void rowToPlanesSse4(const unsigned char* src, int width, int channels, const float* a, const float* b,
+                     float* dst, size_t plane) {
+    if (channels > kMaxSimdChannels) {
+        rowToPlanesScalar(src, width, channels, a, b, dst, plane);
+        return;
+    }
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    size_t x = 0;
+    // 每次处理4个像素，读取16个字节
+    for (; x * channels + 16 <= row_bytes; x += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * channels));
+        for (int c = 0; c < channels; ++c) {
+            __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(kMasks.deinterleave[channels][c]));
+            __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_shuffle_epi8(v, mask)));
+            _mm_storeu_ps(dst + c * plane + x, _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(a[c])), _mm_set1_ps(b[c])));
+        }
+    }
+    if (x < static_cast<size_t>(width)) {
+        rowToPlanesScalar(src + x * channels, width - static_cast<int>(x), channels, a, b, dst + x, plane);
+    }
+}
+
+__attribute__((target("sse4.1")))
+void affineSse4(float* data, size_t n, float a, float b) {
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vb = _mm_set1_ps(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(data + i), va), vb));
+    }
+    affineScalar(data + i, n - i, a, b);
+}
+
+// 翻转是纯粹的字节重排，受内存带宽限制，各级指令都使用这个16字节的pshufb实现
+__attribute__((target("sse4.1")))
+void flipRowSse4(const unsigned char* src, int width, int channels, unsigned char* dst) {
+    if (channels > kMaxSimdChannels) {
+        flipRowScalar(src, width, channels, dst);
+        return;
+    }
+    // 每个16字节块包含pixels个完整像素；3通道时块末尾多出1个字节，写入位置是源像素x - 1的目标位置，
+    // 因此按x递减的顺序处理，由后处理的块或标量部分覆盖，并且留出第一个像素不参与向量化
+    const int pixels = 16 / channels;
+    const int extra = 16 - pixels * channels;
+    const int hi = width - (extra ? 1 : 0);
+    const int blocks = hi > extra ? (hi - extra) / pixels : 0;
+    const int lo = hi - blocks * pixels;
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(kMasks.flip[channels]));
+    for (int x = hi - pixels; x >= lo; x -= pixels) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<size_t>(x) * channels));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + static_cast<size_t>(width - x - pixels) * channels),
+                         _mm_shuffle_epi8(v, mask));
+    }
+    for (int x = 0; x < lo; ++x) {
+        memcpy(dst + static_cast<size_t>(width - 1 - x) * channels, src + static_cast<size_t>(x) * channels,
+               channels);
+    }
+    for (int x = hi; x < width; ++x) {
+        memcpy(dst + static_cast<size_t>(width - 1 - x) * channels, src + static_cast<size_t>(x) * channels,
+               channels);
+    }
+}
+
+const Kernels kSse4Kernels = {
+    blendRowsSse4, interpolateBytesSse4, interpolateFloatsSse4, rowToPlanesSse4, affineSse4, flipRowSse4
+};
+
+// AVX2实现
+
+__attribute__((target("avx2,fma")))
+void blendRowsAvx2(const unsigned char* r0, const unsigned char* r1, float wy, float* out, size_t n) {
+    const __m256 w = _mm256_set1_ps(wy);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i));
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i));
+        __m256 a0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(x0));
+        __m256 a1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(x0, 8)));
+        __m256 b0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(x1));
+        __m256 b1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(x1, 8)));
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(w, _mm256_sub_ps(b0, a0), a0));
+        _mm256_storeu_ps(out + i + 8, _mm256_fmadd_ps(w, _mm256_sub_ps(b1, a1), a1));
+    }
+    blendRowsScalar(r0 + i, r1 + i, wy, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 interpolate8(const float* row, const int32_t* idx, const float* weight, int next) {
+    __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+    __m256 a = _mm256_i32gather_ps(row, i0, 4);
+    __m256 b = _mm256_i32gather_ps(row, _mm256_add_epi32(i0, _mm256_set1_epi32(next)), 4);
+    return _mm256_fmadd_ps(_mm256_loadu_ps(weight), _mm256_sub_ps(b, a), a);
+}
+
+__attribute__((target("avx2,fma")))
+void interpolateBytesAvx2(const float* row, const int32_t* idx, const float* weight, int next,
+                          unsigned char* out, size_t n) {
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i v = _mm256_cvtps_epi32(interpolate8(row, idx + j, weight + j, next));
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(words, words));
+    }
+    interpolateBytesScalar(row, idx + j, weight + j, next, out + j, n - j);
+}
+
+__attribute__((target("avx2,fma")))
+void interpolateFloatsAvx2(const float* row, const int32_t* idx, const float* weight, int next,
+                           float a, float b, float* out, size_t n) {
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256 vb = _mm256_set1_ps(b);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        _mm256_storeu_ps(out + j, _mm256_fmadd_ps(interpolate8(row, idx + j, weight + j, next), va, vb));
+    }
+    interpolateFloatsScalar(row, idx + j, weight + j, next, a, b, out + j, n - j);
+}
+
+__attribute__((target("avx2,fma")))
+void rowToPlanesAvx2(const unsigned char* src, int width, int channels, const float* a, const float* b,
+                     float* dst, size_t plane) {
+    if (channels > kMaxSimdChannels) {
+        rowToPlanesScalar(src, width, channels, a, b, dst, plane);
+        return;
+    }
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    // 两个128位通道分别读取4个像素，重排后每个通道的低4个字节是所需的通道值，再拼接为8个字节
+    const __m256i gather = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+    size_t x = 0;
+    for (; x + 8 <= static_cast<size_t>(width) && (x + 4) * channels + 16 <= row_bytes; x += 8) {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * channels))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + 4) * channels)), 1);
+        for (int c = 0; c < channels; ++c) {
+            __m256i mask = _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(kMasks.deinterleave[channels][c])));
+            __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, mask), gather);
+            __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm256_castsi256_si128(bytes)));
+            _mm256_storeu_ps(dst + c * plane + x, _mm256_fmadd_ps(f, _mm256_set1_ps(a[c]), _mm256_set1_ps(b[c])));
+        }
+    }
+    if (x < static_cast<size_t>(width)) {
+        rowToPlanesSse4(src + x * channels, width - static_cast<int>(x), channels, a, b, dst + x, plane);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void affineAvx2(float* data, size_t n, float a, float b) {
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256 vb = _mm256_set1_ps(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(data + i, _mm256_fmadd_ps(_mm256_loadu_ps(data + i), va, vb));
+    }
+    affineScalar(data + i, n - i, a, b);
+}
+
+const Kernels kAvx2Kernels = {
+    blendRowsAvx2, interpolateBytesAvx2, interpolateFloatsAvx2, rowToPlanesAvx2, affineAvx2, flipRowSse4
+};
+
+// AVX-512实现
+// GCC 12的_mm512_undefined_*()会在内联后触发误报的-Wmaybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+void blendRowsAvx512(const unsigned char* r0, const unsigned char* r1, float wy, float* out, size_t n) {
+    const __m512 w = _mm512_set1_ps(wy);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + i));
+        __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + i));
+        __m512 a0 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm256_castsi256_si128(x0)));
+        __m512 a1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm256_extracti128_si256(x0, 1)));
+        __m512 b0 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm256_castsi256_si128(x1)));
+        __m512 b1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm256_extracti128_si256(x1, 1)));
+        _mm512_storeu_ps(out + i, _mm512_fmadd_ps(w, _mm512_sub_ps(b0, a0), a0));
+        _mm512_storeu_ps(out + i + 16, _mm512_fmadd_ps(w, _mm512_sub_ps(b1, a1), a1));
+    }
+    blendRowsAvx2(r0 + i, r1 + i, wy, out + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+inline __m512 interpolate16(const float* row, const int32_t* idx, const float* weight, int next) {
+    __m512i i0 = _mm512_loadu_si512(idx);
+    __m512 a = _mm512_i32gather_ps(i0, row, 4);
+    __m512 b = _mm512_i32gather_ps(_mm512_add_epi32(i0, _mm512_set1_epi32(next)), row, 4);
+    return _mm512_fmadd_ps(_mm512_loadu_ps(weight), _mm512_sub_ps(b, a), a);
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+void interpolateBytesAvx512(const float* row, const int32_t* idx, const float* weight, int next,
+                            unsigned char* out, size_t n) {
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512i v = _mm512_cvtps_epi32(interpolate16(row, idx + j, weight + j, next));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm512_cvtusepi32_epi8(v));
+    }
+    interpolateBytesAvx2(row, idx + j, weight + j, next, out + j, n - j);
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+void interpolateFloatsAvx512(const float* row, const int32_t* idx, const float* weight, int next,
+                             float a, float b, float* out, size_t n) {
+    const __m512 va = _mm512_set1_ps(a);
+    const __m512 vb = _mm512_set1_ps(b);
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        _mm512_storeu_ps(out + j, _mm512_fmadd_ps(interpolate16(row, idx + j, weight + j, next), va, vb));
+    }
+    interpolateFloatsAvx2(row, idx + j, weight + j, next, a, b, out + j, n - j);
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+void rowToPlanesAvx512(const unsigned char* src, int width, int channels, const float* a, const float* b,
+                       float* dst, size_t plane) {
+    if (channels > kMaxSimdChannels) {
+        rowToPlanesScalar(src, width, channels, a, b, dst, plane);
+        return;
+    }
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    // 四个128位通道各读取4个像素，做法与AVX2实现相同
+    const __m512i gather = _mm512_setr_epi32(0, 4, 8, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t x = 0;
+    for (; x + 16 <= static_cast<size_t>(width) && (x + 12) * channels + 16 <= row_bytes; x += 16) {
+        __m512i v = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * channels)));
+        v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + 4) * channels)), 1);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + 8) * channels)), 2);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + 12) * channels)), 3);
+        for (int c = 0; c < channels; ++c) {
+            __m512i mask = _mm512_broadcast_i32x4(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(kMasks.deinterleave[channels][c])));
+            __m512i bytes = _mm512_permutexvar_epi32(gather, _mm512_shuffle_epi8(v, mask));
+            __m512 f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm512_castsi512_si128(bytes)));
+            _mm512_storeu_ps(dst + c * plane + x, _mm512_fmadd_ps(f, _mm512_set1_ps(a[c]), _mm512_set1_ps(b[c])));
+        }
+    }
+    if (x < static_cast<size_t>(width)) {
+        rowToPlanesAvx2(src + x * channels, width - static_cast<int>(x), channels, a, b, dst + x, plane);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,fma")))
+void affineAvx512(float* data, size_t n, float a, float b) {
+    const __m512 va = _mm512_set1_ps(a);
+    const __m512 vb = _mm512_set1_ps(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(data + i, _mm512_fmadd_ps(_mm512_loadu_ps(data + i), va, vb));
+    }
+    affineAvx2(data + i, n - i, a, b);
+}
+
+const Kernels kAvx512Kernels = {
+    blendRowsAvx512, interpolateBytesAvx512, interpolateFloatsAvx512, rowToPlanesAvx512, affineAvx512, flipRowSse4
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+SimdLevel detectSimdLevel() {
+#ifdef HPDL_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SimdLevel::SSE4;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+const SimdLevel kDetectedLevel = detectSimdLevel();
+std::atomic<SimdLevel> g_level{kDetectedLevel};
+
+const Kernels& kernels() {
+#ifdef HPDL_HAVE_X86_SIMD
+    switch (g_level.load(std::memory_order_relaxed)) {
+    case SimdLevel::AVX512:
+        return kAvx512Kernels;
+    case SimdLevel::AVX2:
+        return kAvx2Kernels;
+    case SimdLevel::SSE4:
+        return kSse4Kernels;
+    case SimdLevel::Scalar:
+        break;
+    }
+#endif
+    return kScalarKernels;
+}
+
+void checkImage(const ImageView& src) {
+    if (!src.data || src.width <= 0 || src.height <= 0 || src.channels <= 0 ||
+        src.stride < static_cast<size_t>(src.width) * src.channels) {
+        throw std::invalid_argument("Invalid image view " + std::to_string(src.width) + "x" +
+                                    std::to_string(src.height) + "x" + std::to_string(src.channels));
+    }
+}
+
+void checkRect(const ImageView& src, const CropRect& rect) {
+    if (rect.width <= 0 || rect.height <= 0 || rect.x < 0 || rect.y < 0 ||
+        rect.x > src.width - rect.width || rect.y > src.height - rect.height) {
+        throw std::invalid_argument("Crop rect (" + std::to_string(rect.x) + ", " + std::to_string(rect.y) + ", " +
+                                    std::to_string(rect.width) + "x" + std::to_string(rect.height) +
+                                    ") is outside " + std::to_string(src.width) + "x" + std::to_string(src.height));
+    }
+}
+
+void checkSize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Invalid output size " + std::to_string(width) + "x" + std::to_string(height));
+    }
+}
+
+/**
+ * 归一化参数展开为每个通道的仿射系数：x * a[c] + b[c]
+ */
+void affineCoefficients(const Normalization& norm, int channels, std::vector<float>& a, std::vector<float>& b) {
+    auto perChannel = [channels](const std::vector<float>& values, float fallback, const char* name) {
+        if (values.empty()) {
+            return std::vector<float>(channels, fallback);
+        }
+        if (values.size() == 1) {
+            return std::vector<float>(channels, values[0]);
+        }
+        if (values.size() != static_cast<size_t>(channels)) {
+            throw std::invalid_argument(std::string("Normalization ") + name + " has " +
+                                        std::to_string(values.size()) + " values for " + std::to_string(channels) +
+                                        " channels");
+        }
+        return values;
+    };
+    std::vector<float> mean = perChannel(norm.mean, 0.0f, "mean");
+    std::vector<float> stddev = perChannel(norm.stddev, 1.0f, "stddev");
+    a.resize(channels);
+    b.resize(channels);
+    for (int c = 0; c < channels; ++c) {
+        if (stddev[c] == 0.0f) {
+            throw std::invalid_argument("Normalization stddev must be non-zero");
+        }
+        a[c] = norm.scale / stddev[c];
+        b[c] = -mean[c] / stddev[c];
+    }
+}
+
+/**
+ * 计算一个方向上每个输出位置的源下标和插值权重（像素中心对齐）
+ * 源下标相对于裁剪区域的起点；位于末尾时权重为0，第二个采样点落在行缓冲区的填充像素上
+ */
+void computeAxis(int src_size, int dst_size, bool reverse, int32_t* index, float* weight) {
+    const double scale = static_cast<double>(src_size) / dst_size;
+    for (int d = 0; d < dst_size; ++d) {
+        int position = reverse ? dst_size - 1 - d : d;
+        double s = std::max(0.0, (position + 0.5) * scale - 0.5);
+        int i0 = static_cast<int>(s);
+        if (i0 >= src_size - 1) {
+            index[d] = src_size - 1;
+            weight[d] = 0.0f;
+        } else {
+            index[d] = i0;
+            weight[d] = static_cast<float>(s - i0);
+        }
+    }
+}
+
+/**
+ * 双线性缩放的公共部分：逐个输出行把两行源像素纵向插值到浮点行缓冲区，再交给emit做横向插值
+ * emit(y, row)中row包含裁剪区域的一行像素（HWC）和一个填充像素
+ */
+template <typename Emit>
+void resampleRows(const ImageView& src, const CropRect& rect, int height, const Kernels& k, Emit&& emit) {
+    thread_local std::vector<float> row;
+    const int channels = src.channels;
+    const size_t span = static_cast<size_t>(rect.width) * channels;
+    row.resize(span + channels);
+    const double scale = static_cast<double>(rect.height) / height;
+    for (int y = 0; y < height; ++y) {
+        double s = std::max(0.0, (y + 0.5) * scale - 0.5);
+        int y0 = std::min(static_cast<int>(s), rect.height - 1);
+        int y1 = std::min(y0 + 1, rect.height - 1);
+        float wy = y0 == y1 ? 0.0f : static_cast<float>(s - y0);
+        const unsigned char* r0 = src.row(rect.y + y0) + static_cast<size_t>(rect.x) * channels;
+        const unsigned char* r1 = src.row(rect.y + y1) + static_cast<size_t>(rect.x) * channels;
+        k.blendRows(r0, r1, wy, row.data(), span);
+        std::copy(row.begin() + (span - channels), row.begin() + span, row.begin() + span);
+        emit(y, row.data());
+    }
+}
+
+std::unique_ptr<ImageData> makeImage(int width, int height, int channels) {
+    PooledBuffer buffer(static_cast<size_t>(width) * height * channels);
+    return std::make_unique<ImageData>(width, height, channels, std::move(buffer));
+}
+
+/**
+ * 标准库引擎的均匀分布（保持原有的抽样结果）
+ */
+struct StdUniform {
+    std::mt19937_64& rng;
+
+    int integer(int low, int high) { return std::uniform_int_distribution<int>(low, high)(rng); }
+    double real(double low, double high) { return std::uniform_real_distribution<double>(low, high)(rng); }
+};
+
+/**
+ * Philox生成器的均匀分布，不依赖标准库分布的实现
+ */
+struct PhiloxUniform {
+    PhiloxRng& rng;
+
+    int integer(int low, int high) { return rng.uniformInt(low, high); }
+    double real(double low, double high) { return rng.uniform(low, high); }
+};
+
+template <typename Uniform>
+CropRect randomCropWith(int width, int height, int crop_width, int crop_height, Uniform uniform) {
+    CropRect rect;
+    rect.width = std::min(crop_width, width);
+    rect.height = std::min(crop_height, height);
+    rect.x = uniform.integer(0, width - rect.width);
+    rect.y = uniform.integer(0, height - rect.height);
+    return rect;
+}
+
+template <typename Uniform>
+CropRect randomResizedCropWith(int width, int height, Uniform uniform, float min_scale, float max_scale,
+                               float min_ratio, float max_ratio) {
+    const double area = static_cast<double>(width) * height;
+    const double log_min_ratio = std::log(min_ratio);
+    const double log_max_ratio = std::log(max_ratio);
+    for (int attempt = 0; attempt < 10; ++attempt) {
+        double target_area = area * uniform.real(min_scale, max_scale);
+        double ratio = std::exp(uniform.real(log_min_ratio, log_max_ratio));
+        int w = static_cast<int>(std::lround(std::sqrt(target_area * ratio)));
+        int h = static_cast<int>(std::lround(std::sqrt(target_area / ratio)));
+        if (w > 0 && h > 0 && w <= width && h <= height) {
+            return randomCropWith(width, height, w, h, uniform);
+        }
+    }
+
+    // 退化为中心裁剪，宽高比限制在[min_ratio, max_ratio]内
+    double ratio = static_cast<double>(width) / height;
+    int w = width;
+    int h = height;
+    if (ratio < min_ratio) {
+        h = std::max(1, static_cast<int>(std::lround(width / min_ratio)));
+    } else if (ratio > max_ratio) {
+        w = std::max(1, static_cast<int>(std::lround(height * max_ratio)));
+    }
+    return ImageOps::centerCrop(width, height, w, h);
+}
+
+} // namespace
+
+ImageView::ImageView(const ImageData& image)
+    : ImageView(image.getData(), image.getWidth(), image.getHeight(), image.getChannels()) {}
+
+SimdLevel ImageOps::detectedSimdLevel() {
+    return kDetectedLevel;
+}
+
+SimdLevel ImageOps::simdLevel() {
+    return g_level.load(std::memory_order_relaxed);
+}
+
+SimdLevel ImageOps::setSimdLevel(SimdLevel level) {
+    level = std::min(level, kDetectedLevel);
+    g_level.store(level, std::memory_order_relaxed);
+    return level;
+}
+
+const char* ImageOps::simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE4:
+        return "SSE4.1";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    }
+    return "unknown";
+}
+
+void ImageOps::toChw(const ImageView& src, float* dst, const Normalization& norm) {
+    checkImage(src);
+    std::vector<float> a, b;
+    affineCoefficients(norm, src.channels, a, b);
+    const Kernels& k = kernels();
+    const size_t plane = static_cast<size_t>(src.width) * src.height;
+    for (int y = 0; y < src.height; ++y) {
+        k.rowToPlanes(src.row(y), src.width, src.channels, a.data(), b.data(),
+                      dst + static_cast<size_t>(y) * src.width, plane);
+    }
+}
+
+void ImageOps::normalize(float* data, int channels, size_t plane_size, const Normalization& norm) {
+    std::vector<float> a, b;
+    affineCoefficients(norm, channels, a, b);
+    const Kernels& k = kernels();
+    for (int c = 0; c < channels; ++c) {
+        k.affine(data + c * plane_size, plane_size, a[c], b[c]);
+    }
+}
+
+void ImageOps::resize(const ImageView& src, unsigned char* dst, int width, int height) {
+    cropResize(src, CropRect{0, 0, src.width, src.height}, width, height, false, dst);
+}
+
+void ImageOps::crop(const ImageView& src, const CropRect& rect, unsigned char* dst) {
+    ImageView view = crop(src, rect);
+    const size_t row_bytes = static_cast<size_t>(view.width) * view.channels;
+    for (int y = 0; y < view.height; ++y) {
+        memcpy(dst + y * row_bytes, view.row(y), row_bytes);
+    }
+}
+
+void ImageOps::flipHorizontal(const ImageView& src, unsigned char* dst) {
+    checkImage(src);
+    const Kernels& k = kernels();
+    const size_t row_bytes = static_cast<size_t>(src.width) * src.channels;
+    for (int y = 0; y < src.height; ++y) {
+        k.flipRow(src.row(y), src.width, src.channels, dst + y * row_bytes);
+    }
+}
+
+void ImageOps::flipVertical(const ImageView& src, unsigned char* dst) {
+    checkImage(src);
+    const size_t row_bytes = static_cast<size_t>(src.width) * src.channels;
+    for (int y = 0; y < src.height; ++y) {
+        memcpy(dst + y * row_bytes, src.row(src.height - 1 - y), row_bytes);
+    }
+}
+
+void ImageOps::cropResize(const ImageView& src, const CropRect& rect, int width, int height, bool flip,
+                          unsigned char* dst) {
+    checkImage(src);
+    checkRect(src, rect);
+    checkSize(width, height);
+    if (rect.width == width && rect.height == height && !flip) {
+        crop(src, rect, dst);
+        return;
+    }
+
+    // 横向表按输出字节展开：第j = x * channels + c个字节取源像素index[x]的第c个通道
+    const int channels = src.channels;
+    const size_t row_bytes = static_cast<size_t>(width) * channels;
+    thread_local std::vector<int32_t> index;
+    thread_local std::vector<float> weight;
+    index.resize(row_bytes);
+    weight.resize(row_bytes);
+    computeAxis(rect.width, width, flip, index.data(), weight.data());
+    for (int x = width - 1; x >= 0; --x) {
+        for (int c = channels - 1; c >= 0; --c) {
+            index[x * channels + c] = index[x] * channels + c;
+            weight[x * channels + c] = weight[x];
+        }
+    }
+
+    const Kernels& k = kernels();
+    resampleRows(src, rect, height, k, [&](int y, const float* row) {
+        k.interpolateBytes(row, index.data(), weight.data(), channels, dst + y * row_bytes, row_bytes);
+    });
+}
+
+void ImageOps::cropResizeToChw(const ImageView& src, const CropRect& rect, int width, int height, bool flip,
+                               float* dst, const Normalization& norm) {
+    checkImage(src);
+    checkRect(src, rect);
+    checkSize(width, height);
+    if (rect.width == width && rect.height == height && !flip) {
+        toChw(crop(src, rect), dst, norm);
+        return;
+    }
+
+    const int channels = src.channels;
+    std::vector<float> a, b;
+    affineCoefficients(norm, channels, a, b);
+    thread_local std::vector<int32_t> index;
+    thread_local std::vector<float> weight;
+    index.resize(width);
+    weight.resize(width);
+    computeAxis(rect.width, width, flip, index.data(), weight.data());
+    for (int x = 0; x < width; ++x) {
+        index[x] *= channels;
+    }
+
+    // 每个通道平面使用同一张下标表，行缓冲区的起点偏移c个元素即为第c个通道
+    const Kernels& k = kernels();
+    const size_t plane = static_cast<size_t>(width) * height;
+    resampleRows(src, rect, height, k, [&](int y, const float* row) {
+        for (int c = 0; c < channels; ++c) {
+            k.interpolateFloats(row + c, index.data(), weight.data(), channels, a[c], b[c],
+                                dst + c * plane + static_cast<size_t>(y) * width, width);
+        }
+    });
+}
+
+ImageView ImageOps::crop(const ImageView& src, const CropRect& rect) {
+    checkImage(src);
+    checkRect(src, rect);
+    return ImageView(src.row(rect.y) + static_cast<size_t>(rect.x) * src.channels, rect.width, rect.height,
+                     src.channels, src.stride);
+}
+
+std::unique_ptr<ImageData> ImageOps::crop(const ImageData& image, const CropRect& rect) {
+    ImageView src(image);
+    checkRect(src, rect);
+    auto result = makeImage(rect.width, rect.height, src.channels);
+    crop(src, rect, result->getData());
+    return result;
+}
+
+std::unique_ptr<ImageData> ImageOps::resize(const ImageData& image, int width, int height) {
+    checkSize(width, height);
+    auto result = makeImage(width, height, image.getChannels());
+    resize(ImageView(image), result->getData(), width, height);
+    return result;
+}
+
+std::unique_ptr<ImageData> ImageOps::flipHorizontal(const ImageData& image) {
+    auto result = makeImage(image.getWidth(), image.getHeight(), image.getChannels());
+    flipHorizontal(ImageView(image), result->getData());
+    return result;
+}
+
+std::unique_ptr<ImageData> ImageOps::cropResize(const ImageData& image, const CropRect& rect, int width, int height,
+                                                bool flip) {
+    checkSize(width, height);
+    auto result = makeImage(width, height, image.getChannels());
+    cropResize(ImageView(image), rect, width, height, flip, result->getData());
+    return result;
+}
+
+std::unique_ptr<TensorData> ImageOps::toChw(const ImageData& image, const Normalization& norm) {
+    auto result = std::make_unique<TensorData>(
+        DType::Float32, TensorData::Shape{image.getChannels(), image.getHeight(), image.getWidth()});
+    toChw(ImageView(image), result->getDataAs<float>(), norm);
+    return result;
+}
+
+std::unique_ptr<TensorData> ImageOps::cropResizeToChw(const ImageData& image, const CropRect& rect, int width,
+                                                      int height, bool flip, const Normalization& norm) {
+    checkSize(width, height);
+    auto result = std::make_unique<TensorData>(DType::Float32,
+                                               TensorData::Shape{image.getChannels(), height, width});
+    cropResizeToChw(ImageView(image), rect, width, height, flip, result->getDataAs<float>(), norm);
+    return result;
+}
+
+CropRect ImageOps::centerCrop(int width, int height, int crop_width, int crop_height) {
+    CropRect rect;
+    rect.width = std::min(crop_width, width);
+    rect.height = std::min(crop_height, height);
+    rect.x = (width - rect.width) / 2;
+    rect.y = (height - rect.height) / 2;
+    return rect;
+}
+
+CropRect ImageOps::randomCrop(int width, int height, int crop_width, int crop_height, std::mt19937_64& rng) {
+    return randomCropWith(width, height, crop_width, crop_height, StdUniform{rng});
+}
+
+CropRect ImageOps::randomCrop(int width, int height, int crop_width, int crop_height, PhiloxRng& rng) {
+    return randomCropWith(width, height, crop_width, crop_height, PhiloxUniform{rng});
+}
+
+CropRect ImageOps::randomResizedCrop(int width, int height, std::mt19937_64& rng, float min_scale, float max_scale,
+                                     float min_ratio, float max_ratio) {
+    return randomResizedCropWith(width, height, StdUniform{rng}, min_scale, max_scale, min_ratio, max_ratio);
+}
+
+CropRect ImageOps::randomResizedCrop(int width, int height, PhiloxRng& rng, float min_scale, float max_scale,
+                                     float min_ratio, float max_ratio) {
+    return randomResizedCropWith(width, height, PhiloxUniform{rng}, min_scale, max_scale, min_ratio, max_ratio);
+}
@@ -0,0 +1,257 @@
+#ifndef IMAGE_OPS_H
+#define IMAGE_OPS_H
+
+#include "philox.h"
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+class ImageData;
+class TensorData;
+
+/**
+ * 图像处理使用的SIMD指令级别
+ */
+enum class SimdLevel {
+    Scalar,  // 标量实现
+    SSE4,    // SSE4.1（含SSSE3）
+    AVX2,    // AVX2 + FMA
+    AVX512   // AVX-512F + AVX-512BW
+};
+
+/**
+ * 只读的HWC（行优先、通道交错）uint8图像视图，不持有数据
+ * 行之间可以有间隔，裁剪得到的视图直接指向原图中的区域
+ */
+struct ImageView {
+    const unsigned char* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+
+    // 相邻两行起始位置之间的字节数
+    size_t stride = 0;
+
+    ImageView() = default;
+
+    /**
+     * 构造函数
+     * @param stride 行间距，0表示紧密排列（width * channels）
+     */
+    ImageView(const unsigned char* data, int width, int height, int channels, size_t stride = 0)
+        : data(data), width(width), height(height), channels(channels),
+          stride(stride ? stride : static_cast<size_t>(width) * channels) {}
+
+    /**
+     * 构造引用ImageData像素的视图（不会触发映射图像的写时复制）
+     */
+    explicit ImageView(const ImageData& image);
+
+    const unsigned char* row(int y) const { return data + static_cast<size_t>(y) * stride; }
+};
+
+/**
+ * 裁剪区域，以像素为单位
+ */
+struct CropRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * 归一化参数：输出 = (像素值 * scale - mean[c]) / stddev[c]
+ * mean和stddev按通道给出，为空时分别视为0和1
+ */
+struct Normalization {
+    std::vector<float> mean;
+    std::vector<float> stddev;
+    float scale = 1.0f / 255.0f;
+
+    /**
+     * 只做类型转换，不缩放也不归一化
+     */
+    static Normalization none() {
+        Normalization norm;
+        norm.scale = 1.0f;
+        return norm;
+    }
+
+    /**
+     * ImageNet的RGB均值和标准差（像素值先缩放到[0, 1]）
+     */
+    static Normalization imagenet() {
+        Normalization norm;
+        norm.mean = {0.485f, 0.456f, 0.406f};
+        norm.stddev = {0.229f, 0.224f, 0.225f};
+        return norm;
+    }
+};
+
+/**
+ * 图像预处理内核 - 布局转换、归一化、双线性缩放、裁剪和翻转
+ * 输入为HWC布局的uint8图像，浮点输出为CHW布局（每个通道一个平面），可以直接作为模型输入。
+ *
+ * x86上按运行时检测到的指令集选择AVX-512、AVX2或SSE4.1实现，其他平台以及不支持的通道数使用标量实现；
+ * 各级实现的计算顺序相同，浮点结果只在舍入误差范围内不同，uint8结果最多相差1。
+ *
+ * 双线性缩放使用像素中心对齐（与OpenCV的INTER_LINEAR和PyTorch的align_corners=False相同），
+ * 先在两行源像素之间做连续的纵向插值，再按预先计算的列下标和权重做横向插值；
+ * 缩小超过2倍时不做抗锯齿。
+ *
+ * 融合内核cropResizeToChw()在一次遍历中完成裁剪、缩放、水平翻转、布局转换和归一化：
+ * 裁剪只改变采样区域，翻转只反转列下标表，不产生中间图像
+ */
+class ImageOps {
+public:
+    /**
+     * 获取当前CPU支持的最高指令级别
+     */
+    static SimdLevel detectedSimdLevel();
+
+    /**
+     * 获取当前使用的指令级别
+     */
+    static SimdLevel simdLevel();
+
+    /**
+     * 设置使用的指令级别，用于性能对比和排查问题
+     * @param level 指令级别，超过CPU支持的级别时使用detectedSimdLevel()
+     * @return 实际使用的级别
+     */
+    static SimdLevel setSimdLevel(SimdLevel level);
+
+    /**
+     * 获取指令级别的名称，例如"AVX2"
+     */
+    static const char* simdLevelName(SimdLevel level);
+
+    /**
+     * HWC uint8转换为CHW float，同时归一化
+     * @param src 源图像
+     * @param dst 输出，大小为channels * height * width
+     * @param norm 归一化参数
+     */
+    static void toChw(const ImageView& src, float* dst, const Normalization& norm = Normalization());
+
+    /**
+     * 对CHW float数据按通道原地归一化：x = (x * scale - mean[c]) / stddev[c]
+     * @param data CHW数据
+     * @param channels 通道数
+     * @param plane_size 每个通道的元素数（height * width）
+     * @param norm 归一化参数
+     */
+    static void normalize(float* data, int channels, size_t plane_size, const Normalization& norm);
+
+    /**
+     * 双线性缩放
+     * @param src 源图像
+     * @param dst 输出，HWC紧密排列，大小为height * width * src.channels
+     * @param width 输出宽度
+     * @param height 输出高度
+     */
+    static void resize(const ImageView& src, unsigned char* dst, int width, int height);
+
+    /**
+     * 裁剪（逐行复制）
+     * 不需要复制时可以直接使用crop(const ImageView&, const CropRect&)得到的视图
+     * @param dst 输出，HWC紧密排列，大小为rect.height * rect.width * src.channels
+     * @throws std::invalid_argument 区域超出图像范围时抛出
+     */
+    static void crop(const ImageView& src, const CropRect& rect, unsigned char* dst);
+
+    /**
+     * 水平翻转（左右镜像）
+     * @param dst 输出，HWC紧密排列，不能与源数据重叠
+     */
+    static void flipHorizontal(const ImageView& src, unsigned char* dst);
+
+    /**
+     * 垂直翻转（上下颠倒）
+     * @param dst 输出，HWC紧密排列，不能与源数据重叠
+     */
+    static void flipVertical(const ImageView& src, unsigned char* dst);
+
+    /**
+     * 融合内核：裁剪 + 双线性缩放 + 可选的水平翻转，输出HWC uint8
+     * @param src 源图像
+     * @param rect 裁剪区域
+     * @param width 输出宽度
+     * @param height 输出高度
+     * @param flip 是否水平翻转
+     * @param dst 输出，大小为height * width * src.channels
+     */
+    static void cropResize(const ImageView& src, const CropRect& rect, int width, int height, bool flip,
+                           unsigned char* dst);
+
+    /**
+     * 融合内核：裁剪 + 双线性缩放 + 可选的水平翻转 + CHW转换 + 归一化
+     * 等价于依次调用crop()、resize()、flipHorizontal()和toChw()，但只读取一遍源像素，不分配中间图像
+     * @param src 源图像
+     * @param rect 裁剪区域
+     * @param width 输出宽度
+     * @param height 输出高度
+     * @param flip 是否水平翻转
+     * @param dst 输出，大小为src.channels * height * width
+     * @param norm 归一化参数
+     */
+    static void cropResizeToChw(const ImageView& src, const CropRect& rect, int width, int height, bool flip,
+                                float* dst, const Normalization& norm = Normalization());
+
+    /**
+     * 获取裁剪区域的视图，不复制数据
+     * @throws std::invalid_argument 区域超出图像范围时抛出
+     */
+    static ImageView crop(const ImageView& src, const CropRect& rect);
+
+    /**
+     * 对ImageData的便捷版本，结果存放在池化缓冲区中
+     */
+    static std::unique_ptr<ImageData> crop(const ImageData& image, const CropRect& rect);
+    static std::unique_ptr<ImageData> resize(const ImageData& image, int width, int height);
+    static std::unique_ptr<ImageData> flipHorizontal(const ImageData& image);
+    static std::unique_ptr<ImageData> cropResize(const ImageData& image, const CropRect& rect, int width, int height,
+                                                 bool flip = false);
+
+    /**
+     * 对ImageData的便捷版本，结果为形状{channels, height, width}的float32张量
+     */
+    static std::unique_ptr<TensorData> toChw(const ImageData& image, const Normalization& norm = Normalization());
+    static std::unique_ptr<TensorData> cropResizeToChw(const ImageData& image, const CropRect& rect, int width,
+                                                       int height, bool flip = false,
+                                                       const Normalization& norm = Normalization());
+
+    /**
+     * 中心裁剪区域，裁剪尺寸大于图像时取图像尺寸
+     */
+    static CropRect centerCrop(int width, int height, int crop_width, int crop_height);
+
+    /**
+     * 随机位置的固定尺寸裁剪区域，裁剪尺寸大于图像时取图像尺寸
+     * @param rng 随机数生成器，可以用Sampler派生的引擎使结果可复现
+     */
+    static CropRect randomCrop(int width, int height, int crop_width, int crop_height, std::mt19937_64& rng);
+
+    /**
+     * 使用预处理上下文中的生成器（ProcessingContext::rng），结果在任何平台上逐位相同
+     */
+    static CropRect randomCrop(int width, int height, int crop_width, int crop_height, PhiloxRng& rng);
+
+    /**
+     * Inception风格的随机缩放裁剪区域（RandomResizedCrop）：面积占比在[min_scale, max_scale]内、
+     * 宽高比在[min_ratio, max_ratio]内（对数均匀）随机选取，10次尝试都不满足时退化为按宽高比限制的中心裁剪
+     * 通常与cropResizeToChw()配合使用
+     */
+    static CropRect randomResizedCrop(int width, int height, std::mt19937_64& rng,
+                                      float min_scale = 0.08f, float max_scale = 1.0f,
+                                      float min_ratio = 3.0f / 4.0f, float max_ratio = 4.0f / 3.0f);
+
+    static CropRect randomResizedCrop(int width, int height, PhiloxRng& rng,
+                                      float min_scale = 0.08f, float max_scale = 1.0f,
+                                      float min_ratio = 3.0f / 4.0f, float max_ratio = 4.0f / 3.0f);
+};
+
+#endif // IMAGE_OPS_H
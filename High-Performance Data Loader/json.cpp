@@ -0,0 +1,402 @@
+#include "json.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+// 递归下降解析器；嵌套深度有上限，避免恶意输入耗尽栈空间
+class JsonValue::Parser {
+public:
+    explicit Parser(const std::string& text) : text_(text) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue(0);
+        skipWhitespace();
+        if (pos_ != text_.size()) {
+            fail("unexpected trailing characters");
+        }
+        return value;
+    }
+
+private:
+    static constexpr size_t kMaxDepth = 512;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos_) + ": " + message);
+    }
+
+    void skipWhitespace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (text_.compare(pos_, length, literal) != 0) {
+            return false;
+        }
+        pos_ += length;
+        return true;
+    }
+
+    JsonValue parseValue(size_t depth) {
+        if (depth > kMaxDepth) {
+            fail("nesting too deep");
+        }
+        skipWhitespace();
+        if (pos_ >= text_.size()) {
+            fail("unexpected end of input");
+        }
+        JsonValue value;
+        char c = text_[pos_];
+        if (c == '{') {
+            value.type_ = Type::Object;
+            value.object_ = parseObject(depth);
+        } else if (c == '[') {
+            value.type_ = Type::Array;
+            value.array_ = parseArray(depth);
+        } else if (c == '"') {
+            value.type_ = Type::String;
+            value.string_ = parseString();
+        } else if (consume("true")) {
+            value.type_ = Type::Bool;
+            value.boolean_ = true;
+        } else if (consume("false")) {
+            value.type_ = Type::Bool;
+        } else if (consume("null")) {
+            value.type_ = Type::Null;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            parseNumber(value);
+        } else {
+            fail(std::string("unexpected character '") + c + "'");
+        }
+        return value;
+    }
+
+    std::shared_ptr<const Object> parseObject(size_t depth) {
+        auto object = std::make_shared<Object>();
+        ++pos_;
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return object;
+        }
+        while (true) {
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') {
+                fail("expected object key");
+            }
+            std::string key = parseString();
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != ':') {
+                fail("expected ':'");
+            }
+            ++pos_;
+            (*object)[std::move(key)] = parseValue(depth + 1);
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == '}') {
+                ++pos_;
+                return object;
+            } else {
+                fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    std::shared_ptr<const Array> parseArray(size_t depth) {
+        auto array = std::make_shared<Array>();
+        ++pos_;
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            ++pos_;
+            return array;
+        }
+        while (true) {
+            array->push_back(parseValue(depth + 1));
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == ']') {
+                ++pos_;
+                return array;
+            } else {
+                fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    unsigned parseHex4() {
+        if (pos_ + 4 > text_.size()) {
+            fail("truncated \\u escape");
+        }
+        unsigned code = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                fail("invalid \\u escape");
+            }
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string parseString() {
+        ++pos_;
+        std::string result;
+        while (true) {
+            // 复制到下一个引号或转义之前的普通字符
+            size_t end = text_.find_first_of("\"\\", pos_);
+            if (end == std::string::npos) {
+                fail("unterminated string");
+            }
+            result.append(text_, pos_, end - pos_);
+            pos_ = end + 1;
+            if (text_[end] == '"') {
+                return result;
+            }
+            if (pos_ >= text_.size()) {
+                fail("unterminated string");
+            }
+            char escape = text_[pos_++];
+            switch (escape) {
+                case '"': result += '"'; break;
+                case '\\': result += '\\'; break;
+                case '/': result += '/'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u': {
+                    unsigned code = parseHex4();
+                    // UTF-16代理对
+                    if (code >= 0xD800 && code <= 0xDBFF && text_.compare(pos_, 2, "\\u") == 0) {
+                        pos_ += 2;
+                        unsigned low = parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            fail("invalid surrogate pair");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(result, code);
+                    break;
+                }
+                default:
+                    fail(std::string("invalid escape '\\") + escape + "'");
+            }
+        }
+    }
+
+    void parseNumber(JsonValue& value) {
+        size_t start = pos_;
+        bool integral = true;
+        if (text_[pos_] == '-') {
+            ++pos_;
+        }
+        auto digits = [&]() {
+            size_t begin = pos_;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+                ++pos_;
+            }
+            if (pos_ == begin) {
+                fail("invalid number");
+            }
+        };
+        digits();
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            integral = false;
+            ++pos_;
+            digits();
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            integral = false;
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+                ++pos_;
+            }
+            digits();
+        }
+
+        std::string literal = text_.substr(start, pos_ - start);
+        value.type_ = Type::Number;
+        value.number_ = std::strtod(literal.c_str(), nullptr);
+        if (!integral) {
+            return;
+        }
+        errno = 0;
+        if (literal[0] == '-') {
+            long long parsed = std::strtoll(literal.c_str(), nullptr, 10);
+            if (errno == 0) {
+                value.integer_ = Integer::Signed;
+                value.signed_ = parsed;
+            }
+        } else {
+            unsigned long long parsed = std::strtoull(literal.c_str(), nullptr, 10);
+            if (errno == 0) {
+                value.unsigned_ = parsed;
+                value.integer_ = Integer::Unsigned;
+                if (parsed <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    value.integer_ = Integer::Signed;
+                    value.signed_ = static_cast<int64_t>(parsed);
+                }
+            }
+        }
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+};
+
+JsonValue JsonValue::parse(const std::string& text) {
+    return Parser(text).parseDocument();
+}
+
+std::string JsonValue::quote(const std::string& value) {
+    std::string quoted = "\"";
+    for (char c : value) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\r': quoted += "\\r"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(c));
+                    quoted += escape;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+bool JsonValue::asBool() const {
+    if (type_ != Type::Bool) {
+        throw std::runtime_error("JSON value is not a boolean");
+    }
+    return boolean_;
+}
+
+double JsonValue::asDouble() const {
+    if (type_ != Type::Number) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    return number_;
+}
+
+int64_t JsonValue::asInt() const {
+    if (type_ != Type::Number) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    if (integer_ == Integer::Signed) {
+        return signed_;
+    }
+    if (integer_ == Integer::None && std::trunc(number_) == number_ && std::fabs(number_) < 9.2e18) {
+        return static_cast<int64_t>(number_);
+    }
+    throw std::runtime_error("JSON number is not a 64-bit integer");
+}
+
+uint64_t JsonValue::asUint() const {
+    if (type_ != Type::Number) {
+        throw std::runtime_error("JSON value is not a number");
+    }
+    if (integer_ == Integer::Signed && signed_ >= 0) {
+        return static_cast<uint64_t>(signed_);
+    }
+    if (integer_ == Integer::Unsigned) {
+        return unsigned_;
+    }
+    if (integer_ == Integer::None && std::trunc(number_) == number_ && number_ >= 0 && number_ < 1.8e19) {
+        return static_cast<uint64_t>(number_);
+    }
+    throw std::runtime_error("JSON number is not an unsigned 64-bit integer");
+}
+
+const std::string& JsonValue::asString() const {
+    if (type_ != Type::String) {
+        throw std::runtime_error("JSON value is not a string");
+    }
+    return string_;
+}
+
+const JsonValue::Array& JsonValue::asArray() const {
+    if (type_ != Type::Array) {
+        throw std::runtime_error("JSON value is not an array");
+    }
+    return *array_;
+}
+
+const JsonValue::Object& JsonValue::asObject() const {
+    if (type_ != Type::Object) {
+        throw std::runtime_error("JSON value is not an object");
+    }
+    return *object_;
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (type_ != Type::Object) {
+        return nullptr;
+    }
+    auto it = object_->find(key);
+    return it == object_->end() ? nullptr : &it->second;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    const JsonValue* value = find(key);
+    if (!value) {
+        throw std::runtime_error("JSON object has no member \"" + key + "\"");
+    }
+    return *value;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    const Array& array = asArray();
+    if (index >= array.size()) {
+        throw std::runtime_error("JSON array index " + std::to_string(index) + " out of range");
+    }
+    return array[index];
+}
+
+size_t JsonValue::size() const {
+    if (type_ == Type::Array) {
+        return array_->size();
+    }
+    if (type_ == Type::Object) {
+        return object_->size();
+    }
+    return 0;
+}
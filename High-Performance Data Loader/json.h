@@ -0,0 +1,97 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * JSON值 - 只读的最小JSON解析器，用于WebHDFS等REST接口的响应和词表之类的配置文件
+ * 整数在int64/uint64范围内时保留精确值（文件长度、偏移），其他数字按double保存。
+ * 数组和对象的内容通过shared_ptr共享，复制JsonValue的开销很小
+ */
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    using Array = std::vector<JsonValue>;
+    using Object = std::map<std::string, JsonValue>;
+
+    JsonValue() = default;
+
+    /**
+     * 解析JSON文本
+     * @param text JSON文本，前后可以有空白
+     * @return 解析结果
+     * @throws std::runtime_error 格式错误时抛出，消息中包含出错的位置
+     */
+    static JsonValue parse(const std::string& text);
+
+    /**
+     * 把字符串编码为带引号的JSON字符串
+     */
+    static std::string quote(const std::string& value);
+
+    Type type() const { return type_; }
+    bool isNull() const { return type_ == Type::Null; }
+    bool isBool() const { return type_ == Type::Bool; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isString() const { return type_ == Type::String; }
+    bool isArray() const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    /**
+     * 类型转换，类型不符或数值超出范围时抛出std::runtime_error
+     */
+    bool asBool() const;
+    double asDouble() const;
+    int64_t asInt() const;
+    uint64_t asUint() const;
+    const std::string& asString() const;
+    const Array& asArray() const;
+    const Object& asObject() const;
+
+    /**
+     * 查找对象成员
+     * @return 成员不存在或不是对象时返回nullptr
+     */
+    const JsonValue* find(const std::string& key) const;
+
+    /**
+     * 获取对象成员
+     * @throws std::runtime_error 不是对象或成员不存在时抛出
+     */
+    const JsonValue& operator[](const std::string& key) const;
+
+    /**
+     * 获取数组元素
+     * @throws std::runtime_error 不是数组或下标越界时抛出
+     */
+    const JsonValue& operator[](size_t index) const;
+
+    /**
+     * 数组或对象的元素个数，其他类型为0
+     */
+    size_t size() const;
+
+private:
+    class Parser;
+
+    // 数字的精确整数表示
+    enum class Integer { None, Signed, Unsigned };
+
+    Type type_ = Type::Null;
+    bool boolean_ = false;
+    Integer integer_ = Integer::None;
+    int64_t signed_ = 0;
+    uint64_t unsigned_ = 0;
+    double number_ = 0.0;
+    std::string string_;
+    std::shared_ptr<const Array> array_;
+    std::shared_ptr<const Object> object_;
+};
+
+#endif // JSON_H
@@ -0,0 +1,229 @@
+#include "line_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+LineReader::LineReader(const std::string& path, Storage* storage, size_t window_bytes,
+                       char delimiter, bool skip_empty, bool strip_cr)
+    : path_(path),
+      storage_(storage),
+      window_bytes_(std::max<size_t>(window_bytes, 4096)),
+      delimiter_(delimiter),
+      skip_empty_(skip_empty),
+      strip_cr_(strip_cr && delimiter != '\r') {
+    if (!storage_) {
+        owned_storage_ = StorageFactory::createStorageForPath(path);
+        storage_ = owned_storage_.get();
+    }
+    file_size_ = storage_->getFileSize(path);
+
+    buffers_[0] = PooledBuffer(window_bytes_);
+    buffers_[1] = PooledBuffer(window_bytes_);
+    if (file_size_ > 0) {
+        startRead(0, 0);
+    }
+}
+
+LineReader::~LineReader() {
+    for (auto& pending : pending_) {
+        if (pending.valid()) {
+            pending.wait();
+        }
+    }
+}
+
+void LineReader::startRead(int slot, uint64_t offset) {
+    size_t length = static_cast<size_t>(std::min<uint64_t>(window_bytes_, file_size_ - offset));
+    unsigned char* destination = buffers_[slot].data();
+    buffer_offsets_[slot] = offset;
+    next_read_offset_ = offset + length;
+
+    pending_[slot] = io_pool_.enqueue([this, destination, offset, length]() {
+        size_t bytes = storage_->readInto(path_, offset, destination, length);
+        if (bytes != length) {
+            throw std::runtime_error("Unexpected end of file: " + path_);
+        }
+        return bytes;
+    });
+}
+
+bool LineReader::advance() {
+    int slot = current_ ^ 1;
+    if (!pending_[slot].valid()) {
+        return false;
+    }
+    size_t bytes = pending_[slot].get();
+
+    current_ = slot;
+    pos_ = reinterpret_cast<const char*>(buffers_[slot].data());
+    end_ = pos_ + bytes;
+
+    // 上一个窗口中未处理完的数据已拼接到carry_中，其缓冲区可以用于读取再下一个窗口
+    if (next_read_offset_ < file_size_) {
+        startRead(slot ^ 1, next_read_offset_);
+    }
+    return true;
+}
+
+bool LineReader::next(std::string_view& line) {
+    if (carry_returned_) {
+        carry_.clear();
+        carry_returned_ = false;
+    }
+
+    while (true) {
+        if (pos_ < end_) {
+            const char* base = reinterpret_cast<const char*>(buffers_[current_].data());
+            const char* hit = static_cast<const char*>(memchr(pos_, delimiter_, static_cast<size_t>(end_ - pos_)));
+            if (!hit) {
+                // 记录延续到下一个窗口，先把已有部分拼接到carry_中
+                if (carry_.empty()) {
+                    record_offset_ = buffer_offsets_[current_] + static_cast<uint64_t>(pos_ - base);
+                }
+                carry_.append(pos_, static_cast<size_t>(end_ - pos_));
+                pos_ = end_;
+            } else {
+                if (carry_.empty()) {
+                    record_offset_ = buffer_offsets_[current_] + static_cast<uint64_t>(pos_ - base);
+                    line = std::string_view(pos_, static_cast<size_t>(hit - pos_));
+                } else {
+                    carry_.append(pos_, static_cast<size_t>(hit - pos_));
+                    line = carry_;
+                    carry_returned_ = true;
+                }
+                pos_ = hit + 1;
+
+                if (strip_cr_ && !line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                if (skip_empty_ && line.empty()) {
+                    if (carry_returned_) {
+                        carry_.clear();
+                        carry_returned_ = false;
+                    }
+                    continue;
+                }
+                return true;
+            }
+        }
+
+        if (!advance()) {
+            // 文件末尾没有分隔符的最后一条记录
+            if (carry_.empty()) {
+                return false;
+            }
+            line = carry_;
+            carry_returned_ = true;
+            if (strip_cr_ && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (skip_empty_ && line.empty()) {
+                return false;
+            }
+            return true;
+        }
+    }
+}
+
+// TextWindowDataset实现
+
+namespace {
+
+// 查找记录边界时第一次读取的字节数，之后每次加倍，不超过窗口大小
+constexpr size_t kBoundaryProbe = 64 << 10;
+
+} // namespace
+
+TextWindowDataset::TextWindowDataset(Storage* storage, size_t window_bytes, char delimiter)
+    : storage_(storage),
+      window_bytes_(std::max<size_t>(window_bytes, 1)),
+      delimiter_(delimiter) {
+}
+
+size_t TextWindowDataset::addFile(const std::string& path) {
+    if (file_index_.count(path) != 0) {
+        return 0;
+    }
+    if (!storage_) {
+        owned_storage_ = StorageFactory::createStorageForPath(path);
+        storage_ = owned_storage_.get();
+    }
+    if (!storage_->fileExists(path)) {
+        throw std::runtime_error("File not found: " + path);
+    }
+    uint64_t file_size = storage_->getFileSize(path);
+    uint32_t file = static_cast<uint32_t>(files_.size());
+    files_.push_back(path);
+    file_sizes_.push_back(file_size);
+    file_index_[path] = file;
+
+    uint64_t count = (file_size + window_bytes_ - 1) / window_bytes_;
+    for (uint64_t i = 0; i < count; ++i) {
+        windows_.push_back(Window{file, i});
+    }
+    return static_cast<size_t>(count);
+}
+
+PathTable TextWindowDataset::windowTable() const {
+    PathTable::Builder builder(true);
+    builder.reserve(windows_.size(), 0);
+    for (const Window& window : windows_) {
+        builder.add(files_[window.file] + "@" + std::to_string(window.index));
+    }
+    return builder.build();
+}
+
+uint64_t TextWindowDataset::recordEnd(const std::string& path, uint64_t from, uint64_t file_size) {
+    std::vector<unsigned char> buffer;
+    size_t probe = std::min(kBoundaryProbe, window_bytes_);
+    while (from < file_size) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(probe, file_size - from));
+        buffer.resize(length);
+        size_t bytes = storage_->readInto(path, from, buffer.data(), length);
+        if (bytes == 0) {
+            break;
+        }
+        const void* hit = memchr(buffer.data(), delimiter_, bytes);
+        if (hit) {
+            return from + static_cast<uint64_t>(static_cast<const unsigned char*>(hit) - buffer.data()) + 1;
+        }
+        from += bytes;
+        probe = std::min(probe * 2, std::max(window_bytes_, kBoundaryProbe));
+    }
+    return file_size;
+}
+
+std::string TextWindowDataset::read(const std::string& window_path) {
+    size_t at = window_path.rfind('@');
+    auto it = at == std::string::npos ? file_index_.end() : file_index_.find(window_path.substr(0, at));
+    if (it == file_index_.end()) {
+        throw std::runtime_error("Unknown text window: " + window_path);
+    }
+    const std::string& path = files_[it->second];
+    uint64_t file_size = file_sizes_[it->second];
+    uint64_t index = 0;
+    try {
+        index = std::stoull(window_path.substr(at + 1));
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Invalid text window: " + window_path);
+    }
+    uint64_t begin = index * window_bytes_;
+    if (begin >= file_size) {
+        throw std::runtime_error("Text window out of range: " + window_path);
+    }
+    uint64_t window_end = std::min<uint64_t>(begin + window_bytes_, file_size);
+
+    // 窗口内的记录从begin处或之后的第一个记录起点开始，到最后一条在窗口内开始的记录结束
+    uint64_t start = index == 0 ? 0 : recordEnd(path, begin - 1, file_size);
+    if (start >= window_end) {
+        return std::string();
+    }
+    uint64_t end = window_end == file_size ? file_size : recordEnd(path, window_end - 1, file_size);
+
+    std::string text(static_cast<size_t>(end - start), '\0');
+    size_t bytes = storage_->readInto(path, start, reinterpret_cast<unsigned char*>(&text[0]), text.size());
+    if (bytes != text.size()) {
+        throw std::runtime_error("Unexpected end of file: " + path);
+    }
+    return text;
+}
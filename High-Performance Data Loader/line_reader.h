@@ -0,0 +1,223 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include "storage.h"
+#include "buffer_pool.h"
+#include "thread_pool.h"
+#include "path_table.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <future>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 流式行读取器 - 以固定大小的窗口逐块读取文本文件，逐条返回行（或以其他分隔符分隔的记录）
+ * 内存占用只有两个窗口，与文件大小无关，适合多GB的文本文件。
+ *
+ * 双缓冲：处理一个窗口中的行时，下一个窗口已在读取器自己的I/O线程上读取。
+ * 返回的行是指向窗口的string_view，不拷贝；只有跨越两个窗口的行（每个窗口至多一条）
+ * 以及超过窗口大小的行才会被拼接到内部缓冲区中
+ */
+class LineReader {
+public:
+    /**
+     * 构造函数，立即开始读取第一个窗口；第二个窗口在第一次切换到第一个窗口时开始读取
+     * @param path 文件路径
+     * @param storage 用于读取的存储接口，为空时根据路径创建；由调用方管理时其生命周期必须长于读取器
+     * @param window_bytes 窗口大小
+     * @param delimiter 记录分隔符
+     * @param skip_empty 是否跳过空记录
+     * @param strip_cr 是否去掉记录末尾的'\r'（CRLF换行）
+     * @throws std::runtime_error 文件不存在时抛出
+     */
+    explicit LineReader(const std::string& path, Storage* storage = nullptr, size_t window_bytes = 4 << 20,
+                        char delimiter = '\n', bool skip_empty = false, bool strip_cr = true);
+
+    /**
+     * 析构函数，等待后台读取完成
+     */
+    ~LineReader();
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    /**
+     * 读取下一条记录
+     * @param line 输出参数，记录内容（不含分隔符），在下一次调用next()之前有效
+     * @return 到达文件末尾时返回false
+     * @throws std::runtime_error 读取失败时抛出
+     */
+    bool next(std::string_view& line);
+
+    /**
+     * 依次处理剩余的所有记录
+     * @param fn 处理函数，参数为std::string_view
+     * @return 处理的记录数量
+     */
+    template<class F>
+    size_t forEach(F&& fn) {
+        size_t count = 0;
+        std::string_view line;
+        while (next(line)) {
+            fn(line);
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * 获取上一条记录在文件中的起始偏移
+     */
+    uint64_t recordOffset() const { return record_offset_; }
+
+    /**
+     * 获取文件大小
+     */
+    uint64_t fileSize() const { return file_size_; }
+
+private:
+    /**
+     * 在后台把从offset开始的一个窗口读入第slot个缓冲区
+     */
+    void startRead(int slot, uint64_t offset);
+
+    /**
+     * 切换到已在后台读取的下一个窗口，并开始读取再下一个窗口
+     * @return 没有更多数据时返回false
+     */
+    bool advance();
+
+    std::string path_;
+    std::unique_ptr<Storage> owned_storage_;
+    Storage* storage_;
+    size_t window_bytes_;
+    char delimiter_;
+    bool skip_empty_;
+    bool strip_cr_;
+    uint64_t file_size_;
+
+    // 两个窗口缓冲区、各自在文件中的偏移及后台读取，pending_[i]返回读取的字节数
+    PooledBuffer buffers_[2];
+    uint64_t buffer_offsets_[2] = {0, 0};
+    std::future<size_t> pending_[2];
+    uint64_t next_read_offset_ = 0;
+
+    // 当前窗口，current_初始指向第二个缓冲区，第一次advance()即切换到第一个窗口
+    int current_ = 1;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+
+    // 跨越窗口的记录；carry_returned_表示上一次返回的记录位于carry_中，下一次调用时清空
+    std::string carry_;
+    bool carry_returned_ = false;
+
+    uint64_t record_offset_ = 0;
+
+    // 执行窗口读取的线程，同一时刻只有一个窗口在读取；最后声明，最先析构
+    ThreadPool io_pool_{1};
+};
+
+/**
+ * 文本窗口数据集 - 把大文本文件按固定大小的窗口切分为DataLoader的数据项，不需要预先建立行索引
+ * 每个窗口对应一个形如"<文件路径>@<窗口序号>"的数据项路径，内容是起始位置落在该窗口内的所有完整记录，
+ * 通过一次区间读取直接读入返回的字符串；加载函数把它包装为TextData，预处理函数再用forEachRecord()
+ * 逐条取出记录的string_view，不再拷贝。
+ * 与RecordDataset相比不需要扫描整个文件，但每个数据项是一批记录，打乱的粒度是窗口
+ */
+class TextWindowDataset {
+public:
+    /**
+     * 构造函数
+     * @param storage 用于读取的存储接口，为空时根据第一个文件的路径创建；由调用方管理时其生命周期必须长于数据集
+     * @param window_bytes 窗口大小
+     * @param delimiter 记录分隔符
+     */
+    explicit TextWindowDataset(Storage* storage = nullptr, size_t window_bytes = 4 << 20, char delimiter = '\n');
+
+    TextWindowDataset(const TextWindowDataset&) = delete;
+    TextWindowDataset& operator=(const TextWindowDataset&) = delete;
+
+    /**
+     * 添加文件，同一路径只添加一次
+     * @param path 文件路径
+     * @return 该文件的窗口数量，已添加过时返回0
+     * @throws std::runtime_error 文件不存在时抛出
+     */
+    size_t addFile(const std::string& path);
+
+    /**
+     * 获取窗口总数
+     */
+    size_t size() const { return windows_.size(); }
+
+    /**
+     * 获取所有窗口的数据项路径表，可以直接传给DataLoader
+     */
+    PathTable windowTable() const;
+
+    /**
+     * 按数据项路径读取窗口中的完整记录（包含记录之后的分隔符）
+     * 窗口内没有记录起点（例如被一条超过窗口大小的记录覆盖）时返回空字符串
+     * @param window_path windowTable()中的路径
+     * @return 窗口内容
+     * @throws std::runtime_error 路径无效或读取失败时抛出
+     */
+    std::string read(const std::string& window_path);
+
+    /**
+     * 依次处理窗口内容中的每条记录
+     * @param text read()返回的窗口内容
+     * @param delimiter 记录分隔符
+     * @param fn 处理函数，参数为指向text的std::string_view
+     * @param skip_empty 是否跳过空记录
+     * @param strip_cr 是否去掉记录末尾的'\r'（CRLF换行）
+     * @return 处理的记录数量
+     */
+    template<class F>
+    static size_t forEachRecord(std::string_view text, char delimiter, F&& fn, bool skip_empty = false,
+                                bool strip_cr = true) {
+        size_t count = 0;
+        while (!text.empty()) {
+            size_t end = text.find(delimiter);
+            std::string_view record = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            if (strip_cr && delimiter != '\r' && !record.empty() && record.back() == '\r') {
+                record.remove_suffix(1);
+            }
+            if (skip_empty && record.empty()) {
+                continue;
+            }
+            fn(record);
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    /**
+     * 查找from处或之后的第一个分隔符
+     * @return 分隔符之后的位置；没有分隔符时返回文件大小
+     */
+    uint64_t recordEnd(const std::string& path, uint64_t from, uint64_t file_size);
+
+    struct Window {
+        uint32_t file;
+        uint64_t index;
+    };
+
+    std::unique_ptr<Storage> owned_storage_;
+    Storage* storage_;
+    size_t window_bytes_;
+    char delimiter_;
+
+    std::vector<std::string> files_;
+    std::vector<uint64_t> file_sizes_;
+    std::unordered_map<std::string, uint32_t> file_index_;
+    std::vector<Window> windows_;
+};
+
+#endif // LINE_READER_H
@@ -0,0 +1,565 @@
+#include "manifest.h"
+#include "byte_order.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace fs = std::filesystem;
+
+constexpr char DatasetManifest::kMagic[8];
+
+namespace {
+
+// 目录修改时间在这个时刻之后的目录，遍历期间的修改可能与遍历时读到的时间戳相同（时间戳精度有限），
+// 写入清单时记为无效，下次加载时重新遍历
+constexpr int64_t kRacyWindowNs = 1000000000;
+
+std::string normalizeRoot(const std::string& root) {
+    std::string normalized = root;
+    while (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+std::string joinPath(const std::string& dir, std::string_view name) {
+    std::string path;
+    path.reserve(dir.size() + 1 + name.size());
+    path += dir;
+    if (path.empty() || path.back() != '/') {
+        path += '/';
+    }
+    path += name;
+    return path;
+}
+
+// 当前时刻，与directoryMtime()使用同一时钟
+int64_t nowNs() {
+#ifdef __linux__
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        fs::file_time_type::clock::now().time_since_epoch()).count();
+#endif
+}
+
+bool directoryMtime(const std::string& path, int64_t& mtime_ns) {
+#ifdef __linux__
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return false;
+    }
+    mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+#else
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    if (ec || !fs::is_directory(path, ec)) {
+        return false;
+    }
+    mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return true;
+#endif
+}
+
+/**
+ * 一次遍历的共享状态
+ */
+class Scanner {
+public:
+    explicit Scanner(const ListOptions& options) : options_(options) {
+        for (const auto& extension : options_.extensions) {
+            std::string lower = extension;
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            extensions_.push_back(std::move(lower));
+        }
+    }
+
+    /**
+     * 读取一个目录，把其中的文件和目录修改时间加入结果
+     * @param dir_path 目录路径
+     * @param is_root 是否为根目录，根目录无法读取时抛出异常
+     * @return 需要继续遍历的子目录
+     */
+    std::vector<std::string> scan(const std::string& dir_path, bool is_root);
+
+    Listing take() {
+        return std::move(listing_);
+    }
+
+private:
+    bool acceptName(std::string_view name, bool is_directory) const {
+        if (options_.skip_hidden && !name.empty() && name[0] == '.') {
+            return false;
+        }
+        if (!is_directory && !extensions_.empty()) {
+            bool matched = false;
+            for (const auto& extension : extensions_) {
+                if (name.size() >= extension.size() &&
+                    std::equal(extension.begin(), extension.end(), name.end() - extension.size(),
+                               [](char a, char b) {
+                                   return a == static_cast<char>(std::tolower(static_cast<unsigned char>(b)));
+                               })) {
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                return false;
+            }
+        }
+        return !options_.filter || options_.filter(name, is_directory);
+    }
+
+    void addResults(std::vector<FileEntry>& files, DirectoryStamp stamp) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listing_.files.insert(listing_.files.end(),
+                              std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+        listing_.directories.push_back(std::move(stamp));
+    }
+
+    const ListOptions& options_;
+    std::vector<std::string> extensions_;
+
+    std::mutex mutex_;
+    Listing listing_;
+
+    // 已遍历目录的(设备号, inode)，只在跟随符号链接时用于检测环路
+    std::set<std::pair<uint64_t, uint64_t>> visited_;
+};
+
+#ifdef __linux__
+
+std::vector<std::string> Scanner::scan(const std::string& dir_path, bool is_root) {
+    std::vector<std::string> subdirs;
+
+    int fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        // 遍历期间被删除或替换的子目录直接跳过
+        if (!is_root && (errno == ENOENT || errno == ENOTDIR)) {
+            return subdirs;
+        }
+        if (is_root) {
+            throw std::runtime_error("Directory does not exist: " + dir_path);
+        }
+        throw std::runtime_error("Failed to open directory: " + dir_path + " - " + strerror(errno));
+    }
+
+    // 在读取目录项之前获取修改时间，遍历期间发生的修改会使记录的时间过期
+    struct stat dir_stat;
+    if (fstat(fd, &dir_stat) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to stat directory: " + dir_path + " - " + strerror(error));
+    }
+    if (options_.follow_symlinks) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!visited_.emplace(static_cast<uint64_t>(dir_stat.st_dev), static_cast<uint64_t>(dir_stat.st_ino)).second) {
+            close(fd);
+            return subdirs;
+        }
+    }
+    DirectoryStamp stamp{dir_path, static_cast<int64_t>(dir_stat.st_mtim.tv_sec) * 1000000000 + dir_stat.st_mtim.tv_nsec};
+
+    // 较大的缓冲区使包含大量条目的目录只需少数几次系统调用
+    thread_local std::vector<char> buffer(256 << 10);
+    std::vector<FileEntry> files;
+
+    while (true) {
+        long bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (bytes < 0) {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("Failed to read directory: " + dir_path + " - " + strerror(error));
+        }
+        if (bytes == 0) {
+            break;
+        }
+
+        // linux_dirent64: d_ino u64 | d_off s64 | d_reclen u16 | d_type u8 | d_name
+        for (long pos = 0; pos < bytes;) {
+            const char* record = buffer.data() + pos;
+            unsigned short reclen;
+            memcpy(&reclen, record + 16, sizeof(reclen));
+            unsigned char type = static_cast<unsigned char>(record[18]);
+            std::string_view name(record + 19);
+            pos += reclen;
+
+            if (name == "." || name == "..") {
+                continue;
+            }
+
+            bool is_directory = type == DT_DIR;
+            bool is_file = type == DT_REG;
+            bool is_link = type == DT_LNK;
+            uint64_t size = 0;
+
+            // 文件系统不提供类型时需要stat
+            struct stat st;
+            if (type == DT_UNKNOWN) {
+                if (fstatat(fd, name.data(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                is_directory = S_ISDIR(st.st_mode);
+                is_file = S_ISREG(st.st_mode);
+                is_link = S_ISLNK(st.st_mode);
+                size = static_cast<uint64_t>(st.st_size);
+            }
+
+            // 符号链接按其目标处理，悬空的链接跳过
+            if (is_link) {
+                if (fstatat(fd, name.data(), &st, 0) != 0) {
+                    continue;
+                }
+                is_directory = S_ISDIR(st.st_mode) && options_.follow_symlinks;
+                is_file = S_ISREG(st.st_mode);
+                size = static_cast<uint64_t>(st.st_size);
+            }
+
+            if (is_directory) {
+                if (options_.recursive && acceptName(name, true)) {
+                    subdirs.push_back(joinPath(dir_path, name));
+                }
+            } else if (is_file && acceptName(name, false)) {
+                if (options_.with_sizes && type == DT_REG) {
+                    if (fstatat(fd, name.data(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                        continue;
+                    }
+                    size = static_cast<uint64_t>(st.st_size);
+                }
+                files.push_back(FileEntry{joinPath(dir_path, name), options_.with_sizes ? size : 0});
+            }
+        }
+    }
+    close(fd);
+
+    addResults(files, std::move(stamp));
+    return subdirs;
+}
+
+#else
+
+std::vector<std::string> Scanner::scan(const std::string& dir_path, bool is_root) {
+    std::vector<std::string> subdirs;
+    std::error_code ec;
+
+    DirectoryStamp stamp{dir_path, 0};
+    if (!directoryMtime(dir_path, stamp.mtime_ns)) {
+        if (is_root) {
+            throw std::runtime_error("Directory does not exist: " + dir_path);
+        }
+        return subdirs;
+    }
+
+    std::vector<FileEntry> files;
+    for (const auto& entry : fs::directory_iterator(dir_path, ec)) {
+        std::string name = entry.path().filename().string();
+        bool is_link = entry.is_symlink(ec);
+        if (entry.is_directory(ec) && (!is_link || options_.follow_symlinks)) {
+            if (options_.recursive && acceptName(name, true)) {
+                subdirs.push_back(joinPath(dir_path, name));
+            }
+        } else if (entry.is_regular_file(ec) && acceptName(name, false)) {
+            uint64_t size = options_.with_sizes ? static_cast<uint64_t>(entry.file_size(ec)) : 0;
+            files.push_back(FileEntry{joinPath(dir_path, name), size});
+        }
+    }
+    if (ec && is_root) {
+        throw std::runtime_error("Failed to read directory: " + dir_path + " - " + ec.message());
+    }
+
+    addResults(files, std::move(stamp));
+    return subdirs;
+}
+
+#endif
+
+std::runtime_error manifestError(const std::string& path, const std::string& what) {
+    return std::runtime_error("Invalid manifest " + path + ": " + what);
+}
+
+} // namespace
+
+// DirectoryLister实现
+
+Listing DirectoryLister::list(const std::string& root, const ListOptions& options) {
+    int64_t started_ns = nowNs();
+    Scanner scanner(options);
+    std::vector<std::string> subdirs = scanner.scan(normalizeRoot(root), true);
+
+    if (!subdirs.empty()) {
+        // 每个目录是一个任务，读取目录时发现的子目录立即提交，任务组等待整棵树完成
+        ThreadPool pool(options.threads ? options.threads : std::thread::hardware_concurrency());
+        ThreadPool::TaskGroup group(pool);
+        std::function<void(const std::string&)> visit = [&](const std::string& dir_path) {
+            for (auto& subdir : scanner.scan(dir_path, false)) {
+                group.run([&visit, subdir = std::move(subdir)]() {
+                    visit(subdir);
+                });
+            }
+        };
+        for (auto& subdir : subdirs) {
+            group.run([&visit, subdir = std::move(subdir)]() {
+                visit(subdir);
+            });
+        }
+        group.wait();
+    }
+
+    Listing listing = scanner.take();
+    listing.started_ns = started_ns;
+    std::sort(listing.files.begin(), listing.files.end(), [](const FileEntry& a, const FileEntry& b) {
+        return a.path < b.path;
+    });
+    std::sort(listing.directories.begin(), listing.directories.end(), [](const DirectoryStamp& a, const DirectoryStamp& b) {
+        return a.path < b.path;
+    });
+    return listing;
+}
+
+// DatasetManifest实现
+
+DatasetManifest::DatasetManifest(std::shared_ptr<MappedFile> file) : file_(std::move(file)) {
+    const std::string& path = file_->path();
+    const unsigned char* in = file_->data();
+    size_t size = file_->size();
+
+    if (size < kHeaderSize || memcmp(in, kMagic, 8) != 0) {
+        throw manifestError(path, "bad header");
+    }
+    if (getU32(in + 8) != kVersion) {
+        throw manifestError(path, "unsupported version " + std::to_string(getU32(in + 8)));
+    }
+    uint64_t file_count = getU64(in + 16);
+    uint64_t dir_count = getU64(in + 24);
+    strings_size_ = getU64(in + 32);
+    options_hash_ = getU64(in + 40);
+    root_length_ = getU32(in + 48);
+
+    uint64_t max_entries = (size - kHeaderSize) / kEntrySize;
+    if (file_count > max_entries || dir_count > max_entries - file_count ||
+        kHeaderSize + (file_count + dir_count) * kEntrySize + strings_size_ != size ||
+        root_length_ > strings_size_) {
+        throw manifestError(path, "truncated manifest");
+    }
+
+    file_count_ = static_cast<size_t>(file_count);
+    dir_count_ = static_cast<size_t>(dir_count);
+    files_ = in + kHeaderSize;
+    dirs_ = files_ + file_count_ * kEntrySize;
+    strings_ = reinterpret_cast<const char*>(dirs_ + dir_count_ * kEntrySize);
+}
+
+uint64_t DatasetManifest::optionsHash(const ListOptions& options) {
+    // FNV-1a，覆盖所有影响遍历结果的选项
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](std::string_view bytes) {
+        for (unsigned char c : bytes) {
+            hash = (hash ^ c) * 0x100000001b3ull;
+        }
+        hash = (hash ^ 0xFF) * 0x100000001b3ull;
+    };
+
+    char flags[4] = {
+        options.recursive ? '1' : '0', options.skip_hidden ? '1' : '0',
+        options.follow_symlinks ? '1' : '0', options.with_sizes ? '1' : '0'
+    };
+    mix(std::string_view(flags, sizeof(flags)));
+
+    std::vector<std::string> extensions;
+    for (const auto& extension : options.extensions) {
+        std::string lower = extension;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        extensions.push_back(std::move(lower));
+    }
+    std::sort(extensions.begin(), extensions.end());
+    for (const auto& extension : extensions) {
+        mix(extension);
+    }
+    mix(options.filter_tag);
+    return hash;
+}
+
+void DatasetManifest::write(const std::string& manifest_path, const std::string& root,
+                            const Listing& listing, const ListOptions& options) {
+    std::string normalized_root = normalizeRoot(root);
+
+    uint64_t strings_size = normalized_root.size();
+    for (const auto& file : listing.files) {
+        strings_size += file.path.size();
+    }
+    for (const auto& dir : listing.directories) {
+        strings_size += dir.path.size();
+    }
+
+    std::string temp_path = manifest_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create manifest: " + temp_path);
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    bool written = true;
+    auto put = [&](const void* data, size_t size) {
+        written = written && fwrite(data, 1, size, file) == size;
+    };
+
+    unsigned char header[kHeaderSize] = {};
+    memcpy(header, kMagic, 8);
+    putU32(header + 8, kVersion);
+    putU64(header + 16, listing.files.size());
+    putU64(header + 24, listing.directories.size());
+    putU64(header + 32, strings_size);
+    putU64(header + 40, optionsHash(options));
+    putU32(header + 48, static_cast<uint32_t>(normalized_root.size()));
+    put(header, sizeof(header));
+
+    // 条目中的偏移按字符串区的写入顺序计算：根目录、文件路径、目录路径
+    uint64_t offset = normalized_root.size();
+    unsigned char entry[kEntrySize] = {};
+    for (const auto& f : listing.files) {
+        putU64(entry, offset);
+        putU64(entry + 8, f.size);
+        putU32(entry + 16, static_cast<uint32_t>(f.path.size()));
+        put(entry, sizeof(entry));
+        offset += f.path.size();
+    }
+    for (const auto& dir : listing.directories) {
+        // 修改时间距遍历开始太近的目录可能在遍历期间被修改而时间戳不变，记为无效
+        int64_t mtime = dir.mtime_ns >= listing.started_ns - kRacyWindowNs ? -1 : dir.mtime_ns;
+        putU64(entry, offset);
+        putU64(entry + 8, static_cast<uint64_t>(mtime));
+        putU32(entry + 16, static_cast<uint32_t>(dir.path.size()));
+        put(entry, sizeof(entry));
+        offset += dir.path.size();
+    }
+
+    put(normalized_root.data(), normalized_root.size());
+    for (const auto& f : listing.files) {
+        put(f.path.data(), f.path.size());
+    }
+    for (const auto& dir : listing.directories) {
+        put(dir.path.data(), dir.path.size());
+    }
+
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        throw std::runtime_error("Failed to write manifest: " + temp_path);
+    }
+    fs::rename(temp_path, manifest_path);
+}
+
+std::shared_ptr<DatasetManifest> DatasetManifest::open(const std::string& manifest_path) {
+    return std::shared_ptr<DatasetManifest>(new DatasetManifest(MappedFile::open(manifest_path)));
+}
+
+std::shared_ptr<DatasetManifest> DatasetManifest::loadOrBuild(const std::string& root, const std::string& manifest_path,
+                                                              const ListOptions& options, bool* rebuilt) {
+    if (FileIO::fileExists(manifest_path)) {
+        try {
+            std::shared_ptr<DatasetManifest> manifest = open(manifest_path);
+            if (manifest->isValid(root, options)) {
+                if (rebuilt) {
+                    *rebuilt = false;
+                }
+                return manifest;
+            }
+        } catch (const std::runtime_error&) {
+            // 清单损坏时重新遍历
+        }
+    }
+
+    Listing listing = DirectoryLister::list(root, options);
+    write(manifest_path, root, listing, options);
+    if (rebuilt) {
+        *rebuilt = true;
+    }
+    return open(manifest_path);
+}
+
+bool DatasetManifest::isValid(const std::string& root, const ListOptions& options) const {
+    if (this->root() != normalizeRoot(root) || options_hash_ != optionsHash(options)) {
+        return false;
+    }
+
+    std::atomic<bool> changed(false);
+    auto check = [this, &changed](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !changed.load(std::memory_order_relaxed); ++i) {
+            const unsigned char* entry = dirs_ + i * kEntrySize;
+            int64_t stored = static_cast<int64_t>(getU64(entry + 8));
+            int64_t current;
+            if (stored < 0 || !directoryMtime(std::string(stringAt(getU64(entry), getU32(entry + 16))), current) ||
+                current != stored) {
+                changed = true;
+            }
+        }
+    };
+
+    // 目录很多时stat本身也很耗时（尤其在网络文件系统上），并行检查
+    constexpr size_t kGrain = 256;
+    if (dir_count_ <= kGrain) {
+        check(0, dir_count_);
+    } else {
+        ThreadPool pool(options.threads ? options.threads : std::thread::hardware_concurrency());
+        pool.parallel_for(0, dir_count_, kGrain, check);
+    }
+    return !changed;
+}
+
+std::string_view DatasetManifest::stringAt(uint64_t offset, uint32_t length) const {
+    if (offset > strings_size_ || length > strings_size_ - offset) {
+        throw manifestError(file_->path(), "path out of range");
+    }
+    return std::string_view(strings_ + offset, length);
+}
+
+std::string_view DatasetManifest::path(size_t index) const {
+    const unsigned char* entry = files_ + index * kEntrySize;
+    return stringAt(getU64(entry), getU32(entry + 16));
+}
+
+uint64_t DatasetManifest::fileSize(size_t index) const {
+    return getU64(files_ + index * kEntrySize + 8);
+}
+
+uint64_t DatasetManifest::totalBytes() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < file_count_; ++i) {
+        total += fileSize(i);
+    }
+    return total;
+}
+
+std::vector<std::string> DatasetManifest::paths() const {
+    std::vector<std::string> result;
+    result.reserve(file_count_);
+    for (size_t i = 0; i < file_count_; ++i) {
+        result.emplace_back(path(i));
+    }
+    return result;
+}
+
+std::string_view DatasetManifest::root() const {
+    return std::string_view(strings_, root_length_);
+}
@@ -0,0 +1,207 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include "file_io.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 目录遍历选项
+ */
+struct ListOptions {
+    // 是否递归遍历子目录
+    bool recursive = true;
+
+    // 只保留这些扩展名的文件（如".jpg"，不区分大小写），为空时保留所有文件
+    std::vector<std::string> extensions;
+
+    // 是否跳过以'.'开头的文件和目录
+    bool skip_hidden = false;
+
+    // 是否进入指向目录的符号链接（会检测环路）；指向文件的符号链接总是按其目标文件处理
+    bool follow_symlinks = false;
+
+    // 是否获取文件大小；不需要时可以省去每个文件一次stat
+    bool with_sizes = true;
+
+    // 自定义过滤函数，参数为条目名称和是否为目录，返回false时跳过该条目（目录则不再进入）。
+    // 清单无法记录函数本身，过滤条件变化时应当使用filter_tag区分
+    std::function<bool(std::string_view name, bool is_directory)> filter;
+
+    // 自定义过滤条件的标识，写入清单并在加载时比较
+    std::string filter_tag;
+
+    // 遍历线程数，0表示使用硬件线程数
+    size_t threads = 0;
+};
+
+/**
+ * 遍历结果中的文件条目
+ */
+struct FileEntry {
+    std::string path;
+    uint64_t size;
+};
+
+/**
+ * 遍历结果中的目录条目，修改时间用于判断清单是否过期
+ */
+struct DirectoryStamp {
+    std::string path;
+    int64_t mtime_ns;
+};
+
+/**
+ * 目录遍历结果，文件和目录均按路径排序
+ */
+struct Listing {
+    std::vector<FileEntry> files;
+    std::vector<DirectoryStamp> directories;
+
+    // 遍历开始的时刻（纳秒，与目录修改时间同一时钟）
+    int64_t started_ns = 0;
+};
+
+/**
+ * 并行目录遍历器
+ * 每个目录作为一个任务提交到线程池，子目录在读取父目录时即被提交，深而宽的目录树可以充分并行。
+ * Linux上直接通过getdents64批量读取目录项，并利用目录项中的类型字段判断文件和目录，
+ * 只在需要文件大小或文件系统不提供类型时才相对于目录描述符调用fstatat；
+ * 其他平台回退到std::filesystem
+ */
+class DirectoryLister {
+public:
+    /**
+     * 遍历目录
+     * @param root 根目录
+     * @param options 遍历选项
+     * @return 遍历结果
+     * @throws std::runtime_error 根目录不存在或目录无法读取时抛出（遍历期间被删除的子目录会被跳过）
+     */
+    static Listing list(const std::string& root, const ListOptions& options = ListOptions());
+};
+
+/**
+ * 数据集清单 - 缓存目录遍历结果的二进制文件
+ * 首次运行时遍历目录并写出清单，之后的运行直接映射清单文件，不必重新遍历。
+ * 清单中记录了每个目录的修改时间：目录中的条目被增加、删除或重命名时其修改时间会改变，
+ * 加载时并行检查所有目录，任何一个发生变化即视为过期并重新遍历。
+ * 文件内容被原地修改不会改变目录的修改时间，此时清单中的文件大小可能过期
+ *
+ * 文件格式（所有整数均为小端序）：
+ *   文件头  magic "HPDLMNFT"(8) | version u32 | reserved u32 | file_count u64 | dir_count u64 |
+ *           strings_size u64 | options_hash u64 | root_length u32 | reserved u32
+ *   文件    path_offset u64 | size u64 | path_length u32 | reserved u32
+ *   目录    path_offset u64 | mtime_ns i64 | path_length u32 | reserved u32
+ *   字符串  根目录及所有路径依次拼接
+ */
+class DatasetManifest {
+public:
+    static constexpr char kMagic[8] = {'H', 'P', 'D', 'L', 'M', 'N', 'F', 'T'};
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 56;
+    static constexpr size_t kEntrySize = 24;
+
+    /**
+     * 把遍历结果写为清单文件（先写临时文件再重命名）
+     * @param manifest_path 清单文件路径
+     * @param root 遍历的根目录
+     * @param listing 遍历结果
+     * @param options 遍历时使用的选项
+     */
+    static void write(const std::string& manifest_path, const std::string& root,
+                      const Listing& listing, const ListOptions& options);
+
+    /**
+     * 映射清单文件
+     * @param manifest_path 清单文件路径
+     * @return 清单
+     * @throws std::runtime_error 文件不存在或格式错误时抛出
+     */
+    static std::shared_ptr<DatasetManifest> open(const std::string& manifest_path);
+
+    /**
+     * 加载清单，清单不存在、格式错误、选项不同或已过期时重新遍历并写出。
+     * 清单文件应放在被遍历的目录之外，否则写出清单本身就会改变目录的修改时间
+     * @param root 根目录
+     * @param manifest_path 清单文件路径
+     * @param options 遍历选项
+     * @param rebuilt 输出参数，可以为空；重新遍历时置为true
+     * @return 清单
+     */
+    static std::shared_ptr<DatasetManifest> loadOrBuild(const std::string& root, const std::string& manifest_path,
+                                                        const ListOptions& options = ListOptions(),
+                                                        bool* rebuilt = nullptr);
+
+    /**
+     * 检查清单是否仍然有效：根目录和选项相同，且所有目录的修改时间都没有变化
+     * @param root 根目录
+     * @param options 遍历选项
+     * @return 有效时返回true
+     */
+    bool isValid(const std::string& root, const ListOptions& options) const;
+
+    /**
+     * 获取文件数量
+     */
+    size_t size() const { return file_count_; }
+
+    /**
+     * 获取目录数量
+     */
+    size_t directoryCount() const { return dir_count_; }
+
+    /**
+     * 获取第index个文件的路径，视图指向映射的清单文件，在清单存活期间有效
+     */
+    std::string_view path(size_t index) const;
+
+    /**
+     * 获取第index个文件的大小
+     */
+    uint64_t fileSize(size_t index) const;
+
+    /**
+     * 获取所有文件的总大小
+     */
+    uint64_t totalBytes() const;
+
+    /**
+     * 获取所有文件的路径
+     */
+    std::vector<std::string> paths() const;
+
+    /**
+     * 获取遍历的根目录
+     */
+    std::string_view root() const;
+
+    /**
+     * 获取清单文件的映射
+     */
+    const std::shared_ptr<MappedFile>& mapping() const { return file_; }
+
+private:
+    explicit DatasetManifest(std::shared_ptr<MappedFile> file);
+
+    static uint64_t optionsHash(const ListOptions& options);
+
+    std::string_view stringAt(uint64_t offset, uint32_t length) const;
+
+    std::shared_ptr<MappedFile> file_;
+    size_t file_count_ = 0;
+    size_t dir_count_ = 0;
+    uint64_t options_hash_ = 0;
+    const unsigned char* files_ = nullptr;
+    const unsigned char* dirs_ = nullptr;
+    const char* strings_ = nullptr;
+    uint64_t strings_size_ = 0;
+    uint32_t root_length_ = 0;
+};
+
+#endif // MANIFEST_H
@@ -0,0 +1,201 @@
+#include "metadata_cache.h"
+#include "manifest.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+MetadataCachingStorage::MetadataCachingStorage(std::unique_ptr<Storage> inner, const MetadataCacheOptions& options)
+    : inner_(std::move(inner)), options_(options), listings_(std::max<size_t>(options.list_capacity, 1)) {
+    if (!inner_) {
+        throw std::runtime_error("MetadataCachingStorage requires an inner storage");
+    }
+    size_t per_shard = std::max<size_t>((options_.capacity + kShards - 1) / kShards, 1);
+    shards_.reserve(kShards);
+    for (size_t i = 0; i < kShards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(per_shard));
+    }
+}
+
+MetadataCachingStorage::~MetadataCachingStorage() = default;
+
+MetadataCachingStorage::Shard& MetadataCachingStorage::shardFor(const std::string& file_path) const {
+    return *shards_[std::hash<std::string>()(file_path) % kShards];
+}
+
+MetadataCachingStorage::Clock::time_point MetadataCachingStorage::expiry(std::chrono::milliseconds ttl) const {
+    return ttl.count() > 0 ? Clock::now() + ttl : Clock::time_point::max();
+}
+
+bool MetadataCachingStorage::find(const std::string& file_path, Entry& entry, bool need_size) {
+    Shard& shard = shardFor(file_path);
+    std::optional<Entry> cached = shard.get(file_path);
+    if (cached && cached->expires <= Clock::now()) {
+        shard.remove(file_path);
+    } else if (cached && (!need_size || !cached->exists || cached->size_known)) {
+        entry = *cached;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void MetadataCachingStorage::store(const std::string& file_path, bool exists, bool size_known, uint64_t size) {
+    if (!exists && options_.negative_ttl.count() <= 0) {
+        return;
+    }
+    Entry entry;
+    entry.exists = exists;
+    entry.size_known = size_known;
+    entry.size = size;
+    entry.expires = expiry(exists ? options_.ttl : options_.negative_ttl);
+    shardFor(file_path).put(file_path, std::move(entry));
+}
+
+bool MetadataCachingStorage::fileExists(const std::string& file_path) {
+    Entry entry;
+    if (find(file_path, entry)) {
+        return entry.exists;
+    }
+    bool exists = inner_->fileExists(file_path);
+    store(file_path, exists, false, 0);
+    return exists;
+}
+
+size_t MetadataCachingStorage::getFileSize(const std::string& file_path) {
+    Entry entry;
+    if (find(file_path, entry, true)) {
+        if (!entry.exists) {
+            throw std::runtime_error("File does not exist: " + file_path);
+        }
+        return static_cast<size_t>(entry.size);
+    }
+    size_t size = inner_->getFileSize(file_path);
+    store(file_path, true, true, size);
+    return size;
+}
+
+std::vector<std::string> MetadataCachingStorage::listFiles(const std::string& dir_path) {
+    std::optional<Listing> cached = listings_.get(dir_path);
+    if (cached && cached->expires > Clock::now()) {
+        list_hits_.fetch_add(1, std::memory_order_relaxed);
+        return *cached->files;
+    }
+    list_misses_.fetch_add(1, std::memory_order_relaxed);
+
+    auto files = std::make_shared<const std::vector<std::string>>(inner_->listFiles(dir_path));
+    Listing listing;
+    listing.files = files;
+    listing.expires = expiry(options_.list_ttl);
+    listings_.put(dir_path, std::move(listing));
+    return *files;
+}
+
+void MetadataCachingStorage::prefetchMetadata(const std::vector<std::string>& paths, size_t threads) {
+    std::vector<const std::string*> missing;
+    Clock::time_point now = Clock::now();
+    for (const auto& path : paths) {
+        std::optional<Entry> cached = shardFor(path).get(path);
+        if (!cached || cached->expires <= now || (cached->exists && !cached->size_known)) {
+            missing.push_back(&path);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    // 查询主要是等待（stat或网络往返），线程数可以远多于CPU核数
+    ThreadPool pool(std::min(std::max<size_t>(threads, 1), missing.size()));
+    pool.parallel_for(0, missing.size(), 0, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const std::string& path = *missing[i];
+            try {
+                store(path, true, true, inner_->getFileSize(path));
+            } catch (const std::runtime_error&) {
+                // 只有确认文件不存在时才缓存否定结果，其他错误留给之后的访问处理
+                try {
+                    if (!inner_->fileExists(path)) {
+                        store(path, false, false, 0);
+                    }
+                } catch (const std::runtime_error&) {
+                }
+            }
+        }
+    });
+}
+
+void MetadataCachingStorage::loadManifest(const DatasetManifest& manifest) {
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        store(std::string(manifest.path(i)), true, true, manifest.fileSize(i));
+    }
+}
+
+void MetadataCachingStorage::insert(const std::string& file_path, uint64_t size) {
+    store(file_path, true, true, size);
+}
+
+void MetadataCachingStorage::invalidate(const std::string& file_path) {
+    shardFor(file_path).remove(file_path);
+}
+
+void MetadataCachingStorage::clear() {
+    for (auto& shard : shards_) {
+        shard->clear();
+    }
+    listings_.clear();
+}
+
+MetadataCachingStorage::Stats MetadataCachingStorage::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.list_hits = list_hits_.load(std::memory_order_relaxed);
+    stats.list_misses = list_misses_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+        stats.entries += shard->size();
+    }
+    return stats;
+}
+
+std::vector<unsigned char> MetadataCachingStorage::readFile(const std::string& file_path) {
+    return inner_->readFile(file_path);
+}
+
+std::vector<unsigned char> MetadataCachingStorage::readRange(const std::string& file_path, uint64_t offset,
+                                                             size_t length) {
+    return inner_->readRange(file_path, offset, length);
+}
+
+size_t MetadataCachingStorage::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer,
+                                        size_t length) {
+    return inner_->readInto(file_path, offset, buffer, length);
+}
+
+PooledBuffer MetadataCachingStorage::readFilePooled(const std::string& file_path) {
+    return inner_->readFilePooled(file_path);
+}
+
+std::string MetadataCachingStorage::readTextFile(const std::string& file_path) {
+    return inner_->readTextFile(file_path);
+}
+
+void MetadataCachingStorage::prefetch(const std::vector<std::string>& paths) {
+    inner_->prefetch(paths);
+}
+
+void MetadataCachingStorage::setAccessPattern(AccessAdvice pattern) {
+    inner_->setAccessPattern(pattern);
+}
+
+void MetadataCachingStorage::setStreaming(bool enabled) {
+    inner_->setStreaming(enabled);
+}
+
+void MetadataCachingStorage::advise(const std::vector<std::string>& paths, AccessAdvice advice) {
+    inner_->advise(paths, advice);
+}
+
+std::vector<BlockLocation> MetadataCachingStorage::getBlockLocations(const std::string& file_path) {
+    return inner_->getBlockLocations(file_path);
+}
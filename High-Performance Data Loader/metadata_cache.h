@@ -0,0 +1,179 @@
+#ifndef METADATA_CACHE_H
+#define METADATA_CACHE_H
+
+#include "storage.h"
+#include "cache.h"
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class DatasetManifest;
+
+/**
+ * 元数据缓存选项
+ */
+struct MetadataCacheOptions {
+    // 缓存的文件元数据条目数上限（平均分配到各分片，向上取整），超出时淘汰最久未使用的条目
+    size_t capacity = 1 << 20;
+
+    // 缓存的目录列表数上限
+    size_t list_capacity = 1024;
+
+    // 文件存在时的元数据（存在性和大小）的有效期，0表示永不过期
+    std::chrono::milliseconds ttl = std::chrono::minutes(10);
+
+    // 文件不存在的结果的有效期，0表示不缓存这类结果
+    std::chrono::milliseconds negative_ttl = std::chrono::seconds(30);
+
+    // 目录列表的有效期，0表示永不过期
+    std::chrono::milliseconds list_ttl = std::chrono::minutes(1);
+};
+
+/**
+ * 元数据缓存存储 - 包装另一个存储，缓存fileExists()、getFileSize()和listFiles()的结果
+ * 本地存储每次查询都要stat，远程存储每次查询都是一次往返（HEAD或LIST）；按大小预分配缓冲区或
+ * 过滤缺失文件的加载函数每轮都对每个样本查询一次。缓存条目有数量上限（按LRU淘汰）和有效期，
+ * 分为多个分片以减少加载线程之间的锁竞争。可以通过prefetchMetadata()并行查询整个数据集的元数据，
+ * 或通过loadManifest()直接使用清单中记录的文件大小。
+ * 读取操作直接转发，不做缓存；数据集在运行期间被修改时，缓存的结果在有效期内可能过时
+ */
+class MetadataCachingStorage : public Storage {
+public:
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        uint64_t hits = 0;         // 文件元数据命中次数
+        uint64_t misses = 0;       // 文件元数据未命中（含过期和缺少大小）次数
+        uint64_t list_hits = 0;    // 目录列表命中次数
+        uint64_t list_misses = 0;  // 目录列表未命中次数
+        size_t entries = 0;        // 缓存的文件元数据条目数
+
+        /**
+         * 文件元数据的命中率
+         */
+        double hitRate() const {
+            uint64_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
+        }
+    };
+
+    /**
+     * 构造函数
+     * @param inner 被包装的存储
+     * @param options 缓存选项
+     */
+    explicit MetadataCachingStorage(std::unique_ptr<Storage> inner,
+                                    const MetadataCacheOptions& options = MetadataCacheOptions());
+
+    ~MetadataCachingStorage() override;
+
+    std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
+    bool fileExists(const std::string& file_path) override;
+    size_t getFileSize(const std::string& file_path) override;
+    std::string readTextFile(const std::string& file_path) override;
+    std::vector<std::string> listFiles(const std::string& dir_path) override;
+    void prefetch(const std::vector<std::string>& paths) override;
+    void setAccessPattern(AccessAdvice pattern) override;
+    void setStreaming(bool enabled) override;
+    void advise(const std::vector<std::string>& paths, AccessAdvice advice) override;
+    std::vector<BlockLocation> getBlockLocations(const std::string& file_path) override;
+
+    /**
+     * 并行查询一批文件的元数据并放入缓存，已缓存且未过期的文件被跳过
+     * 查询失败的文件不缓存，之后访问时重新查询
+     * @param paths 文件路径列表
+     * @param threads 并行查询的线程数，远程存储可以设置得较大以覆盖往返延迟
+     */
+    void prefetchMetadata(const std::vector<std::string>& paths, size_t threads = 16);
+
+    /**
+     * 把清单中的所有文件及其大小放入缓存，不访问存储
+     * @param manifest 数据集清单
+     */
+    void loadManifest(const DatasetManifest& manifest);
+
+    /**
+     * 放入一个文件的大小
+     * @param file_path 文件路径
+     * @param size 文件大小
+     */
+    void insert(const std::string& file_path, uint64_t size);
+
+    /**
+     * 移除一个文件的缓存元数据
+     * @param file_path 文件路径
+     */
+    void invalidate(const std::string& file_path);
+
+    /**
+     * 清空所有缓存
+     */
+    void clear();
+
+    /**
+     * 获取被包装的存储
+     */
+    Storage& inner() { return *inner_; }
+
+    /**
+     * 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * 文件元数据；exists为false时表示文件不存在，size_known为false时只知道文件存在
+     */
+    struct Entry {
+        bool exists = false;
+        bool size_known = false;
+        uint64_t size = 0;
+        Clock::time_point expires;
+    };
+
+    /**
+     * 目录列表
+     */
+    struct Listing {
+        std::shared_ptr<const std::vector<std::string>> files;
+        Clock::time_point expires;
+    };
+
+    using Shard = LRUCache<std::string, Entry>;
+
+    // 分片数，按路径的哈希选择分片
+    static constexpr size_t kShards = 16;
+
+    Shard& shardFor(const std::string& file_path) const;
+
+    /**
+     * 查找未过期的条目，过期的条目被移除
+     * @param need_size 为true时，只由fileExists()记录、不含大小的存在条目不能回答查询，计为未命中
+     */
+    bool find(const std::string& file_path, Entry& entry, bool need_size = false);
+
+    void store(const std::string& file_path, bool exists, bool size_known, uint64_t size);
+
+    Clock::time_point expiry(std::chrono::milliseconds ttl) const;
+
+    std::unique_ptr<Storage> inner_;
+    MetadataCacheOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    LRUCache<std::string, Listing> listings_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> list_hits_{0};
+    std::atomic<uint64_t> list_misses_{0};
+};
+
+#endif // METADATA_CACHE_H
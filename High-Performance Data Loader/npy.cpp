@@ -0,0 +1,457 @@
+#include "npy.h"
+#include "shard.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const char kMagic[] = "\x93NUMPY";
+constexpr size_t kMagicSize = 6;
+
+// 文件头总长度对齐到该值（与NumPy 1.14以后的写入方式相同）
+constexpr size_t kHeaderAlignment = 64;
+
+std::runtime_error headerError(const std::string& message) {
+    return std::runtime_error("Invalid NPY header: " + message);
+}
+
+/**
+ * 文件头字典的解析器
+ * 文件头是Python字面量，例如 {'descr': '<f4', 'fortran_order': False, 'shape': (3, 4), }
+ * 只支持其中出现的字符串、True/False和整数元组
+ */
+class HeaderParser {
+public:
+    HeaderParser(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+    NpyHeader parse() {
+        NpyHeader header;
+        bool has_descr = false;
+        bool has_order = false;
+        bool has_shape = false;
+        expect('{');
+        while (!consume('}')) {
+            std::string key = parseString();
+            expect(':');
+            if (key == "descr") {
+                if (peek() == '[') {
+                    throw headerError("structured dtypes are not supported");
+                }
+                header.dtype = parseDescr(parseString());
+                has_descr = true;
+            } else if (key == "fortran_order") {
+                header.fortran_order = parseBool();
+                has_order = true;
+            } else if (key == "shape") {
+                header.shape = parseShape();
+                has_shape = true;
+            } else {
+                throw headerError("unexpected key '" + key + "'");
+            }
+            if (!consume(',')) {
+                expect('}');
+                break;
+            }
+        }
+        if (!has_descr || !has_order || !has_shape) {
+            throw headerError("missing descr, fortran_order or shape");
+        }
+        return header;
+    }
+
+private:
+    char peek() {
+        skipSpace();
+        return pos_ < end_ ? *pos_ : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            throw headerError(std::string("expected '") + c + "'");
+        }
+    }
+
+    void skipSpace() {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+            ++pos_;
+        }
+    }
+
+    std::string parseString() {
+        char quote = peek();
+        if (quote != '\'' && quote != '"') {
+            throw headerError("expected a string");
+        }
+        const char* begin = ++pos_;
+        while (pos_ < end_ && *pos_ != quote) {
+            ++pos_;
+        }
+        if (pos_ == end_) {
+            throw headerError("unterminated string");
+        }
+        return std::string(begin, pos_++);
+    }
+
+    bool parseBool() {
+        skipSpace();
+        if (end_ - pos_ >= 4 && memcmp(pos_, "True", 4) == 0) {
+            pos_ += 4;
+            return true;
+        }
+        if (end_ - pos_ >= 5 && memcmp(pos_, "False", 5) == 0) {
+            pos_ += 5;
+            return false;
+        }
+        throw headerError("expected True or False");
+    }
+
+    TensorData::Shape parseShape() {
+        TensorData::Shape shape;
+        expect('(');
+        while (!consume(')')) {
+            skipSpace();
+            int64_t dim = 0;
+            const char* begin = pos_;
+            while (pos_ < end_ && *pos_ >= '0' && *pos_ <= '9') {
+                if (dim > (std::numeric_limits<int64_t>::max() - 9) / 10) {
+                    throw headerError("dimension is too large");
+                }
+                dim = dim * 10 + (*pos_++ - '0');
+            }
+            // Python 2写入的文件中维度可能带有L后缀
+            if (pos_ < end_ && *pos_ == 'L') {
+                ++pos_;
+            }
+            if (pos_ == begin) {
+                throw headerError("expected a dimension");
+            }
+            shape.push_back(dim);
+            if (!consume(',')) {
+                expect(')');
+                break;
+            }
+        }
+        return shape;
+    }
+
+    static DType parseDescr(const std::string& descr) {
+        if (descr.size() < 3) {
+            throw headerError("unsupported dtype '" + descr + "'");
+        }
+        char order = descr[0];
+        std::string type = descr.substr(1);
+        DType dtype;
+        if (type == "b1") {
+            dtype = DType::Bool;
+        } else if (type == "u1") {
+            dtype = DType::UInt8;
+        } else if (type == "i1") {
+            dtype = DType::Int8;
+        } else if (type == "u2") {
+            dtype = DType::UInt16;
+        } else if (type == "i2") {
+            dtype = DType::Int16;
+        } else if (type == "u4") {
+            dtype = DType::UInt32;
+        } else if (type == "i4") {
+            dtype = DType::Int32;
+        } else if (type == "u8") {
+            dtype = DType::UInt64;
+        } else if (type == "i8") {
+            dtype = DType::Int64;
+        } else if (type == "f2") {
+            dtype = DType::Float16;
+        } else if (type == "f4") {
+            dtype = DType::Float32;
+        } else if (type == "f8") {
+            dtype = DType::Float64;
+        } else {
+            throw headerError("unsupported dtype '" + descr + "'");
+        }
+
+        // '='是写入文件的机器的字节序，NumPy写入时总会换成'<'或'>'，这里按小端序处理
+        bool little_endian = order == '<' || order == '|' || order == '=';
+        if (order != '<' && order != '>' && order != '|' && order != '=') {
+            throw headerError("unsupported dtype '" + descr + "'");
+        }
+        if (!little_endian && dtypeSize(dtype) > 1) {
+            throw headerError("big-endian dtype '" + descr + "' is not supported");
+        }
+        return dtype;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+/**
+ * 形状和步长覆盖的字节数，用于确定一行在映射中的范围
+ */
+size_t spanBytes(const TensorData::Shape& shape, const TensorData::Shape& strides, size_t item_size) {
+    size_t last = 0;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (shape[i] == 0) {
+            return 0;
+        }
+        last += static_cast<size_t>(shape[i] - 1) * static_cast<size_t>(strides[i]);
+    }
+    return (last + 1) * item_size;
+}
+
+const char* descrOf(DType dtype) {
+    switch (dtype) {
+    case DType::Bool:
+        return "|b1";
+    case DType::UInt8:
+        return "|u1";
+    case DType::Int8:
+        return "|i1";
+    case DType::UInt16:
+        return "<u2";
+    case DType::Int16:
+        return "<i2";
+    case DType::UInt32:
+        return "<u4";
+    case DType::Int32:
+        return "<i4";
+    case DType::UInt64:
+        return "<u8";
+    case DType::Int64:
+        return "<i8";
+    case DType::Float16:
+        return "<f2";
+    case DType::Float32:
+        return "<f4";
+    case DType::Float64:
+        return "<f8";
+    case DType::BFloat16:
+        break;
+    }
+    throw std::invalid_argument(std::string("dtype ") + dtypeName(dtype) + " cannot be stored in NPY format");
+}
+
+} // namespace
+
+// NpyHeader实现
+
+TensorData::Shape NpyHeader::strides() const {
+    if (!fortran_order) {
+        return TensorData::contiguousStrides(shape);
+    }
+    TensorData::Shape strides(shape.size());
+    int64_t stride = 1;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        strides[i] = stride;
+        stride *= std::max<int64_t>(shape[i], 1);
+    }
+    return strides;
+}
+
+// NpyFormat实现
+
+NpyHeader NpyFormat::parseHeader(const unsigned char* data, size_t size) {
+    if (size < kMagicSize + 4 || memcmp(data, kMagic, kMagicSize) != 0) {
+        throw headerError("missing magic string");
+    }
+    const unsigned char major = data[kMagicSize];
+    size_t prefix;
+    size_t header_len;
+    if (major == 1) {
+        prefix = kMagicSize + 4;
+        header_len = static_cast<size_t>(data[8]) | static_cast<size_t>(data[9]) << 8;
+    } else if (major == 2 || major == 3) {
+        if (size < kMagicSize + 6) {
+            throw headerError("truncated header");
+        }
+        prefix = kMagicSize + 6;
+        header_len = 0;
+        for (int i = 3; i >= 0; --i) {
+            header_len = header_len << 8 | data[8 + i];
+        }
+    } else {
+        throw headerError("unsupported version " + std::to_string(major));
+    }
+    if (header_len > size - prefix) {
+        throw headerError("truncated header");
+    }
+
+    const char* text = reinterpret_cast<const char*>(data + prefix);
+    NpyHeader header = HeaderParser(text, text + header_len).parse();
+    header.data_offset = prefix + header_len;
+    return header;
+}
+
+std::string NpyFormat::makeHeader(DType dtype, const TensorData::Shape& shape) {
+    std::string dict = std::string("{'descr': '") + descrOf(dtype) + "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        dict += (i > 0 ? ", " : "") + std::to_string(shape[i]);
+    }
+    dict += shape.size() == 1 ? ",), }" : "), }";  // 一维元组写作"(n,)"
+
+    // 用空格填充，使魔数、版本、长度字段和以换行结尾的字典的总长度为kHeaderAlignment的倍数
+    size_t prefix = kMagicSize + 4;
+    size_t total = (prefix + dict.size() + 1 + kHeaderAlignment - 1) / kHeaderAlignment * kHeaderAlignment;
+    unsigned char major = 1;
+    if (total - prefix > 0xFFFF) {
+        prefix = kMagicSize + 6;
+        total = (prefix + dict.size() + 1 + kHeaderAlignment - 1) / kHeaderAlignment * kHeaderAlignment;
+        major = 2;
+    }
+    const size_t header_len = total - prefix;
+    dict.append(header_len - dict.size() - 1, ' ');
+    dict += '\n';
+
+    std::string header(kMagic, kMagicSize);
+    header += static_cast<char>(major);
+    header += '\0';
+    for (size_t i = 0; i < prefix - kMagicSize - 2; ++i) {
+        header += static_cast<char>((header_len >> (8 * i)) & 0xFF);
+    }
+    return header + dict;
+}
+
+TensorData NpyFormat::view(const MappedBuffer& file) {
+    NpyHeader header = parseHeader(file.data(), file.size());
+    if (header.dataBytes() > file.size() - header.data_offset) {
+        throw std::runtime_error("NPY data is truncated: expected " + std::to_string(header.dataBytes()) +
+                                 " bytes of " + dtypeName(header.dtype) + TensorData::shapeString(header.shape));
+    }
+    TensorData tensor(header.dtype, header.shape, file.subspan(header.data_offset, header.dataBytes()),
+                      header.strides());
+    if (reinterpret_cast<uintptr_t>(file.data() + header.data_offset) % tensor.getItemSize() != 0) {
+        return tensor.copy();
+    }
+    return tensor;
+}
+
+TensorData NpyFormat::load(const std::string& path, AccessAdvice advice) {
+    try {
+        return view(FileIO::mapFile(path, advice));
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+void NpyFormat::save(const std::string& path, const TensorData& tensor) {
+    std::string header = makeHeader(tensor.getDType(), tensor.getShape());
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+    bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+    if (ok && tensor.getByteSize() > 0) {
+        if (tensor.isContiguous()) {
+            ok = fwrite(tensor.getData(), 1, tensor.getByteSize(), file) == tensor.getByteSize();
+        } else {
+            PooledBuffer data(tensor.getByteSize());
+            tensor.copyTo(data.data());
+            ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+        }
+    }
+    if (fclose(file) != 0 || !ok) {
+        throw std::runtime_error("Failed to write file: " + path);
+    }
+}
+
+std::function<std::unique_ptr<DataItem>(const std::string&)> NpyFormat::loader(AccessAdvice advice) {
+    return [advice](const std::string& path) -> std::unique_ptr<DataItem> {
+        return std::make_unique<TensorData>(load(path, advice));
+    };
+}
+
+// NpyDataset实现
+
+NpyDataset::NpyDataset(AccessAdvice advice, bool prefetch) : advice_(advice), prefetch_(prefetch) {}
+
+std::unique_ptr<NpyDataset> NpyDataset::fromFiles(const std::vector<std::string>& paths, AccessAdvice advice) {
+    auto dataset = std::make_unique<NpyDataset>(advice);
+    for (const auto& path : paths) {
+        dataset->addFile(path);
+    }
+    return dataset;
+}
+
+size_t NpyDataset::addFile(const std::string& path) {
+    TensorData array = NpyFormat::load(path, advice_);
+    if (array.getNumDims() == 0) {
+        throw std::runtime_error(path + ": NPY array has no rows (0-dimensional)");
+    }
+    const size_t rows = static_cast<size_t>(array.getShape()[0]);
+    file_index_.emplace(path, files_.size());
+    files_.push_back(path);
+    arrays_.push_back(std::move(array));
+    row_offsets_.push_back(row_offsets_.back() + rows);
+    return rows;
+}
+
+TensorData NpyDataset::row(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("NPY row index " + std::to_string(index) + " out of range (" +
+                                std::to_string(size()) + " rows)");
+    }
+    const size_t file = fileOf(index);
+    const TensorData& array = arrays_[file];
+    const size_t local = index - row_offsets_[file];
+
+    TensorData::Shape shape(array.getShape().begin() + 1, array.getShape().end());
+    TensorData::Shape strides(array.getStrides().begin() + 1, array.getStrides().end());
+    const size_t offset = local * static_cast<size_t>(array.getStrides()[0]) * array.getItemSize();
+    if (array.isView()) {
+        MappedBuffer view = array.getView().subspan(offset, spanBytes(shape, strides, array.getItemSize()));
+        return TensorData(array.getDType(), std::move(shape), std::move(view), std::move(strides));
+    }
+
+    // 未对齐而复制过的数组：复制该行，避免引用数据集内部的存储
+    const unsigned char* data = static_cast<const unsigned char*>(array.getData()) + offset;
+    return TensorData(array.getDType(), std::move(shape), static_cast<const void*>(data), nullptr, std::move(strides))
+        .copy();
+}
+
+size_t NpyDataset::fileOf(size_t index) const {
+    return static_cast<size_t>(std::upper_bound(row_offsets_.begin(), row_offsets_.end(), index) -
+                               row_offsets_.begin()) - 1;
+}
+
+std::unique_ptr<DataItem> NpyDataset::load(const std::string& row_path) const {
+    std::string file_path;
+    size_t local;
+    if (!ShardFormat::parseRecordPath(row_path, file_path, local)) {
+        throw std::runtime_error("Invalid NPY row path: " + row_path);
+    }
+    auto it = file_index_.find(file_path);
+    if (it == file_index_.end() || local >= row_offsets_[it->second + 1] - row_offsets_[it->second]) {
+        throw std::runtime_error("NPY row path does not match dataset: " + row_path);
+    }
+    auto item = std::make_unique<TensorData>(row(row_offsets_[it->second] + local));
+    if (prefetch_ && item->isView()) {
+        // 行所在的页面由内核异步读入，预处理线程访问时通常已经在页缓存中
+        item->getView().advise(AccessAdvice::WillNeed);
+    }
+    return item;
+}
+
+PathTable NpyDataset::rowTable() const {
+    PathTable::Builder builder(true);
+    builder.reserve(size(), 0);
+    for (size_t file = 0; file < files_.size(); ++file) {
+        for (size_t local = 0; local < row_offsets_[file + 1] - row_offsets_[file]; ++local) {
+            builder.add(ShardFormat::recordPath(files_[file], local));
+        }
+    }
+    return builder.build();
+}
+
+std::function<std::unique_ptr<DataItem>(const std::string&)> NpyDataset::loader() const {
+    return [this](const std::string& row_path) { return load(row_path); };
+}
@@ -0,0 +1,192 @@
+#ifndef NPY_H
+#define NPY_H
+
+#include "tensor.h"
+#include "file_io.h"
+#include "path_table.h"
+#include "access_advice.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * NPY文件头 - 数组的元素类型、形状、存储顺序和数据起始位置
+ */
+struct NpyHeader {
+    DType dtype = DType::UInt8;
+    TensorData::Shape shape;
+
+    // 是否为列优先（Fortran）顺序
+    bool fortran_order = false;
+
+    // 数据在文件中的起始偏移（文件头的总长度）
+    size_t data_offset = 0;
+
+    /**
+     * 计算数据的字节数
+     */
+    size_t dataBytes() const { return TensorData::numElements(shape) * dtypeSize(dtype); }
+
+    /**
+     * 计算数组的步长（元素），列优先顺序时为反向的累积乘积
+     */
+    TensorData::Shape strides() const;
+};
+
+/**
+ * NPY格式（NumPy的.npy文件）- 文件头解析与写入
+ * 支持1.0、2.0和3.0版本的文件头，元素类型为小端序（或单字节）的bool、整数和浮点数；
+ * 大端序、结构化类型和Python对象数组不支持。
+ *
+ * 加载时整个文件只读映射，数组直接引用映射中的数据，不复制：页面在第一次访问时才由内核读入，
+ * 只用到一小部分数据时（例如只取几行）不会读取整个文件
+ */
+class NpyFormat {
+public:
+    /**
+     * 解析文件头
+     * @param data 文件开头的数据
+     * @param size 数据大小，至少包含整个文件头
+     * @return 文件头
+     * @throws std::runtime_error 格式不正确或元素类型不支持时抛出
+     */
+    static NpyHeader parseHeader(const unsigned char* data, size_t size);
+
+    /**
+     * 生成文件头（1.0版本，需要时为2.0），长度为64的倍数，使数据起始位置64字节对齐
+     * @param dtype 元素类型，不支持bfloat16
+     * @param shape 形状
+     * @return 文件头的字节
+     */
+    static std::string makeHeader(DType dtype, const TensorData::Shape& shape);
+
+    /**
+     * 把映射的NPY文件解释为张量，不复制数据
+     * 数据起始位置没有按元素大小对齐时（少见的手工构造文件）复制为池化存储
+     * @param file 整个文件的映射区间
+     * @return 张量视图
+     * @throws std::runtime_error 格式不正确或文件被截断时抛出
+     */
+    static TensorData view(const MappedBuffer& file);
+
+    /**
+     * 映射并加载NPY文件，不复制数据
+     * @param path 本地文件路径
+     * @param advice 映射建立后应用的访问模式提示
+     * @return 张量视图
+     */
+    static TensorData load(const std::string& path, AccessAdvice advice = AccessAdvice::Normal);
+
+    /**
+     * 把张量写入NPY文件（行优先顺序）
+     * @throws std::runtime_error 写入失败时抛出
+     */
+    static void save(const std::string& path, const TensorData& tensor);
+
+    /**
+     * 创建加载整个NPY文件的加载函数，可以直接传给DataLoader::setLoaderFunction()
+     * @param advice 映射建立后应用的访问模式提示
+     */
+    static std::function<std::unique_ptr<DataItem>(const std::string&)> loader(
+        AccessAdvice advice = AccessAdvice::Normal);
+};
+
+/**
+ * NPY行数据集 - 把一个或多个大.npy文件的第0维切成单独的样本
+ * 预先计算的特征通常保存为形状{N, ...}的一个大数组，每一行是一个样本。
+ * 每个文件只映射一次，每行对应一个形如"<文件路径>#<行序号>"的数据项路径（序号为文件内的行号），
+ * 加载得到的是引用映射的形状为{...}的张量，不复制数据；
+ * 由于数据项引用映射，DataLoader缓存的副本也只共享映射，不占用额外内存。
+ *
+ * 所有文件都添加完之后才能开始加载，之后数据集只读，可以被多个加载线程同时使用
+ */
+class NpyDataset {
+public:
+    /**
+     * 构造函数
+     * @param advice 映射文件的访问模式提示，按行随机读取时默认关闭预读
+     * @param prefetch 加载一行时是否提示内核提前读入该行（WillNeed），使页面读取与后续处理重叠
+     */
+    explicit NpyDataset(AccessAdvice advice = AccessAdvice::Random, bool prefetch = true);
+
+    NpyDataset(const NpyDataset&) = delete;
+    NpyDataset& operator=(const NpyDataset&) = delete;
+
+    /**
+     * 映射一组文件并创建数据集
+     */
+    static std::unique_ptr<NpyDataset> fromFiles(const std::vector<std::string>& paths,
+                                                 AccessAdvice advice = AccessAdvice::Random);
+
+    /**
+     * 映射文件并添加其中的所有行
+     * @param path 本地文件路径
+     * @return 添加的行数
+     * @throws std::runtime_error 格式不正确或数组为0维时抛出
+     */
+    size_t addFile(const std::string& path);
+
+    /**
+     * 获取总行数
+     */
+    size_t size() const { return row_offsets_.back(); }
+
+    /**
+     * 获取文件数量
+     */
+    size_t fileCount() const { return arrays_.size(); }
+
+    /**
+     * 获取文件路径
+     */
+    const std::string& filePath(size_t file) const { return files_.at(file); }
+
+    /**
+     * 获取文件中的整个数组（视图）
+     */
+    const TensorData& array(size_t file) const { return arrays_.at(file); }
+
+    /**
+     * 按全局行索引获取一行，不复制数据
+     * @throws std::out_of_range 索引越界时抛出
+     */
+    TensorData row(size_t index) const;
+
+    /**
+     * 按数据项路径加载一行
+     * @param row_path rowTable()中的路径
+     * @throws std::runtime_error 路径格式不正确或与数据集不符时抛出
+     */
+    std::unique_ptr<DataItem> load(const std::string& row_path) const;
+
+    /**
+     * 获取所有行的数据项路径表（前缀压缩），顺序与全局行索引一致
+     */
+    PathTable rowTable() const;
+
+    /**
+     * 创建加载函数，可以直接传给DataLoader::setLoaderFunction()；数据集的生命周期必须长于加载器
+     */
+    std::function<std::unique_ptr<DataItem>(const std::string&)> loader() const;
+
+private:
+    size_t fileOf(size_t index) const;
+
+    AccessAdvice advice_;
+    bool prefetch_;
+
+    std::vector<std::string> files_;
+    std::vector<TensorData> arrays_;
+
+    // 文件路径到文件序号的映射，同一文件添加多次时指向第一次
+    std::unordered_map<std::string, size_t> file_index_;
+
+    // 每个文件第一行的全局行索引，最后一个元素为总行数
+    std::vector<size_t> row_offsets_{0};
+};
+
+#endif // NPY_H
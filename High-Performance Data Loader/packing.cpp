@@ -0,0 +1,243 @@
+#include "packing.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// 打包结果超过该字节数时才在线程池上并行复制
+constexpr size_t kParallelPackBytes = 1 << 20;
+
+/**
+ * First-Fit的行容量线段树：叶子为各行的剩余容量，内部节点为子树中的最大值。
+ * 尚未使用的行的剩余容量为整行，查找第一个放得下的行时自然按顺序开启新行
+ */
+class CapacityTree {
+public:
+    CapacityTree(size_t rows, size_t capacity) {
+        leaves_ = 1;
+        while (leaves_ < rows) {
+            leaves_ <<= 1;
+        }
+        max_.assign(2 * leaves_, 0);
+        std::fill(max_.begin() + static_cast<std::ptrdiff_t>(leaves_),
+                  max_.begin() + static_cast<std::ptrdiff_t>(leaves_ + rows), capacity);
+        for (size_t node = leaves_; node-- > 1;) {
+            max_[node] = std::max(max_[2 * node], max_[2 * node + 1]);
+        }
+    }
+
+    /**
+     * 查找剩余容量不小于length的第一行，并从中扣除length
+     */
+    size_t take(size_t length) {
+        size_t node = 1;
+        while (node < leaves_) {
+            node = max_[2 * node] >= length ? 2 * node : 2 * node + 1;
+        }
+        max_[node] -= length;
+        const size_t row = node - leaves_;
+        for (node >>= 1; node >= 1; node >>= 1) {
+            max_[node] = std::max(max_[2 * node], max_[2 * node + 1]);
+        }
+        return row;
+    }
+
+private:
+    size_t leaves_;
+    std::vector<size_t> max_;
+};
+
+} // namespace
+
+SequencePacker::SequencePacker(PackingOptions options) : options_(std::move(options)) {
+    if (options_.row_length == 0) {
+        throw std::invalid_argument("Packing row length must be positive");
+    }
+}
+
+std::vector<SequencePacker::Row> SequencePacker::plan(const std::vector<size_t>& lengths) const {
+    const size_t row_length = options_.row_length;
+
+    // 切分超长样本，每个片段最长为一行
+    std::vector<Segment> pieces;
+    pieces.reserve(lengths.size());
+    for (size_t sample = 0; sample < lengths.size(); ++sample) {
+        const size_t length = options_.truncate ? std::min(lengths[sample], row_length) : lengths[sample];
+        for (size_t offset = 0; offset < length; offset += row_length) {
+            pieces.push_back({static_cast<uint32_t>(sample), static_cast<uint32_t>(offset),
+                              static_cast<uint32_t>(std::min(row_length, length - offset))});
+        }
+    }
+    if (options_.sort_by_length) {
+        std::stable_sort(pieces.begin(), pieces.end(),
+                         [](const Segment& a, const Segment& b) { return a.length > b.length; });
+    }
+
+    std::vector<Row> rows;
+    if (options_.strategy == PackingStrategy::FirstFit) {
+        // 行数不会超过片段数
+        CapacityTree tree(pieces.size(), row_length);
+        for (const Segment& piece : pieces) {
+            const size_t row = tree.take(piece.length);
+            if (row == rows.size()) {
+                rows.emplace_back();
+            }
+            rows[row].push_back(piece);
+        }
+    } else {
+        // (剩余容量, 行号)，剩余容量相同时选行号最小的行，方案与标准库实现无关
+        std::set<std::pair<size_t, size_t>> open;
+        for (const Segment& piece : pieces) {
+            auto it = open.lower_bound({piece.length, 0});
+            size_t row;
+            size_t remaining;
+            if (it == open.end()) {
+                row = rows.size();
+                remaining = row_length;
+                rows.emplace_back();
+            } else {
+                row = it->second;
+                remaining = it->first;
+                open.erase(it);
+            }
+            rows[row].push_back(piece);
+            if (remaining > piece.length) {
+                open.insert({remaining - piece.length, row});
+            }
+        }
+    }
+    return rows;
+}
+
+TensorMap SequencePacker::pack(const std::vector<const TensorData*>& samples, ThreadPool* pool) const {
+    const size_t row_length = options_.row_length;
+    DType dtype = samples.empty() ? DType::Int32 : samples.front()->getDType();
+
+    // 非连续的样本先复制为连续布局，片段按字节区间直接复制
+    std::vector<TensorData> copies;
+    std::vector<const unsigned char*> sources(samples.size());
+    std::vector<size_t> lengths(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const TensorData& sample = *samples[i];
+        if (sample.getShape().size() != 1 || sample.getDType() != dtype) {
+            throw std::invalid_argument(std::string("Cannot pack tensor of ") + dtypeName(sample.getDType()) +
+                                        TensorData::shapeString(sample.getShape()) + " with " +
+                                        dtypeName(dtype) + " sequences");
+        }
+        lengths[i] = sample.getNumElements();
+        if (sample.isContiguous()) {
+            sources[i] = static_cast<const unsigned char*>(sample.getData());
+        }
+    }
+    copies.reserve(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!sources[i] && lengths[i] > 0) {
+            copies.push_back(samples[i]->copy());
+            sources[i] = static_cast<const unsigned char*>(static_cast<const TensorData&>(copies.back()).getData());
+        }
+    }
+
+    const std::vector<Row> rows = plan(lengths);
+    const size_t row_count = std::max(rows.size(), options_.min_rows);
+    if (row_count * row_length > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        throw std::length_error("Packed batch exceeds int32 positions");
+    }
+
+    const TensorData::Shape shape = {static_cast<int64_t>(row_count), static_cast<int64_t>(row_length)};
+    TensorData input_ids(dtype, shape);
+    TensorData position_ids(DType::Int64, shape);
+    TensorData segment_ids(DType::Int32, shape);
+    input_ids.fill(static_cast<double>(options_.pad_id));
+    position_ids.fill(0);
+    segment_ids.fill(0);
+
+    const size_t item_size = dtypeSize(dtype);
+    unsigned char* ids = static_cast<unsigned char*>(input_ids.getData());
+    int64_t* positions = position_ids.getDataAs<int64_t>();
+    int32_t* segments = segment_ids.getDataAs<int32_t>();
+    auto fillRows = [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            size_t column = 0;
+            int32_t segment = 0;
+            for (const Segment& piece : rows[r]) {
+                const size_t at = r * row_length + column;
+                std::memcpy(ids + at * item_size, sources[piece.sample] + piece.offset * item_size,
+                            piece.length * item_size);
+                std::iota(positions + at, positions + at + piece.length, int64_t(0));
+                std::fill(segments + at, segments + at + piece.length, ++segment);
+                column += piece.length;
+            }
+        }
+    };
+    if (pool && rows.size() > 1 && input_ids.getByteSize() >= kParallelPackBytes) {
+        pool->parallel_for(0, rows.size(), 0, fillRows);
+    } else {
+        fillRows(0, rows.size());
+    }
+
+    // 片段边界，行尾的补齐作为一个片段
+    std::vector<int32_t> cu_seqlens{0};
+    int32_t total = 0;
+    for (size_t r = 0; r < row_count; ++r) {
+        size_t used = 0;
+        if (r < rows.size()) {
+            for (const Segment& piece : rows[r]) {
+                total += static_cast<int32_t>(piece.length);
+                cu_seqlens.push_back(total);
+                used += piece.length;
+            }
+        }
+        if (used < row_length) {
+            total += static_cast<int32_t>(row_length - used);
+            cu_seqlens.push_back(total);
+        }
+    }
+
+    TensorMap result;
+    result.set("input_ids", std::move(input_ids));
+    result.set("position_ids", std::move(position_ids));
+    result.set("segment_ids", std::move(segment_ids));
+    result.set("cu_seqlens", TensorData::copyOf(cu_seqlens));
+    return result;
+}
+
+std::unique_ptr<DataItem> SequencePacker::collate(const std::vector<std::unique_ptr<DataItem>>& batch,
+                                                  ThreadPool* pool) const {
+    std::vector<const TensorData*> samples;
+    samples.reserve(batch.size());
+    for (const auto& item : batch) {
+        auto* tensor = dynamic_cast<const TensorData*>(item.get());
+        if (!tensor) {
+            throw std::invalid_argument("Cannot pack a batch containing items that are not tensors");
+        }
+        samples.push_back(tensor);
+    }
+    return std::make_unique<TensorMap>(pack(samples, pool));
+}
+
+std::function<std::unique_ptr<DataItem>(std::vector<std::unique_ptr<DataItem>>)> SequencePacker::collator(
+    ThreadPool* pool) const {
+    return [packer = *this, pool](std::vector<std::unique_ptr<DataItem>> batch) {
+        return packer.collate(batch, pool);
+    };
+}
+
+double SequencePacker::paddingRatio(const std::vector<Row>& rows, size_t row_length) {
+    if (rows.empty()) {
+        return 0;
+    }
+    size_t used = 0;
+    for (const Row& row : rows) {
+        for (const Segment& piece : row) {
+            used += piece.length;
+        }
+    }
+    const size_t total = rows.size() * row_length;
+    return static_cast<double>(total - used) / static_cast<double>(total);
+}
@@ -0,0 +1,117 @@
+#ifndef PACKING_H
+#define PACKING_H
+
+#include "tensor.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 装箱策略
+ */
+enum class PackingStrategy {
+    FirstFit,  // 放入第一个放得下的行
+    BestFit    // 放入放得下且剩余空间最小的行
+};
+
+/**
+ * 序列打包选项
+ */
+struct PackingOptions {
+    // 每行的词元数
+    size_t row_length = 2048;
+
+    // 装箱策略
+    PackingStrategy strategy = PackingStrategy::BestFit;
+
+    // 装箱前按长度从长到短排序（First-Fit Decreasing / Best-Fit Decreasing），否则按批次中的顺序装入
+    bool sort_by_length = true;
+
+    // 补齐位置的词元ID
+    int64_t pad_id = 0;
+
+    // 长度超过行长度的样本：true时截断到行长度，false时切成多段，每段作为一个独立的片段
+    bool truncate = false;
+
+    // 输出的最少行数，不足时补空行（例如固定批次形状）；0表示按需要
+    size_t min_rows = 0;
+};
+
+/**
+ * 序列打包 - 把一个批次中长度不同的词元序列拼接进固定长度的行，代替逐个样本补齐
+ * 每个样本（或超长样本切出的一段）是一个片段，片段按装箱策略放入各行，行尾剩余的位置补齐。
+ * 打包结果为TensorMap：
+ * - "input_ids"：{行数, 行长度}，元素类型与样本相同，补齐位置为pad_id
+ * - "position_ids"：{行数, 行长度}的int64，每个片段从0开始编号，补齐位置为0
+ * - "segment_ids"：{行数, 行长度}的int32，片段在行内的编号（从1开始），补齐位置为0；
+ *   注意力掩码据此只允许同一片段内的位置互相可见
+ * - "cu_seqlens"：int32的片段边界，把各行首尾相接后第i个片段为[cu_seqlens[i], cu_seqlens[i+1])，
+ *   行尾的补齐也作为一个片段，使边界连续覆盖全部位置（与FlashAttention的变长接口相同）
+ *
+ * 作为DataLoader的批次拼接函数使用：预处理函数把样本编码为一维词元ID张量，collator()在消费线程中打包
+ */
+class SequencePacker {
+public:
+    /**
+     * 片段：批次中第sample个样本从offset开始的length个词元
+     */
+    struct Segment {
+        uint32_t sample;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    using Row = std::vector<Segment>;
+
+    /**
+     * 构造函数
+     * @throws std::invalid_argument 行长度为0时抛出
+     */
+    explicit SequencePacker(PackingOptions options = PackingOptions());
+
+    /**
+     * 计算装箱方案
+     * 同样的长度总是得到同样的方案；长度为0的样本不占用位置
+     * @param lengths 批次中每个样本的词元数
+     * @return 每行的片段，按放入的先后排列
+     */
+    std::vector<Row> plan(const std::vector<size_t>& lengths) const;
+
+    /**
+     * 打包一组一维张量
+     * @param samples 样本，元素类型必须相同
+     * @param pool 不为空且数据量较大时在该线程池上并行复制各行
+     * @throws std::invalid_argument 样本不是一维张量或元素类型不一致时抛出
+     * @throws std::length_error 总位置数超出int32范围时抛出
+     */
+    TensorMap pack(const std::vector<const TensorData*>& samples, ThreadPool* pool = nullptr) const;
+
+    /**
+     * 打包一个批次
+     * @throws std::invalid_argument 批次中有不是张量的数据项时抛出
+     */
+    std::unique_ptr<DataItem> collate(const std::vector<std::unique_ptr<DataItem>>& batch,
+                                      ThreadPool* pool = nullptr) const;
+
+    /**
+     * 创建批次拼接函数，可以直接传给DataLoader::setCollateFunction()
+     * 函数持有打包器的副本，不依赖打包器的生命周期
+     * @param pool 不为空时在该线程池上并行复制，例如DataLoader::getProcessorPool()
+     */
+    std::function<std::unique_ptr<DataItem>(std::vector<std::unique_ptr<DataItem>>)> collator(
+        ThreadPool* pool = nullptr) const;
+
+    /**
+     * 计算装箱方案的补齐比例：补齐位置占全部位置的比例
+     */
+    static double paddingRatio(const std::vector<Row>& rows, size_t row_length);
+
+    const PackingOptions& options() const { return options_; }
+
+private:
+    PackingOptions options_;
+};
+
+#endif // PACKING_H
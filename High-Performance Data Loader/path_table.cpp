@@ -0,0 +1,192 @@
+#include "path_table.h"
+#include "manifest.h"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * 路径表的底层存储
+ */
+struct PathTableData {
+    // 路径数量
+    size_t count = 0;
+
+    // 是否前缀压缩
+    bool compressed = false;
+
+    // 字符串区：平铺时为路径依次拼接，压缩时为编码后的块
+    std::string arena;
+
+    // 平铺时为每个路径的起始偏移（末尾多一个结束偏移），压缩时为每块的起始偏移
+    std::vector<uint64_t> offsets;
+
+    // 引用清单时非空，此时arena和offsets不使用
+    std::shared_ptr<const DatasetManifest> manifest;
+};
+
+namespace {
+
+// LEB128变长整数
+
+void putVarint(std::string& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+size_t getVarint(const char*& in) {
+    size_t value = 0;
+    int shift = 0;
+    while (true) {
+        unsigned char byte = static_cast<unsigned char>(*in++);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+} // namespace
+
+// PathTable::Builder实现
+
+PathTable::Builder::Builder(bool compress) : data_(std::make_shared<PathTableData>()) {
+    data_->compressed = compress;
+    if (!compress) {
+        data_->offsets.push_back(0);
+    }
+}
+
+void PathTable::Builder::reserve(size_t paths, size_t bytes) {
+    if (data_->compressed) {
+        data_->offsets.reserve(paths / kBlockSize + 1);
+    } else {
+        data_->offsets.reserve(paths + 1);
+        data_->arena.reserve(bytes);
+    }
+}
+
+void PathTable::Builder::add(std::string_view path) {
+    if (!data_) {
+        throw std::logic_error("PathTable::Builder used after build()");
+    }
+
+    if (!data_->compressed) {
+        data_->arena.append(path.data(), path.size());
+        data_->offsets.push_back(data_->arena.size());
+        ++data_->count;
+        return;
+    }
+
+    // 块首存储完整路径，其余路径存储与前一个路径的公共前缀长度和后缀
+    if (data_->count % kBlockSize == 0) {
+        data_->offsets.push_back(data_->arena.size());
+        putVarint(data_->arena, path.size());
+        data_->arena.append(path.data(), path.size());
+    } else {
+        size_t limit = std::min(previous_.size(), path.size());
+        size_t shared = static_cast<size_t>(
+            std::mismatch(path.begin(), path.begin() + limit, previous_.begin()).first - path.begin());
+        putVarint(data_->arena, shared);
+        putVarint(data_->arena, path.size() - shared);
+        data_->arena.append(path.data() + shared, path.size() - shared);
+    }
+    previous_.assign(path.data(), path.size());
+    ++data_->count;
+}
+
+PathTable PathTable::Builder::build() {
+    if (!data_) {
+        throw std::logic_error("PathTable::Builder used after build()");
+    }
+    data_->arena.shrink_to_fit();
+    data_->offsets.shrink_to_fit();
+    std::shared_ptr<const PathTableData> data = std::move(data_);
+    return PathTable(std::move(data));
+}
+
+// PathTable实现
+
+PathTable::PathTable() : data_(std::make_shared<PathTableData>()) {
+}
+
+PathTable::PathTable(std::shared_ptr<const PathTableData> data) : data_(std::move(data)) {
+}
+
+PathTable::PathTable(const std::vector<std::string>& paths, bool compress) {
+    size_t bytes = 0;
+    for (const auto& path : paths) {
+        bytes += path.size();
+    }
+    Builder builder(compress);
+    builder.reserve(paths.size(), bytes);
+    for (const auto& path : paths) {
+        builder.add(path);
+    }
+    data_ = builder.build().data_;
+}
+
+PathTable PathTable::fromManifest(std::shared_ptr<const DatasetManifest> manifest) {
+    auto data = std::make_shared<PathTableData>();
+    data->count = manifest->size();
+    data->manifest = std::move(manifest);
+    return PathTable(std::move(data));
+}
+
+size_t PathTable::size() const {
+    return data_->count;
+}
+
+bool PathTable::compressed() const {
+    return data_->compressed;
+}
+
+std::string_view PathTable::view(size_t index, std::string& buffer) const {
+    const PathTableData& data = *data_;
+    if (data.manifest) {
+        return data.manifest->path(index);
+    }
+    if (!data.compressed) {
+        return std::string_view(data.arena.data() + data.offsets[index],
+                                static_cast<size_t>(data.offsets[index + 1] - data.offsets[index]));
+    }
+
+    // 从块首开始依次解码到目标路径
+    const char* in = data.arena.data() + data.offsets[index / kBlockSize];
+    size_t length = getVarint(in);
+    buffer.assign(in, length);
+    in += length;
+    for (size_t i = 0; i < index % kBlockSize; ++i) {
+        size_t shared = getVarint(in);
+        size_t suffix = getVarint(in);
+        buffer.resize(shared);
+        buffer.append(in, suffix);
+        in += suffix;
+    }
+    return buffer;
+}
+
+std::string PathTable::operator[](size_t index) const {
+    std::string buffer;
+    std::string_view path = view(index, buffer);
+    if (path.data() == buffer.data()) {
+        return buffer;
+    }
+    return std::string(path);
+}
+
+size_t PathTable::memoryUsage() const {
+    return sizeof(PathTableData) + data_->arena.capacity() + data_->offsets.capacity() * sizeof(uint64_t);
+}
+
+std::vector<std::string> PathTable::toVector() const {
+    std::vector<std::string> paths;
+    paths.reserve(size());
+    std::string buffer;
+    for (size_t i = 0; i < size(); ++i) {
+        paths.emplace_back(view(i, buffer));
+    }
+    return paths;
+}
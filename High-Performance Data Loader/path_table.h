@@ -0,0 +1,128 @@
+#ifndef PATH_TABLE_H
+#define PATH_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+class DatasetManifest;
+struct PathTableData;
+
+/**
+ * 路径表 - 紧凑存储大量数据路径
+ * std::vector<std::string>中每个路径都有一个字符串头和一次堆分配，数千万个路径时内存以GB计，
+ * 拷贝也很慢。路径表把所有路径依次存放在一块连续内存中，按整数索引访问，有三种存储方式：
+ * - 平铺：连续字符串区加每个路径的偏移
+ * - 前缀压缩：每kBlockSize个路径为一块，块内除第一个路径外只存储与前一个路径不同的后缀，
+ *   适合排序后共享长目录前缀的路径，只需保存每块的偏移
+ * - 清单：直接引用映射的DatasetManifest，不占用额外内存
+ *
+ * 路径表不可修改，拷贝只共享底层存储
+ */
+class PathTable {
+public:
+    // 前缀压缩时每块的路径数量
+    static constexpr size_t kBlockSize = 16;
+
+    /**
+     * 逐个追加路径构造路径表，避免先构造std::vector<std::string>
+     */
+    class Builder {
+    public:
+        /**
+         * 构造函数
+         * @param compress 是否前缀压缩
+         */
+        explicit Builder(bool compress = false);
+
+        /**
+         * 预留空间
+         * @param paths 路径数量
+         * @param bytes 路径总字节数（未压缩）
+         */
+        void reserve(size_t paths, size_t bytes);
+
+        /**
+         * 追加一个路径
+         */
+        void add(std::string_view path);
+
+        /**
+         * 完成构造，之后Builder不再可用
+         */
+        PathTable build();
+
+    private:
+        std::shared_ptr<PathTableData> data_;
+        std::string previous_;
+    };
+
+    /**
+     * 构造空路径表
+     */
+    PathTable();
+
+    /**
+     * 从路径列表构造
+     * @param paths 路径列表
+     * @param compress 是否前缀压缩
+     */
+    explicit PathTable(const std::vector<std::string>& paths, bool compress = false);
+
+    /**
+     * 引用清单中的路径，路径表持有清单的所有权
+     * @param manifest 数据集清单
+     * @return 路径表
+     */
+    static PathTable fromManifest(std::shared_ptr<const DatasetManifest> manifest);
+
+    /**
+     * 获取路径数量
+     */
+    size_t size() const;
+
+    /**
+     * 是否为空
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * 获取路径
+     * @param index 路径索引，必须小于size()
+     * @return 路径
+     */
+    std::string operator[](size_t index) const;
+
+    /**
+     * 获取路径视图，未压缩时不拷贝
+     * @param index 路径索引，必须小于size()
+     * @param buffer 压缩存储时用于解码的缓冲区
+     * @return 路径视图，指向路径表或buffer，在两者都未改变期间有效
+     */
+    std::string_view view(size_t index, std::string& buffer) const;
+
+    /**
+     * 是否为前缀压缩存储
+     */
+    bool compressed() const;
+
+    /**
+     * 获取路径表占用的堆内存（字节），引用清单时不含映射的清单文件
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * 转换为路径列表
+     */
+    std::vector<std::string> toVector() const;
+
+private:
+    explicit PathTable(std::shared_ptr<const PathTableData> data);
+
+    std::shared_ptr<const PathTableData> data_;
+};
+
+#endif // PATH_TABLE_H
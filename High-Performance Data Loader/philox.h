@@ -0,0 +1,142 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * 基于计数器的随机数生成器Philox4x32-10（Salmon等，"Parallel Random Numbers: As Easy as 1, 2, 3"）
+ * 输出是(计数器, 密钥)的纯函数：密钥取种子，计数器的高96位取流编号，低32位是流内的块编号，
+ * 每个块经过10轮乘法和异或得到4个32位随机数。
+ * 不同的流编号得到互不相关的序列，构造只是设置几个整数，没有状态初始化的开销，
+ * 因此可以为每个样本构造一个独立的生成器，多线程使用时不需要共享状态或加锁。
+ *
+ * 满足UniformRandomBitGenerator，可以配合标准库的分布使用；但标准库分布的算法由实现决定，
+ * 需要跨平台逐位复现时使用uniform()、uniformInt()等成员函数
+ */
+class PhiloxRng {
+public:
+    using result_type = uint32_t;
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    /**
+     * 构造函数
+     * @param seed 种子
+     * @param stream 流编号，例如数据索引
+     * @param substream 第二级流编号，例如轮次（只取低32位）
+     */
+    PhiloxRng(uint64_t seed, uint64_t stream, uint32_t substream = 0)
+        : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+          counter_{0, static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32), substream} {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * 下一个32位随机数；每个流可以产生2^34个（块编号回绕后重复）
+     */
+    result_type operator()() {
+        if (next_ == buffer_.size()) {
+            buffer_ = block(counter_, key_);
+            ++counter_[0];
+            next_ = 0;
+        }
+        return buffer_[next_++];
+    }
+
+    /**
+     * 下一个64位随机数
+     */
+    uint64_t next64() {
+        uint64_t low = (*this)();
+        return static_cast<uint64_t>((*this)()) << 32 | low;
+    }
+
+    /**
+     * [0, 1)内均匀分布的double（53位精度）
+     */
+    double uniform() { return static_cast<double>(next64() >> 11) * 0x1.0p-53; }
+
+    /**
+     * [low, high)内均匀分布的double
+     */
+    double uniform(double low, double high) { return low + (high - low) * uniform(); }
+
+    /**
+     * [0, bound)内均匀分布的整数，无偏（Lemire的乘法拒绝采样）；bound为0时返回0
+     */
+    uint32_t uniformInt(uint32_t bound) {
+        uint64_t product = static_cast<uint64_t>((*this)()) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            const uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>((*this)()) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    /**
+     * [low, high]内均匀分布的整数，要求low <= high
+     * 区间覆盖全部int时直接返回32位随机数；加法在无符号算术中进行，避免有符号溢出
+     */
+    int uniformInt(int low, int high) {
+        const uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(high) - low) + 1;
+        const uint32_t offset = span > std::numeric_limits<uint32_t>::max()
+                                    ? (*this)()
+                                    : uniformInt(static_cast<uint32_t>(span));
+        const uint32_t value = static_cast<uint32_t>(low) + offset;
+        // 按补码解释，结果在[low, high]内，一定能表示为int
+        return value <= static_cast<uint32_t>(std::numeric_limits<int>::max())
+                   ? static_cast<int>(value)
+                   : static_cast<int>(value - static_cast<uint32_t>(std::numeric_limits<int>::max()) - 1) +
+                         std::numeric_limits<int>::min();
+    }
+
+    /**
+     * 以概率p返回true
+     */
+    bool bernoulli(double p) { return uniform() < p; }
+
+    /**
+     * 标准正态分布（Box-Muller，每次消耗两个uniform()）
+     */
+    double normal() {
+        const double u1 = 1.0 - uniform();  // (0, 1]，避免log(0)
+        const double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+    /**
+     * Philox4x32-10的分组函数
+     */
+    static Counter block(Counter counter, Key key) {
+        constexpr uint32_t kMultiplier0 = 0xD2511F53;
+        constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+        constexpr uint32_t kWeyl0 = 0x9E3779B9;
+        constexpr uint32_t kWeyl1 = 0xBB67AE85;
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * counter[0];
+            const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * counter[2];
+            counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+                       static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0)};
+            key[0] += kWeyl0;
+            key[1] += kWeyl1;
+        }
+        return counter;
+    }
+
+private:
+    Key key_;
+    Counter counter_;
+    Counter buffer_{};
+    size_t next_ = 4;
+};
+
+#endif // PHILOX_H
@@ -0,0 +1,363 @@
+#include "record_dataset.h"
+#include "shard.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HPDL_HAVE_X86_SIMD 1
+#endif
+
+namespace {
+
+// 块内相邻记录之间允许的最大间隙，间隙中的字节随块一起读取后丢弃
+constexpr uint64_t kMaxBlockGap = 64 << 10;
+
+#ifdef HPDL_HAVE_X86_SIMD
+// 逐位取出掩码中的命中位置
+inline void appendMatches(uint32_t mask, uint64_t base, std::vector<uint64_t>& positions) {
+    while (mask) {
+        positions.push_back(base + static_cast<uint64_t>(__builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+__attribute__((target("avx2")))
+size_t findDelimitersAvx2(const unsigned char* data, size_t size, unsigned char delimiter,
+                          uint64_t base, std::vector<uint64_t>& positions) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(delimiter));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        appendMatches(mask, base + i, positions);
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+size_t findDelimitersSse2(const unsigned char* data, size_t size, unsigned char delimiter,
+                          uint64_t base, std::vector<uint64_t>& positions) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(delimiter));
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        appendMatches(mask, base + i, positions);
+    }
+    return i;
+}
+#endif
+
+std::runtime_error readError(const std::string& path, const std::string& what) {
+    return std::runtime_error("Failed to read records from " + path + ": " + what);
+}
+
+} // namespace
+
+// LineIndexer实现
+
+void LineIndexer::findDelimiters(const unsigned char* data, size_t size, unsigned char delimiter,
+                                 uint64_t base, std::vector<uint64_t>& positions) {
+    size_t done = 0;
+#ifdef HPDL_HAVE_X86_SIMD
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_sse2 = __builtin_cpu_supports("sse2");
+    if (has_avx2) {
+        done = findDelimitersAvx2(data, size, delimiter, base, positions);
+    } else if (has_sse2) {
+        done = findDelimitersSse2(data, size, delimiter, base, positions);
+    }
+    for (size_t i = done; i < size; ++i) {
+        if (data[i] == delimiter) {
+            positions.push_back(base + i);
+        }
+    }
+#else
+    // 其他平台上memchr通常已经向量化
+    while (done < size) {
+        const void* hit = memchr(data + done, delimiter, size - done);
+        if (!hit) {
+            break;
+        }
+        size_t i = static_cast<size_t>(static_cast<const unsigned char*>(hit) - data);
+        positions.push_back(base + i);
+        done = i + 1;
+    }
+#endif
+}
+
+std::vector<SampleRef> LineIndexer::indexFile(const std::string& path, uint32_t file, Storage& storage,
+                                              const LineIndexOptions& options) {
+    const uint64_t file_size = storage.getFileSize(path);
+    const size_t chunk_bytes = std::max<size_t>(options.chunk_bytes, 4096);
+    const size_t chunks = static_cast<size_t>((file_size + chunk_bytes - 1) / chunk_bytes);
+    const unsigned char delimiter = static_cast<unsigned char>(options.delimiter);
+
+    // 每个块独立读取和扫描，分隔符位置按块分别收集后拼接。
+    // 同时记录每个分隔符前的字节是否为'\r'；分隔符位于块首时该字节是上一个块的最后一个字节
+    const bool strip_cr = options.strip_cr && delimiter != '\r';
+    std::vector<std::vector<uint64_t>> found(chunks);
+    std::vector<std::vector<bool>> cr_before(chunks);
+    std::vector<unsigned char> last_byte(chunks);
+    auto scan = [&](size_t begin, size_t end) {
+        PooledBuffer buffer(chunk_bytes);
+        for (size_t c = begin; c < end; ++c) {
+            uint64_t offset = static_cast<uint64_t>(c) * chunk_bytes;
+            size_t length = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, file_size - offset));
+            if (storage.readInto(path, offset, buffer.data(), length) != length) {
+                throw readError(path, "unexpected end of file");
+            }
+            findDelimiters(buffer.data(), length, delimiter, offset, found[c]);
+            last_byte[c] = buffer[length - 1];
+            if (strip_cr) {
+                cr_before[c].reserve(found[c].size());
+                for (uint64_t position : found[c]) {
+                    cr_before[c].push_back(position > offset && buffer[static_cast<size_t>(position - offset - 1)] == '\r');
+                }
+            }
+        }
+    };
+    if (chunks <= 1) {
+        scan(0, chunks);
+    } else {
+        ThreadPool pool(std::min(chunks, options.threads ? options.threads : std::thread::hardware_concurrency()));
+        pool.parallel_for(0, chunks, 1, scan);
+    }
+
+    std::vector<SampleRef> refs;
+    size_t total = 0;
+    for (const auto& positions : found) {
+        total += positions.size();
+    }
+    refs.reserve(total + 1);
+
+    auto addRecord = [&](uint64_t begin, uint64_t end, bool cr) {
+        if (cr && end > begin) {
+            --end;
+        }
+        if (end == begin && options.skip_empty) {
+            return;
+        }
+        if (end - begin > std::numeric_limits<uint32_t>::max()) {
+            throw readError(path, "record at offset " + std::to_string(begin) + " exceeds 4 GB");
+        }
+        refs.push_back(SampleRef{begin, static_cast<uint32_t>(end - begin), file});
+    };
+
+    uint64_t begin = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        uint64_t chunk_offset = static_cast<uint64_t>(c) * chunk_bytes;
+        for (size_t k = 0; k < found[c].size(); ++k) {
+            uint64_t position = found[c][k];
+            bool cr = false;
+            if (strip_cr) {
+                cr = position == chunk_offset ? c > 0 && last_byte[c - 1] == '\r' : cr_before[c][k];
+            }
+            addRecord(begin, position, cr);
+            begin = position + 1;
+        }
+    }
+    if (begin < file_size) {
+        addRecord(begin, file_size, strip_cr && last_byte[chunks - 1] == '\r');
+    }
+    return refs;
+}
+
+// RecordDataset实现
+
+RecordDataset::RecordDataset(Storage* storage, size_t block_bytes, size_t cached_blocks)
+    : storage_(storage),
+      block_bytes_(block_bytes),
+      blocks_(std::max<size_t>(cached_blocks, 1)) {
+}
+
+std::unique_ptr<RecordDataset> RecordDataset::fromLines(const std::vector<std::string>& paths, Storage* storage,
+                                                        const LineIndexOptions& options) {
+    auto dataset = std::make_unique<RecordDataset>(storage);
+    for (const auto& path : paths) {
+        dataset->addLines(path, options);
+    }
+    return dataset;
+}
+
+uint32_t RecordDataset::addFile(const std::string& path) {
+    auto it = file_index_.find(path);
+    if (it != file_index_.end()) {
+        return it->second;
+    }
+    if (!storage_) {
+        owned_storage_ = StorageFactory::createStorageForPath(path);
+        storage_ = owned_storage_.get();
+    }
+    uint32_t file = static_cast<uint32_t>(files_.size());
+    files_.push_back(path);
+    file_index_[path] = file;
+    return file;
+}
+
+size_t RecordDataset::addRecord(uint32_t file, uint64_t offset, uint64_t length) {
+    if (sealed_) {
+        throw std::logic_error("Cannot add records after RecordDataset has been read");
+    }
+    if (file >= files_.size()) {
+        throw std::out_of_range("Invalid file index: " + std::to_string(file));
+    }
+    if (length > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Record exceeds 4 GB: " + files_[file] + " at offset " + std::to_string(offset));
+    }
+    refs_.push_back(SampleRef{offset, static_cast<uint32_t>(length), file});
+    return refs_.size() - 1;
+}
+
+size_t RecordDataset::addLines(const std::string& path, const LineIndexOptions& options) {
+    if (sealed_) {
+        throw std::logic_error("Cannot add records after RecordDataset has been read");
+    }
+    uint32_t file = addFile(path);
+    std::vector<SampleRef> refs = LineIndexer::indexFile(path, file, *storage_, options);
+    refs_.insert(refs_.end(), refs.begin(), refs.end());
+    return refs.size();
+}
+
+std::vector<size_t> RecordDataset::recordLengths() const {
+    std::vector<size_t> lengths;
+    lengths.reserve(refs_.size());
+    for (const SampleRef& ref : refs_) {
+        lengths.push_back(ref.length);
+    }
+    return lengths;
+}
+
+PathTable RecordDataset::recordTable() const {
+    PathTable::Builder builder(true);
+    builder.reserve(refs_.size(), 0);
+    for (size_t i = 0; i < refs_.size(); ++i) {
+        builder.add(ShardFormat::recordPath(files_[refs_[i].file], i));
+    }
+    return builder.build();
+}
+
+void RecordDataset::buildBlocks() {
+    sealed_ = true;
+
+    // 贪心地把编号连续的记录合并为块：同一文件、偏移递增、间隙不超过kMaxBlockGap，
+    // 块的读取范围不超过block_bytes_（单条记录超过时独占一块）
+    size_t i = 0;
+    while (i < refs_.size()) {
+        if (i == 0 || refs_[i].file != refs_[i - 1].file) {
+            run_first_block_.push_back(block_first_.size());
+        }
+        block_first_.push_back(i);
+        uint64_t begin = refs_[i].offset;
+        uint64_t end = begin + refs_[i].length;
+        size_t j = i + 1;
+        while (j < refs_.size() && refs_[j].file == refs_[i].file && refs_[j].offset >= end &&
+               refs_[j].offset - end <= kMaxBlockGap && refs_[j].offset + refs_[j].length - begin <= block_bytes_) {
+            end = refs_[j].offset + refs_[j].length;
+            ++j;
+        }
+        i = j;
+    }
+}
+
+size_t RecordDataset::blockCount() {
+    std::call_once(blocks_built_, [this] { buildBlocks(); });
+    return block_first_.size();
+}
+
+size_t RecordDataset::blockOf(size_t index) const {
+    return static_cast<size_t>(std::upper_bound(block_first_.begin(), block_first_.end(), index) - block_first_.begin()) - 1;
+}
+
+RecordDataset::Block RecordDataset::fetchBlock(size_t block) {
+    std::promise<std::shared_ptr<const PooledBuffer>> promise;
+    Block result = promise.get_future().share();
+    {
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        if (auto cached = blocks_.get(block)) {
+            return *cached;
+        }
+        blocks_.put(block, result);
+    }
+
+    // 整个块（包括记录之间的分隔符）通过一次区间读取取回
+    size_t first = block_first_[block];
+    size_t last = (block + 1 < block_first_.size() ? block_first_[block + 1] : refs_.size()) - 1;
+    const std::string& path = files_[refs_[first].file];
+    uint64_t begin = refs_[first].offset;
+    size_t length = static_cast<size_t>(refs_[last].offset + refs_[last].length - begin);
+
+    try {
+        auto data = std::make_shared<PooledBuffer>(length);
+        if (storage_->readInto(path, begin, data->data(), length) != length) {
+            throw readError(path, "unexpected end of file");
+        }
+        promise.set_value(std::move(data));
+    } catch (...) {
+        // 读取失败的块不保留在缓存中，下次访问时重新读取
+        {
+            std::lock_guard<std::mutex> lock(fetch_mutex_);
+            blocks_.remove(block);
+        }
+        promise.set_exception(std::current_exception());
+    }
+    return result;
+}
+
+PooledBuffer RecordDataset::read(size_t index) {
+    if (index >= refs_.size()) {
+        throw std::runtime_error("Record index out of range: " + std::to_string(index));
+    }
+    std::call_once(blocks_built_, [this] { buildBlocks(); });
+
+    const SampleRef& ref = refs_[index];
+    size_t block = blockOf(index);
+    size_t block_end = block + 1 < block_first_.size() ? block_first_[block + 1] : refs_.size();
+    if (block_end - block_first_[block] == 1) {
+        // 单条记录的块直接读入结果缓冲区，不经过块缓存
+        PooledBuffer record(ref.length);
+        if (storage_->readInto(files_[ref.file], ref.offset, record.data(), ref.length) != ref.length) {
+            throw readError(files_[ref.file], "unexpected end of file");
+        }
+        return record;
+    }
+
+    std::shared_ptr<const PooledBuffer> data = fetchBlock(block).get();
+    size_t offset = static_cast<size_t>(ref.offset - refs_[block_first_[block]].offset);
+    return PooledBuffer::copyOf(data->data() + offset, ref.length);
+}
+
+PooledBuffer RecordDataset::read(const std::string& record_path) {
+    std::string file_path;
+    size_t index;
+    if (!ShardFormat::parseRecordPath(record_path, file_path, index)) {
+        throw std::runtime_error("Invalid record path: " + record_path);
+    }
+    if (index < refs_.size() && files_[refs_[index].file] != file_path) {
+        throw std::runtime_error("Record path does not match dataset: " + record_path);
+    }
+    return read(index);
+}
+
+std::shared_ptr<Sampler> RecordDataset::makeSampler(uint64_t seed, bool shuffle) {
+    std::call_once(blocks_built_, [this] { buildBlocks(); });
+
+    // 每个连续记录段作为ShardSampler中的一个分片，段内的块按记录编号连续
+    std::vector<std::vector<size_t>> runs;
+    for (size_t r = 0; r < run_first_block_.size(); ++r) {
+        size_t first_block = run_first_block_[r];
+        size_t end_block = r + 1 < run_first_block_.size() ? run_first_block_[r + 1] : block_first_.size();
+        std::vector<size_t> blocks;
+        for (size_t b = first_block; b < end_block; ++b) {
+            size_t end = b + 1 < block_first_.size() ? block_first_[b + 1] : refs_.size();
+            blocks.push_back(end - block_first_[b]);
+        }
+        runs.push_back(std::move(blocks));
+    }
+    return std::make_shared<ShardSampler>(std::move(runs), seed, shuffle, shuffle);
+}
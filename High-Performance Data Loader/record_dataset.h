@@ -0,0 +1,226 @@
+#ifndef RECORD_DATASET_H
+#define RECORD_DATASET_H
+
+#include "storage.h"
+#include "buffer_pool.h"
+#include "sampler.h"
+#include "cache.h"
+#include "path_table.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 样本描述 - 文件中的一段字节区间
+ * 多GB的JSONL等文本语料中每一行是一个样本，不必拆分为数百万个小文件
+ */
+struct SampleRef {
+    // 区间在文件中的起始偏移
+    uint64_t offset;
+
+    // 区间长度
+    uint32_t length;
+
+    // 文件在RecordDataset中的编号
+    uint32_t file;
+};
+
+/**
+ * 行索引选项
+ */
+struct LineIndexOptions {
+    // 记录分隔符
+    char delimiter = '\n';
+
+    // 是否跳过空记录
+    bool skip_empty = true;
+
+    // 是否去掉记录末尾的'\r'（CRLF换行）
+    bool strip_cr = true;
+
+    // 并行扫描时每个任务处理的字节数
+    size_t chunk_bytes = 16 << 20;
+
+    // 扫描线程数，0表示使用硬件线程数
+    size_t threads = 0;
+};
+
+/**
+ * 行索引器 - 找出文件中所有记录的偏移和长度
+ * 文件按chunk_bytes切分后在线程池上并行读取和扫描，每个块内用SIMD指令
+ * （x86上运行时选择AVX2或SSE2）一次比较32或16个字节，只在命中分隔符时逐位取出位置
+ */
+class LineIndexer {
+public:
+    /**
+     * 查找分隔符的位置
+     * @param data 数据
+     * @param size 数据大小
+     * @param delimiter 分隔符
+     * @param base 加到每个位置上的偏移，通常为数据在文件中的起始偏移
+     * @param positions 输出参数，分隔符位置依次追加到末尾
+     */
+    static void findDelimiters(const unsigned char* data, size_t size, unsigned char delimiter,
+                               uint64_t base, std::vector<uint64_t>& positions);
+
+    /**
+     * 为文件建立记录索引
+     * @param path 文件路径
+     * @param file 写入SampleRef::file的文件编号
+     * @param storage 用于读取的存储接口
+     * @param options 索引选项
+     * @return 按偏移排序的记录
+     * @throws std::runtime_error 读取失败或单条记录超过4GB时抛出
+     */
+    static std::vector<SampleRef> indexFile(const std::string& path, uint32_t file, Storage& storage,
+                                            const LineIndexOptions& options = LineIndexOptions());
+};
+
+/**
+ * 记录数据集 - 以(文件, 偏移, 长度)寻址的样本集合，供DataLoader使用
+ * 每条记录对应一个形如"<文件路径>#<记录序号>"的数据项路径（序号为全局记录索引），
+ * 加载函数通过read(path)读取记录内容。
+ *
+ * 读取合并：编号连续、位于同一文件且在文件中相邻（间隙很小）的记录组成一个块，
+ * 读取某条记录时整个块通过一次区间读取取回并缓存，块内其余记录直接从内存中获得；
+ * 配合makeSampler()按块访问时，每个块只需读取一次
+ */
+class RecordDataset {
+public:
+    /**
+     * 构造函数
+     * @param storage 用于读取的存储接口，为空时根据第一个文件的路径创建；由调用方管理时其生命周期必须长于数据集
+     * @param block_bytes 块大小上限，0表示每条记录单独读取
+     * @param cached_blocks 最多缓存的块数量
+     */
+    explicit RecordDataset(Storage* storage = nullptr, size_t block_bytes = 4 << 20, size_t cached_blocks = 16);
+
+    RecordDataset(const RecordDataset&) = delete;
+    RecordDataset& operator=(const RecordDataset&) = delete;
+
+    /**
+     * 为一组文本文件逐行建立索引，创建数据集
+     * @param paths 文件路径列表
+     * @param storage 用于读取的存储接口
+     * @param options 行索引选项
+     * @return 数据集
+     */
+    static std::unique_ptr<RecordDataset> fromLines(const std::vector<std::string>& paths, Storage* storage = nullptr,
+                                                    const LineIndexOptions& options = LineIndexOptions());
+
+    /**
+     * 添加文件，同一路径只添加一次
+     * @param path 文件路径
+     * @return 文件编号
+     */
+    uint32_t addFile(const std::string& path);
+
+    /**
+     * 添加一条记录（任意字节区间），例如定长记录的二进制文件
+     * @param file 文件编号
+     * @param offset 起始偏移
+     * @param length 长度
+     * @return 记录索引
+     * @throws std::logic_error 数据集已开始读取后调用时抛出
+     */
+    size_t addRecord(uint32_t file, uint64_t offset, uint64_t length);
+
+    /**
+     * 为文本文件逐行建立索引并添加其中的所有记录
+     * @param path 文件路径
+     * @param options 行索引选项
+     * @return 添加的记录数量
+     */
+    size_t addLines(const std::string& path, const LineIndexOptions& options = LineIndexOptions());
+
+    /**
+     * 获取记录总数
+     */
+    size_t size() const { return refs_.size(); }
+
+    /**
+     * 获取文件数量
+     */
+    size_t fileCount() const { return files_.size(); }
+
+    /**
+     * 获取文件路径
+     */
+    const std::string& filePath(uint32_t file) const { return files_.at(file); }
+
+    /**
+     * 获取记录的样本描述
+     */
+    const SampleRef& ref(size_t index) const { return refs_.at(index); }
+
+    /**
+     * 获取所有记录的字节数，顺序与全局记录索引一致，可以作为BucketBatchSampler的长度
+     */
+    std::vector<size_t> recordLengths() const;
+
+    /**
+     * 获取所有记录的数据项路径表（前缀压缩），顺序与全局记录索引一致
+     */
+    PathTable recordTable() const;
+
+    /**
+     * 按数据项路径读取记录
+     * @param record_path recordTable()中的路径
+     * @return 记录内容
+     */
+    PooledBuffer read(const std::string& record_path);
+
+    /**
+     * 按全局记录索引读取记录
+     * @throws std::runtime_error 索引越界或读取失败时抛出
+     */
+    PooledBuffer read(size_t index);
+
+    /**
+     * 获取块数量
+     */
+    size_t blockCount();
+
+    /**
+     * 创建按块打乱的采样器：先打乱文件中连续记录段的顺序，再打乱段内块的顺序，最后打乱块内记录
+     * @param seed 随机种子
+     * @param shuffle 是否打乱，false时按存储顺序访问
+     * @return 采样器
+     */
+    std::shared_ptr<Sampler> makeSampler(uint64_t seed, bool shuffle = true);
+
+private:
+    // 一个块的数据：读取中的块以shared_future共享，避免多个线程重复读取
+    using Block = std::shared_future<std::shared_ptr<const PooledBuffer>>;
+
+    void buildBlocks();
+    Block fetchBlock(size_t block);
+    size_t blockOf(size_t index) const;
+
+    std::unique_ptr<Storage> owned_storage_;
+    Storage* storage_;
+    size_t block_bytes_;
+
+    std::vector<std::string> files_;
+    std::unordered_map<std::string, uint32_t> file_index_;
+    std::vector<SampleRef> refs_;
+
+    // 块在第一次读取或创建采样器时建立，之后不能再添加记录
+    std::once_flag blocks_built_;
+    bool sealed_ = false;
+
+    // 每个块的第一条记录索引；每个连续记录段（同一文件中编号连续的记录）的第一个块
+    std::vector<size_t> block_first_;
+    std::vector<size_t> run_first_block_;
+
+    // 已读取（或正在读取）的块，由LRU缓存淘汰；fetch_mutex_使查找和插入成为一个原子操作
+    std::mutex fetch_mutex_;
+    LRUCache<size_t, Block> blocks_;
+};
+
+#endif // RECORD_DATASET_H
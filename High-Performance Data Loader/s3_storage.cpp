@@ -0,0 +1,409 @@
+#include "storage.h"
+#include "sigv4.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// readFilePooled()第一个请求读取的字节数，不超过part_size
+constexpr size_t kProbeBytes = 1 << 20;
+
+// 空请求体的SHA-256摘要
+const char* const kEmptyPayloadHash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+std::string environment(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? value : "";
+}
+
+// 还原XML中的预定义实体
+std::string xmlUnescape(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '&') {
+            result += text[i];
+            continue;
+        }
+        static const std::pair<const char*, char> entities[] = {
+            {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''},
+        };
+        bool matched = false;
+        for (const auto& entity : entities) {
+            size_t length = strlen(entity.first);
+            if (text.compare(i, length, entity.first) == 0) {
+                result += entity.second;
+                i += length - 1;
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) {
+            result += '&';
+        }
+    }
+    return result;
+}
+
+// 依次取出XML中所有<tag>...</tag>元素的文本，S3的响应结构固定，不需要完整的XML解析器
+std::vector<std::string> xmlValues(const std::string& xml, const std::string& tag, size_t begin = 0,
+                                   size_t end = std::string::npos) {
+    std::vector<std::string> values;
+    std::string open = "<" + tag + ">";
+    std::string close = "</" + tag + ">";
+    end = std::min(end, xml.size());
+    size_t pos = begin;
+    while ((pos = xml.find(open, pos)) != std::string::npos && pos < end) {
+        size_t value_begin = pos + open.size();
+        size_t value_end = xml.find(close, value_begin);
+        if (value_end == std::string::npos || value_end > end) {
+            break;
+        }
+        values.push_back(xmlUnescape(xml.substr(value_begin, value_end - value_begin)));
+        pos = value_end + close.size();
+    }
+    return values;
+}
+
+std::string xmlValue(const std::string& xml, const std::string& tag) {
+    std::vector<std::string> values = xmlValues(xml, tag);
+    return values.empty() ? "" : values.front();
+}
+
+} // namespace
+
+// S3Storage实现
+
+S3Storage::S3Storage(
+    const std::string& bucket,
+    const std::string& access_key,
+    const std::string& secret_key,
+    const std::string& region
+) : S3Storage(bucket, [&]() {
+        S3Config config;
+        config.access_key = access_key;
+        config.secret_key = secret_key;
+        config.region = region;
+        return config;
+    }()) {}
+
+S3Storage::S3Storage(const std::string& bucket, const S3Config& config)
+    : bucket_(bucket), config_(config), connected_(false) {
+    if (config_.access_key.empty() && config_.secret_key.empty()) {
+        config_.access_key = environment("AWS_ACCESS_KEY_ID");
+        config_.secret_key = environment("AWS_SECRET_ACCESS_KEY");
+        config_.session_token = environment("AWS_SESSION_TOKEN");
+    }
+    if (config_.endpoint.empty()) {
+        config_.endpoint = environment("AWS_ENDPOINT_URL");
+        config_.path_style = config_.path_style || !config_.endpoint.empty();
+    }
+
+    std::string base_url = config_.endpoint;
+    if (base_url.empty()) {
+        base_url = config_.path_style ? "https://s3." + config_.region + ".amazonaws.com"
+                                      : "https://" + bucket_ + ".s3." + config_.region + ".amazonaws.com";
+    }
+
+    HttpOptions options;
+    options.max_connections = config_.max_connections;
+    options.timeout_ms = config_.timeout_ms;
+    options.verify_tls = config_.verify_tls;
+    client_ = std::make_unique<HttpClient>(base_url, options);
+
+    if (!config_.access_key.empty()) {
+        signer_ = std::make_unique<SigV4Signer>(config_.access_key, config_.secret_key, config_.region, "s3",
+                                                config_.session_token);
+    }
+    config_.part_size = std::max<size_t>(config_.part_size, 64 * 1024);
+    config_.max_concurrency = std::max<size_t>(config_.max_concurrency, 1);
+    pool_ = std::make_unique<ThreadPool>(std::max<size_t>(config_.max_concurrency - 1, 1));
+}
+
+S3Storage::~S3Storage() {
+    if (connected_) {
+        disconnect();
+    }
+}
+
+bool S3Storage::connect() {
+    try {
+        HttpResponse response = send("HEAD", config_.path_style ? "/" + bucket_ : "/", {});
+        connected_ = response.status >= 200 && response.status < 300;
+    } catch (const std::runtime_error&) {
+        connected_ = false;
+    }
+    return connected_;
+}
+
+void S3Storage::disconnect() {
+    client_->closeIdle();
+    connected_ = false;
+}
+
+bool S3Storage::isConnected() const {
+    return connected_;
+}
+
+void S3Storage::requireConnected() const {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to S3 storage");
+    }
+}
+
+std::string S3Storage::objectKey(const std::string& file_path) const {
+    if (file_path.compare(0, 5, "s3://") == 0) {
+        size_t slash = file_path.find('/', 5);
+        std::string bucket = file_path.substr(5, slash == std::string::npos ? std::string::npos : slash - 5);
+        if (bucket != bucket_) {
+            throw std::runtime_error("Path " + file_path + " is not in bucket " + bucket_);
+        }
+        return slash == std::string::npos ? "" : file_path.substr(slash + 1);
+    }
+    size_t start = file_path.find_first_not_of('/');
+    return start == std::string::npos ? "" : file_path.substr(start);
+}
+
+std::string S3Storage::requestTarget(const std::string& key, const std::string& query) const {
+    std::string target = config_.path_style ? "/" + bucket_ : "";
+    if (!key.empty() || target.empty()) {
+        target += "/" + uriEncode(key, false);
+    }
+    if (!query.empty()) {
+        target += "?" + query;
+    }
+    return target;
+}
+
+HttpResponse S3Storage::send(const std::string& method, const std::string& target, HttpClient::Headers headers,
+                             unsigned char* buffer, size_t capacity, size_t* received) {
+    if (signer_) {
+        headers.emplace_back("host", client_->hostHeader());
+        signer_->sign(method, target, headers, kEmptyPayloadHash, std::time(nullptr));
+    }
+    // 连接失败、超时和连接中断都可能是暂时的；响应格式错误等其他错误原样抛出，不会被重试
+    try {
+        if (buffer) {
+            return client_->requestInto(method, target, headers, buffer, capacity, *received);
+        }
+        return client_->request(method, target, headers);
+    } catch (const HttpTransportError& e) {
+        throw TransientStorageError(e.what());
+    }
+}
+
+void S3Storage::throwError(const std::string& operation, const std::string& key,
+                           const HttpResponse& response) const {
+    std::string message = operation + " s3://" + bucket_ + "/" + key + " failed: HTTP " +
+                          std::to_string(response.status);
+    std::string code = xmlValue(response.body, "Code");
+    if (!code.empty()) {
+        message += " " + code;
+        std::string detail = xmlValue(response.body, "Message");
+        if (!detail.empty()) {
+            message += ": " + detail;
+        }
+    }
+    // 限流（429、503 SlowDown）和服务端错误可以重试
+    if (response.status == 429 || response.status >= 500) {
+        throw TransientStorageError(message);
+    }
+    throw std::runtime_error(message);
+}
+
+size_t S3Storage::getRange(const std::string& key, uint64_t offset, unsigned char* buffer, size_t length,
+                           uint64_t* object_size) {
+    if (length == 0) {
+        return 0;
+    }
+    std::string range = "bytes=" + std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+    size_t received = 0;
+    HttpResponse response = send("GET", requestTarget(key), {{"range", range}}, buffer, length, &received);
+
+    if (response.status == 416) {
+        // 区间起点超出对象末尾（包括空对象）
+        if (object_size) {
+            const std::string* content_range = response.header("content-range");
+            size_t slash = content_range ? content_range->rfind('/') : std::string::npos;
+            *object_size = slash == std::string::npos ? offset : std::stoull(content_range->substr(slash + 1));
+        }
+        return 0;
+    }
+    if (response.status == 404) {
+        throw std::runtime_error("S3 object not found: s3://" + bucket_ + "/" + key);
+    }
+    if (response.status == 200 && offset > 0) {
+        // 服务器忽略了Range头部，返回了整个对象；对象不大于length时才会走到这里
+        throw std::runtime_error("S3 server ignored the Range header for s3://" + bucket_ + "/" + key);
+    }
+    if (response.status != 200 && response.status != 206) {
+        throwError("GET", key, response);
+    }
+
+    if (object_size) {
+        // Content-Range: bytes <first>-<last>/<size>
+        const std::string* content_range = response.header("content-range");
+        size_t slash = content_range ? content_range->rfind('/') : std::string::npos;
+        if (response.status == 206 && slash != std::string::npos && content_range->compare(slash + 1, 1, "*") != 0) {
+            *object_size = std::stoull(content_range->substr(slash + 1));
+        } else {
+            *object_size = offset + received;
+        }
+    }
+    return received;
+}
+
+size_t S3Storage::getRangeParallel(const std::string& key, uint64_t offset, unsigned char* buffer, size_t length) {
+    size_t part_size = config_.part_size;
+    size_t parts = (length + part_size - 1) / part_size;
+    if (parts <= 1) {
+        return getRange(key, offset, buffer, length);
+    }
+
+    // 最多max_concurrency个任务依次领取分段，各段直接写入缓冲区中对应的位置；
+    // 调用线程在wait()中也执行任务，因此线程池只需max_concurrency - 1个线程参与
+    std::vector<size_t> received(parts, 0);
+    std::atomic<size_t> next_part{0};
+    {
+        ThreadPool::TaskGroup group(*pool_);
+        size_t tasks = std::min(parts, config_.max_concurrency);
+        for (size_t task = 0; task < tasks; ++task) {
+            group.run([this, &key, &received, &next_part, offset, buffer, length, part_size, parts]() {
+                for (size_t part = next_part++; part < parts; part = next_part++) {
+                    size_t begin = part * part_size;
+                    size_t size = std::min(part_size, length - begin);
+                    received[part] = getRange(key, offset + begin, buffer + begin, size);
+                }
+            });
+        }
+        group.wait();
+    }
+
+    // 对象末尾之后的分段读取到0字节，总长度为第一个不完整分段之前（含）的字节数
+    size_t total = 0;
+    for (size_t part = 0; part < parts; ++part) {
+        total += received[part];
+        if (received[part] < std::min(part_size, length - part * part_size)) {
+            break;
+        }
+    }
+    return total;
+}
+
+size_t S3Storage::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+    requireConnected();
+    return getRangeParallel(objectKey(file_path), offset, buffer, length);
+}
+
+std::vector<unsigned char> S3Storage::readRange(const std::string& file_path, uint64_t offset, size_t length) {
+    requireConnected();
+    std::vector<unsigned char> data(length);
+    data.resize(getRangeParallel(objectKey(file_path), offset, data.data(), length));
+    return data;
+}
+
+PooledBuffer S3Storage::readFilePooled(const std::string& file_path) {
+    requireConnected();
+    std::string key = objectKey(file_path);
+
+    // 第一个请求同时得到对象大小（Content-Range），小对象一次往返即可读完，不需要先发HEAD请求；
+    // 大对象的其余部分在得知大小后并行读取，第一个请求只读kProbeBytes以缩短串行的部分
+    size_t probe = std::min(config_.part_size, kProbeBytes);
+    PooledBuffer first(probe);
+    uint64_t object_size = 0;
+    size_t received = getRange(key, 0, first.data(), probe, &object_size);
+    if (object_size <= received) {
+        first.resize(received);
+        return first;
+    }
+
+    PooledBuffer buffer(static_cast<size_t>(object_size));
+    memcpy(buffer.data(), first.data(), received);
+    first = PooledBuffer();
+    size_t rest = getRangeParallel(key, received, buffer.data() + received, static_cast<size_t>(object_size) - received);
+    buffer.resize(received + rest);
+    return buffer;
+}
+
+std::vector<unsigned char> S3Storage::readFile(const std::string& file_path) {
+    PooledBuffer buffer = readFilePooled(file_path);
+    return std::vector<unsigned char>(buffer.begin(), buffer.end());
+}
+
+std::string S3Storage::readTextFile(const std::string& file_path) {
+    PooledBuffer buffer = readFilePooled(file_path);
+    return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+bool S3Storage::head(const std::string& key, size_t* size) {
+    HttpResponse response = send("HEAD", requestTarget(key), {});
+    if (response.status == 404) {
+        return false;
+    }
+    if (response.status != 200) {
+        throwError("HEAD", key, response);
+    }
+    if (size) {
+        const std::string* content_length = response.header("content-length");
+        *size = content_length ? static_cast<size_t>(std::stoull(*content_length)) : 0;
+    }
+    return true;
+}
+
+bool S3Storage::fileExists(const std::string& file_path) {
+    requireConnected();
+    return head(objectKey(file_path), nullptr);
+}
+
+size_t S3Storage::getFileSize(const std::string& file_path) {
+    requireConnected();
+    std::string key = objectKey(file_path);
+    size_t size = 0;
+    if (!head(key, &size)) {
+        throw std::runtime_error("S3 object not found: s3://" + bucket_ + "/" + key);
+    }
+    return size;
+}
+
+std::vector<std::string> S3Storage::listFiles(const std::string& dir_path) {
+    requireConnected();
+    std::string prefix = objectKey(dir_path);
+    if (!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+    }
+
+    // ListObjectsV2，每页最多1000个对象，通过continuation-token翻页
+    std::vector<std::string> files;
+    std::string token;
+    do {
+        std::string query = "list-type=2&delimiter=%2F&prefix=" + uriEncode(prefix);
+        if (!token.empty()) {
+            query += "&continuation-token=" + uriEncode(token);
+        }
+        HttpResponse response = send("GET", requestTarget("", query), {});
+        if (response.status != 200) {
+            throwError("LIST", prefix, response);
+        }
+
+        const std::string& xml = response.body;
+        size_t pos = 0;
+        while ((pos = xml.find("<Contents>", pos)) != std::string::npos) {
+            size_t end = xml.find("</Contents>", pos);
+            std::vector<std::string> keys = xmlValues(xml, "Key", pos, end);
+            // 以'/'结尾的空对象是控制台创建的"目录"占位符
+            if (!keys.empty() && keys.front() != prefix) {
+                files.push_back("s3://" + bucket_ + "/" + keys.front());
+            }
+            pos = end == std::string::npos ? xml.size() : end;
+        }
+
+        token.clear();
+        if (xmlValue(xml, "IsTruncated") == "true") {
+            token = xmlValue(xml, "NextContinuationToken");
+        }
+    } while (!token.empty());
+    return files;
+}
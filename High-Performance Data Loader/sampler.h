@@ -0,0 +1,335 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <vector>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "access_advice.h"
+
+/**
+ * 采样器接口 - 决定每一轮按什么顺序访问数据项
+ * DataLoader在每一轮开始时调用indices()，按返回的顺序加载数据
+ */
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    /**
+     * 获取一轮的访问顺序
+     * 同一个epoch多次调用应当返回相同的结果，使数据顺序可以复现
+     * @param epoch 轮次编号
+     * @return 数据项索引列表
+     */
+    virtual std::vector<size_t> indices(size_t epoch) const = 0;
+
+    /**
+     * 获取数据项总数
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * 获取该采样顺序对应的文件访问模式，DataLoader据此设置存储的预读策略
+     */
+    virtual AccessAdvice accessPattern() const { return AccessAdvice::Normal; }
+
+protected:
+    /**
+     * 由种子和轮次派生随机数生成器，不同轮次得到不同且可复现的顺序
+     */
+    static std::mt19937_64 makeEngine(uint64_t seed, size_t epoch) {
+        std::seed_seq seq{
+            static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+            static_cast<uint32_t>(epoch), static_cast<uint32_t>(static_cast<uint64_t>(epoch) >> 32)
+        };
+        return std::mt19937_64(seq);
+    }
+};
+
+/**
+ * 顺序采样器 - 按索引顺序访问
+ */
+class SequentialSampler : public Sampler {
+public:
+    explicit SequentialSampler(size_t size) : size_(size) {}
+
+    std::vector<size_t> indices(size_t epoch) const override {
+        (void)epoch;
+        std::vector<size_t> order(size_);
+        std::iota(order.begin(), order.end(), size_t(0));
+        return order;
+    }
+
+    size_t size() const override { return size_; }
+    AccessAdvice accessPattern() const override { return AccessAdvice::Sequential; }
+
+private:
+    size_t size_;
+};
+
+/**
+ * 随机采样器 - 每一轮对全部数据项做一次完整的随机排列
+ */
+class RandomSampler : public Sampler {
+public:
+    RandomSampler(size_t size, uint64_t seed) : size_(size), seed_(seed) {}
+
+    std::vector<size_t> indices(size_t epoch) const override {
+        std::vector<size_t> order(size_);
+        std::iota(order.begin(), order.end(), size_t(0));
+        auto engine = makeEngine(seed_, epoch);
+        std::shuffle(order.begin(), order.end(), engine);
+        return order;
+    }
+
+    size_t size() const override { return size_; }
+    AccessAdvice accessPattern() const override { return AccessAdvice::Random; }
+
+private:
+    size_t size_;
+    uint64_t seed_;
+};
+
+/**
+ * 分片采样器 - 两级打乱，使读取保持大块、顺序
+ * 数据项按分片组织，每个分片再分为若干个块（块内的记录在文件中连续存放）：
+ * 先打乱分片顺序，再打乱分片内块的顺序，最后打乱块内记录的顺序。
+ * 同一时刻只访问少数几个块，每个块可以通过一次大的顺序读取取回
+ */
+class ShardSampler : public Sampler {
+public:
+    /**
+     * 构造函数
+     * @param shard_blocks 每个分片中各个块的记录数量，记录的全局索引按分片、块的顺序连续编号
+     * @param seed 随机种子
+     * @param shuffle_shards 是否打乱分片和块的顺序
+     * @param shuffle_within_block 是否打乱块内记录的顺序
+     */
+    ShardSampler(std::vector<std::vector<size_t>> shard_blocks, uint64_t seed,
+                 bool shuffle_shards = true, bool shuffle_within_block = true)
+        : shard_blocks_(std::move(shard_blocks)), seed_(seed),
+          shuffle_shards_(shuffle_shards), shuffle_within_block_(shuffle_within_block) {
+        size_t first = 0;
+        for (const auto& blocks : shard_blocks_) {
+            shard_first_.push_back(first);
+            for (size_t count : blocks) {
+                first += count;
+            }
+        }
+        size_ = first;
+    }
+
+    std::vector<size_t> indices(size_t epoch) const override {
+        auto engine = makeEngine(seed_, epoch);
+
+        std::vector<size_t> shards(shard_blocks_.size());
+        std::iota(shards.begin(), shards.end(), size_t(0));
+        if (shuffle_shards_) {
+            std::shuffle(shards.begin(), shards.end(), engine);
+        }
+
+        std::vector<size_t> order;
+        order.reserve(size_);
+        for (size_t shard : shards) {
+            const auto& blocks = shard_blocks_[shard];
+
+            // 块在分片内的起始索引
+            std::vector<size_t> block_first(blocks.size());
+            size_t first = shard_first_[shard];
+            for (size_t b = 0; b < blocks.size(); ++b) {
+                block_first[b] = first;
+                first += blocks[b];
+            }
+
+            std::vector<size_t> block_order(blocks.size());
+            std::iota(block_order.begin(), block_order.end(), size_t(0));
+            if (shuffle_shards_) {
+                std::shuffle(block_order.begin(), block_order.end(), engine);
+            }
+
+            for (size_t b : block_order) {
+                size_t begin = order.size();
+                for (size_t i = 0; i < blocks[b]; ++i) {
+                    order.push_back(block_first[b] + i);
+                }
+                if (shuffle_within_block_) {
+                    std::shuffle(order.begin() + begin, order.end(), engine);
+                }
+            }
+        }
+        return order;
+    }
+
+    size_t size() const override { return size_; }
+
+    // 块通过一次大的区间读取取回，块与块之间在文件中也大多相邻
+    AccessAdvice accessPattern() const override { return AccessAdvice::Sequential; }
+
+private:
+    std::vector<std::vector<size_t>> shard_blocks_;
+    std::vector<size_t> shard_first_;
+    size_t size_;
+    uint64_t seed_;
+    bool shuffle_shards_;
+    bool shuffle_within_block_;
+};
+
+/**
+ * 批次采样器接口 - 除了访问顺序，还决定每个批次包含哪些数据项
+ * 通过DataLoader::setBatchSampler()设置后，getNextBatch()按batches()的划分返回批次，各批次的大小可以不同
+ */
+class BatchSampler : public Sampler {
+public:
+    /**
+     * 获取一轮的批次划分
+     * 同一个epoch多次调用应当返回相同的结果
+     * @param epoch 轮次编号
+     * @return 每个批次的数据项索引列表
+     */
+    virtual std::vector<std::vector<size_t>> batches(size_t epoch) const = 0;
+
+    /**
+     * 访问顺序为各个批次依次连接
+     */
+    std::vector<size_t> indices(size_t epoch) const override {
+        std::vector<size_t> order;
+        order.reserve(size());
+        for (const auto& batch : batches(epoch)) {
+            order.insert(order.end(), batch.begin(), batch.end());
+        }
+        return order;
+    }
+};
+
+/**
+ * 分桶批次采样器选项
+ */
+struct BucketBatchOptions {
+    // 预算的计算方式：true时为批次内最大长度×数据项数（补齐后的大小），false时为长度之和（拼接或打包后的大小）
+    bool padded = true;
+
+    // 每批最多的数据项数，0表示只受预算限制
+    size_t max_batch_size = 0;
+
+    // 打乱窗口的数据项数：先整体打乱，再在每个窗口内按长度分桶；
+    // 窗口越大，批次内的长度越接近，补齐越少，但批次的组成越固定
+    size_t window = 4096;
+
+    // 桶的长度上界（升序），长度不超过boundaries[i]的数据项进入第i个桶，更长的进入最后一个桶；
+    // 为空时每个长度一个桶（窗口内按长度排序）
+    std::vector<size_t> boundaries;
+
+    // 是否打乱数据项和批次的顺序；false时窗口按索引顺序划分，批次按生成顺序返回
+    bool shuffle = true;
+};
+
+/**
+ * 分桶批次采样器 - 按长度分桶组成批次，批次大小由词元数或字节数预算决定，而不是固定的数据项数
+ * 每一轮先打乱全部数据项，再把打乱后的序列按窗口切开，窗口内的数据项按所在的桶稳定排序（同一个桶内保持打乱后的顺序），
+ * 然后依次装入批次，直到再加入一个数据项会超出预算或进入下一个桶；最后打乱全部批次的顺序。
+ * 长度相近的数据项进入同一个批次，补齐浪费小；预算限制了每个批次的总大小，长样本集中时也不会使批次过大。
+ * 打乱、分桶和批次顺序都只由种子和轮次决定，结果可以复现
+ */
+class BucketBatchSampler : public BatchSampler {
+public:
+    /**
+     * 构造函数
+     * @param lengths 每个数据项的长度（词元数或字节数），下标为数据索引
+     * @param max_tokens 每批的预算，与lengths的单位相同；长度超过预算的数据项单独成为一批
+     * @param seed 随机种子
+     * @param options 选项
+     * @throws std::invalid_argument 预算或窗口为0、桶边界不是升序时抛出
+     */
+    BucketBatchSampler(std::vector<size_t> lengths, size_t max_tokens, uint64_t seed,
+                       BucketBatchOptions options = BucketBatchOptions())
+        : lengths_(std::move(lengths)), max_tokens_(max_tokens), seed_(seed), options_(std::move(options)) {
+        if (max_tokens_ == 0 || options_.window == 0) {
+            throw std::invalid_argument("Bucket batch budget and window must be positive");
+        }
+        if (!std::is_sorted(options_.boundaries.begin(), options_.boundaries.end())) {
+            throw std::invalid_argument("Bucket boundaries must be in ascending order");
+        }
+    }
+
+    std::vector<std::vector<size_t>> batches(size_t epoch) const override {
+        auto engine = makeEngine(seed_, epoch);
+
+        std::vector<size_t> order(lengths_.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        if (options_.shuffle) {
+            std::shuffle(order.begin(), order.end(), engine);
+        }
+
+        std::vector<std::vector<size_t>> result;
+        for (size_t begin = 0; begin < order.size(); begin += options_.window) {
+            auto first = order.begin() + begin;
+            auto last = order.begin() + std::min(order.size(), begin + options_.window);
+            std::stable_sort(first, last, [this](size_t a, size_t b) { return bucketOf(a) < bucketOf(b); });
+
+            std::vector<size_t> batch;
+            size_t bucket = 0;
+            size_t max_length = 0;
+            size_t total = 0;
+            for (auto it = first; it != last; ++it) {
+                const size_t length = lengths_[*it];
+                if (!batch.empty()) {
+                    const size_t cost = options_.padded ? std::max(max_length, length) * (batch.size() + 1)
+                                                        : total + length;
+                    if (cost > max_tokens_ || (!options_.boundaries.empty() && bucketOf(*it) != bucket) ||
+                        (options_.max_batch_size > 0 && batch.size() >= options_.max_batch_size)) {
+                        result.push_back(std::move(batch));
+                        batch.clear();
+                    }
+                }
+                if (batch.empty()) {
+                    bucket = bucketOf(*it);
+                    max_length = 0;
+                    total = 0;
+                }
+                batch.push_back(*it);
+                max_length = std::max(max_length, length);
+                total += length;
+            }
+            if (!batch.empty()) {
+                result.push_back(std::move(batch));
+            }
+        }
+
+        // 窗口内的批次按长度递增生成，打乱后长批次不会集中出现
+        if (options_.shuffle) {
+            std::shuffle(result.begin(), result.end(), engine);
+        }
+        return result;
+    }
+
+    size_t size() const override { return lengths_.size(); }
+    AccessAdvice accessPattern() const override { return AccessAdvice::Random; }
+
+    /**
+     * 获取每个数据项的长度
+     */
+    const std::vector<size_t>& lengths() const { return lengths_; }
+
+private:
+    /**
+     * 数据项所在的桶；没有桶边界时以长度本身作为桶
+     */
+    size_t bucketOf(size_t index) const {
+        const size_t length = lengths_[index];
+        if (options_.boundaries.empty()) {
+            return length;
+        }
+        return static_cast<size_t>(std::lower_bound(options_.boundaries.begin(), options_.boundaries.end(), length) -
+                                   options_.boundaries.begin());
+    }
+
+    std::vector<size_t> lengths_;
+    size_t max_tokens_;
+    uint64_t seed_;
+    BucketBatchOptions options_;
+};
+
+#endif // SAMPLER_H
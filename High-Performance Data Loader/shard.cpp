@@ -0,0 +1,498 @@
+#include "shard.h"
+#include "byte_order.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define HPDL_HAVE_SSE42_CRC 1
+#endif
+
+namespace fs = std::filesystem;
+
+constexpr char ShardFormat::kDataMagic[8];
+constexpr char ShardFormat::kIndexMagic[8];
+
+namespace {
+
+// CRC-32C软件实现（slicing-by-8），多项式0x82F63B78（反射形式）
+struct Crc32cTable {
+    uint32_t table[8][256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+uint32_t crc32cSoftware(const unsigned char* data, size_t size, uint32_t crc) {
+    static const Crc32cTable tables;
+    const auto& t = tables.table;
+
+    crc = ~crc;
+    while (size >= 8) {
+        uint32_t low = getU32(data) ^ crc;
+        uint32_t high = getU32(data + 4);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return ~crc;
+}
+
+#ifdef HPDL_HAVE_SSE42_CRC
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(const unsigned char* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return ~crc;
+}
+#endif
+
+std::runtime_error formatError(const std::string& path, const std::string& what) {
+    return std::runtime_error("Invalid shard " + path + ": " + what);
+}
+
+} // namespace
+
+// ShardFormat实现
+
+std::string ShardFormat::shardPath(const std::string& prefix, size_t number) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%05zu.shard", number);
+    return prefix + suffix;
+}
+
+uint32_t ShardFormat::crc32c(const void* data, size_t size, uint32_t crc) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+#ifdef HPDL_HAVE_SSE42_CRC
+    static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+    if (has_sse42) {
+        return crc32cHardware(bytes, size, crc);
+    }
+#endif
+    return crc32cSoftware(bytes, size, crc);
+}
+
+bool ShardFormat::parseRecordPath(const std::string& record_path, std::string& shard_path, size_t& index) {
+    size_t hash = record_path.rfind('#');
+    if (hash == std::string::npos || hash + 1 >= record_path.size()) {
+        return false;
+    }
+    size_t value = 0;
+    for (size_t i = hash + 1; i < record_path.size(); ++i) {
+        char c = record_path[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    shard_path = record_path.substr(0, hash);
+    index = value;
+    return true;
+}
+
+// ShardWriter实现
+
+ShardWriter::ShardWriter(std::string prefix, uint64_t max_shard_bytes)
+    : prefix_(std::move(prefix)), max_shard_bytes_(max_shard_bytes) {}
+
+ShardWriter::~ShardWriter() {
+    if (!finished_) {
+        try {
+            finish();
+        } catch (...) {
+            // 析构函数中不抛出异常
+        }
+    }
+}
+
+void ShardWriter::add(const std::string& key, const void* data, size_t size) {
+    if (finished_) {
+        throw std::runtime_error("ShardWriter already finished");
+    }
+    if (key.size() > UINT32_MAX) {
+        throw std::runtime_error("Record key too long");
+    }
+
+    uint64_t record_bytes = ShardFormat::kRecordHeaderSize + key.size() + size;
+    if (file_ && !entries_.empty() && offset_ + record_bytes > max_shard_bytes_) {
+        closeShard();
+    }
+    if (!file_) {
+        openShard();
+    }
+
+    uint32_t crc = ShardFormat::crc32c(data, size);
+
+    unsigned char header[ShardFormat::kRecordHeaderSize];
+    putU32(header, static_cast<uint32_t>(key.size()));
+    putU64(header + 4, size);
+    putU32(header + 12, crc);
+
+    if (fwrite(header, 1, sizeof(header), file_) != sizeof(header) ||
+        fwrite(key.data(), 1, key.size(), file_) != key.size() ||
+        (size > 0 && fwrite(data, 1, size, file_) != size)) {
+        throw std::runtime_error("Failed to write shard: " + current_path_);
+    }
+
+    Entry entry;
+    entry.offset = offset_ + ShardFormat::kRecordHeaderSize + key.size();
+    entry.size = size;
+    entry.key_offset = keys_.size();
+    entry.key_length = static_cast<uint32_t>(key.size());
+    entry.crc = crc;
+    entries_.push_back(entry);
+    keys_ += key;
+
+    offset_ += record_bytes;
+    ++total_records_;
+}
+
+std::vector<std::string> ShardWriter::finish() {
+    if (!finished_) {
+        finished_ = true;
+        if (file_) {
+            closeShard();
+        }
+    }
+    return shards_;
+}
+
+void ShardWriter::openShard() {
+    current_path_ = ShardFormat::shardPath(prefix_, shards_.size());
+    file_ = fopen(current_path_.c_str(), "wb");
+    if (!file_) {
+        throw std::runtime_error("Failed to create shard: " + current_path_);
+    }
+    // 样本通常很小，使用较大的写缓冲区减少系统调用
+    setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+    unsigned char header[ShardFormat::kDataHeaderSize] = {};
+    memcpy(header, ShardFormat::kDataMagic, 8);
+    putU32(header + 8, ShardFormat::kVersion);
+    if (fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+        throw std::runtime_error("Failed to write shard: " + current_path_);
+    }
+    offset_ = ShardFormat::kDataHeaderSize;
+    entries_.clear();
+    keys_.clear();
+}
+
+void ShardWriter::closeShard() {
+    bool failed = fflush(file_) != 0 || ferror(file_);
+    failed = fclose(file_) != 0 || failed;
+    file_ = nullptr;
+    if (failed) {
+        throw std::runtime_error("Failed to write shard: " + current_path_);
+    }
+
+    // 序列化索引
+    std::vector<unsigned char> index(ShardFormat::kIndexHeaderSize + entries_.size() * ShardFormat::kIndexEntrySize + keys_.size());
+    unsigned char* out = index.data();
+    memcpy(out, ShardFormat::kIndexMagic, 8);
+    putU32(out + 8, ShardFormat::kVersion);
+    putU32(out + 12, 0);
+    putU64(out + 16, entries_.size());
+    putU64(out + 24, offset_);
+    putU64(out + 32, keys_.size());
+    out += ShardFormat::kIndexHeaderSize;
+    for (const auto& entry : entries_) {
+        putU64(out, entry.offset);
+        putU64(out + 8, entry.size);
+        putU64(out + 16, entry.key_offset);
+        putU32(out + 24, entry.key_length);
+        putU32(out + 28, entry.crc);
+        out += ShardFormat::kIndexEntrySize;
+    }
+    if (!keys_.empty()) {
+        memcpy(out, keys_.data(), keys_.size());
+    }
+
+    // 先写临时文件再重命名，索引文件存在即表示分片完整
+    std::string index_path = ShardFormat::indexPath(current_path_);
+    std::string temp_path = index_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Failed to create shard index: " + temp_path);
+    }
+    bool written = fwrite(index.data(), 1, index.size(), file) == index.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        throw std::runtime_error("Failed to write shard index: " + temp_path);
+    }
+    fs::rename(temp_path, index_path);
+
+    shards_.push_back(current_path_);
+    entries_.clear();
+    keys_.clear();
+}
+
+// ShardReader实现
+
+ShardReader::ShardReader(const std::string& shard_path, Storage* storage, size_t block_bytes, size_t cached_blocks)
+    : path_(shard_path),
+      storage_(storage),
+      blocks_(std::max<size_t>(cached_blocks, 1)) {
+    if (!storage_) {
+        owned_storage_ = StorageFactory::createStorageForPath(shard_path);
+        storage_ = owned_storage_.get();
+    }
+    loadIndex();
+    buildBlocks(block_bytes);
+}
+
+void ShardReader::loadIndex() {
+    std::string index_path = ShardFormat::indexPath(path_);
+    std::vector<unsigned char> index = storage_->readFile(index_path);
+
+    if (index.size() < ShardFormat::kIndexHeaderSize || memcmp(index.data(), ShardFormat::kIndexMagic, 8) != 0) {
+        throw formatError(index_path, "bad index header");
+    }
+    const unsigned char* in = index.data();
+    if (getU32(in + 8) != ShardFormat::kVersion) {
+        throw formatError(index_path, "unsupported version " + std::to_string(getU32(in + 8)));
+    }
+    uint64_t count = getU64(in + 16);
+    uint64_t data_size = getU64(in + 24);
+    uint64_t keys_size = getU64(in + 32);
+
+    uint64_t entries_end = ShardFormat::kIndexHeaderSize + count * ShardFormat::kIndexEntrySize;
+    if (count > index.size() / ShardFormat::kIndexEntrySize || entries_end + keys_size != index.size()) {
+        throw formatError(index_path, "truncated index");
+    }
+
+    entries_.resize(static_cast<size_t>(count));
+    in += ShardFormat::kIndexHeaderSize;
+    for (auto& entry : entries_) {
+        entry.offset = getU64(in);
+        entry.size = getU64(in + 8);
+        entry.key_offset = getU64(in + 16);
+        entry.key_length = getU32(in + 24);
+        entry.crc = getU32(in + 28);
+        in += ShardFormat::kIndexEntrySize;
+
+        if (entry.offset > data_size || entry.size > data_size - entry.offset ||
+            entry.key_offset > keys_size || entry.key_length > keys_size - entry.key_offset) {
+            throw formatError(index_path, "record out of range");
+        }
+    }
+    keys_.assign(reinterpret_cast<const char*>(in), static_cast<size_t>(keys_size));
+}
+
+void ShardReader::buildBlocks(size_t block_bytes) {
+    // 贪心地把连续记录合并为块，块的读取范围不超过block_bytes（单条记录超过时独占一块）
+    size_t i = 0;
+    while (i < entries_.size()) {
+        block_first_.push_back(i);
+        uint64_t begin = entries_[i].offset;
+        size_t j = i + 1;
+        while (j < entries_.size() && entries_[j].offset + entries_[j].size - begin <= block_bytes) {
+            ++j;
+        }
+        i = j;
+    }
+}
+
+std::vector<size_t> ShardReader::blockSizes() const {
+    std::vector<size_t> sizes(block_first_.size());
+    for (size_t b = 0; b < block_first_.size(); ++b) {
+        size_t end = b + 1 < block_first_.size() ? block_first_[b + 1] : entries_.size();
+        sizes[b] = end - block_first_[b];
+    }
+    return sizes;
+}
+
+size_t ShardReader::blockOf(size_t index) const {
+    return static_cast<size_t>(std::upper_bound(block_first_.begin(), block_first_.end(), index) - block_first_.begin()) - 1;
+}
+
+std::string_view ShardReader::key(size_t index) const {
+    const Entry& entry = entries_.at(index);
+    return std::string_view(keys_).substr(static_cast<size_t>(entry.key_offset), entry.key_length);
+}
+
+size_t ShardReader::recordSize(size_t index) const {
+    return static_cast<size_t>(entries_.at(index).size);
+}
+
+ShardReader::Block ShardReader::fetchBlock(size_t block) {
+    std::promise<std::shared_ptr<const PooledBuffer>> promise;
+    Block result = promise.get_future().share();
+    {
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        if (auto cached = blocks_.get(block)) {
+            return *cached;
+        }
+        blocks_.put(block, result);
+    }
+
+    // 整个块通过一次区间读取取回
+    size_t first = block_first_[block];
+    size_t last = (block + 1 < block_first_.size() ? block_first_[block + 1] : entries_.size()) - 1;
+    uint64_t begin = entries_[first].offset;
+    size_t length = static_cast<size_t>(entries_[last].offset + entries_[last].size - begin);
+
+    try {
+        auto data = std::make_shared<PooledBuffer>(length);
+        if (storage_->readInto(path_, begin, data->data(), length) != length) {
+            throw formatError(path_, "unexpected end of file");
+        }
+        promise.set_value(std::move(data));
+    } catch (...) {
+        // 读取失败的块不保留在缓存中，下次访问时重新读取
+        {
+            std::lock_guard<std::mutex> lock(fetch_mutex_);
+            blocks_.remove(block);
+        }
+        promise.set_exception(std::current_exception());
+    }
+    return result;
+}
+
+PooledBuffer ShardReader::read(size_t index) {
+    if (index >= entries_.size()) {
+        throw std::runtime_error("Record index out of range: " + ShardFormat::recordPath(path_, index));
+    }
+    const Entry& entry = entries_[index];
+    size_t size = static_cast<size_t>(entry.size);
+    size_t block = blockOf(index);
+
+    PooledBuffer record;
+    size_t block_end = block + 1 < block_first_.size() ? block_first_[block + 1] : entries_.size();
+    if (block_end - block_first_[block] == 1) {
+        // 单条记录的块直接读入结果缓冲区，不经过块缓存
+        record = PooledBuffer(size);
+        if (storage_->readInto(path_, entry.offset, record.data(), size) != size) {
+            throw formatError(path_, "unexpected end of file");
+        }
+    } else {
+        std::shared_ptr<const PooledBuffer> data = fetchBlock(block).get();
+        size_t offset = static_cast<size_t>(entry.offset - entries_[block_first_[block]].offset);
+        record = PooledBuffer::copyOf(data->data() + offset, size);
+    }
+
+    if (ShardFormat::crc32c(record.data(), size) != entry.crc) {
+        throw formatError(path_, "checksum mismatch for record " + std::to_string(index));
+    }
+    return record;
+}
+
+// ShardDataset实现
+
+ShardDataset::ShardDataset(const std::vector<std::string>& shard_paths, Storage* storage, size_t block_bytes) {
+    for (const auto& path : shard_paths) {
+        reader_index_[path] = readers_.size();
+        shard_first_.push_back(total_records_);
+        readers_.push_back(std::make_unique<ShardReader>(path, storage, block_bytes));
+        total_records_ += readers_.back()->size();
+    }
+}
+
+std::unique_ptr<ShardDataset> ShardDataset::open(const std::string& prefix, Storage* storage) {
+    std::unique_ptr<Storage> owned;
+    Storage* probe = storage;
+    if (!probe) {
+        owned = StorageFactory::createStorageForPath(prefix);
+        probe = owned.get();
+    }
+
+    std::vector<std::string> paths;
+    for (size_t number = 0;; ++number) {
+        std::string path = ShardFormat::shardPath(prefix, number);
+        if (!probe->fileExists(ShardFormat::indexPath(path))) {
+            break;
+        }
+        paths.push_back(path);
+    }
+    if (paths.empty()) {
+        throw std::runtime_error("No shards found with prefix: " + prefix);
+    }
+    return std::make_unique<ShardDataset>(paths, storage);
+}
+
+std::vector<std::string> ShardDataset::recordPaths() const {
+    std::vector<std::string> paths;
+    paths.reserve(total_records_);
+    for (const auto& reader : readers_) {
+        for (size_t i = 0; i < reader->size(); ++i) {
+            paths.push_back(ShardFormat::recordPath(reader->path(), i));
+        }
+    }
+    return paths;
+}
+
+PathTable ShardDataset::recordTable() const {
+    // 同一分片的记录路径只有序号不同，前缀压缩后每条记录只占几个字节
+    PathTable::Builder builder(true);
+    builder.reserve(total_records_, 0);
+    for (const auto& reader : readers_) {
+        for (size_t i = 0; i < reader->size(); ++i) {
+            builder.add(ShardFormat::recordPath(reader->path(), i));
+        }
+    }
+    return builder.build();
+}
+
+ShardReader& ShardDataset::readerFor(const std::string& shard_path) {
+    auto it = reader_index_.find(shard_path);
+    if (it == reader_index_.end()) {
+        throw std::runtime_error("Unknown shard: " + shard_path);
+    }
+    return *readers_[it->second];
+}
+
+PooledBuffer ShardDataset::read(const std::string& record_path) {
+    std::string shard_path;
+    size_t index = 0;
+    if (!ShardFormat::parseRecordPath(record_path, shard_path, index)) {
+        throw std::runtime_error("Invalid record path: " + record_path);
+    }
+    return readerFor(shard_path).read(index);
+}
+
+PooledBuffer ShardDataset::read(size_t index) {
+    if (index >= total_records_) {
+        throw std::runtime_error("Record index out of range: " + std::to_string(index));
+    }
+    size_t shard = static_cast<size_t>(std::upper_bound(shard_first_.begin(), shard_first_.end(), index) - shard_first_.begin()) - 1;
+    return readers_[shard]->read(index - shard_first_[shard]);
+}
+
+std::shared_ptr<Sampler> ShardDataset::makeSampler(uint64_t seed, bool shuffle) const {
+    std::vector<std::vector<size_t>> blocks;
+    blocks.reserve(readers_.size());
+    for (const auto& reader : readers_) {
+        blocks.push_back(reader->blockSizes());
+    }
+    return std::make_shared<ShardSampler>(std::move(blocks), seed, shuffle, shuffle);
+}
@@ -0,0 +1,315 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "storage.h"
+#include "buffer_pool.h"
+#include "sampler.h"
+#include "path_table.h"
+#include "cache.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 分片格式
+ *
+ * 大量小文件作为样本时，每个样本都要一次open/stat（或一次S3请求），元数据操作会主导I/O时间。
+ * 分片把许多样本打包成少量大文件：
+ *
+ * 数据文件 <prefix>-NNNNN.shard（只追加写入）：
+ *   文件头  magic "HPDLSHRD"(8) | version u32 | reserved u32
+ *   记录    key_length u32 | payload_length u64 | crc32c u32 | key | payload
+ *
+ * 索引文件 <prefix>-NNNNN.shard.idx（分片写完后生成，存在即表示分片完整）：
+ *   文件头  magic "HPDLSIDX"(8) | version u32 | reserved u32 |
+ *           record_count u64 | data_size u64 | keys_size u64
+ *   条目    payload_offset u64 | payload_length u64 | key_offset u64 | key_length u32 | crc32c u32
+ *   键      所有记录键依次拼接
+ *
+ * 所有整数均为小端序；数据文件中的记录头使记录在没有索引时也能被顺序扫描恢复
+ */
+struct ShardFormat {
+    static constexpr char kDataMagic[8] = {'H', 'P', 'D', 'L', 'S', 'H', 'R', 'D'};
+    static constexpr char kIndexMagic[8] = {'H', 'P', 'D', 'L', 'S', 'I', 'D', 'X'};
+    static constexpr uint32_t kVersion = 1;
+
+    static constexpr size_t kDataHeaderSize = 16;
+    static constexpr size_t kRecordHeaderSize = 16;
+    static constexpr size_t kIndexHeaderSize = 40;
+    static constexpr size_t kIndexEntrySize = 32;
+
+    /**
+     * 获取分片对应的索引文件路径
+     */
+    static std::string indexPath(const std::string& shard_path) {
+        return shard_path + ".idx";
+    }
+
+    /**
+     * 获取第number个分片的数据文件路径
+     */
+    static std::string shardPath(const std::string& prefix, size_t number);
+
+    /**
+     * 计算CRC-32C（Castagnoli）校验和
+     * 支持SSE4.2的x86处理器上使用硬件指令
+     * @param data 数据
+     * @param size 数据大小
+     * @param crc 之前的校验和，用于分段计算
+     * @return 校验和
+     */
+    static uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+    /**
+     * 生成记录的数据项路径 "<分片路径>#<记录序号>"，可以作为DataLoader的数据路径
+     */
+    static std::string recordPath(const std::string& shard_path, size_t index) {
+        return shard_path + "#" + std::to_string(index);
+    }
+
+    /**
+     * 解析记录的数据项路径
+     * @param record_path 数据项路径
+     * @param shard_path 输出参数，分片路径
+     * @param index 输出参数，记录序号
+     * @return 格式正确时返回true
+     */
+    static bool parseRecordPath(const std::string& record_path, std::string& shard_path, size_t& index);
+};
+
+/**
+ * 分片写入器 - 把记录依次追加到分片中，分片达到大小上限时自动切换到下一个分片
+ */
+class ShardWriter {
+public:
+    /**
+     * 构造函数
+     * @param prefix 输出路径前缀，分片命名为<prefix>-00000.shard、<prefix>-00001.shard……
+     * @param max_shard_bytes 单个分片数据文件的大小上限，单条记录超过上限时独占一个分片
+     */
+    explicit ShardWriter(std::string prefix, uint64_t max_shard_bytes = uint64_t(256) << 20);
+
+    /**
+     * 析构函数，未调用finish()时自动完成最后一个分片（忽略错误）
+     */
+    ~ShardWriter();
+
+    ShardWriter(const ShardWriter&) = delete;
+    ShardWriter& operator=(const ShardWriter&) = delete;
+
+    /**
+     * 追加一条记录
+     * @param key 记录键，例如原始文件的相对路径
+     * @param data 记录内容
+     * @param size 内容大小
+     */
+    void add(const std::string& key, const void* data, size_t size);
+
+    /**
+     * 完成写入，写出最后一个分片的索引
+     * @return 所有分片的数据文件路径
+     */
+    std::vector<std::string> finish();
+
+    /**
+     * 已写入的记录数量
+     */
+    size_t recordCount() const { return total_records_; }
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t key_offset;
+        uint32_t key_length;
+        uint32_t crc;
+    };
+
+    void openShard();
+    void closeShard();
+
+    std::string prefix_;
+    uint64_t max_shard_bytes_;
+
+    // 当前分片
+    FILE* file_ = nullptr;
+    std::string current_path_;
+    uint64_t offset_ = 0;
+    std::vector<Entry> entries_;
+    std::string keys_;
+
+    std::vector<std::string> shards_;
+    size_t total_records_ = 0;
+    bool finished_ = false;
+};
+
+/**
+ * 分片读取器 - 读取单个分片中的记录
+ * 索引在打开时一次读入内存。记录按块读取：连续的若干条记录组成一个块，
+ * 读取某条记录时整个块通过一次区间读取取回并缓存，块内其余记录直接从内存中获得，
+ * 配合ShardSampler按块访问时，每个块只需读取一次
+ */
+class ShardReader {
+public:
+    /**
+     * 构造函数
+     * @param shard_path 分片数据文件路径
+     * @param storage 用于读取的存储接口，为空时根据路径创建；由调用方管理时其生命周期必须长于读取器
+     * @param block_bytes 块大小上限，0表示每条记录单独读取
+     * @param cached_blocks 最多缓存的块数量
+     * @throws std::runtime_error 索引不存在或格式错误时抛出
+     */
+    explicit ShardReader(const std::string& shard_path, Storage* storage = nullptr,
+                         size_t block_bytes = 4 << 20, size_t cached_blocks = 8);
+
+    /**
+     * 获取分片路径
+     */
+    const std::string& path() const { return path_; }
+
+    /**
+     * 获取记录数量
+     */
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * 获取记录键
+     */
+    std::string_view key(size_t index) const;
+
+    /**
+     * 获取记录大小
+     */
+    size_t recordSize(size_t index) const;
+
+    /**
+     * 读取一条记录并校验
+     * @param index 记录序号
+     * @return 记录内容
+     * @throws std::runtime_error 序号越界、读取失败或校验和不匹配时抛出
+     */
+    PooledBuffer read(size_t index);
+
+    /**
+     * 获取块数量
+     */
+    size_t blockCount() const { return block_first_.size(); }
+
+    /**
+     * 获取各个块的记录数量，可用于构造ShardSampler
+     */
+    std::vector<size_t> blockSizes() const;
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t key_offset;
+        uint32_t key_length;
+        uint32_t crc;
+    };
+
+    // 一个块的数据：读取中的块以shared_future共享，避免多个线程重复读取
+    using Block = std::shared_future<std::shared_ptr<const PooledBuffer>>;
+
+    void loadIndex();
+    void buildBlocks(size_t block_bytes);
+    Block fetchBlock(size_t block);
+    size_t blockOf(size_t index) const;
+
+    std::string path_;
+    std::unique_ptr<Storage> owned_storage_;
+    Storage* storage_;
+
+    std::vector<Entry> entries_;
+    std::string keys_;
+
+    // 每个块的第一条记录序号
+    std::vector<size_t> block_first_;
+
+    // 已读取（或正在读取）的块，由LRU缓存淘汰；fetch_mutex_使查找和插入成为一个原子操作
+    std::mutex fetch_mutex_;
+    LRUCache<size_t, Block> blocks_;
+};
+
+/**
+ * 分片数据集 - 把一组分片组织为一个数据集，供DataLoader使用
+ * 每条记录对应一个形如"<分片路径>#<记录序号>"的数据项路径，
+ * 加载函数通过read(path)读取记录内容并解码为具体的数据项
+ */
+class ShardDataset {
+public:
+    /**
+     * 构造函数
+     * @param shard_paths 分片数据文件路径列表
+     * @param storage 用于读取的存储接口，为空时每个分片根据路径创建；其生命周期必须长于数据集
+     * @param block_bytes 块大小上限
+     */
+    explicit ShardDataset(const std::vector<std::string>& shard_paths, Storage* storage = nullptr,
+                          size_t block_bytes = 4 << 20);
+
+    /**
+     * 打开以prefix为前缀的全部分片（<prefix>-00000.shard起连续编号，遇到缺失的编号为止）
+     * @param prefix 分片路径前缀
+     * @param storage 用于读取的存储接口
+     * @return 分片数据集
+     */
+    static std::unique_ptr<ShardDataset> open(const std::string& prefix, Storage* storage = nullptr);
+
+    /**
+     * 获取记录总数
+     */
+    size_t size() const { return total_records_; }
+
+    /**
+     * 获取分片数量
+     */
+    size_t shardCount() const { return readers_.size(); }
+
+    /**
+     * 获取所有记录的数据项路径，顺序与全局记录索引一致
+     */
+    std::vector<std::string> recordPaths() const;
+
+    /**
+     * 获取所有记录的数据项路径表（前缀压缩），顺序与全局记录索引一致
+     */
+    PathTable recordTable() const;
+
+    /**
+     * 按数据项路径读取记录
+     * @param record_path recordPaths()中的路径
+     * @return 记录内容
+     */
+    PooledBuffer read(const std::string& record_path);
+
+    /**
+     * 按全局记录索引读取记录
+     */
+    PooledBuffer read(size_t index);
+
+    /**
+     * 创建按分片、块两级打乱的采样器
+     * @param seed 随机种子
+     * @param shuffle 是否打乱，false时按存储顺序访问
+     * @return 采样器
+     */
+    std::shared_ptr<Sampler> makeSampler(uint64_t seed, bool shuffle = true) const;
+
+private:
+    ShardReader& readerFor(const std::string& shard_path);
+
+    std::vector<std::unique_ptr<ShardReader>> readers_;
+    std::unordered_map<std::string, size_t> reader_index_;
+    std::vector<size_t> shard_first_;
+    size_t total_records_ = 0;
+};
+
+#endif // SHARD_H
@@ -0,0 +1,301 @@
+#include "sigv4.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// SHA-256（FIPS 180-4），只用于签名中的短字符串，不追求吞吐量
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t rotr(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+void compress(uint32_t state[8], const unsigned char block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+               (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t choose = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choose + kRoundConstants[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+std::string lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+// 规范头部值：去掉首尾空白，连续空白压缩为一个空格
+std::string canonicalValue(const std::string& value) {
+    std::string result;
+    bool space = false;
+    for (char c : value) {
+        if (c == ' ' || c == '\t') {
+            space = !result.empty();
+            continue;
+        }
+        if (space) {
+            result += ' ';
+            space = false;
+        }
+        result += c;
+    }
+    return result;
+}
+
+} // namespace
+
+std::string sha256(const void* data, size_t size) {
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t full = size / 64 * 64;
+    for (size_t offset = 0; offset < full; offset += 64) {
+        compress(state, bytes + offset);
+    }
+
+    // 填充：0x80，若干个0，最后8字节为大端序的位长度
+    unsigned char tail[128] = {};
+    size_t remaining = size - full;
+    if (remaining > 0) {
+        memcpy(tail, bytes + full, remaining);
+    }
+    tail[remaining] = 0x80;
+    size_t tail_size = remaining + 9 <= 64 ? 64 : 128;
+    uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (int i = 0; i < 8; ++i) {
+        tail[tail_size - 1 - i] = static_cast<unsigned char>(bits >> (i * 8));
+    }
+    for (size_t offset = 0; offset < tail_size; offset += 64) {
+        compress(state, tail + offset);
+    }
+
+    std::string digest(32, '\0');
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<char>(state[i]);
+    }
+    return digest;
+}
+
+std::string hmacSha256(const std::string& key, const std::string& message) {
+    std::string block_key = key.size() > 64 ? sha256(key.data(), key.size()) : key;
+    block_key.resize(64, '\0');
+
+    std::string inner(64, '\0');
+    std::string outer(64, '\0');
+    for (size_t i = 0; i < 64; ++i) {
+        inner[i] = static_cast<char>(block_key[i] ^ 0x36);
+        outer[i] = static_cast<char>(block_key[i] ^ 0x5c);
+    }
+    inner += message;
+    outer += sha256(inner.data(), inner.size());
+    return sha256(outer.data(), outer.size());
+}
+
+std::string toHex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char byte : bytes) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0x0f];
+    }
+    return hex;
+}
+
+std::string uriEncode(const std::string& value, bool encode_slash) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || (c == '/' && !encode_slash)) {
+            encoded += static_cast<char>(c);
+        } else {
+            encoded += '%';
+            encoded += digits[c >> 4];
+            encoded += digits[c & 0x0f];
+        }
+    }
+    return encoded;
+}
+
+// SigV4Signer实现
+
+SigV4Signer::SigV4Signer(const std::string& access_key, const std::string& secret_key, const std::string& region,
+                         const std::string& service, const std::string& session_token)
+    : access_key_(access_key),
+      secret_key_(secret_key),
+      region_(region),
+      service_(service),
+      session_token_(session_token) {}
+
+std::string SigV4Signer::formatDate(std::time_t time) {
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &time);
+#else
+    gmtime_r(&time, &tm);
+#endif
+    char buffer[17];
+    strftime(buffer, sizeof(buffer), "%Y%m%dT%H%M%SZ", &tm);
+    return buffer;
+}
+
+std::string SigV4Signer::canonicalRequest(const std::string& method, const std::string& target,
+                                          const Headers& signed_headers, const std::string& payload_hash) {
+    size_t question = target.find('?');
+    std::string path = target.substr(0, question);
+    if (path.empty()) {
+        path = "/";
+    }
+
+    // 查询参数按名称（再按值）排序，没有值的参数写为"name="
+    std::vector<std::pair<std::string, std::string>> params;
+    if (question != std::string::npos) {
+        size_t start = question + 1;
+        while (start <= target.size()) {
+            size_t end = target.find('&', start);
+            if (end == std::string::npos) {
+                end = target.size();
+            }
+            std::string param = target.substr(start, end - start);
+            if (!param.empty()) {
+                size_t equals = param.find('=');
+                if (equals == std::string::npos) {
+                    params.emplace_back(param, "");
+                } else {
+                    params.emplace_back(param.substr(0, equals), param.substr(equals + 1));
+                }
+            }
+            start = end + 1;
+        }
+    }
+    std::sort(params.begin(), params.end());
+
+    Headers headers;
+    headers.reserve(signed_headers.size());
+    for (const auto& header : signed_headers) {
+        headers.emplace_back(lowercase(header.first), canonicalValue(header.second));
+    }
+    std::sort(headers.begin(), headers.end());
+
+    std::string request = method + "\n" + path + "\n";
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (i > 0) {
+            request += '&';
+        }
+        request += params[i].first + "=" + params[i].second;
+    }
+    request += '\n';
+    for (const auto& header : headers) {
+        request += header.first + ":" + header.second + "\n";
+    }
+    request += '\n';
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (i > 0) {
+            request += ';';
+        }
+        request += headers[i].first;
+    }
+    request += '\n';
+    request += payload_hash;
+    return request;
+}
+
+std::string SigV4Signer::signingKey(const std::string& date) const {
+    std::lock_guard<std::mutex> lock(key_mutex_);
+    if (key_date_ != date) {
+        std::string key = hmacSha256("AWS4" + secret_key_, date);
+        key = hmacSha256(key, region_);
+        key = hmacSha256(key, service_);
+        key_ = hmacSha256(key, "aws4_request");
+        key_date_ = date;
+    }
+    return key_;
+}
+
+std::string SigV4Signer::signature(const std::string& method, const std::string& target,
+                                   const Headers& signed_headers, const std::string& payload_hash,
+                                   const std::string& amz_date) const {
+    std::string date = amz_date.substr(0, 8);
+    std::string scope = date + "/" + region_ + "/" + service_ + "/aws4_request";
+    std::string canonical = canonicalRequest(method, target, signed_headers, payload_hash);
+    std::string string_to_sign = "AWS4-HMAC-SHA256\n" + amz_date + "\n" + scope + "\n" +
+                                 toHex(sha256(canonical.data(), canonical.size()));
+    return toHex(hmacSha256(signingKey(date), string_to_sign));
+}
+
+void SigV4Signer::sign(const std::string& method, const std::string& target, Headers& headers,
+                       const std::string& payload_hash, std::time_t now) const {
+    std::string amz_date = formatDate(now);
+    headers.emplace_back("x-amz-date", amz_date);
+    headers.emplace_back("x-amz-content-sha256", payload_hash);
+    if (!session_token_.empty()) {
+        headers.emplace_back("x-amz-security-token", session_token_);
+    }
+
+    std::vector<std::string> names;
+    names.reserve(headers.size());
+    for (const auto& header : headers) {
+        names.push_back(lowercase(header.first));
+    }
+    std::sort(names.begin(), names.end());
+    std::string signed_names;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) {
+            signed_names += ';';
+        }
+        signed_names += names[i];
+    }
+
+    std::string scope = amz_date.substr(0, 8) + "/" + region_ + "/" + service_ + "/aws4_request";
+    std::string signed_value = signature(method, target, headers, payload_hash, amz_date);
+    headers.emplace_back("Authorization", "AWS4-HMAC-SHA256 Credential=" + access_key_ + "/" + scope +
+                                              ", SignedHeaders=" + signed_names + ", Signature=" + signed_value);
+}
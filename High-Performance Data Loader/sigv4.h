@@ -0,0 +1,122 @@
+#ifndef SIGV4_H
+#define SIGV4_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * SHA-256摘要
+ * @param data 数据
+ * @param size 数据大小
+ * @return 32字节的摘要
+ */
+std::string sha256(const void* data, size_t size);
+
+/**
+ * HMAC-SHA256消息认证码
+ * @param key 密钥
+ * @param message 消息
+ * @return 32字节的认证码
+ */
+std::string hmacSha256(const std::string& key, const std::string& message);
+
+/**
+ * 转换为小写十六进制字符串
+ */
+std::string toHex(const std::string& bytes);
+
+/**
+ * 按RFC 3986对字符串做百分号编码，只保留非保留字符A-Z a-z 0-9 - _ . ~
+ * @param value 原始字符串
+ * @param encode_slash 是否编码'/'，编码对象键作为URL路径时为false
+ * @return 编码后的字符串
+ */
+std::string uriEncode(const std::string& value, bool encode_slash = true);
+
+/**
+ * AWS Signature Version 4签名器
+ * 计算规范请求（方法、路径、排序后的查询参数、参与签名的头部、负载摘要）的签名，
+ * 派生的签名密钥按日期缓存，同一天内的请求只需两次HMAC
+ */
+class SigV4Signer {
+public:
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+    // 不计算负载摘要时使用的占位值，S3允许
+    static constexpr const char* kUnsignedPayload = "UNSIGNED-PAYLOAD";
+
+    /**
+     * 构造函数
+     * @param access_key 访问密钥ID
+     * @param secret_key 秘密访问密钥
+     * @param region 区域
+     * @param service 服务名称
+     * @param session_token 临时凭证的会话令牌，为空表示长期凭证
+     */
+    SigV4Signer(const std::string& access_key, const std::string& secret_key, const std::string& region,
+                const std::string& service = "s3", const std::string& session_token = "");
+
+    /**
+     * 为请求签名，向headers中追加x-amz-date、x-amz-content-sha256、x-amz-security-token（如有）
+     * 和Authorization头部；headers中已有的其他头部（以及host）都参与签名
+     * @param method HTTP方法
+     * @param target 请求目标：已编码的路径加可选的查询字符串，例如"/bucket/key?partNumber=1"
+     * @param headers 请求头部，必须包含host
+     * @param payload_hash 负载的SHA-256十六进制摘要，或kUnsignedPayload
+     * @param now 签名时间
+     */
+    void sign(const std::string& method, const std::string& target, Headers& headers,
+              const std::string& payload_hash, std::time_t now) const;
+
+    /**
+     * 计算签名（十六进制）
+     * @param method HTTP方法
+     * @param target 请求目标
+     * @param signed_headers 参与签名的头部，名称为小写
+     * @param payload_hash 负载摘要
+     * @param amz_date ISO 8601基本格式的时间，例如"20130524T000000Z"
+     * @return 签名
+     */
+    std::string signature(const std::string& method, const std::string& target, const Headers& signed_headers,
+                          const std::string& payload_hash, const std::string& amz_date) const;
+
+    /**
+     * 构造规范请求，服务端校验签名和调试签名不一致时使用
+     */
+    static std::string canonicalRequest(const std::string& method, const std::string& target,
+                                        const Headers& signed_headers, const std::string& payload_hash);
+
+    /**
+     * 格式化为ISO 8601基本格式的UTC时间
+     */
+    static std::string formatDate(std::time_t time);
+
+    const std::string& accessKey() const { return access_key_; }
+    const std::string& region() const { return region_; }
+    const std::string& service() const { return service_; }
+
+private:
+    /**
+     * 获取某一天的签名密钥
+     * @param date 日期，例如"20130524"
+     */
+    std::string signingKey(const std::string& date) const;
+
+    std::string access_key_;
+    std::string secret_key_;
+    std::string region_;
+    std::string service_;
+    std::string session_token_;
+
+    // 最近一次派生的签名密钥及其日期
+    mutable std::mutex key_mutex_;
+    mutable std::string key_date_;
+    mutable std::string key_;
+};
+
+#endif // SIGV4_H
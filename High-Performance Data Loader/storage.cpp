@@ -1,5 +1,7 @@
 #include "storage.h"
-#include <iostream>
+#include "async_reader.h"
+#include "file_io.h"
+#include "manifest.h"
 #include <filesystem>
 #include <fstream>
 #include <string>
@@ -20,252 +22,197 @@ namespace fs = std::filesystem;
 
 // LocalStorage实现
 
-std::vector<unsigned char> LocalStorage::readFile(const std::string& file_path) {
-    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
-    if (!file) {
-        throw std::runtime_error("Failed to open file: " + file_path);
-    }
+LocalStorage::LocalStorage(size_t queue_depth, size_t max_prefetched, bool direct_io)
+    : queue_depth_(queue_depth),
+      max_prefetched_(max_prefetched),
+      direct_io_(direct_io),
+      access_pattern_(AccessAdvice::Normal),
+      streaming_(false) {}
 
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
+LocalStorage::~LocalStorage() = default;
 
-    std::vector<unsigned char> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-        throw std::runtime_error("Failed to read file: " + file_path);
+std::shared_ptr<AsyncFileReader> LocalStorage::reader() {
+    std::lock_guard<std::mutex> lock(reader_mutex_);
+    if (!reader_) {
+        reader_ = AsyncFileReader::create(queue_depth_, direct_io_);
     }
-
-    return buffer;
+    return reader_;
 }
 
-bool LocalStorage::fileExists(const std::string& file_path) {
-    return fs::exists(file_path) && fs::is_regular_file(file_path);
+const char* LocalStorage::getReaderName() {
+    return reader()->name();
 }
 
-size_t LocalStorage::getFileSize(const std::string& file_path) {
-    if (!fileExists(file_path)) {
-        throw std::runtime_error("File does not exist: " + file_path);
-    }
-    return fs::file_size(file_path);
-}
+void LocalStorage::setDirectIO(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(reader_mutex_);
+        if (direct_io_ == enabled) {
+            return;
+        }
+        direct_io_ = enabled;
 
-std::string LocalStorage::readTextFile(const std::string& file_path) {
-    std::ifstream file(file_path);
-    if (!file) {
-        throw std::runtime_error("Failed to open file: " + file_path);
+        // 正在使用旧后端的读取持有其shared_ptr，完成后旧后端才会析构
+        reader_.reset();
     }
 
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
-    return content;
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetched_.clear();
+    prefetch_order_.clear();
 }
 
-std::vector<std::string> LocalStorage::listFiles(const std::string& dir_path) {
-    std::vector<std::string> files;
-    
-    if (!fs::exists(dir_path) || !fs::is_directory(dir_path)) {
-        throw std::runtime_error("Directory does not exist: " + dir_path);
-    }
-    
-    for (const auto& entry : fs::directory_iterator(dir_path)) {
-        if (fs::is_regular_file(entry)) {
-            files.push_back(entry.path().string());
-        }
-    }
-    
-    return files;
+bool LocalStorage::isDirectIO() {
+    std::lock_guard<std::mutex> lock(reader_mutex_);
+    return direct_io_;
 }
 
-// S3Storage实现
-
-S3Storage::S3Storage(
-    const std::string& bucket,
-    const std::string& access_key,
-    const std::string& secret_key,
-    const std::string& region
-) : bucket_(bucket), access_key_(access_key), secret_key_(secret_key), region_(region), connected_(false) {
-    // 注意：在实际实现中，这里应该初始化S3客户端库
-    std::cout << "S3Storage initialized for bucket: " << bucket << " (region: " << region << ")" << std::endl;
+std::future<PooledBuffer> LocalStorage::takePrefetched(const std::string& file_path) {
+    std::future<PooledBuffer> result;
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    auto it = prefetched_.find(file_path);
+    if (it != prefetched_.end()) {
+        result = std::move(it->second.result);
+        prefetch_order_.erase(it->second.order);
+        prefetched_.erase(it);
+    }
+    return result;
 }
 
-S3Storage::~S3Storage() {
-    if (connected_) {
-        disconnect();
+std::vector<unsigned char> LocalStorage::readFile(const std::string& file_path) {
+    // 预取结果在池化缓冲区中，需要复制一次；readFilePooled()可以直接取用
+    std::future<PooledBuffer> prefetched = takePrefetched(file_path);
+    if (prefetched.valid()) {
+        PooledBuffer data = prefetched.get();
+        return std::vector<unsigned char>(data.begin(), data.end());
     }
-}
 
-bool S3Storage::connect() {
-    // 注意：在实际实现中，这里应该连接到S3存储系统
-    std::cout << "Connecting to S3 storage..." << std::endl;
-    connected_ = true;
-    std::cout << "Connected to S3 storage successfully." << std::endl;
-    return true;
+    // 未预取的文件单独提交
+    return reader()->submit(makeRequest(file_path, 0, ReadRequest::kToEnd)).get();
 }
 
-void S3Storage::disconnect() {
-    // 注意：在实际实现中，这里应该断开与S3存储系统的连接
-    std::cout << "Disconnecting from S3 storage..." << std::endl;
-    connected_ = false;
-    std::cout << "Disconnected from S3 storage." << std::endl;
+std::vector<unsigned char> LocalStorage::readRange(const std::string& file_path, uint64_t offset, size_t length) {
+    return reader()->submit(makeRequest(file_path, offset, length)).get();
 }
 
-bool S3Storage::isConnected() const {
-    return connected_;
+size_t LocalStorage::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+    // 经由异步读取器直接读入调用方的缓冲区，避免分配和额外的复制
+    return reader()->submitInto(makeRequest(file_path, offset, length), buffer).get();
 }
 
-std::vector<unsigned char> S3Storage::readFile(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to S3 storage");
+PooledBuffer LocalStorage::readFilePooled(const std::string& file_path) {
+    // 已预取的文件直接取用预取的池化缓冲区
+    std::future<PooledBuffer> result = takePrefetched(file_path);
+    if (!result.valid()) {
+        result = reader()->submitPooled(makeRequest(file_path, 0, ReadRequest::kToEnd));
     }
-
-    // 注意：在实际实现中，这里应该使用S3客户端库读取文件
-    std::cout << "Reading file from S3: " << file_path << " in bucket: " << bucket_ << std::endl;
-    
-    // 示例实现：返回空数据
-    // 在实际应用中，应该使用如AWS SDK for C++等库来读取S3文件
-    return {};
+    return result.get();
 }
 
-bool S3Storage::fileExists(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to S3 storage");
+void LocalStorage::prefetch(const std::vector<std::string>& paths) {
+    std::vector<ReadRequest> requests;
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        for (const auto& path : paths) {
+            if (prefetched_.count(path) == 0) {
+                requests.push_back(makeRequest(path, 0, ReadRequest::kToEnd));
+            }
+        }
     }
-
-    // 注意：在实际实现中，这里应该使用S3客户端库检查文件是否存在
-    std::cout << "Checking if file exists in S3: " << file_path << " in bucket: " << bucket_ << std::endl;
-    
-    // 示例实现：假设文件存在
-    return true;
-}
-
-size_t S3Storage::getFileSize(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to S3 storage");
+    if (requests.empty()) {
+        return;
     }
 
-    // 注意：在实际实现中，这里应该使用S3客户端库获取文件大小
-    std::cout << "Getting file size from S3: " << file_path << " in bucket: " << bucket_ << std::endl;
-    
-    // 示例实现：返回0
-    return 0;
-}
+    // 整批提交，读取在后台完成，结果留在池化缓冲区中
+    auto results = reader()->submitBatchPooled(requests);
 
-std::string S3Storage::readTextFile(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to S3 storage");
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto inserted = prefetched_.try_emplace(requests[i].path);
+        PrefetchEntry& entry = inserted.first->second;
+        if (!inserted.second) {
+            // 同一路径已由并发的预取登记，以本次结果为准并移到队尾
+            prefetch_order_.erase(entry.order);
+        }
+        entry.result = std::move(results[i]);
+        entry.order = prefetch_order_.insert(prefetch_order_.end(), requests[i].path);
     }
 
-    // 注意：在实际实现中，这里应该使用S3客户端库读取文本文件
-    std::cout << "Reading text file from S3: " << file_path << " in bucket: " << bucket_ << std::endl;
-    
-    // 示例实现：返回空字符串
-    return "";
-}
-
-std::vector<std::string> S3Storage::listFiles(const std::string& dir_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to S3 storage");
+    // 丢弃最早且从未被读取的预取结果，避免无人读取时无限增长
+    while (prefetched_.size() > max_prefetched_) {
+        prefetched_.erase(prefetch_order_.front());
+        prefetch_order_.pop_front();
     }
-
-    // 注意：在实际实现中，这里应该使用S3客户端库列出目录下的文件
-    std::cout << "Listing files in S3 directory: " << dir_path << " in bucket: " << bucket_ << std::endl;
-    
-    // 示例实现：返回空列表
-    return {};
 }
 
-// HDFSStorage实现
-
-HDFSStorage::HDFSStorage(
-    const std::string& namenode,
-    int port
-) : namenode_(namenode), port_(port), connected_(false) {
-    // 注意：在实际实现中，这里应该初始化HDFS客户端库
-    std::cout << "HDFSStorage initialized for namenode: " << namenode << " (port: " << port << ")" << std::endl;
+ReadRequest LocalStorage::makeRequest(const std::string& file_path, uint64_t offset, size_t length) const {
+    ReadRequest request;
+    request.path = file_path;
+    request.offset = offset;
+    request.length = length;
+    request.advice = access_pattern_;
+    request.drop_behind = streaming_;
+    return request;
 }
 
-HDFSStorage::~HDFSStorage() {
-    if (connected_) {
-        disconnect();
-    }
+void LocalStorage::setAccessPattern(AccessAdvice pattern) {
+    access_pattern_ = pattern;
 }
 
-bool HDFSStorage::connect() {
-    // 注意：在实际实现中，这里应该连接到HDFS存储系统
-    std::cout << "Connecting to HDFS..." << std::endl;
-    connected_ = true;
-    std::cout << "Connected to HDFS successfully." << std::endl;
-    return true;
+void LocalStorage::setStreaming(bool enabled) {
+    streaming_ = enabled;
 }
 
-void HDFSStorage::disconnect() {
-    // 注意：在实际实现中，这里应该断开与HDFS存储系统的连接
-    std::cout << "Disconnecting from HDFS..." << std::endl;
-    connected_ = false;
-    std::cout << "Disconnected from HDFS." << std::endl;
+void LocalStorage::advise(const std::vector<std::string>& paths, AccessAdvice advice) {
+    // 直接I/O不经过页缓存，预读提示没有意义
+    if (advice == AccessAdvice::WillNeed && isDirectIO()) {
+        return;
+    }
+    for (const auto& path : paths) {
+        FileIO::adviseFile(path, advice);
+    }
 }
 
-bool HDFSStorage::isConnected() const {
-    return connected_;
+bool LocalStorage::fileExists(const std::string& file_path) {
+    std::error_code ec;
+    return fs::is_regular_file(file_path, ec);
 }
 
-std::vector<unsigned char> HDFSStorage::readFile(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to HDFS");
+size_t LocalStorage::getFileSize(const std::string& file_path) {
+#ifdef _WIN32
+    // 只取一次文件状态，status()失败时不再调用file_size()
+    std::error_code ec;
+    fs::file_status status = fs::status(file_path, ec);
+    uintmax_t size = fs::is_regular_file(status) ? fs::file_size(file_path, ec) : 0;
+    if (ec || !fs::is_regular_file(status)) {
+        throw std::runtime_error("File does not exist: " + file_path);
     }
-
-    // 注意：在实际实现中，这里应该使用HDFS客户端库读取文件
-    std::cout << "Reading file from HDFS: " << file_path << std::endl;
-    
-    // 示例实现：返回空数据
-    return {};
-}
-
-bool HDFSStorage::fileExists(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to HDFS");
+    return static_cast<size_t>(size);
+#else
+    // 一次stat同时确认文件存在并得到大小
+    struct stat st;
+    if (::stat(file_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        throw std::runtime_error("File does not exist: " + file_path);
     }
-
-    // 注意：在实际实现中，这里应该使用HDFS客户端库检查文件是否存在
-    std::cout << "Checking if file exists in HDFS: " << file_path << std::endl;
-    
-    // 示例实现：假设文件存在
-    return true;
+    return static_cast<size_t>(st.st_size);
+#endif
 }
 
-size_t HDFSStorage::getFileSize(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to HDFS");
-    }
-
-    // 注意：在实际实现中，这里应该使用HDFS客户端库获取文件大小
-    std::cout << "Getting file size from HDFS: " << file_path << std::endl;
-    
-    // 示例实现：返回0
-    return 0;
+std::string LocalStorage::readTextFile(const std::string& file_path) {
+    // 与readFilePooled()相同：优先取用预取结果，否则通过异步读取器读取
+    PooledBuffer data = readFilePooled(file_path);
+    return std::string(data.begin(), data.end());
 }
 
-std::string HDFSStorage::readTextFile(const std::string& file_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to HDFS");
-    }
-
-    // 注意：在实际实现中，这里应该使用HDFS客户端库读取文本文件
-    std::cout << "Reading text file from HDFS: " << file_path << std::endl;
+std::vector<std::string> LocalStorage::listFiles(const std::string& dir_path) {
+    // 只列出一层，不需要文件大小：大多数文件系统上无需逐个stat
+    ListOptions options;
+    options.recursive = false;
+    options.with_sizes = false;
     
-    // 示例实现：返回空字符串
-    return "";
-}
-
-std::vector<std::string> HDFSStorage::listFiles(const std::string& dir_path) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to HDFS");
+    std::vector<std::string> files;
+    for (auto& entry : DirectoryLister::list(dir_path, options).files) {
+        files.push_back(std::move(entry.path));
     }
-
-    // 注意：在实际实现中，这里应该使用HDFS客户端库列出目录下的文件
-    std::cout << "Listing files in HDFS directory: " << dir_path << std::endl;
-    
-    // 示例实现：返回空列表
-    return {};
+    return files;
 }
 
 // StorageFactory实现
@@ -283,6 +230,10 @@ std::unique_ptr<DistributedStorage> StorageFactory::createS3Storage(
     return std::make_unique<S3Storage>(bucket, access_key, secret_key, region);
 }
 
+std::unique_ptr<DistributedStorage> StorageFactory::createS3Storage(const std::string& bucket, const S3Config& config) {
+    return std::make_unique<S3Storage>(bucket, config);
+}
+
 std::unique_ptr<DistributedStorage> StorageFactory::createHDFSStorage(
     const std::string& namenode,
     int port
@@ -290,6 +241,11 @@ std::unique_ptr<DistributedStorage> StorageFactory::createHDFSStorage(
     return std::make_unique<HDFSStorage>(namenode, port);
 }
 
+std::unique_ptr<DistributedStorage> StorageFactory::createHDFSStorage(const std::string& namenode, int port,
+                                                                      const HDFSConfig& config) {
+    return std::make_unique<HDFSStorage>(namenode, port, config);
+}
+
 std::unique_ptr<Storage> StorageFactory::createStorageForPath(const std::string& path) {
     // 根据路径前缀判断使用哪种存储
     if (path.substr(0, 5) == "s3://") {
@@ -300,9 +256,12 @@ std::unique_ptr<Storage> StorageFactory::createStorageForPath(const std::string&
             bucket_end = path.length();
         }
         std::string bucket = path.substr(bucket_start, bucket_end - bucket_start);
-        return createS3Storage(bucket);
+        // 凭证和端点从环境变量读取；连接失败时之后的读取会抛出异常
+        auto storage = createS3Storage(bucket);
+        storage->connect();
+        return storage;
     } else if (path.substr(0, 7) == "hdfs://") {
-        // 解析HDFS路径 hdfs://namenode:port/path/to/file
+        // 解析HDFS路径 hdfs://namenode:port/path/to/file，端口为WebHDFS（名称节点HTTP）端口
         size_t nn_start = 7;
         size_t nn_end = path.find('/', nn_start);
         if (nn_end == std::string::npos) {
@@ -311,7 +270,7 @@ std::unique_ptr<Storage> StorageFactory::createStorageForPath(const std::string&
         std::string nn_part = path.substr(nn_start, nn_end - nn_start);
         
         std::string namenode = "localhost";
-        int port = 9000;
+        int port = 9870;
         
         size_t port_pos = nn_part.find(':');
         if (port_pos != std::string::npos) {
@@ -325,7 +284,10 @@ std::unique_ptr<Storage> StorageFactory::createStorageForPath(const std::string&
             namenode = nn_part;
         }
         
-        return createHDFSStorage(namenode, port);
+        // 用户名从环境变量读取；连接失败时之后的读取会抛出异常
+        auto storage = createHDFSStorage(namenode, port);
+        storage->connect();
+        return storage;
     } else {
         // 默认使用本地存储
         return createLocalStorage();
@@ -5,8 +5,46 @@
 #include <vector>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <stdexcept>
 #include <functional>
+#include "buffer_pool.h"
+#include "access_advice.h"
+#include "http_client.h"
+#include <future>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <atomic>
+
+class AsyncFileReader;
+struct ReadRequest;
+class SigV4Signer;
+class ThreadPool;
+
+/**
+ * 暂时性存储错误 - 超时、连接中断、服务端限流或5xx错误等，稍后重试可能成功
+ * 文件不存在、权限不足等确定性的错误仍以std::runtime_error抛出
+ */
+class TransientStorageError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * 文件中一个数据块的位置
+ * 分布式文件系统按块存放文件，每个块有若干个副本，分别位于不同的主机上
+ */
+struct BlockLocation {
+    // 块在文件中的起始偏移和长度
+    uint64_t offset = 0;
+    uint64_t length = 0;
+
+    // 存放该块副本的主机名
+    std::vector<std::string> hosts;
+};
 
 /**
  * 存储接口 - 定义统一的文件访问操作，支持本地和分布式存储
@@ -22,6 +60,59 @@ public:
      */
     virtual std::vector<unsigned char> readFile(const std::string& file_path) = 0;
 
+    /**
+     * 读取文件中的一段区间
+     * 默认实现读取整个文件后截取，支持随机访问的实现应当重写
+     * @param file_path 文件路径
+     * @param offset 起始偏移
+     * @param length 读取长度
+     * @return 区间内容，超出文件末尾的部分被截断
+     */
+    virtual std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) {
+        std::vector<unsigned char> data = readFile(file_path);
+        if (offset >= data.size()) {
+            return {};
+        }
+        size_t begin = static_cast<size_t>(offset);
+        size_t end = begin + std::min(length, data.size() - begin);
+        return std::vector<unsigned char>(data.begin() + begin, data.begin() + end);
+    }
+
+    /**
+     * 将文件中的一段区间读入调用方提供的缓冲区，不分配新的内存
+     * 默认实现通过readRange()读取后复制，支持随机访问的实现应当重写
+     * @param file_path 文件路径
+     * @param offset 起始偏移
+     * @param buffer 目标缓冲区
+     * @param length 缓冲区长度（即最多读取的字节数）
+     * @return 实际读取的字节数，到达文件末尾时小于length
+     */
+    virtual size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+        if (length == 0) {
+            return 0;
+        }
+        std::vector<unsigned char> data = readRange(file_path, offset, length);
+        if (!data.empty()) {
+            // 空vector的data()可能为nullptr，不能传给memcpy
+            memcpy(buffer, data.data(), data.size());
+        }
+        return data.size();
+    }
+
+    /**
+     * 读取整个文件到池化缓冲区
+     * 缓冲区释放后回到缓冲池，适合每个样本读取一次、用完即弃的场景。
+     * 默认实现先获取文件大小，再通过readInto()读入
+     * @param file_path 文件路径
+     * @return 文件内容
+     */
+    virtual PooledBuffer readFilePooled(const std::string& file_path) {
+        size_t size = getFileSize(file_path);
+        PooledBuffer buffer(size);
+        buffer.resize(readInto(file_path, 0, buffer.data(), size));
+        return buffer;
+    }
+
     /**
      * 检查文件是否存在
      * @param file_path 文件路径
@@ -49,18 +140,144 @@ public:
      * @return 文件路径列表
      */
     virtual std::vector<std::string> listFiles(const std::string& dir_path) = 0;
+
+    /**
+     * 预取即将读取的文件
+     * 支持异步读取的实现会批量提交这些读取请求，之后的readFile()直接取用结果；
+     * 默认实现不做任何事
+     * @param paths 即将读取的文件路径列表
+     */
+    virtual void prefetch(const std::vector<std::string>& paths) {
+        (void)paths;
+    }
+
+    /**
+     * 设置之后读取的访问模式，存储据此调整内核预读
+     * 例如顺序扫描分片时使用Sequential加大预读，随机读取小样本时使用Random避免无用的预读。
+     * 默认实现忽略该提示
+     * @param pattern 访问模式，Normal、Sequential或Random
+     */
+    virtual void setAccessPattern(AccessAdvice pattern) {
+        (void)pattern;
+    }
+
+    /**
+     * 开启或关闭流式读取
+     * 开启后每次读取完成时把读过的范围从页缓存中逐出，适合远大于内存、每个字节只读一次的数据集。
+     * 默认实现忽略该设置
+     * @param enabled 是否开启
+     */
+    virtual void setStreaming(bool enabled) {
+        (void)enabled;
+    }
+
+    /**
+     * 对一批文件发出访问提示，例如在读取之前用WillNeed让内核提前读入页缓存
+     * 提示只是建议，无法打开的路径会被忽略。默认实现不做任何事
+     * @param paths 文件路径列表
+     * @param advice 访问提示，WillNeed或DontNeed
+     */
+    virtual void advise(const std::vector<std::string>& paths, AccessAdvice advice) {
+        (void)paths;
+        (void)advice;
+    }
+
+    /**
+     * 获取文件各个数据块的位置，供调度时优先把样本分配给持有本地副本的节点
+     * 默认实现返回空列表，表示没有位置信息（本地文件、对象存储）
+     * @param file_path 文件路径
+     * @return 按偏移排列的数据块位置
+     */
+    virtual std::vector<BlockLocation> getBlockLocations(const std::string& file_path) {
+        (void)file_path;
+        return {};
+    }
 };
 
 /**
  * 本地文件存储实现
+ * 读取通过AsyncFileReader完成：优先使用io_uring批量提交，不可用时回退到pread。
+ * 开启直接I/O后读取绕过页缓存，适合远大于内存、只读一遍的数据集
  */
 class LocalStorage : public Storage {
 public:
+    /**
+     * 构造函数
+     * @param queue_depth 异步读取的最大在途请求数量
+     * @param max_prefetched 最多保留的预取结果数量，超出时丢弃最早的预取
+     * @param direct_io 是否使用O_DIRECT绕过页缓存
+     */
+    explicit LocalStorage(size_t queue_depth = 64, size_t max_prefetched = 256, bool direct_io = false);
+    ~LocalStorage() override;
+
     std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
     bool fileExists(const std::string& file_path) override;
     size_t getFileSize(const std::string& file_path) override;
     std::string readTextFile(const std::string& file_path) override;
     std::vector<std::string> listFiles(const std::string& dir_path) override;
+    void prefetch(const std::vector<std::string>& paths) override;
+    void setAccessPattern(AccessAdvice pattern) override;
+    void setStreaming(bool enabled) override;
+    void advise(const std::vector<std::string>& paths, AccessAdvice advice) override;
+
+    /**
+     * 获取实际使用的读取后端名称
+     * @return "io_uring"或"pread"
+     */
+    const char* getReaderName();
+
+    /**
+     * 开启或关闭直接I/O
+     * 切换后新的读取使用新的后端，尚未取用的预取结果会被丢弃
+     * @param enabled 是否使用O_DIRECT绕过页缓存
+     */
+    void setDirectIO(bool enabled);
+
+    /**
+     * 是否开启了直接I/O
+     */
+    bool isDirectIO();
+
+private:
+    /**
+     * 获取异步读取器，首次使用时创建
+     */
+    std::shared_ptr<AsyncFileReader> reader();
+
+    /**
+     * 取出已提交的预取结果
+     * @return 预取结果，文件未被预取时返回无效的future
+     */
+    std::future<PooledBuffer> takePrefetched(const std::string& file_path);
+
+    /**
+     * 构造带有当前访问模式和流式读取设置的读取请求
+     */
+    ReadRequest makeRequest(const std::string& file_path, uint64_t offset, size_t length) const;
+
+    size_t queue_depth_;
+    size_t max_prefetched_;
+
+    // 读取后端及其配置，由reader_mutex_保护
+    std::mutex reader_mutex_;
+    bool direct_io_;
+    std::shared_ptr<AsyncFileReader> reader_;
+
+    // 访问模式及流式读取设置，应用于之后提交的读取请求
+    std::atomic<AccessAdvice> access_pattern_;
+    std::atomic<bool> streaming_;
+
+    // 预取结果，按提交顺序淘汰；每项记录其在prefetch_order_中的位置，取走时一并移除
+    struct PrefetchEntry {
+        std::future<PooledBuffer> result;
+        std::list<std::string>::iterator order;
+    };
+    std::mutex prefetch_mutex_;
+    std::unordered_map<std::string, PrefetchEntry> prefetched_;
+    std::list<std::string> prefetch_order_;
 };
 
 /**
@@ -86,8 +303,50 @@ public:
     virtual bool isConnected() const = 0;
 };
 
+/**
+ * S3存储配置
+ * 未设置的凭证从环境变量AWS_ACCESS_KEY_ID、AWS_SECRET_ACCESS_KEY和AWS_SESSION_TOKEN读取，
+ * 仍为空时以匿名方式访问（公开的存储桶）
+ */
+struct S3Config {
+    // 服务端点，例如"http://127.0.0.1:9000"；为空时使用环境变量AWS_ENDPOINT_URL，
+    // 仍为空时使用AWS的区域端点https://s3.<region>.amazonaws.com
+    std::string endpoint;
+
+    // AWS区域
+    std::string region = "us-east-1";
+
+    // 访问密钥ID、秘密访问密钥和临时凭证的会话令牌
+    std::string access_key;
+    std::string secret_key;
+    std::string session_token;
+
+    // 使用路径风格的URL（<endpoint>/<bucket>/<key>）；自定义端点（MinIO、本地测试服务器）通常需要开启，
+    // 关闭时使用虚拟主机风格（<bucket>.s3.<region>.amazonaws.com/<key>）
+    bool path_style = false;
+
+    // 连接池中的最大连接数
+    size_t max_connections = 64;
+
+    // 大对象分段读取时每段的大小
+    size_t part_size = 8 << 20;
+
+    // 每次读取中同时进行的分段请求数上限；分段在S3Storage内部的线程池上执行，所有读取共享该线程池
+    size_t max_concurrency = 16;
+
+    // 连接、发送和接收的超时时间（毫秒）
+    int timeout_ms = 30000;
+
+    // 是否校验服务器的TLS证书
+    bool verify_tls = true;
+};
+
 /**
  * S3存储实现
+ * 通过HTTP(S)直接访问S3 REST API（或兼容的MinIO等服务），请求使用SigV4签名，
+ * 连接在请求之间复用。大于part_size的读取被拆分为多个Range GET，在内部线程池上
+ * 并行执行，各段直接接收到调用方缓冲区中对应的位置。
+ * 文件路径可以是"s3://<bucket>/<key>"，也可以是存储桶内的对象键
  */
 class S3Storage : public DistributedStorage {
 public:
@@ -105,59 +364,268 @@ public:
         const std::string& region = "us-east-1"
     );
 
+    /**
+     * 构造函数
+     * @param bucket S3存储桶名称
+     * @param config S3配置
+     * @throws std::runtime_error 端点无效时抛出
+     */
+    S3Storage(const std::string& bucket, const S3Config& config);
+
     ~S3Storage() override;
-    
+
+    /**
+     * 检查存储桶是否可以访问（HEAD请求）
+     * @return 存储桶存在且有权限访问时返回true
+     */
     bool connect() override;
     void disconnect() override;
     bool isConnected() const override;
-    
+
     std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
     bool fileExists(const std::string& file_path) override;
     size_t getFileSize(const std::string& file_path) override;
     std::string readTextFile(const std::string& file_path) override;
+
+    /**
+     * 列出"目录"（键前缀）下的对象，不递归
+     * @param dir_path 目录路径，例如"s3://bucket/images"
+     * @return "s3://<bucket>/<key>"形式的对象路径列表
+     */
     std::vector<std::string> listFiles(const std::string& dir_path) override;
 
+    /**
+     * 获取配置
+     */
+    const S3Config& config() const { return config_; }
+
+    /**
+     * 获取连接池统计
+     */
+    HttpClient::Stats httpStats() const { return client_->stats(); }
+
 private:
+    /**
+     * 把文件路径转换为对象键
+     * @throws std::runtime_error 路径属于其他存储桶时抛出
+     */
+    std::string objectKey(const std::string& file_path) const;
+
+    /**
+     * 构造请求目标（已编码的路径和查询字符串）
+     */
+    std::string requestTarget(const std::string& key, const std::string& query = "") const;
+
+    /**
+     * 发送签名的请求
+     * @param buffer 不为空时2xx响应体直接写入该缓冲区
+     */
+    HttpResponse send(const std::string& method, const std::string& target, HttpClient::Headers headers,
+                      unsigned char* buffer = nullptr, size_t capacity = 0, size_t* received = nullptr);
+
+    /**
+     * 用一次Range GET读取对象的一段区间
+     * @param object_size 不为空时输出对象大小（由Content-Range得到）
+     * @return 读取的字节数，区间超出对象末尾时小于length
+     */
+    size_t getRange(const std::string& key, uint64_t offset, unsigned char* buffer, size_t length,
+                    uint64_t* object_size = nullptr);
+
+    /**
+     * 把区间拆分为多个分段并行读取
+     */
+    size_t getRangeParallel(const std::string& key, uint64_t offset, unsigned char* buffer, size_t length);
+
+    /**
+     * 读取响应头部，对象不存在时返回false
+     */
+    bool head(const std::string& key, size_t* size);
+
+    void requireConnected() const;
+
+    [[noreturn]] void throwError(const std::string& operation, const std::string& key,
+                                 const HttpResponse& response) const;
+
     std::string bucket_;
-    std::string access_key_;
-    std::string secret_key_;
-    std::string region_;
+    S3Config config_;
     bool connected_;
-    // 注意：在实际实现中，这里应该包含S3客户端库的实例
+
+    std::unique_ptr<HttpClient> client_;
+    std::unique_ptr<SigV4Signer> signer_;
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+/**
+ * HDFS存储配置
+ * 未设置的用户名从环境变量HADOOP_USER_NAME读取
+ */
+struct HDFSConfig {
+    // WebHDFS服务端点，例如"http://127.0.0.1:9870"；为空时使用http://<namenode>:<port>
+    std::string endpoint;
+
+    // 简单认证的用户名（user.name参数），为空时不发送
+    std::string user;
+
+    // 委托令牌（delegation参数），不为空时代替用户名进行认证
+    std::string delegation_token;
+
+    // 每个服务器（名称节点和各个数据节点）的连接池中的最大连接数
+    size_t max_connections = 64;
+
+    // 大文件分段读取时每段的大小；分段不跨越数据块边界
+    size_t part_size = 8 << 20;
+
+    // 每次读取中同时进行的分段请求数上限；分段在HDFSStorage内部的线程池上执行，所有读取共享该线程池
+    size_t max_concurrency = 16;
+
+    // 连接、发送和接收的超时时间（毫秒）
+    int timeout_ms = 30000;
+
+    // 是否校验服务器的TLS证书（swebhdfs）
+    bool verify_tls = true;
 };
 
 /**
  * HDFS存储实现
+ * 通过WebHDFS REST API访问HDFS：元数据请求发给名称节点，读取请求（OPEN）由名称节点重定向到
+ * 持有数据块的数据节点。名称节点和每个数据节点各有一个连接池，连接在请求之间复用。
+ * 大于part_size的读取按数据块边界和part_size拆分为多个分段，在内部线程池上并行执行，
+ * 不同的块通常由不同的数据节点提供。
+ * 文件路径可以是"hdfs://<namenode>:<port>/<path>"，也可以是文件系统内的绝对路径
  */
 class HDFSStorage : public DistributedStorage {
 public:
     /**
      * 构造函数
      * @param namenode HDFS名称节点
-     * @param port HDFS端口
+     * @param port WebHDFS端口（名称节点的HTTP端口）
      */
     HDFSStorage(
         const std::string& namenode = "localhost",
-        int port = 9000
+        int port = 9870
     );
 
+    /**
+     * 构造函数
+     * @param namenode HDFS名称节点
+     * @param port WebHDFS端口
+     * @param config HDFS配置
+     * @throws std::runtime_error 端点无效时抛出
+     */
+    HDFSStorage(const std::string& namenode, int port, const HDFSConfig& config);
+
     ~HDFSStorage() override;
-    
+
+    /**
+     * 检查名称节点是否可以访问（根目录的GETFILESTATUS请求）
+     * @return 名称节点可以访问且有权限时返回true
+     */
     bool connect() override;
     void disconnect() override;
     bool isConnected() const override;
-    
+
     std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
     bool fileExists(const std::string& file_path) override;
     size_t getFileSize(const std::string& file_path) override;
     std::string readTextFile(const std::string& file_path) override;
+
+    /**
+     * 列出目录下的文件，不递归，跳过子目录
+     * @param dir_path 目录路径，例如"hdfs://namenode:9870/data"
+     * @return "hdfs://<namenode>:<port>/<path>"形式的文件路径列表
+     */
     std::vector<std::string> listFiles(const std::string& dir_path) override;
 
+    /**
+     * 获取文件各个数据块的位置（GETFILEBLOCKLOCATIONS）
+     * 名称节点不支持该操作时按块大小划分，主机列表为空
+     */
+    std::vector<BlockLocation> getBlockLocations(const std::string& file_path) override;
+
+    /**
+     * 获取配置
+     */
+    const HDFSConfig& config() const { return config_; }
+
+    /**
+     * 获取名称节点和所有数据节点连接池的统计之和
+     */
+    HttpClient::Stats httpStats() const;
+
 private:
+    /**
+     * 文件状态（GETFILESTATUS的结果）
+     */
+    struct FileStatus {
+        bool directory = false;
+        uint64_t length = 0;
+        uint64_t block_size = 0;
+    };
+
+    /**
+     * 把文件路径转换为文件系统内的绝对路径
+     * @throws std::runtime_error 路径属于其他名称节点时抛出
+     */
+    std::string hdfsPath(const std::string& file_path) const;
+
+    /**
+     * 构造请求目标：/webhdfs/v1<path>?op=<op>&<query>，附带认证参数
+     */
+    std::string requestTarget(const std::string& path, const std::string& op, const std::string& query = "") const;
+
+    /**
+     * 获取服务器对应的连接池，没有时新建
+     * @param base_url 服务器地址，例如"http://datanode1:9864"
+     */
+    HttpClient& clientFor(const std::string& base_url);
+
+    /**
+     * 发送请求，跟随3xx重定向
+     * @param buffer 不为空时2xx响应体直接写入该缓冲区
+     */
+    HttpResponse send(const std::string& target, unsigned char* buffer = nullptr, size_t capacity = 0,
+                      size_t* received = nullptr);
+
+    /**
+     * 读取文件状态，文件不存在时返回false
+     */
+    bool status(const std::string& path, FileStatus* file_status);
+
+    /**
+     * 用一次OPEN请求读取文件的一段区间
+     * @return 读取的字节数，区间超出文件末尾时小于length
+     */
+    size_t openRange(const std::string& path, uint64_t offset, unsigned char* buffer, size_t length);
+
+    /**
+     * 把区间按数据块边界和part_size拆分为多个分段并行读取
+     * @param known_status 已知的文件状态，为空时需要时再查询
+     */
+    size_t openRangeParallel(const std::string& path, uint64_t offset, unsigned char* buffer, size_t length,
+                             const FileStatus* known_status = nullptr);
+
+    void requireConnected() const;
+
+    [[noreturn]] void throwError(const std::string& operation, const std::string& path,
+                                 const HttpResponse& response) const;
+
     std::string namenode_;
     int port_;
+    HDFSConfig config_;
     bool connected_;
-    // 注意：在实际实现中，这里应该包含HDFS客户端库的实例
+
+    // 名称节点的连接池，以及按地址索引的数据节点连接池；连接池创建后不再移除
+    std::unique_ptr<HttpClient> client_;
+    mutable std::mutex datanodes_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<HttpClient>> datanodes_;
+
+    std::unique_ptr<ThreadPool> pool_;
 };
 
 /**
@@ -186,17 +654,35 @@ public:
         const std::string& region = "us-east-1"
     );
 
+    /**
+     * 创建S3存储实例
+     * @param bucket S3存储桶名称
+     * @param config S3配置
+     * @return S3存储实例
+     */
+    static std::unique_ptr<DistributedStorage> createS3Storage(const std::string& bucket, const S3Config& config);
+
     /**
      * 创建HDFS存储实例
      * @param namenode HDFS名称节点
-     * @param port HDFS端口
+     * @param port WebHDFS端口
      * @return HDFS存储实例
      */
     static std::unique_ptr<DistributedStorage> createHDFSStorage(
         const std::string& namenode = "localhost",
-        int port = 9000
+        int port = 9870
     );
 
+    /**
+     * 创建HDFS存储实例
+     * @param namenode HDFS名称节点
+     * @param port WebHDFS端口
+     * @param config HDFS配置
+     * @return HDFS存储实例
+     */
+    static std::unique_ptr<DistributedStorage> createHDFSStorage(const std::string& namenode, int port,
+                                                                 const HDFSConfig& config);
+
     /**
      * 根据文件路径创建合适的存储实例
      * @param path 文件路径
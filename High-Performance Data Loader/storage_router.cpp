@@ -0,0 +1,292 @@
+#include "storage_router.h"
+#include <cctype>
+#include <stdexcept>
+
+// StorageRegistry实现
+
+StorageRegistry::StorageRegistry() {
+    Factory connected = [](const std::string& key) -> std::unique_ptr<Storage> {
+        // createStorageForPath()已经尝试过连接，失败时不再重复连接
+        std::unique_ptr<Storage> storage = StorageFactory::createStorageForPath(key);
+        auto* distributed = dynamic_cast<DistributedStorage*>(storage.get());
+        if (distributed && !distributed->isConnected()) {
+            throw std::runtime_error("Failed to connect to " + key);
+        }
+        return storage;
+    };
+    factories_["s3"] = connected;
+    factories_["hdfs"] = connected;
+}
+
+std::shared_ptr<StorageRegistry> StorageRegistry::shared() {
+    static std::shared_ptr<StorageRegistry> registry = std::make_shared<StorageRegistry>();
+    return registry;
+}
+
+std::string StorageRegistry::keyOf(const std::string& path) {
+    size_t separator = path.find("://");
+    if (separator == std::string::npos || separator == 0) {
+        return "";
+    }
+    // 协议只能由字母、数字和"+-."组成，否则视为普通路径
+    for (size_t i = 0; i < separator; ++i) {
+        char c = path[i];
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '+' && c != '-' && c != '.') {
+            return "";
+        }
+    }
+    size_t end = path.find('/', separator + 3);
+    return path.substr(0, end == std::string::npos ? path.size() : end);
+}
+
+void StorageRegistry::registerScheme(const std::string& scheme, Factory factory) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    factories_[scheme] = std::move(factory);
+}
+
+void StorageRegistry::registerStorage(const std::string& key, std::shared_ptr<Storage> storage) {
+    if (keyOf(key) != key) {
+        throw std::invalid_argument("Storage key must be <scheme>://<authority>: " + key);
+    }
+    if (!storage) {
+        throw std::invalid_argument("Cannot register null storage for " + key);
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!storages_.emplace(key, std::move(storage)).second) {
+        throw std::logic_error("Storage already registered for " + key);
+    }
+}
+
+std::shared_ptr<Storage> StorageRegistry::get(const std::string& path) {
+    std::string key = keyOf(path);
+    if (key.empty()) {
+        return nullptr;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = storages_.find(key);
+        if (it != storages_.end()) {
+            return it->second;
+        }
+    }
+
+    Factory factory;
+    std::shared_ptr<std::mutex> slot;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = storages_.find(key);
+        if (it != storages_.end()) {
+            return it->second;
+        }
+        auto factory_it = factories_.find(key.substr(0, key.find("://")));
+        if (factory_it == factories_.end()) {
+            return nullptr;
+        }
+        factory = factory_it->second;
+        std::shared_ptr<std::mutex>& entry = creating_[key];
+        if (!entry) {
+            entry = std::make_shared<std::mutex>();
+        }
+        slot = entry;
+    }
+
+    // 同一个键的创建串行化，其他线程等待后直接取用创建好的实例；不同的键互不阻塞
+    std::lock_guard<std::mutex> create_lock(*slot);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = storages_.find(key);
+        if (it != storages_.end()) {
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<Storage> storage = factory(key);
+    if (!storage) {
+        throw std::runtime_error("Storage factory returned null for " + key);
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    creating_.erase(key);
+    // 创建期间可能已由registerStorage()注册
+    auto result = storages_.emplace(key, std::move(storage));
+    return result.first->second;
+}
+
+size_t StorageRegistry::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return storages_.size();
+}
+
+std::vector<std::string> StorageRegistry::keys() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::string> keys;
+    keys.reserve(storages_.size());
+    for (const auto& entry : storages_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+// StorageRouter实现
+
+StorageRouter::StorageRouter(std::shared_ptr<StorageRegistry> registry)
+    : registry_(std::move(registry)) {
+    if (!registry_) {
+        throw std::invalid_argument("StorageRouter requires a registry");
+    }
+}
+
+StorageRouter::~StorageRouter() = default;
+
+void StorageRouter::setLocalStorage(std::unique_ptr<Storage> storage) {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    std::shared_ptr<Storage> local(std::move(storage));
+    if (local) {
+        local->setAccessPattern(pattern_);
+        local->setStreaming(streaming_);
+    }
+    std::atomic_store(&local_, std::move(local));
+}
+
+std::shared_ptr<Storage> StorageRouter::local() {
+    if (std::shared_ptr<Storage> local = std::atomic_load(&local_)) {
+        return local;
+    }
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    if (!local_) {
+        std::shared_ptr<Storage> local = StorageFactory::createLocalStorage();
+        local->setAccessPattern(pattern_);
+        local->setStreaming(streaming_);
+        std::atomic_store(&local_, std::move(local));
+    }
+    return local_;
+}
+
+std::shared_ptr<Storage> StorageRouter::route(const std::string& path) {
+    // 本地路径最常见，先用协议分隔符快速判断
+    if (path.find("://") == std::string::npos || path.compare(0, 7, "file://") == 0) {
+        return local();
+    }
+    if (std::shared_ptr<Storage> storage = registry_->get(path)) {
+        return storage;
+    }
+    // 没有协议（例如包含"://"的普通路径）或协议未注册时按本地路径处理
+    return local();
+}
+
+std::string StorageRouter::storagePath(const std::string& path) {
+    return path.compare(0, 7, "file://") == 0 ? path.substr(7) : path;
+}
+
+template <typename F>
+auto StorageRouter::dispatch(const std::string& path, F&& fn) {
+    std::shared_ptr<Storage> storage = route(path);
+    return fn(*storage, storagePath(path));
+}
+
+void StorageRouter::forEachGroup(const std::vector<std::string>& paths,
+                                 const std::function<void(Storage&, const std::vector<std::string>&)>& fn) {
+    std::vector<std::pair<std::shared_ptr<Storage>, std::vector<std::string>>> groups;
+    for (const auto& path : paths) {
+        // 预取和提示只是建议，无法创建或连接存储的路径留给之后的读取报告错误
+        std::shared_ptr<Storage> storage;
+        try {
+            storage = route(path);
+        } catch (const std::runtime_error&) {
+            continue;
+        }
+        auto it = groups.begin();
+        while (it != groups.end() && it->first != storage) {
+            ++it;
+        }
+        if (it == groups.end()) {
+            groups.emplace_back(storage, std::vector<std::string>());
+            it = groups.end() - 1;
+        }
+        it->second.push_back(storagePath(path));
+    }
+    for (const auto& group : groups) {
+        fn(*group.first, group.second);
+    }
+}
+
+std::vector<unsigned char> StorageRouter::readFile(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.readFile(path);
+    });
+}
+
+std::vector<unsigned char> StorageRouter::readRange(const std::string& file_path, uint64_t offset, size_t length) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.readRange(path, offset, length);
+    });
+}
+
+size_t StorageRouter::readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.readInto(path, offset, buffer, length);
+    });
+}
+
+PooledBuffer StorageRouter::readFilePooled(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.readFilePooled(path);
+    });
+}
+
+bool StorageRouter::fileExists(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.fileExists(path);
+    });
+}
+
+size_t StorageRouter::getFileSize(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.getFileSize(path);
+    });
+}
+
+std::string StorageRouter::readTextFile(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.readTextFile(path);
+    });
+}
+
+std::vector<std::string> StorageRouter::listFiles(const std::string& dir_path) {
+    return dispatch(dir_path, [&](Storage& storage, const std::string& path) {
+        return storage.listFiles(path);
+    });
+}
+
+void StorageRouter::prefetch(const std::vector<std::string>& paths) {
+    forEachGroup(paths, [](Storage& storage, const std::vector<std::string>& group) {
+        storage.prefetch(group);
+    });
+}
+
+void StorageRouter::setAccessPattern(AccessAdvice pattern) {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    pattern_ = pattern;
+    if (local_) {
+        local_->setAccessPattern(pattern);
+    }
+}
+
+void StorageRouter::setStreaming(bool enabled) {
+    std::lock_guard<std::mutex> lock(local_mutex_);
+    streaming_ = enabled;
+    if (local_) {
+        local_->setStreaming(enabled);
+    }
+}
+
+void StorageRouter::advise(const std::vector<std::string>& paths, AccessAdvice advice) {
+    forEachGroup(paths, [advice](Storage& storage, const std::vector<std::string>& group) {
+        storage.advise(group, advice);
+    });
+}
+
+std::vector<BlockLocation> StorageRouter::getBlockLocations(const std::string& file_path) {
+    return dispatch(file_path, [&](Storage& storage, const std::string& path) {
+        return storage.getBlockLocations(path);
+    });
+}
@@ -0,0 +1,176 @@
+#ifndef STORAGE_ROUTER_H
+#define STORAGE_ROUTER_H
+
+#include "storage.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <functional>
+
+/**
+ * 存储注册表 - 按"协议://授权部分"（例如"s3://bucket"、"hdfs://namenode:9870"）管理共享的远程存储实例
+ * 每个存储桶或名称节点在第一次被访问时创建并连接一个存储实例，之后所有使用同一注册表的
+ * StorageRouter（通常是进程中的所有DataLoader）共享它，连接池和线程池只建立一次。
+ * 存储实例会被多个线程同时使用，必须是线程安全的
+ */
+class StorageRegistry {
+public:
+    /**
+     * 存储工厂，参数为"协议://授权部分"形式的键，返回已连接的存储
+     */
+    using Factory = std::function<std::unique_ptr<Storage>(const std::string& key)>;
+
+    /**
+     * 构造函数，注册s3和hdfs的默认工厂（通过StorageFactory::createStorageForPath创建并连接）
+     */
+    StorageRegistry();
+
+    StorageRegistry(const StorageRegistry&) = delete;
+    StorageRegistry& operator=(const StorageRegistry&) = delete;
+
+    /**
+     * 进程级共享注册表
+     */
+    static std::shared_ptr<StorageRegistry> shared();
+
+    /**
+     * 获取路径的键
+     * @param path 文件路径，例如"s3://bucket/images/1.jpg"
+     * @return "s3://bucket"；没有协议的本地路径返回空字符串
+     */
+    static std::string keyOf(const std::string& path);
+
+    /**
+     * 注册或替换某个协议的工厂，只影响之后新建的存储
+     * @param scheme 协议名称，例如"s3"
+     * @param factory 存储工厂
+     */
+    void registerScheme(const std::string& scheme, Factory factory);
+
+    /**
+     * 注册已配置好的存储实例，例如使用自定义S3Config或用HedgedStorage包装的存储
+     * 已注册的实例不会被替换，正在使用它的读取不会失去存储
+     * @param key "协议://授权部分"形式的键，例如"s3://bucket"
+     * @param storage 存储实例
+     * @throws std::invalid_argument 键的格式不正确时抛出
+     * @throws std::logic_error 该键已有存储实例（已注册或已由工厂创建）时抛出
+     */
+    void registerStorage(const std::string& key, std::shared_ptr<Storage> storage);
+
+    /**
+     * 获取路径所属的存储，不存在时通过工厂创建
+     * 创建失败（例如无法连接）时不缓存，下次访问会重新创建
+     * @param path 带协议的文件路径
+     * @return 存储实例，调用方持有共享所有权；路径没有协议或协议未注册时返回空
+     * @throws std::runtime_error 创建或连接失败时抛出
+     */
+    std::shared_ptr<Storage> get(const std::string& path);
+
+    /**
+     * 获取已创建的存储实例数量
+     */
+    size_t size() const;
+
+    /**
+     * 获取已创建的存储实例的键
+     */
+    std::vector<std::string> keys() const;
+
+private:
+    // 保护factories_和storages_；查找使用共享锁
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, Factory> factories_;
+    std::map<std::string, std::shared_ptr<Storage>> storages_;
+
+    // 正在创建存储的键及其创建锁，由mutex_保护；同一个键只创建一次，
+    // 创建（连接）期间不阻塞其他键的创建和查找，创建成功后移除
+    std::map<std::string, std::shared_ptr<std::mutex>> creating_;
+};
+
+/**
+ * 存储路由 - 按路径的协议和授权部分把每个操作分派给对应的存储
+ * 同一个数据集可以混合本地路径、"file://"、"s3://"和"hdfs://"路径。远程存储来自StorageRegistry，
+ * 由使用同一注册表的所有路由共享；本地路径由每个路由自己的LocalStorage读取，
+ * 因此setAccessPattern()和setStreaming()只作用于本路由的本地存储，不影响其他加载器。
+ * 没有协议或协议未注册的路径由本地存储读取，"file://"路径去掉协议前缀后由本地存储读取。
+ * prefetch()和advise()按存储分组转发
+ */
+class StorageRouter : public Storage {
+public:
+    /**
+     * 构造函数，不立即创建任何存储
+     * @param registry 远程存储注册表，默认为进程级共享注册表
+     */
+    explicit StorageRouter(std::shared_ptr<StorageRegistry> registry = StorageRegistry::shared());
+
+    ~StorageRouter() override;
+
+    /**
+     * 替换本地路径使用的存储（默认为LocalStorage），须在开始读取之前调用
+     * @param storage 本地存储
+     */
+    void setLocalStorage(std::unique_ptr<Storage> storage);
+
+    /**
+     * 获取路径对应的存储
+     * @param path 文件路径
+     * @return 存储实例，调用方持有共享所有权
+     */
+    std::shared_ptr<Storage> route(const std::string& path);
+
+    /**
+     * 获取远程存储注册表
+     */
+    StorageRegistry& registry() { return *registry_; }
+
+    std::vector<unsigned char> readFile(const std::string& file_path) override;
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override;
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override;
+    PooledBuffer readFilePooled(const std::string& file_path) override;
+    bool fileExists(const std::string& file_path) override;
+    size_t getFileSize(const std::string& file_path) override;
+    std::string readTextFile(const std::string& file_path) override;
+    std::vector<std::string> listFiles(const std::string& dir_path) override;
+    void prefetch(const std::vector<std::string>& paths) override;
+    void setAccessPattern(AccessAdvice pattern) override;
+    void setStreaming(bool enabled) override;
+    void advise(const std::vector<std::string>& paths, AccessAdvice advice) override;
+    std::vector<BlockLocation> getBlockLocations(const std::string& file_path) override;
+
+private:
+    /**
+     * 获取本地存储，第一次访问本地路径时创建
+     */
+    std::shared_ptr<Storage> local();
+
+    /**
+     * 路径在所属存储中的形式："file://"路径去掉协议前缀，其他路径不变
+     */
+    static std::string storagePath(const std::string& path);
+
+    /**
+     * 在路径所属的存储上调用fn(存储, 存储中的路径)
+     */
+    template <typename F>
+    auto dispatch(const std::string& path, F&& fn);
+
+    /**
+     * 把路径列表按存储分组（保持各组内的顺序）后逐组调用fn，跳过无法路由的路径
+     */
+    void forEachGroup(const std::vector<std::string>& paths,
+                      const std::function<void(Storage&, const std::vector<std::string>&)>& fn);
+
+    std::shared_ptr<StorageRegistry> registry_;
+
+    // 本地存储及其访问模式设置，在local_mutex_下创建和修改；local_通过std::atomic_load()无锁读取
+    std::mutex local_mutex_;
+    std::shared_ptr<Storage> local_;
+    AccessAdvice pattern_ = AccessAdvice::Normal;
+    bool streaming_ = false;
+};
+
+#endif // STORAGE_ROUTER_H
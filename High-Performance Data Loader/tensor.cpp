@@ -0,0 +1,580 @@
+#include "tensor.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 拼接的总数据量超过该值时才在线程池上并行复制
+constexpr size_t kParallelStackBytes = 1 << 20;
+
+/**
+ * 形状和步长覆盖的字节数：最后一个元素的偏移加一个元素
+ */
+size_t spanBytes(const TensorData::Shape& shape, const TensorData::Shape& strides, size_t item_size) {
+    size_t last = 0;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (shape[i] == 0) {
+            return 0;
+        }
+        last += static_cast<size_t>(shape[i] - 1) * static_cast<size_t>(strides[i]);
+    }
+    return (last + 1) * item_size;
+}
+
+/**
+ * 把数值转换为元素类型的一个元素，写入out
+ */
+void encodeValue(DType dtype, double value, unsigned char* out) {
+    auto put = [out](auto element) { std::memcpy(out, &element, sizeof(element)); };
+    switch (dtype) {
+    case DType::Bool:
+        put(static_cast<uint8_t>(value != 0));
+        break;
+    case DType::UInt8:
+        put(static_cast<uint8_t>(value));
+        break;
+    case DType::Int8:
+        put(static_cast<int8_t>(value));
+        break;
+    case DType::UInt16:
+        put(static_cast<uint16_t>(value));
+        break;
+    case DType::Int16:
+        put(static_cast<int16_t>(value));
+        break;
+    case DType::UInt32:
+        put(static_cast<uint32_t>(value));
+        break;
+    case DType::Int32:
+        put(static_cast<int32_t>(value));
+        break;
+    case DType::UInt64:
+        put(static_cast<uint64_t>(value));
+        break;
+    case DType::Int64:
+        put(static_cast<int64_t>(value));
+        break;
+    case DType::Float16: {
+        // 截断转换，补齐值通常是0、-1等可以精确表示的数
+        float f = static_cast<float>(value);
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+        uint16_t half;
+        if ((bits & 0x7FFFFFFF) == 0 || exponent <= 0) {
+            half = sign;
+        } else if (exponent >= 31) {
+            half = static_cast<uint16_t>(sign | 0x7C00);
+        } else {
+            half = static_cast<uint16_t>(sign | exponent << 10 | ((bits >> 13) & 0x3FF));
+        }
+        put(half);
+        break;
+    }
+    case DType::BFloat16: {
+        float f = static_cast<float>(value);
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        put(static_cast<uint16_t>(bits >> 16));
+        break;
+    }
+    case DType::Float32:
+        put(static_cast<float>(value));
+        break;
+    case DType::Float64:
+        put(value);
+        break;
+    }
+}
+
+} // namespace
+
+const char* dtypeName(DType dtype) {
+    switch (dtype) {
+    case DType::Bool:
+        return "bool";
+    case DType::UInt8:
+        return "uint8";
+    case DType::Int8:
+        return "int8";
+    case DType::UInt16:
+        return "uint16";
+    case DType::Int16:
+        return "int16";
+    case DType::UInt32:
+        return "uint32";
+    case DType::Int32:
+        return "int32";
+    case DType::UInt64:
+        return "uint64";
+    case DType::Int64:
+        return "int64";
+    case DType::Float16:
+        return "float16";
+    case DType::BFloat16:
+        return "bfloat16";
+    case DType::Float32:
+        return "float32";
+    case DType::Float64:
+        return "float64";
+    }
+    return "unknown";
+}
+
+// TensorData实现
+
+TensorData::TensorData(DType dtype, Shape shape) : dtype_(dtype) {
+    setLayout(std::move(shape), Shape());
+    buffer_ = PooledBuffer(getByteSize());
+    data_ = buffer_.data();
+}
+
+TensorData::TensorData(DType dtype, Shape shape, PooledBuffer buffer) : dtype_(dtype), buffer_(std::move(buffer)) {
+    setLayout(std::move(shape), Shape());
+    if (buffer_.size() < getByteSize()) {
+        throw std::invalid_argument("Pooled buffer is smaller than tensor size " + shapeString(shape_));
+    }
+    data_ = buffer_.data();
+}
+
+TensorData::TensorData(DType dtype, Shape shape, MappedBuffer view, Shape strides)
+    : dtype_(dtype), writable_(false), view_(std::move(view)) {
+    setLayout(std::move(shape), std::move(strides));
+    if (view_.size() < spanBytes(shape_, strides_, getItemSize())) {
+        throw std::invalid_argument("Mapped view is smaller than tensor size " + shapeString(shape_));
+    }
+    data_ = view_.data();
+}
+
+TensorData::TensorData(DType dtype, Shape shape, void* data, std::shared_ptr<const void> owner, Shape strides)
+    : dtype_(dtype), data_(static_cast<const unsigned char*>(data)), owner_(std::move(owner)) {
+    setLayout(std::move(shape), std::move(strides));
+}
+
+TensorData::TensorData(DType dtype, Shape shape, const void* data, std::shared_ptr<const void> owner, Shape strides)
+    : dtype_(dtype), data_(static_cast<const unsigned char*>(data)), writable_(false), owner_(std::move(owner)) {
+    setLayout(std::move(shape), std::move(strides));
+}
+
+TensorData::TensorData(TensorData&& other) noexcept
+    : DataItem(other),
+      dtype_(other.dtype_),
+      shape_(std::move(other.shape_)),
+      strides_(std::move(other.strides_)),
+      data_(other.data_),
+      writable_(other.writable_),
+      buffer_(std::move(other.buffer_)),
+      view_(std::move(other.view_)),
+      owner_(std::move(other.owner_)) {
+    other.shape_ = {0};
+    other.strides_ = {1};
+    other.data_ = nullptr;
+    other.writable_ = true;
+}
+
+TensorData& TensorData::operator=(TensorData&& other) noexcept {
+    if (this != &other) {
+        dtype_ = other.dtype_;
+        shape_ = std::move(other.shape_);
+        strides_ = std::move(other.strides_);
+        data_ = other.data_;
+        writable_ = other.writable_;
+        buffer_ = std::move(other.buffer_);
+        view_ = std::move(other.view_);
+        owner_ = std::move(other.owner_);
+        other.shape_ = {0};
+        other.strides_ = {1};
+        other.data_ = nullptr;
+        other.writable_ = true;
+    }
+    return *this;
+}
+
+void TensorData::setLayout(Shape shape, Shape strides) {
+    for (int64_t dim : shape) {
+        if (dim < 0) {
+            throw std::invalid_argument("Tensor shape has a negative dimension: " + shapeString(shape));
+        }
+    }
+    if (strides.empty()) {
+        strides = contiguousStrides(shape);
+    } else if (strides.size() != shape.size()) {
+        throw std::invalid_argument("Tensor strides " + shapeString(strides) + " do not match shape " +
+                                    shapeString(shape));
+    }
+    for (int64_t stride : strides) {
+        if (stride < 0) {
+            throw std::invalid_argument("Tensor strides must be non-negative: " + shapeString(strides));
+        }
+    }
+    shape_ = std::move(shape);
+    strides_ = std::move(strides);
+}
+
+void TensorData::checkType(DType requested) const {
+    if (requested != dtype_) {
+        throw std::invalid_argument(std::string("Tensor of type ") + dtypeName(dtype_) + " accessed as " +
+                                    dtypeName(requested));
+    }
+}
+
+bool TensorData::isContiguous() const {
+    int64_t expected = 1;
+    for (size_t i = shape_.size(); i-- > 0;) {
+        if (shape_[i] != 1 && strides_[i] != expected) {
+            return false;
+        }
+        expected *= shape_[i];
+    }
+    return true;
+}
+
+void* TensorData::getData() {
+    if (!writable_) {
+        PooledBuffer buffer(getByteSize());
+        copyTo(buffer.data());
+        buffer_ = std::move(buffer);
+        view_ = MappedBuffer();
+        owner_.reset();
+        strides_ = contiguousStrides(shape_);
+        data_ = buffer_.data();
+        writable_ = true;
+    }
+    return const_cast<unsigned char*>(data_);
+}
+
+void TensorData::copyTo(void* dst) const {
+    const size_t bytes = getByteSize();
+    if (bytes == 0) {
+        return;
+    }
+    unsigned char* out = static_cast<unsigned char*>(dst);
+    if (isContiguous()) {
+        memcpy(out, data_, bytes);
+        return;
+    }
+
+    // 最内层维度连续时整行复制，否则逐个元素复制；外层维度用计数器逐个推进
+    const size_t item_size = getItemSize();
+    const size_t dims = shape_.size();
+    const size_t inner = static_cast<size_t>(shape_[dims - 1]);
+    const bool inner_contiguous = inner == 1 || strides_[dims - 1] == 1;
+    const size_t inner_stride = static_cast<size_t>(strides_[dims - 1]) * item_size;
+    std::vector<int64_t> index(dims - 1, 0);
+    size_t offset = 0;
+    for (size_t written = 0; written < bytes; written += inner * item_size) {
+        const unsigned char* row = data_ + offset;
+        if (inner_contiguous) {
+            memcpy(out + written, row, inner * item_size);
+        } else {
+            for (size_t i = 0; i < inner; ++i) {
+                memcpy(out + written + i * item_size, row + i * inner_stride, item_size);
+            }
+        }
+        for (size_t d = dims - 1; d-- > 0;) {
+            offset += static_cast<size_t>(strides_[d]) * item_size;
+            if (++index[d] < shape_[d]) {
+                break;
+            }
+            offset -= static_cast<size_t>(strides_[d]) * static_cast<size_t>(shape_[d]) * item_size;
+            index[d] = 0;
+        }
+    }
+}
+
+void TensorData::fill(double value) {
+    if (getNumElements() == 0) {
+        return;
+    }
+    unsigned char element[sizeof(double)];
+    const size_t item_size = getItemSize();
+    encodeValue(dtype_, value, element);
+    unsigned char* data = static_cast<unsigned char*>(getData());
+    if (isContiguous()) {
+        const size_t bytes = getByteSize();
+        if (std::all_of(element, element + item_size, [](unsigned char byte) { return byte == 0; })) {
+            std::memset(data, 0, bytes);
+        } else {
+            for (size_t offset = 0; offset < bytes; offset += item_size) {
+                std::memcpy(data + offset, element, item_size);
+            }
+        }
+        return;
+    }
+    // 非连续布局（外部可写内存的跨步视图）逐个元素写入
+    Shape index(shape_.size(), 0);
+    for (size_t n = getNumElements(); n > 0; --n) {
+        size_t offset = 0;
+        for (size_t d = 0; d < shape_.size(); ++d) {
+            offset += static_cast<size_t>(index[d] * strides_[d]);
+        }
+        std::memcpy(data + offset * item_size, element, item_size);
+        for (size_t d = shape_.size(); d-- > 0;) {
+            if (++index[d] < shape_[d]) {
+                break;
+            }
+            index[d] = 0;
+        }
+    }
+}
+
+TensorData TensorData::copy() const {
+    TensorData result(dtype_, shape_);
+    copyTo(result.buffer_.data());
+    return result;
+}
+
+TensorData TensorData::duplicate() const {
+    if (view_.file()) {
+        return TensorData(dtype_, shape_, view_, strides_);
+    }
+    if (!writable_ && owner_) {
+        return TensorData(dtype_, shape_, static_cast<const void*>(data_), owner_, strides_);
+    }
+    return copy();
+}
+
+std::unique_ptr<DataItem> TensorData::clone() const {
+    return std::make_unique<TensorData>(duplicate());
+}
+
+TensorData TensorData::stack(const std::vector<const TensorData*>& items, ThreadPool* pool) {
+    if (items.empty()) {
+        throw std::invalid_argument("Cannot stack an empty list of tensors");
+    }
+    const TensorData& first = *items.front();
+    for (const TensorData* item : items) {
+        if (item->dtype_ != first.dtype_ || item->shape_ != first.shape_) {
+            throw std::invalid_argument(std::string("Cannot stack tensors of ") + dtypeName(first.dtype_) +
+                                        shapeString(first.shape_) + " and " + dtypeName(item->dtype_) +
+                                        shapeString(item->shape_));
+        }
+    }
+
+    Shape shape;
+    shape.reserve(first.shape_.size() + 1);
+    shape.push_back(static_cast<int64_t>(items.size()));
+    shape.insert(shape.end(), first.shape_.begin(), first.shape_.end());
+    TensorData result(first.dtype_, std::move(shape));
+
+    const size_t item_bytes = first.getByteSize();
+    unsigned char* out = result.buffer_.data();
+    auto copyRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            items[i]->copyTo(out + i * item_bytes);
+        }
+    };
+    if (pool && items.size() > 1 && result.getByteSize() >= kParallelStackBytes) {
+        pool->parallel_for(0, items.size(), 0, copyRange);
+    } else {
+        copyRange(0, items.size());
+    }
+    return result;
+}
+
+TensorData TensorData::padStack(const std::vector<const TensorData*>& items, double pad_value, ThreadPool* pool) {
+    if (items.empty()) {
+        throw std::invalid_argument("Cannot stack an empty list of tensors");
+    }
+    const TensorData& first = *items.front();
+    if (first.shape_.empty()) {
+        throw std::invalid_argument("Cannot pad scalar tensors");
+    }
+    int64_t max_length = 0;
+    for (const TensorData* item : items) {
+        if (item->dtype_ != first.dtype_ || item->shape_.size() != first.shape_.size() ||
+            !std::equal(item->shape_.begin() + 1, item->shape_.end(), first.shape_.begin() + 1)) {
+            throw std::invalid_argument(std::string("Cannot pad and stack tensors of ") + dtypeName(first.dtype_) +
+                                        shapeString(first.shape_) + " and " + dtypeName(item->dtype_) +
+                                        shapeString(item->shape_));
+        }
+        max_length = std::max(max_length, item->shape_[0]);
+    }
+
+    Shape shape;
+    shape.reserve(first.shape_.size() + 1);
+    shape.push_back(static_cast<int64_t>(items.size()));
+    shape.push_back(max_length);
+    shape.insert(shape.end(), first.shape_.begin() + 1, first.shape_.end());
+    TensorData result(first.dtype_, std::move(shape));
+
+    // 第0维上一个位置的字节数
+    const size_t item_size = first.getItemSize();
+    const size_t step_bytes = numElements(Shape(first.shape_.begin() + 1, first.shape_.end())) * item_size;
+    const size_t row_bytes = static_cast<size_t>(max_length) * step_bytes;
+    unsigned char pad[sizeof(double)];
+    encodeValue(first.dtype_, pad_value, pad);
+    const bool zero_pad = std::all_of(pad, pad + item_size, [](unsigned char byte) { return byte == 0; });
+
+    unsigned char* out = result.buffer_.data();
+    auto copyRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            unsigned char* row = out + i * row_bytes;
+            const size_t used = items[i]->getByteSize();
+            items[i]->copyTo(row);
+            if (zero_pad) {
+                std::memset(row + used, 0, row_bytes - used);
+            } else {
+                for (size_t offset = used; offset < row_bytes; offset += item_size) {
+                    std::memcpy(row + offset, pad, item_size);
+                }
+            }
+        }
+    };
+    if (pool && items.size() > 1 && result.getByteSize() >= kParallelStackBytes) {
+        pool->parallel_for(0, items.size(), 0, copyRange);
+    } else {
+        copyRange(0, items.size());
+    }
+    return result;
+}
+
+TensorData::Shape TensorData::contiguousStrides(const Shape& shape) {
+    Shape strides(shape.size());
+    int64_t stride = 1;
+    for (size_t i = shape.size(); i-- > 0;) {
+        strides[i] = stride;
+        stride *= std::max<int64_t>(shape[i], 1);
+    }
+    return strides;
+}
+
+size_t TensorData::numElements(const Shape& shape) {
+    size_t count = 1;
+    for (int64_t dim : shape) {
+        count *= static_cast<size_t>(dim);
+    }
+    return count;
+}
+
+std::string TensorData::shapeString(const Shape& shape) {
+    std::string result = "[";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (i > 0) {
+            result += ", ";
+        }
+        result += std::to_string(shape[i]);
+    }
+    return result + "]";
+}
+
+// TensorMap实现
+
+void TensorMap::set(const std::string& name, TensorData tensor) {
+    if (TensorData* existing = find(name)) {
+        *existing = std::move(tensor);
+        return;
+    }
+    fields_.emplace_back(name, std::move(tensor));
+}
+
+TensorData* TensorMap::find(const std::string& name) {
+    for (auto& field : fields_) {
+        if (field.first == name) {
+            return &field.second;
+        }
+    }
+    return nullptr;
+}
+
+const TensorData* TensorMap::find(const std::string& name) const {
+    return const_cast<TensorMap*>(this)->find(name);
+}
+
+TensorData& TensorMap::get(const std::string& name) {
+    if (TensorData* tensor = find(name)) {
+        return *tensor;
+    }
+    throw std::out_of_range("No tensor named " + name);
+}
+
+const TensorData& TensorMap::get(const std::string& name) const {
+    return const_cast<TensorMap*>(this)->get(name);
+}
+
+std::unique_ptr<DataItem> TensorMap::clone() const {
+    auto result = std::make_unique<TensorMap>();
+    result->fields_.reserve(fields_.size());
+    for (const auto& field : fields_) {
+        auto tensor = field.second.clone();
+        result->fields_.emplace_back(field.first, std::move(static_cast<TensorData&>(*tensor)));
+    }
+    return result;
+}
+
+TensorMap TensorMap::stack(const std::vector<const TensorMap*>& items, ThreadPool* pool) {
+    if (items.empty()) {
+        throw std::invalid_argument("Cannot stack an empty list of tensor maps");
+    }
+    TensorMap result;
+    std::vector<const TensorData*> tensors(items.size());
+    for (const auto& field : items.front()->fields_) {
+        for (size_t i = 0; i < items.size(); ++i) {
+            tensors[i] = items[i]->find(field.first);
+            if (!tensors[i] || items[i]->size() != items.front()->size()) {
+                throw std::invalid_argument("Cannot stack tensor maps with different fields (missing " +
+                                            field.first + ")");
+            }
+        }
+        try {
+            result.fields_.emplace_back(field.first, TensorData::stack(tensors, pool));
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Field " + field.first + ": " + e.what());
+        }
+    }
+    return result;
+}
+
+std::unique_ptr<DataItem> collateBatch(const std::vector<std::unique_ptr<DataItem>>& batch, ThreadPool* pool) {
+    if (batch.empty()) {
+        throw std::invalid_argument("Cannot collate an empty batch");
+    }
+    if (dynamic_cast<const TensorMap*>(batch.front().get())) {
+        std::vector<const TensorMap*> maps;
+        maps.reserve(batch.size());
+        for (const auto& item : batch) {
+            auto* map = dynamic_cast<const TensorMap*>(item.get());
+            if (!map) {
+                throw std::invalid_argument("Cannot collate a batch mixing TensorMap and other items");
+            }
+            maps.push_back(map);
+        }
+        return std::make_unique<TensorMap>(TensorMap::stack(maps, pool));
+    }
+
+    std::vector<const TensorData*> tensors;
+    tensors.reserve(batch.size());
+    for (const auto& item : batch) {
+        auto* tensor = dynamic_cast<const TensorData*>(item.get());
+        if (!tensor) {
+            throw std::invalid_argument("Cannot collate a batch containing items that are not tensors");
+        }
+        tensors.push_back(tensor);
+    }
+    return std::make_unique<TensorData>(TensorData::stack(tensors, pool));
+}
+
+std::unique_ptr<DataItem> collatePadded(const std::vector<std::unique_ptr<DataItem>>& batch, double pad_value,
+                                        ThreadPool* pool) {
+    if (batch.empty()) {
+        throw std::invalid_argument("Cannot collate an empty batch");
+    }
+    std::vector<const TensorData*> tensors;
+    std::vector<int64_t> lengths;
+    tensors.reserve(batch.size());
+    lengths.reserve(batch.size());
+    for (const auto& item : batch) {
+        auto* tensor = dynamic_cast<const TensorData*>(item.get());
+        if (!tensor) {
+            throw std::invalid_argument("Cannot collate a batch containing items that are not tensors");
+        }
+        tensors.push_back(tensor);
+        lengths.push_back(tensor->getShape().empty() ? 0 : tensor->getShape()[0]);
+    }
+    auto result = std::make_unique<TensorMap>();
+    result->set("data", TensorData::padStack(tensors, pad_value, pool));
+    result->set("lengths", TensorData::copyOf(lengths));
+    return result;
+}
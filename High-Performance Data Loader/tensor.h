@@ -0,0 +1,389 @@
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include "data_item.h"
+#include "buffer_pool.h"
+#include "file_io.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class ThreadPool;
+
+/**
+ * 张量元素类型
+ */
+enum class DType : uint8_t {
+    Bool,
+    UInt8,
+    Int8,
+    UInt16,
+    Int16,
+    UInt32,
+    Int32,
+    UInt64,
+    Int64,
+    Float16,   // IEEE半精度，只存储，不提供C++类型
+    BFloat16,  // bfloat16，只存储，不提供C++类型
+    Float32,
+    Float64
+};
+
+/**
+ * 获取元素类型的字节数
+ */
+inline size_t dtypeSize(DType dtype) {
+    switch (dtype) {
+    case DType::Bool:
+    case DType::UInt8:
+    case DType::Int8:
+        return 1;
+    case DType::UInt16:
+    case DType::Int16:
+    case DType::Float16:
+    case DType::BFloat16:
+        return 2;
+    case DType::UInt32:
+    case DType::Int32:
+    case DType::Float32:
+        return 4;
+    case DType::UInt64:
+    case DType::Int64:
+    case DType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+/**
+ * 获取元素类型的名称，例如"float32"
+ */
+const char* dtypeName(DType dtype);
+
+/**
+ * C++类型对应的元素类型：DTypeOf<float>::value == DType::Float32
+ */
+template <typename T> struct DTypeOf;
+template <> struct DTypeOf<bool> { static constexpr DType value = DType::Bool; };
+template <> struct DTypeOf<uint8_t> { static constexpr DType value = DType::UInt8; };
+template <> struct DTypeOf<int8_t> { static constexpr DType value = DType::Int8; };
+template <> struct DTypeOf<uint16_t> { static constexpr DType value = DType::UInt16; };
+template <> struct DTypeOf<int16_t> { static constexpr DType value = DType::Int16; };
+template <> struct DTypeOf<uint32_t> { static constexpr DType value = DType::UInt32; };
+template <> struct DTypeOf<int32_t> { static constexpr DType value = DType::Int32; };
+template <> struct DTypeOf<uint64_t> { static constexpr DType value = DType::UInt64; };
+template <> struct DTypeOf<int64_t> { static constexpr DType value = DType::Int64; };
+template <> struct DTypeOf<float> { static constexpr DType value = DType::Float32; };
+template <> struct DTypeOf<double> { static constexpr DType value = DType::Float64; };
+
+/**
+ * 张量数据项 - 元素类型、N维形状和步长描述的一块数据，用于浮点特征、词元ID、标签等任意数值样本
+ * 步长以元素为单位（与PyTorch相同），未指定时为行优先的连续布局。
+ * 数据可以来自：
+ * - 新分配或传入的池化缓冲区（64字节对齐，连续布局），张量销毁时回到缓冲池
+ * - 内存映射文件中的只读切片（零拷贝，可以带步长）
+ * - 外部内存，通过owner共享所有权保证其生命周期；以const指针传入时视为只读
+ * 只读数据在首次可写访问时复制为连续的池化缓冲区（写时复制）。
+ *
+ * 张量只能移动，深拷贝使用copy()或clone()
+ */
+class TensorData : public DataItem {
+public:
+    using Shape = std::vector<int64_t>;
+
+    /**
+     * 构造空张量（形状为{0}）
+     */
+    TensorData() = default;
+
+    /**
+     * 构造张量并从缓冲池分配存储，内容未初始化
+     * @param dtype 元素类型
+     * @param shape 形状，空形状表示标量
+     * @throws std::invalid_argument 形状中有负数时抛出
+     */
+    TensorData(DType dtype, Shape shape);
+
+    /**
+     * 构造持有池化缓冲区的张量（连续布局）
+     * @param buffer 数据，大小至少为getByteSize()
+     */
+    TensorData(DType dtype, Shape shape, PooledBuffer buffer);
+
+    /**
+     * 构造引用映射文件切片的张量，不复制数据
+     * @param view 数据所在的映射区间
+     * @param strides 步长（元素），为空时为连续布局
+     * @throws std::invalid_argument 区间小于形状和步长覆盖的范围时抛出
+     */
+    TensorData(DType dtype, Shape shape, MappedBuffer view, Shape strides = Shape());
+
+    /**
+     * 构造引用外部可写内存的张量，不复制数据
+     * @param data 数据起始地址
+     * @param owner 数据的所有者，张量持有其共享所有权；为空时由调用方保证数据的生命周期长于张量
+     * @param strides 步长（元素），为空时为连续布局
+     */
+    TensorData(DType dtype, Shape shape, void* data, std::shared_ptr<const void> owner, Shape strides = Shape());
+
+    /**
+     * 构造引用外部只读内存的张量，首次可写访问时复制
+     */
+    TensorData(DType dtype, Shape shape, const void* data, std::shared_ptr<const void> owner,
+               Shape strides = Shape());
+
+    /**
+     * 复制一段连续数据构造张量
+     * @param data 源数据，元素个数为形状中各维大小之积
+     */
+    template <typename T>
+    static TensorData copyOf(const T* data, Shape shape) {
+        TensorData tensor(DTypeOf<T>::value, std::move(shape));
+        if (tensor.getByteSize() > 0) {
+            memcpy(tensor.buffer_.data(), data, tensor.getByteSize());
+        }
+        return tensor;
+    }
+
+    /**
+     * 复制一组值构造张量
+     * @param shape 形状，为空时为一维{values.size()}
+     */
+    template <typename T>
+    static TensorData copyOf(const std::vector<T>& values, Shape shape = Shape()) {
+        if (shape.empty()) {
+            shape.push_back(static_cast<int64_t>(values.size()));
+        }
+        if (numElements(shape) != values.size()) {
+            throw std::invalid_argument("Tensor shape does not match number of values");
+        }
+        return copyOf(values.data(), std::move(shape));
+    }
+
+    /**
+     * 构造0维张量（标量），例如分类标签
+     */
+    template <typename T>
+    static TensorData scalar(T value) {
+        return copyOf(&value, Shape());
+    }
+
+    TensorData(const TensorData&) = delete;
+    TensorData& operator=(const TensorData&) = delete;
+
+    /**
+     * 移动构造，被移动的张量变为空张量
+     */
+    TensorData(TensorData&& other) noexcept;
+    TensorData& operator=(TensorData&& other) noexcept;
+
+    DType getDType() const { return dtype_; }
+    const Shape& getShape() const { return shape_; }
+    const Shape& getStrides() const { return strides_; }
+    size_t getNumDims() const { return shape_.size(); }
+    size_t getItemSize() const { return dtypeSize(dtype_); }
+    size_t getNumElements() const { return numElements(shape_); }
+    size_t getByteSize() const { return getNumElements() * getItemSize(); }
+
+    /**
+     * 是否为行优先的连续布局（大小为1的维度不考虑步长）
+     */
+    bool isContiguous() const;
+
+    /**
+     * 是否引用只读数据（映射文件或只读外部内存，尚未复制）
+     */
+    bool isView() const { return !writable_ && data_ != nullptr; }
+
+    /**
+     * 获取引用的映射区间，不是由映射区间构造时为空
+     */
+    const MappedBuffer& getView() const { return view_; }
+
+    /**
+     * 获取可写的数据
+     * 引用只读数据时，首次调用会复制为连续的池化缓冲区（写时复制）
+     */
+    void* getData();
+
+    /**
+     * 获取只读的数据，按getStrides()访问
+     */
+    const void* getData() const { return data_; }
+
+    /**
+     * 按元素类型访问数据
+     * @throws std::invalid_argument T与元素类型不一致时抛出
+     */
+    template <typename T>
+    T* getDataAs() {
+        checkType(DTypeOf<T>::value);
+        return static_cast<T*>(getData());
+    }
+
+    template <typename T>
+    const T* getDataAs() const {
+        checkType(DTypeOf<T>::value);
+        return static_cast<const T*>(getData());
+    }
+
+    /**
+     * 按行优先顺序把数据复制到连续内存，处理任意步长
+     * @param dst 目标地址，大小至少为getByteSize()
+     */
+    void copyTo(void* dst) const;
+
+    /**
+     * 把所有元素设置为同一个值（转换为元素类型），引用只读数据时先复制
+     */
+    void fill(double value);
+
+    /**
+     * 深拷贝为连续布局的池化存储
+     */
+    TensorData copy() const;
+
+    std::unique_ptr<DataItem> clone() const override;
+
+    /**
+     * 沿新的第0维拼接一组形状和元素类型都相同的张量，结果形状为{N, ...}
+     * @param items 张量
+     * @param pool 不为空且数据量较大时在该线程池上并行复制
+     * @throws std::invalid_argument 列表为空或形状、元素类型不一致时抛出
+     */
+    static TensorData stack(const std::vector<const TensorData*>& items, ThreadPool* pool = nullptr);
+
+    /**
+     * 沿新的第0维拼接一组第0维长度不同的张量（例如长度不同的词元ID序列），
+     * 较短的在末尾用pad_value补齐，结果形状为{N, 最大长度, ...}
+     * @param items 张量，元素类型和第0维以外的形状必须相同，不能是0维张量
+     * @param pad_value 补齐的值，转换为元素类型
+     * @param pool 不为空且数据量较大时在该线程池上并行复制
+     * @throws std::invalid_argument 列表为空或元素类型、形状不一致时抛出
+     */
+    static TensorData padStack(const std::vector<const TensorData*>& items, double pad_value = 0,
+                               ThreadPool* pool = nullptr);
+
+    /**
+     * 计算行优先连续布局的步长
+     */
+    static Shape contiguousStrides(const Shape& shape);
+
+    /**
+     * 计算形状对应的元素个数
+     */
+    static size_t numElements(const Shape& shape);
+
+    /**
+     * 形状的字符串表示，例如"[32, 3, 224, 224]"
+     */
+    static std::string shapeString(const Shape& shape);
+
+protected:
+    /**
+     * 创建供clone()使用的副本：只读数据且生命周期有保证时共享，否则深拷贝
+     */
+    TensorData duplicate() const;
+
+private:
+    void setLayout(Shape shape, Shape strides);
+    void checkType(DType requested) const;
+
+    DType dtype_ = DType::UInt8;
+    Shape shape_{0};
+    Shape strides_{1};
+
+    // 当前数据的起始地址，指向以下存储之一
+    const unsigned char* data_ = nullptr;
+    bool writable_ = true;
+
+    // 池化存储
+    PooledBuffer buffer_;
+
+    // 映射文件切片
+    MappedBuffer view_;
+
+    // 外部内存的所有者
+    std::shared_ptr<const void> owner_;
+};
+
+/**
+ * 命名张量集合 - 一个样本或批次的多个字段，例如{"input_ids", "label"}
+ * 字段按插入顺序保存，字段数通常很少，按名称线性查找
+ */
+class TensorMap : public DataItem {
+public:
+    using Field = std::pair<std::string, TensorData>;
+
+    TensorMap() = default;
+    TensorMap(TensorMap&&) noexcept = default;
+    TensorMap& operator=(TensorMap&&) noexcept = default;
+
+    /**
+     * 设置字段，已存在时替换
+     */
+    void set(const std::string& name, TensorData tensor);
+
+    /**
+     * 查找字段
+     * @return 字段，不存在时返回空
+     */
+    TensorData* find(const std::string& name);
+    const TensorData* find(const std::string& name) const;
+
+    /**
+     * 获取字段
+     * @throws std::out_of_range 字段不存在时抛出
+     */
+    TensorData& get(const std::string& name);
+    const TensorData& get(const std::string& name) const;
+
+    bool contains(const std::string& name) const { return find(name) != nullptr; }
+    size_t size() const { return fields_.size(); }
+    bool empty() const { return fields_.empty(); }
+
+    std::vector<Field>::iterator begin() { return fields_.begin(); }
+    std::vector<Field>::iterator end() { return fields_.end(); }
+    std::vector<Field>::const_iterator begin() const { return fields_.begin(); }
+    std::vector<Field>::const_iterator end() const { return fields_.end(); }
+
+    std::unique_ptr<DataItem> clone() const override;
+
+    /**
+     * 逐字段拼接一组字段名相同的集合，字段顺序与第一个集合相同
+     * @throws std::invalid_argument 列表为空、字段名不一致或某个字段无法拼接时抛出
+     */
+    static TensorMap stack(const std::vector<const TensorMap*>& items, ThreadPool* pool = nullptr);
+
+private:
+    std::vector<Field> fields_;
+};
+
+/**
+ * 默认的批次拼接（collate）函数
+ * 批次中全部为TensorData（包括ImageData）时沿新的第0维拼接为一个TensorData，
+ * 全部为TensorMap时逐字段拼接为一个TensorMap
+ * @param batch 批次
+ * @param pool 不为空时在该线程池上并行复制
+ * @return 拼接结果
+ * @throws std::invalid_argument 批次为空、类型混合或包含不能拼接的数据项（如TextData）时抛出
+ */
+std::unique_ptr<DataItem> collateBatch(const std::vector<std::unique_ptr<DataItem>>& batch, ThreadPool* pool = nullptr);
+
+/**
+ * 补齐的批次拼接函数，用于第0维长度不同的样本（例如按长度分桶的词元ID序列）
+ * 结果为TensorMap：{"data": TensorData::padStack()的结果, "lengths": 每个样本第0维长度的int64张量{N}}
+ * @param batch 批次，全部为TensorData
+ * @param pad_value 补齐的值
+ * @param pool 不为空时在该线程池上并行复制
+ * @throws std::invalid_argument 批次为空、包含不是张量的数据项或无法补齐拼接时抛出
+ */
+std::unique_ptr<DataItem> collatePadded(const std::vector<std::unique_ptr<DataItem>>& batch, double pad_value = 0,
+                                        ThreadPool* pool = nullptr);
+
+#endif // TENSOR_H
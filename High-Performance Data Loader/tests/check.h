@@ -0,0 +1,61 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <exception>
+
+/**
+ * 测试程序使用的最小检查工具：检查失败时打印位置并计数，不中止后续检查；
+ * main()最后返回testResult()，由CTest根据退出码判断是否通过
+ */
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                           \
+    do {                                                                                           \
+        if (!(condition)) {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+            ++testFailures();                                                                      \
+        }                                                                                          \
+    } while (0)
+
+#define CHECK_THROWS(expression, exception_type)                                                   \
+    do {                                                                                           \
+        bool thrown = false;                                                                       \
+        try {                                                                                      \
+            (void)(expression);                                                                    \
+        } catch (const exception_type&) {                                                          \
+            thrown = true;                                                                         \
+        }                                                                                          \
+        if (!thrown) {                                                                             \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #exception_type " from "     \
+                      << #expression << std::endl;                                                 \
+            ++testFailures();                                                                      \
+        }                                                                                          \
+    } while (0)
+
+/**
+ * 运行一组测试，未捕获的异常计为失败
+ */
+template<class Test>
+void runTest(const char* name, Test test) {
+    try {
+        test();
+    } catch (const std::exception& e) {
+        std::cerr << name << ": unexpected exception: " << e.what() << std::endl;
+        ++testFailures();
+    }
+}
+
+inline int testResult() {
+    if (testFailures() > 0) {
+        std::cerr << testFailures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,97 @@
+#include "storage.h"
+#include "fake_hdfs_server.h"
+#include "check.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 测试：HDFSStorage对本地替身服务器的往返读取
+ * 列目录、整个文件读取、区间读取、读入调用方缓冲区，以及块位置查询
+ */
+
+static std::string randomData(size_t size, uint32_t seed) {
+    std::mt19937 engine(seed);
+    std::string data(size, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(engine());
+    }
+    return data;
+}
+
+static std::string toString(const std::vector<unsigned char>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+static std::string toString(const PooledBuffer& data) {
+    return std::string(data.begin(), data.end());
+}
+
+static void testHdfs() {
+    FakeHdfsServer::Options options;
+    options.datanodes = 3;
+    options.replication = 2;
+    options.block_size = 1 << 20;
+    FakeHdfsServer server(options);
+    const std::string small = "hello, hdfs";
+    const std::string large = randomData((3 << 20) + 12345, 2);
+    server.putFile("/data/small.txt", small);
+    server.putFile("/data/large.bin", large);
+    server.putFile("/data/nested/inner.bin", "inner");
+    server.start();
+
+    HDFSConfig config;
+    config.user = "test";
+    config.part_size = 256 << 10;
+    config.max_concurrency = 4;
+    HDFSStorage storage("127.0.0.1", server.port(), config);
+    CHECK(storage.connect());
+    const std::string root = server.uri();
+
+    std::vector<std::string> files = storage.listFiles(root + "/data");
+    std::sort(files.begin(), files.end());
+    CHECK((files == std::vector<std::string>{root + "/data/large.bin", root + "/data/small.txt"}));
+
+    CHECK(storage.fileExists(root + "/data/small.txt"));
+    CHECK(!storage.fileExists(root + "/data/missing.txt"));
+    CHECK(storage.getFileSize(root + "/data/large.bin") == large.size());
+    CHECK(toString(storage.readFile(root + "/data/small.txt")) == small);
+    CHECK_THROWS(storage.readFile(root + "/data/missing.txt"), std::runtime_error);
+
+    // 大文件按数据块边界分段，由多个数据节点提供
+    server.resetStats();
+    CHECK(toString(storage.readFilePooled(root + "/data/large.bin")) == large);
+    size_t serving = 0;
+    for (uint64_t bytes : server.stats().datanode_bytes) {
+        serving += bytes > 0 ? 1 : 0;
+    }
+    CHECK(serving > 1);
+
+    // 跨越数据块边界的区间
+    const uint64_t offset = (1 << 20) - 1000;
+    CHECK(toString(storage.readRange(root + "/data/large.bin", offset, 1 << 20)) == large.substr(offset, 1 << 20));
+    std::vector<unsigned char> buffer(500000);
+    CHECK(storage.readInto(root + "/data/large.bin", 2000000, buffer.data(), buffer.size()) == buffer.size());
+    CHECK(toString(buffer) == large.substr(2000000, buffer.size()));
+
+    // 块位置与替身的副本分布一致
+    std::vector<BlockLocation> blocks = storage.getBlockLocations(root + "/data/large.bin");
+    CHECK(blocks.size() == 4);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        CHECK(blocks[i].offset == i << 20);
+        CHECK(blocks[i].hosts.size() == options.replication);
+        std::vector<size_t> replicas = server.replicas("/data/large.bin", i);
+        for (size_t r = 0; r < replicas.size() && r < blocks[i].hosts.size(); ++r) {
+            CHECK(blocks[i].hosts[r] == "datanode-" + std::to_string(replicas[r]));
+        }
+    }
+    CHECK(blocks.back().length == large.size() - (3 << 20));
+
+    server.stop();
+}
+
+int main() {
+    runTest("hdfs", testHdfs);
+    return testResult();
+}
@@ -0,0 +1,177 @@
+#include "hedged_storage.h"
+#include "fault_injecting_storage.h"
+#include "check.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+/**
+ * 测试：HedgedStorage在FaultInjectingStorage上的对冲与重试
+ * 对冲只在超过截止时间后发出且先完成的请求胜出，只重试暂时性错误，以及对冲预算限制额外请求数
+ */
+
+namespace fs = std::filesystem;
+
+static const std::string kContent = "hedged storage test data";
+
+/**
+ * 临时目录中的一个小文件，测试结束时删除
+ */
+class TempFile {
+public:
+    TempFile() {
+        dir_ = fs::temp_directory_path() / ("hpdl_test_hedged_" + std::to_string(getpid()));
+        fs::create_directories(dir_);
+        path_ = (dir_ / "sample.bin").string();
+        FILE* file = fopen(path_.c_str(), "wb");
+        if (!file || fwrite(kContent.data(), 1, kContent.size(), file) != kContent.size()) {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+        fclose(file);
+    }
+
+    ~TempFile() {
+        std::error_code error;
+        fs::remove_all(dir_, error);
+    }
+
+    const std::string& path() const { return path_; }
+
+private:
+    fs::path dir_;
+    std::string path_;
+};
+
+static std::string toString(const std::vector<unsigned char>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+/**
+ * 构造HedgedStorage，同时返回被包装的FaultInjectingStorage以便检查实际发出的请求数
+ */
+static std::unique_ptr<HedgedStorage> makeStorage(const FaultProfile& profile, const HedgingPolicy& hedging,
+                                                  const RetryPolicy& retry, FaultInjectingStorage*& faults) {
+    auto inner = std::make_unique<FaultInjectingStorage>(std::make_unique<LocalStorage>(), profile);
+    faults = inner.get();
+    return std::make_unique<HedgedStorage>(std::move(inner), hedging, retry, 8);
+}
+
+static void testHedgeAfterDeadline(const TempFile& file) {
+    FaultProfile profile;
+    profile.latency = std::chrono::milliseconds(2);
+    profile.jitter = 0.0;
+    profile.slow_latency = std::chrono::milliseconds(500);
+
+    HedgingPolicy hedging;
+    hedging.initial_delay = std::chrono::milliseconds(50);
+    hedging.min_samples = 1000000;
+    RetryPolicy retry;
+    retry.max_attempts = 1;
+
+    // 在截止时间内完成的读取不会被对冲
+    {
+        FaultInjectingStorage* faults = nullptr;
+        auto storage = makeStorage(profile, hedging, retry, faults);
+        CHECK(toString(storage->readFile(file.path())) == kContent);
+        CHECK(storage->stats().hedges == 0);
+        CHECK(faults->stats().reads == 1);
+    }
+
+    // 第一个请求很慢：截止时间之后发出额外请求，额外请求先完成并胜出
+    profile.slow_first = 1;
+    FaultInjectingStorage* faults = nullptr;
+    auto storage = makeStorage(profile, hedging, retry, faults);
+    auto start = std::chrono::steady_clock::now();
+    CHECK(toString(storage->readFile(file.path())) == kContent);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(elapsed >= hedging.initial_delay);
+    CHECK(elapsed < profile.slow_latency);
+    HedgedStorage::Stats stats = storage->stats();
+    CHECK(stats.hedges == 1);
+    CHECK(stats.hedge_wins == 1);
+    CHECK(faults->stats().reads == 2);
+    CHECK(faults->stats().slow == 1);
+}
+
+static void testRetry(const TempFile& file) {
+    FaultProfile profile;
+    profile.latency = std::chrono::microseconds(100);
+    profile.jitter = 0.0;
+
+    HedgingPolicy hedging;
+    hedging.enabled = false;
+    RetryPolicy retry;
+    retry.max_attempts = 3;
+    retry.initial_backoff = std::chrono::microseconds(100);
+
+    // 暂时性错误被重试，之后的尝试成功
+    profile.fail_first = 2;
+    {
+        FaultInjectingStorage* faults = nullptr;
+        auto storage = makeStorage(profile, hedging, retry, faults);
+        CHECK(toString(storage->readFile(file.path())) == kContent);
+        CHECK(storage->stats().retries == 2);
+        CHECK(faults->stats().reads == 3);
+    }
+
+    // 每次尝试都失败时，达到max_attempts后抛出最后一次的暂时性错误
+    profile.fail_first = 0;
+    profile.failure_probability = 1.0;
+    {
+        FaultInjectingStorage* faults = nullptr;
+        auto storage = makeStorage(profile, hedging, retry, faults);
+        CHECK_THROWS(storage->readFile(file.path()), TransientStorageError);
+        CHECK(faults->stats().reads == retry.max_attempts);
+        CHECK(storage->stats().failures == 1);
+    }
+
+    // 文件不存在等确定性的错误不重试
+    profile.failure_probability = 0.0;
+    FaultInjectingStorage* faults = nullptr;
+    auto storage = makeStorage(profile, hedging, retry, faults);
+    CHECK_THROWS(storage->readFile(file.path() + ".missing"), std::runtime_error);
+    CHECK(storage->stats().retries == 0);
+    CHECK(faults->stats().reads == 1);
+}
+
+static void testHedgeBudget(const TempFile& file) {
+    // 每个请求都超过截止时间，只有对冲预算限制额外请求数
+    FaultProfile profile;
+    profile.latency = std::chrono::milliseconds(5);
+    profile.jitter = 0.0;
+
+    HedgingPolicy hedging;
+    hedging.initial_delay = std::chrono::microseconds(500);
+    hedging.min_delay = std::chrono::microseconds(500);
+    hedging.min_samples = 1000000;
+    hedging.max_hedges = 1;
+    hedging.max_hedge_ratio = 0.1;
+    RetryPolicy retry;
+    retry.max_attempts = 1;
+
+    FaultInjectingStorage* faults = nullptr;
+    auto storage = makeStorage(profile, hedging, retry, faults);
+    const size_t reads = 60;
+    for (size_t i = 0; i < reads; ++i) {
+        CHECK(toString(storage->readFile(file.path())) == kContent);
+    }
+
+    // 预算为0.1 * 读取数加上少量突发额度（10个）
+    HedgedStorage::Stats stats = storage->stats();
+    CHECK(stats.reads == reads);
+    CHECK(stats.hedges > 0);
+    CHECK(stats.hedges <= static_cast<size_t>(hedging.max_hedge_ratio * reads) + 10);
+    CHECK(faults->stats().reads == reads + stats.hedges);
+}
+
+int main() {
+    TempFile file;
+    runTest("hedge_after_deadline", [&]() { testHedgeAfterDeadline(file); });
+    runTest("retry", [&]() { testRetry(file); });
+    runTest("hedge_budget", [&]() { testHedgeBudget(file); });
+    return testResult();
+}
@@ -0,0 +1,142 @@
+#include "image_ops.h"
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * 测试：图像内核在每个不超过detectedSimdLevel()的SIMD级别上与标量实现的结果一致
+ * 覆盖1到5个通道和奇数宽度（SIMD主循环之后剩余的尾部像素），浮点结果只允许舍入误差，uint8结果最多相差1
+ */
+
+static const int kWidths[] = {1, 3, 7, 15, 17, 31, 33, 65, 129};
+
+/**
+ * 带行间隔的随机图像，行间隔中填充的字节不应影响结果
+ */
+struct TestImage {
+    std::vector<unsigned char> pixels;
+    ImageView view;
+
+    TestImage(int width, int height, int channels, std::mt19937& engine) {
+        size_t stride = static_cast<size_t>(width) * channels + 5;
+        pixels.resize(stride * height);
+        for (auto& pixel : pixels) {
+            pixel = static_cast<unsigned char>(engine());
+        }
+        view = ImageView(pixels.data(), width, height, channels, stride);
+    }
+};
+
+static Normalization makeNormalization(int channels) {
+    Normalization norm;
+    for (int c = 0; c < channels; ++c) {
+        norm.mean.push_back(0.4f + 0.03f * c);
+        norm.stddev.push_back(0.2f + 0.01f * c);
+    }
+    return norm;
+}
+
+static bool closeFloats(const std::vector<float>& expected, const std::vector<float>& actual) {
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (std::fabs(expected[i] - actual[i]) > 1e-4f * std::max(1.0f, std::fabs(expected[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool closeBytes(const std::vector<unsigned char>& expected, const std::vector<unsigned char>& actual) {
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (std::abs(expected[i] - actual[i]) > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 分别以标量实现和level级别运行run，比较两次的输出
+ */
+template<class T, class Run>
+static std::vector<T> runAt(SimdLevel level, size_t size, Run run) {
+    ImageOps::setSimdLevel(level);
+    std::vector<T> out(size);
+    run(out.data());
+    return out;
+}
+
+static void testToChw(SimdLevel level) {
+    std::mt19937 engine(1);
+    for (int channels = 1; channels <= 5; ++channels) {
+        Normalization norm = makeNormalization(channels);
+        for (int width : kWidths) {
+            TestImage image(width, 3, channels, engine);
+            size_t size = static_cast<size_t>(channels) * width * 3;
+            auto run = [&](float* out) { ImageOps::toChw(image.view, out, norm); };
+            CHECK(closeFloats(runAt<float>(SimdLevel::Scalar, size, run), runAt<float>(level, size, run)));
+        }
+    }
+}
+
+static void testFlipHorizontal(SimdLevel level) {
+    std::mt19937 engine(2);
+    for (int channels = 1; channels <= 5; ++channels) {
+        for (int width : kWidths) {
+            TestImage image(width, 3, channels, engine);
+            size_t size = static_cast<size_t>(channels) * width * 3;
+            auto run = [&](unsigned char* out) { ImageOps::flipHorizontal(image.view, out); };
+            // 翻转只移动字节，结果必须完全相同
+            CHECK(runAt<unsigned char>(SimdLevel::Scalar, size, run) == runAt<unsigned char>(level, size, run));
+        }
+    }
+}
+
+static void testCropResize(SimdLevel level) {
+    std::mt19937 engine(3);
+    for (int channels = 1; channels <= 5; ++channels) {
+        Normalization norm = makeNormalization(channels);
+        for (int width : kWidths) {
+            TestImage image(width + 6, 11, channels, engine);
+            CropRect rect{3, 2, width, 7};
+            // 放大、缩小到另一个奇数宽度和保持宽度（只缩放高度）
+            for (int out_width : {width * 2 + 1, std::max(1, width / 2) | 1, width}) {
+                for (bool flip : {false, true}) {
+                    size_t size = static_cast<size_t>(channels) * out_width * 5;
+                    auto bytes = [&](unsigned char* out) {
+                        ImageOps::cropResize(image.view, rect, out_width, 5, flip, out);
+                    };
+                    CHECK(closeBytes(runAt<unsigned char>(SimdLevel::Scalar, size, bytes),
+                                     runAt<unsigned char>(level, size, bytes)));
+                    auto floats = [&](float* out) {
+                        ImageOps::cropResizeToChw(image.view, rect, out_width, 5, flip, out, norm);
+                    };
+                    CHECK(closeFloats(runAt<float>(SimdLevel::Scalar, size, floats),
+                                      runAt<float>(level, size, floats)));
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    const SimdLevel detected = ImageOps::detectedSimdLevel();
+    for (int i = static_cast<int>(SimdLevel::Scalar) + 1; i <= static_cast<int>(detected); ++i) {
+        SimdLevel level = static_cast<SimdLevel>(i);
+        std::cout << "Checking " << ImageOps::simdLevelName(level) << " against scalar" << std::endl;
+        runTest("to_chw", [&]() { testToChw(level); });
+        runTest("flip_horizontal", [&]() { testFlipHorizontal(level); });
+        runTest("crop_resize", [&]() { testCropResize(level); });
+    }
+    ImageOps::setSimdLevel(detected);
+    return testResult();
+}
@@ -0,0 +1,134 @@
+#include "line_reader.h"
+#include "data_loader.h"
+#include "check.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+/**
+ * 测试：LineReader流式读取与TextWindowDataset按窗口切分
+ * 包括跨越窗口的记录、超过窗口大小的记录、CRLF换行、文件末尾没有分隔符的记录，
+ * 以及通过DataLoader加载窗口后取出的记录与原始记录一致
+ */
+
+namespace fs = std::filesystem;
+
+/**
+ * 临时目录中的文本文件，测试结束时删除
+ */
+class TempText {
+public:
+    explicit TempText(const std::string& content) {
+        dir_ = fs::temp_directory_path() / ("hpdl_test_lines_" + std::to_string(getpid()));
+        fs::create_directories(dir_);
+        path_ = (dir_ / "corpus.jsonl").string();
+        FILE* file = fopen(path_.c_str(), "wb");
+        if (!file || fwrite(content.data(), 1, content.size(), file) != content.size()) {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+        fclose(file);
+    }
+
+    ~TempText() {
+        std::error_code error;
+        fs::remove_all(dir_, error);
+    }
+
+    const std::string& path() const { return path_; }
+
+private:
+    fs::path dir_;
+    std::string path_;
+};
+
+// 长度随机的记录，其中有空记录、CRLF结尾的记录和若干超过窗口大小的长记录
+static std::vector<std::string> makeRecords(std::string& content) {
+    std::mt19937 engine(7);
+    std::vector<std::string> records;
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t length = engine() % 10 == 0 ? 5000 + engine() % 3000 : engine() % 200;
+        std::string record = "{\"id\":" + std::to_string(i) + ",\"text\":\"" + std::string(length, 'a' + i % 26) + "\"}";
+        if (i % 97 == 0) {
+            record.clear();
+        }
+        records.push_back(record);
+        content += record;
+        content += i % 5 == 0 ? "\r\n" : "\n";
+    }
+    // 文件末尾没有分隔符的最后一条记录
+    records.push_back("tail");
+    content += "tail";
+    return records;
+}
+
+static void testLineReader(const TempText& file, const std::vector<std::string>& expected) {
+    LineReader reader(file.path(), nullptr, 4096);
+    std::vector<std::string> lines;
+    reader.forEach([&](std::string_view line) {
+        lines.emplace_back(line);
+    });
+    CHECK(lines == expected);
+}
+
+static void testWindows(const TempText& file, const std::vector<std::string>& expected) {
+    for (size_t window : {size_t(37), size_t(4096), size_t(1) << 20}) {
+        TextWindowDataset dataset(nullptr, window);
+        size_t windows = dataset.addFile(file.path());
+        CHECK(windows == (fs::file_size(file.path()) + window - 1) / window);
+        CHECK(dataset.addFile(file.path()) == 0);
+        CHECK(dataset.size() == windows);
+
+        // 按顺序拼接所有窗口中的记录，应与原始记录一致
+        std::vector<std::string> records;
+        PathTable table = dataset.windowTable();
+        for (size_t i = 0; i < table.size(); ++i) {
+            std::string text = dataset.read(table[i]);
+            TextWindowDataset::forEachRecord(text, '\n', [&](std::string_view record) {
+                records.emplace_back(record);
+            });
+        }
+        CHECK(records == expected);
+    }
+    TextWindowDataset dataset(nullptr, 4096);
+    dataset.addFile(file.path());
+    CHECK_THROWS(dataset.read(file.path() + "@100000"), std::runtime_error);
+    CHECK_THROWS(dataset.read("missing.jsonl@0"), std::runtime_error);
+}
+
+static void testLoader(const TempText& file, const std::vector<std::string>& expected) {
+    TextWindowDataset dataset(nullptr, 4096);
+    dataset.addFile(file.path());
+
+    DataLoader loader(dataset.windowTable(), 4, 2, 2, 16, 0);
+    loader.setLoaderFunction([&](const std::string& path) -> std::unique_ptr<DataItem> {
+        return std::make_unique<TextData>(dataset.read(path));
+    });
+
+    std::vector<std::string> records;
+    while (auto batch = loader.getNextBatch()) {
+        for (const auto& item : *batch) {
+            const auto& text = static_cast<const TextData&>(*item);
+            TextWindowDataset::forEachRecord(text.getTextView(), '\n', [&](std::string_view record) {
+                records.emplace_back(record);
+            });
+        }
+    }
+    std::vector<std::string> sorted = expected;
+    std::sort(sorted.begin(), sorted.end());
+    std::sort(records.begin(), records.end());
+    CHECK(records == sorted);
+}
+
+int main() {
+    std::string content;
+    std::vector<std::string> expected = makeRecords(content);
+    TempText file(content);
+    runTest("line_reader", [&]() { testLineReader(file, expected); });
+    runTest("text_windows", [&]() { testWindows(file, expected); });
+    runTest("text_windows_loader", [&]() { testLoader(file, expected); });
+    return testResult();
+}
@@ -0,0 +1,73 @@
+#include "philox.h"
+#include "check.h"
+#include <limits>
+
+/**
+ * 测试：PhiloxRng的分组函数与Random123的已知答案向量一致，以及生成器的复现性和取值范围
+ * 分组函数的任何改动都会改变所有增强的随机序列，必须在这里失败
+ */
+
+static void testKnownAnswers() {
+    // Random123 kat_vectors中philox4x32-10的三组向量
+    CHECK((PhiloxRng::block({0x00000000, 0x00000000, 0x00000000, 0x00000000}, {0x00000000, 0x00000000}) ==
+           PhiloxRng::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    CHECK((PhiloxRng::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}) ==
+           PhiloxRng::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    CHECK((PhiloxRng::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}) ==
+           PhiloxRng::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+static void testStreams() {
+    // 生成器按(密钥=种子, 计数器=块编号|流编号|第二级流编号)逐块输出
+    PhiloxRng rng(0x299f31d0a4093822ULL, 0x13198a2e85a308d3ULL, 0x03707344);
+    PhiloxRng::Counter first = PhiloxRng::block({0, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+    PhiloxRng::Counter second = PhiloxRng::block({1, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+    for (uint32_t value : first) {
+        CHECK(rng() == value);
+    }
+    for (uint32_t value : second) {
+        CHECK(rng() == value);
+    }
+
+    // 相同的(种子, 流)得到相同的序列，不同的流不同
+    PhiloxRng a(42, 7, 1);
+    PhiloxRng b(42, 7, 1);
+    PhiloxRng c(42, 8, 1);
+    bool differs = false;
+    for (int i = 0; i < 64; ++i) {
+        uint32_t value = a();
+        CHECK(b() == value);
+        differs = differs || c() != value;
+    }
+    CHECK(differs);
+}
+
+static void testRanges() {
+    PhiloxRng rng(1, 2);
+    for (int i = 0; i < 10000; ++i) {
+        double u = rng.uniform();
+        CHECK(u >= 0.0 && u < 1.0);
+        CHECK(rng.uniformInt(7u) < 7u);
+        int value = rng.uniformInt(-3, 3);
+        CHECK(value >= -3 && value <= 3);
+    }
+    CHECK(rng.uniformInt(0u) == 0u);
+    CHECK(rng.uniformInt(5, 5) == 5);
+
+    // 覆盖全部int的区间
+    bool negative = false;
+    bool positive = false;
+    for (int i = 0; i < 64; ++i) {
+        int value = rng.uniformInt(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        negative = negative || value < 0;
+        positive = positive || value > 0;
+    }
+    CHECK(negative && positive);
+}
+
+int main() {
+    runTest("known_answers", testKnownAnswers);
+    runTest("streams", testStreams);
+    runTest("ranges", testRanges);
+    return testResult();
+}
@@ -0,0 +1,101 @@
+#include "storage.h"
+#include "fake_s3_server.h"
+#include "check.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 测试：S3Storage对本地替身服务器的往返读取
+ * 列目录、整个文件读取、区间读取、读入调用方缓冲区，以及签名错误的请求被拒绝
+ */
+
+static const char* kAccessKey = "AKIDTEST";
+static const char* kSecretKey = "test-secret-key";
+
+static std::string randomData(size_t size, uint32_t seed) {
+    std::mt19937 engine(seed);
+    std::string data(size, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(engine());
+    }
+    return data;
+}
+
+static std::string toString(const std::vector<unsigned char>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+static std::string toString(const PooledBuffer& data) {
+    return std::string(data.begin(), data.end());
+}
+
+static void testS3() {
+    FakeS3Server::Options options;
+    options.bucket = "test-bucket";
+    options.access_key = kAccessKey;
+    options.secret_key = kSecretKey;
+    FakeS3Server server(options);
+    const std::string small = "hello, s3";
+    const std::string large = randomData(3 << 20, 1);
+    server.putObject("data/small.txt", small);
+    server.putObject("data/large.bin", large);
+    server.putObject("data/nested/inner.bin", "inner");
+    server.putObject("other/file.bin", "other");
+    server.start();
+
+    S3Config config;
+    config.endpoint = server.endpoint();
+    config.path_style = true;
+    config.access_key = kAccessKey;
+    config.secret_key = kSecretKey;
+    config.part_size = 256 << 10;
+    config.max_concurrency = 4;
+    S3Storage storage("test-bucket", config);
+    CHECK(storage.connect());
+
+    // 列目录只返回该层的对象
+    std::vector<std::string> files = storage.listFiles("s3://test-bucket/data");
+    std::sort(files.begin(), files.end());
+    CHECK((files == std::vector<std::string>{"s3://test-bucket/data/large.bin", "s3://test-bucket/data/small.txt"}));
+
+    CHECK(storage.fileExists("s3://test-bucket/data/small.txt"));
+    CHECK(!storage.fileExists("s3://test-bucket/data/missing.txt"));
+    CHECK(storage.getFileSize("s3://test-bucket/data/large.bin") == large.size());
+    CHECK(toString(storage.readFile("s3://test-bucket/data/small.txt")) == small);
+    CHECK(storage.readTextFile("s3://test-bucket/data/small.txt") == small);
+    CHECK_THROWS(storage.readFile("s3://test-bucket/data/missing.txt"), std::runtime_error);
+
+    // 大对象按分段并行读取
+    server.resetStats();
+    CHECK(toString(storage.readFilePooled("s3://test-bucket/data/large.bin")) == large);
+    CHECK(server.stats().range_requests > 1);
+
+    // 区间读取，包括跨分段和越过对象末尾的区间
+    CHECK(toString(storage.readRange("s3://test-bucket/data/large.bin", 1000, 700000)) == large.substr(1000, 700000));
+    CHECK(toString(storage.readRange("s3://test-bucket/data/large.bin", large.size() - 10, 100)) ==
+          large.substr(large.size() - 10));
+    std::vector<unsigned char> buffer(300000);
+    CHECK(storage.readInto("s3://test-bucket/data/large.bin", 123456, buffer.data(), buffer.size()) == buffer.size());
+    CHECK(toString(buffer) == large.substr(123456, buffer.size()));
+    CHECK(server.stats().auth_failures == 0);
+
+    // 密钥错误时签名校验失败
+    S3Config bad_config = config;
+    bad_config.secret_key = "wrong-secret-key";
+    S3Storage bad("test-bucket", bad_config);
+    server.resetStats();
+    CHECK(!bad.connect());
+    CHECK(server.stats().auth_failures > 0);
+    CHECK_THROWS(bad.readFile("s3://test-bucket/data/small.txt"), std::runtime_error);
+
+    // 服务器不可达属于传输层错误，可以重试
+    server.stop();
+    CHECK_THROWS(storage.readFile("s3://test-bucket/data/small.txt"), TransientStorageError);
+}
+
+int main() {
+    runTest("s3", testS3);
+    return testResult();
+}
@@ -11,54 +11,36 @@
 #include <memory>
 #include <atomic>
 #include <stdexcept>
+#include <deque>
+#include <exception>
+#include <algorithm>
+#include <chrono>
 
 /**
  * 线程池类 - 使用现代C++实现的高效线程池
  * 支持任务提交、异步结果获取、动态线程管理
+ * 线程数量可以通过resize()在运行时调整；设置空闲超时后，长时间空闲的线程进入停车状态，
+ * 只在活跃线程不足时被单独唤醒，避免多个线程池共存时空闲线程互相争抢CPU
  */
 class ThreadPool {
 public:
+    class TaskGroup;
+
     /**
      * 构造函数
      * @param num_threads 线程池中的线程数量，默认为硬件线程数
+     * @param idle_timeout 空闲超时时间，工作线程空闲超过该时间后进入停车状态，0表示不停车
      */
-    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency())
-        : stop_(false) {
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency(),
+                        std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0))
+        : stop_(false), num_threads_(0), idle_workers_(0), retire_count_(0), idle_timeout_(idle_timeout) {
         if (num_threads == 0) {
             num_threads = 1; // 确保至少有一个线程
         }
         
         // 创建指定数量的工作线程
-        workers_.reserve(num_threads);
-        for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this] {
-                // 工作线程函数
-                while (true) {
-                    std::function<void()> task;
-                    
-                    { // 锁作用域开始
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        
-                        // 等待任务或停止信号
-                        this->condition_.wait(lock, [this] {
-                            return this->stop_ || !this->tasks_.empty();
-                        });
-                        
-                        // 如果线程池停止且任务队列为空，则退出线程
-                        if (this->stop_ && this->tasks_.empty()) {
-                            return;
-                        }
-                        
-                        // 从队列中获取一个任务
-                        task = std::move(this->tasks_.front());
-                        this->tasks_.pop();
-                    } // 锁作用域结束
-                    
-                    // 执行任务
-                    task();
-                }
-            });
-        }
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        addWorkers(num_threads);
     }
     
     /**
@@ -85,18 +67,20 @@ public:
      * 析构函数 - 停止所有工作线程
      */
     ~ThreadPool() {
+        std::lock_guard<std::mutex> resize_lock(resize_mutex_);
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             stop_ = true;
+            
+            // 通知所有线程，包括处于停车状态的线程
+            condition_.notify_all();
+            wakeParkedWorkers(parked_workers_.size());
         }
         
-        // 通知所有线程
-        condition_.notify_all();
-        
         // 等待所有线程完成
-        for (std::thread& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
             }
         }
     }
@@ -133,20 +117,101 @@ public:
             tasks_.emplace([task]() {
                 (*task)();
             });
+            
+            // 通知一个线程执行任务
+            notifyWorker();
         }
         
-        // 通知一个线程执行任务
-        condition_.notify_one();
-        
         return result;
     }
     
+    /**
+     * 并行执行区间[begin, end)上的循环
+     * 区间被切分为大小约为grain的块，每块调用一次fn(chunk_begin, chunk_end)。
+     * 调用线程会参与执行，因此可以在线程池的工作线程内部（例如预处理函数中）安全调用。
+     * @tparam F 块处理函数类型，签名为void(size_t, size_t)
+     * @param begin 区间起点
+     * @param end 区间终点（不包含）
+     * @param grain 每块的元素数量，0表示根据线程数自动选择
+     * @param fn 块处理函数
+     */
+    template<class F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& fn);
+    
     /**
      * 获取线程池中的线程数量
      * @return 线程数量
      */
     size_t size() const {
-        return workers_.size();
+        return num_threads_;
+    }
+    
+    /**
+     * 在运行时调整线程数量
+     * 增加时立即创建新线程；减少时多余的线程在完成当前任务后退出，不会中断正在执行的任务
+     * @param num_threads 新的线程数量，0会被视为1
+     */
+    void resize(size_t num_threads) {
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+        
+        std::lock_guard<std::mutex> resize_lock(resize_mutex_);
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (stop_) {
+            throw std::runtime_error("Cannot resize stopped ThreadPool");
+        }
+        
+        // 回收已经退出的线程
+        for (auto it = workers_.begin(); it != workers_.end();) {
+            if ((*it)->exited) {
+                (*it)->thread.join();
+                it = workers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        
+        size_t current = num_threads_;
+        if (num_threads > current) {
+            // 优先撤销尚未生效的退出请求，再创建新线程
+            size_t grow = num_threads - current;
+            size_t revoked = std::min(retire_count_, grow);
+            retire_count_ -= revoked;
+            num_threads_ += revoked;
+            addWorkers(grow - revoked);
+        } else if (num_threads < current) {
+            size_t shrink = current - num_threads;
+            retire_count_ += shrink;
+            num_threads_ -= shrink;
+            
+            // 停车的线程最先退出，其余由空闲或完成任务后的线程承担
+            size_t parked = std::min(shrink, parked_workers_.size());
+            wakeParkedWorkers(parked);
+            if (shrink > parked) {
+                condition_.notify_all();
+            }
+        }
+    }
+    
+    /**
+     * 设置空闲超时时间
+     * 工作线程空闲超过该时间后进入停车状态，只有当活跃的空闲线程不足以处理新任务时才被唤醒
+     * @param idle_timeout 空闲超时时间，0表示不停车
+     */
+    void set_idle_timeout(std::chrono::milliseconds idle_timeout) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        idle_timeout_ = idle_timeout;
+        condition_.notify_all();
+    }
+    
+    /**
+     * 获取当前处于停车状态的线程数量
+     * @return 停车线程数量
+     */
+    size_t parked_count() const {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        return parked_workers_.size();
     }
     
     /**
@@ -159,20 +224,328 @@ public:
     }
     
 private:
-    // 工作线程容器
-    std::vector<std::thread> workers_;
+    /**
+     * 提交不需要返回值的内部任务（不创建future）
+     * @param task 任务函数
+     */
+    void post(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (stop_) {
+                throw std::runtime_error("Cannot enqueue task into stopped ThreadPool");
+            }
+            tasks_.emplace(std::move(task));
+            notifyWorker();
+        }
+    }
+    
+    // 工作线程及其停车状态
+    struct Worker {
+        std::thread thread;
+        
+        // 停车时等待的条件变量，每个线程独立，便于精确唤醒
+        std::condition_variable parked_condition;
+        
+        // 唤醒标志，由queue_mutex_保护
+        bool wake = false;
+        
+        // 线程是否已退出，由queue_mutex_保护
+        bool exited = false;
+    };
+    
+    /**
+     * 创建工作线程（调用方需持有queue_mutex_）
+     * @param count 新线程数量
+     */
+    void addWorkers(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto worker = std::make_unique<Worker>();
+            Worker* self = worker.get();
+            worker->thread = std::thread([this, self] {
+                this->workerLoop(self);
+            });
+            workers_.push_back(std::move(worker));
+        }
+        num_threads_ += count;
+    }
+    
+    /**
+     * 工作线程函数
+     * @param self 当前线程的状态
+     */
+    void workerLoop(Worker* self) {
+        while (true) {
+            std::function<void()> task;
+            
+            { // 锁作用域开始
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                
+                while (true) {
+                    // 响应resize()的缩减请求
+                    if (retire_count_ > 0) {
+                        --retire_count_;
+                        self->exited = true;
+                        return;
+                    }
+                    
+                    if (!tasks_.empty()) {
+                        break;
+                    }
+                    
+                    // 如果线程池停止且任务队列为空，则退出线程
+                    if (stop_) {
+                        self->exited = true;
+                        return;
+                    }
+                    
+                    // 等待任务或停止信号
+                    auto ready = [this] {
+                        return this->stop_ || !this->tasks_.empty() || this->retire_count_ > 0;
+                    };
+                    ++idle_workers_;
+                    bool woken = true;
+                    if (idle_timeout_.count() > 0) {
+                        woken = condition_.wait_for(lock, idle_timeout_, ready);
+                    } else {
+                        condition_.wait(lock, ready);
+                    }
+                    --idle_workers_;
+                    
+                    if (!woken) {
+                        // 空闲超时，进入停车状态，直到被notifyWorker()或resize()单独唤醒
+                        parked_workers_.push_back(self);
+                        self->parked_condition.wait(lock, [self] {
+                            return self->wake;
+                        });
+                        self->wake = false;
+                    }
+                }
+                
+                // 从队列中获取一个任务
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            } // 锁作用域结束
+            
+            // 执行任务
+            task();
+        }
+    }
+    
+    /**
+     * 通知一个线程执行新任务（调用方需持有queue_mutex_）
+     * 活跃的空闲线程足够时只通知它们，否则唤醒最近停车的线程
+     */
+    void notifyWorker() {
+        if (idle_workers_ >= tasks_.size() || parked_workers_.empty()) {
+            condition_.notify_one();
+        } else {
+            wakeParkedWorkers(1);
+        }
+    }
+    
+    /**
+     * 唤醒停车的线程（调用方需持有queue_mutex_）
+     * 按后进先出顺序唤醒，最近停车的线程缓存更热
+     * @param count 唤醒数量
+     */
+    void wakeParkedWorkers(size_t count) {
+        for (size_t i = 0; i < count && !parked_workers_.empty(); ++i) {
+            Worker* worker = parked_workers_.back();
+            parked_workers_.pop_back();
+            worker->wake = true;
+            worker->parked_condition.notify_one();
+        }
+    }
+    
+    // 工作线程容器，由resize_mutex_和queue_mutex_共同保护
+    std::vector<std::unique_ptr<Worker>> workers_;
     
     // 任务队列
     std::queue<std::function<void()>> tasks_;
     
-    // 用于保护任务队列的互斥锁
+    // 用于保护任务队列和线程状态的互斥锁
     mutable std::mutex queue_mutex_;
     
+    // 串行化resize()与析构，保证回收线程时不会并发修改workers_
+    std::mutex resize_mutex_;
+    
     // 条件变量，用于线程同步
     std::condition_variable condition_;
     
     // 线程池停止标志
     std::atomic<bool> stop_;
+    
+    // 目标线程数量（不包括等待退出的线程）
+    std::atomic<size_t> num_threads_;
+    
+    // 正在condition_上等待任务的线程数量
+    size_t idle_workers_;
+    
+    // 停车线程栈，栈顶为最近停车的线程
+    std::vector<Worker*> parked_workers_;
+    
+    // 等待退出的线程数量
+    size_t retire_count_;
+    
+    // 空闲超时时间
+    std::chrono::milliseconds idle_timeout_;
+};
+
+/**
+ * 任务组 - 基于ThreadPool的fork/join并行原语
+ * 通过run()提交的任务由线程池的工作线程执行；wait()在等待期间会直接执行
+ * 本组中尚未被工作线程取走的任务，而不是阻塞休眠。因此即使所有工作线程
+ * 都在wait()中，任务组也总能向前推进，不会死锁。
+ */
+class ThreadPool::TaskGroup {
+public:
+    /**
+     * 构造函数
+     * @param pool 执行任务的线程池
+     */
+    explicit TaskGroup(ThreadPool& pool)
+        : pool_(pool), state_(std::make_shared<State>()) {}
+    
+    /**
+     * 禁止拷贝构造函数
+     */
+    TaskGroup(const TaskGroup&) = delete;
+    
+    /**
+     * 禁止赋值操作符
+     */
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    
+    /**
+     * 析构函数 - 等待所有任务完成，忽略未被取出的异常
+     */
+    ~TaskGroup() {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+    
+    /**
+     * 提交任务到任务组
+     * @tparam F 任务函数类型
+     * @param f 任务函数
+     */
+    template<class F>
+    void run(F&& f) {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->pending.emplace_back(std::forward<F>(f));
+            ++state_->unfinished;
+        }
+        
+        // 线程池中的跳板任务只从本组的待执行队列取任务，
+        // 若该任务已被wait()执行，跳板任务直接返回
+        std::shared_ptr<State> state = state_;
+        try {
+            pool_.post([state]() {
+                runOne(*state);
+            });
+        } catch (const std::runtime_error&) {
+            // 线程池已停止，任务留在待执行队列中，由wait()执行
+        }
+    }
+    
+    /**
+     * 等待所有已提交的任务完成
+     * 如果有任务抛出异常，在所有任务完成后重新抛出第一个异常
+     */
+    void wait() {
+        // 帮助执行尚未被工作线程取走的任务
+        while (runOne(*state_)) {
+        }
+        
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->done.wait(lock, [this] {
+            return state_->unfinished == 0;
+        });
+        
+        if (state_->error) {
+            std::exception_ptr error = state_->error;
+            state_->error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+    
+private:
+    // 任务组共享状态，由跳板任务共同持有，保证任务组析构后仍然有效
+    struct State {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::deque<std::function<void()>> pending;
+        size_t unfinished = 0;
+        std::exception_ptr error;
+    };
+    
+    /**
+     * 从待执行队列中取出一个任务并执行
+     * @param state 任务组状态
+     * @return 如果执行了任务则返回true
+     */
+    static bool runOne(State& state) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.pending.empty()) {
+                return false;
+            }
+            task = std::move(state.pending.front());
+            state.pending.pop_front();
+        }
+        
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (error && !state.error) {
+                state.error = error;
+            }
+            if (--state.unfinished == 0) {
+                state.done.notify_all();
+            }
+        }
+        return true;
+    }
+    
+    ThreadPool& pool_;
+    std::shared_ptr<State> state_;
 };
 
+template<class F>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, F&& fn) {
+    if (begin >= end) {
+        return;
+    }
+    
+    const size_t count = end - begin;
+    if (grain == 0) {
+        // 每个线程约分到4块，以便在块耗时不均时平衡负载
+        grain = std::max<size_t>(1, count / (size() * 4));
+    }
+    
+    if (count <= grain) {
+        fn(begin, end);
+        return;
+    }
+    
+    TaskGroup group(*this);
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += grain) {
+        size_t chunk_end = std::min(end, chunk_begin + grain);
+        group.run([&fn, chunk_begin, chunk_end]() {
+            fn(chunk_begin, chunk_end);
+        });
+    }
+    group.wait();
+}
+
 #endif // THREAD_POOL_H
\ No newline at end of file
@@ -0,0 +1,626 @@
+#include "tokenizer.h"
+#include "data_loader.h"
+#include "file_io.h"
+#include "json.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HPDL_HAVE_X86_SIMD 1
+#endif
+
+namespace {
+
+// 一次分类的字节数
+constexpr size_t kBlockSize = 64;
+
+/**
+ * 64字节块的分类结果：第i位表示第i个字节是否为空白（含控制字符）或ASCII标点
+ */
+struct ClassMasks {
+    uint64_t space;
+    uint64_t punct;
+};
+
+using ClassifyFn = ClassMasks (*)(const unsigned char* block);
+
+enum : unsigned char { kWord = 0, kSpace = 1, kPunct = 2 };
+
+struct ClassTable {
+    unsigned char classes[256];
+
+    ClassTable() {
+        for (int c = 0; c < 256; ++c) {
+            if (c <= 0x20 || c == 0x7F) {
+                classes[c] = kSpace;
+            } else if (c < 0x7F && !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+                classes[c] = kPunct;
+            } else {
+                classes[c] = kWord;
+            }
+        }
+    }
+};
+
+const ClassTable kClassTable;
+
+ClassMasks classifyScalar(const unsigned char* block) {
+    ClassMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; ++i) {
+        const unsigned char c = kClassTable.classes[block[i]];
+        masks.space |= static_cast<uint64_t>(c == kSpace) << i;
+        masks.punct |= static_cast<uint64_t>(c == kPunct) << i;
+    }
+    return masks;
+}
+
+#ifdef HPDL_HAVE_X86_SIMD
+// 按有符号字节比较：非ASCII字节（>= 0x80）是负数，不会落入任何ASCII范围。
+// 标点 = 可打印ASCII（0x21-0x7E）中去掉数字和字母（字母按位或0x20后统一为小写再比较）
+
+__attribute__((target("sse2")))
+inline void classify16(__m128i x, uint32_t& space, uint32_t& punct) {
+    const __m128i ctrl = _mm_and_si128(_mm_cmplt_epi8(x, _mm_set1_epi8(0x21)), _mm_cmpgt_epi8(x, _mm_set1_epi8(-1)));
+    const __m128i del = _mm_cmpeq_epi8(x, _mm_set1_epi8(0x7F));
+    const __m128i printable =
+        _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(0x20)), _mm_cmplt_epi8(x, _mm_set1_epi8(0x7F)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('9' + 1)));
+    const __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    const __m128i alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    space = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(ctrl, del)));
+    punct = static_cast<uint32_t>(_mm_movemask_epi8(_mm_andnot_si128(_mm_or_si128(digit, alpha), printable)));
+}
+
+__attribute__((target("sse2")))
+ClassMasks classifySse2(const unsigned char* block) {
+    ClassMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; i += 16) {
+        uint32_t space, punct;
+        classify16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i)), space, punct);
+        masks.space |= static_cast<uint64_t>(space) << i;
+        masks.punct |= static_cast<uint64_t>(punct) << i;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2")))
+ClassMasks classifyAvx2(const unsigned char* block) {
+    ClassMasks masks{0, 0};
+    for (size_t i = 0; i < kBlockSize; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const __m256i ctrl = _mm256_andnot_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(0x20)),
+                                                 _mm256_cmpgt_epi8(x, _mm256_set1_epi8(-1)));
+        const __m256i del = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(0x7F));
+        const __m256i printable = _mm256_andnot_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(0x7E)),
+                                                      _mm256_cmpgt_epi8(x, _mm256_set1_epi8(0x20)));
+        const __m256i digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('9')),
+                                                  _mm256_cmpgt_epi8(x, _mm256_set1_epi8('0' - 1)));
+        const __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        const __m256i alpha = _mm256_andnot_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('z')),
+                                                  _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)));
+        const uint32_t space = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ctrl, del)));
+        const uint32_t punct =
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_andnot_si256(_mm256_or_si256(digit, alpha), printable)));
+        masks.space |= static_cast<uint64_t>(space) << i;
+        masks.punct |= static_cast<uint64_t>(punct) << i;
+    }
+    return masks;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+ClassMasks classifyAvx512(const unsigned char* block) {
+    const __m512i x = _mm512_loadu_si512(block);
+    const __mmask64 ctrl = _mm512_cmplt_epi8_mask(x, _mm512_set1_epi8(0x21)) &
+                           _mm512_cmpgt_epi8_mask(x, _mm512_set1_epi8(-1));
+    const __mmask64 del = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(0x7F));
+    const __mmask64 printable = _mm512_cmpgt_epi8_mask(x, _mm512_set1_epi8(0x20)) &
+                                _mm512_cmplt_epi8_mask(x, _mm512_set1_epi8(0x7F));
+    const __mmask64 digit = _mm512_cmpgt_epi8_mask(x, _mm512_set1_epi8('0' - 1)) &
+                            _mm512_cmplt_epi8_mask(x, _mm512_set1_epi8('9' + 1));
+    const __m512i lower = _mm512_or_si512(x, _mm512_set1_epi8(0x20));
+    const __mmask64 alpha = _mm512_cmpgt_epi8_mask(lower, _mm512_set1_epi8('a' - 1)) &
+                            _mm512_cmplt_epi8_mask(lower, _mm512_set1_epi8('z' + 1));
+    return ClassMasks{ctrl | del, printable & ~(digit | alpha)};
+}
+#endif
+
+SimdLevel detectSimdLevel() {
+#ifdef HPDL_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    // 16字节的分类只用到SSE2指令，但与图像内核共用SimdLevel，这一级按名称要求SSE4.1，
+    // 使simdLevelName()的输出与实际检测的指令集一致；只支持SSE2的CPU使用标量实现
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SimdLevel::SSE4;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+const SimdLevel kDetectedLevel = detectSimdLevel();
+std::atomic<SimdLevel> g_level{kDetectedLevel};
+
+ClassifyFn classifier() {
+#ifdef HPDL_HAVE_X86_SIMD
+    switch (g_level.load(std::memory_order_relaxed)) {
+    case SimdLevel::AVX512:
+        return classifyAvx512;
+    case SimdLevel::AVX2:
+        return classifyAvx2;
+    case SimdLevel::SSE4:
+        return classifySse2;
+    case SimdLevel::Scalar:
+        break;
+    }
+#endif
+    return classifyScalar;
+}
+
+/**
+ * 线程本地的单词切分缓存，只保存最近使用的一个分词器的结果
+ */
+struct WordCache {
+    uint64_t owner = 0;
+    std::unordered_map<std::string, std::vector<int32_t>> words;
+};
+
+WordCache& threadCache(uint64_t owner) {
+    thread_local WordCache cache;
+    if (cache.owner != owner) {
+        cache.words.clear();
+        cache.owner = owner;
+    }
+    return cache;
+}
+
+std::atomic<uint64_t> g_next_serial{1};
+
+inline bool isUtf8Continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+inline size_t utf8Length(unsigned char lead) {
+    return lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+}
+
+void appendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+/**
+ * 按行读取文本文件，去掉行尾的'\r'，忽略末尾的空行
+ */
+std::vector<std::string> readLines(const std::string& path) {
+    std::string text = FileIO::readTextFile(path);
+    std::vector<std::string> lines;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        size_t stop = end > begin && text[end - 1] == '\r' ? end - 1 : end;
+        lines.emplace_back(text, begin, stop - begin);
+        begin = end + 1;
+    }
+    return lines;
+}
+
+} // namespace
+
+// PreTokenizer实现
+
+void PreTokenizer::split(std::string_view text, std::vector<Piece>& pieces) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    const ClassifyFn classify = classifier();
+
+    // 单词字节的位掩码中，0到1的跳变是单词开头，1到0的跳变是单词结尾的下一个位置；
+    // carry是上一个块最后一个字节是否属于单词
+    uint64_t carry = 0;
+    size_t word_start = 0;
+    auto push = [&](size_t offset, size_t length) {
+        pieces.push_back(Piece{static_cast<uint32_t>(offset), static_cast<uint32_t>(length),
+                               offset > 0 && data[offset - 1] == ' '});
+    };
+    for (size_t base = 0; base < size; base += kBlockSize) {
+        ClassMasks masks;
+        if (size - base >= kBlockSize) {
+            masks = classify(data + base);
+        } else {
+            // 最后不足一块的部分用空格补齐，补齐的字节不属于任何片段
+            unsigned char tail[kBlockSize];
+            memset(tail, ' ', kBlockSize);
+            memcpy(tail, data + base, size - base);
+            masks = classify(tail);
+        }
+        const uint64_t word = ~(masks.space | masks.punct);
+        const uint64_t previous = word << 1 | carry;
+        const uint64_t starts = word & ~previous;
+        const uint64_t ends = ~word & previous;
+        uint64_t events = starts | ends | masks.punct;
+        while (events) {
+            const int bit = __builtin_ctzll(events);
+            const uint64_t mask = uint64_t(1) << bit;
+            const size_t pos = base + static_cast<size_t>(bit);
+            if (ends & mask) {
+                push(word_start, pos - word_start);
+            }
+            if (starts & mask) {
+                word_start = pos;
+            }
+            if (masks.punct & mask) {
+                push(pos, 1);
+            }
+            events &= events - 1;
+        }
+        carry = word >> 63;
+    }
+    if (carry) {
+        push(word_start, size - word_start);
+    }
+}
+
+SimdLevel PreTokenizer::simdLevel() {
+    return g_level.load(std::memory_order_relaxed);
+}
+
+SimdLevel PreTokenizer::setSimdLevel(SimdLevel level) {
+    level = std::min(level, kDetectedLevel);
+    g_level.store(level, std::memory_order_relaxed);
+    return level;
+}
+
+// Tokenizer实现
+
+Tokenizer::Tokenizer(std::vector<std::string> tokens, TokenizerOptions options, bool require_unk)
+    : tokens_(std::move(tokens)), options_(std::move(options)), serial_(g_next_serial.fetch_add(1)) {
+    if (options_.dtype != DType::Int32 && options_.dtype != DType::Int64) {
+        throw std::invalid_argument(std::string("Tokenizer output dtype must be int32 or int64, got ") +
+                                    dtypeName(options_.dtype));
+    }
+    if (tokens_.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        throw std::invalid_argument("Tokenizer vocabulary is too large");
+    }
+    ids_.reserve(tokens_.size());
+    for (size_t id = 0; id < tokens_.size(); ++id) {
+        if (!tokens_[id].empty()) {
+            ids_.emplace(tokens_[id], static_cast<int32_t>(id));
+            max_token_bytes_ = std::max(max_token_bytes_, tokens_[id].size());
+        }
+    }
+
+    auto special = [this](const std::string& token) {
+        if (token.empty()) {
+            return -1;
+        }
+        int32_t id = tokenToId(token);
+        if (id < 0) {
+            throw std::runtime_error("Special token '" + token + "' is not in the vocabulary");
+        }
+        return id;
+    };
+    unk_id_ = tokenToId(options_.unk_token);
+    if (require_unk) {
+        unk_id_ = special(options_.unk_token);
+    }
+    bos_id_ = special(options_.bos_token);
+    eos_id_ = special(options_.eos_token);
+}
+
+std::unique_ptr<Tokenizer> Tokenizer::wordPiece(const std::string& vocab_path, const TokenizerOptions& options) {
+    return std::make_unique<WordPieceTokenizer>(readLines(vocab_path), options);
+}
+
+std::unique_ptr<Tokenizer> Tokenizer::bpe(const std::string& vocab_path, const std::string& merges_path,
+                                          const TokenizerOptions& options) {
+    JsonValue vocab = JsonValue::parse(FileIO::readTextFile(vocab_path));
+    if (!vocab.isObject()) {
+        throw std::runtime_error("BPE vocabulary must be a JSON object: " + vocab_path);
+    }
+    std::vector<std::string> tokens;
+    for (const auto& entry : vocab.asObject()) {
+        const uint64_t id = entry.second.asUint();
+        if (id >= static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+            throw std::runtime_error("BPE token id out of range in " + vocab_path + ": " + entry.first);
+        }
+        if (id >= tokens.size()) {
+            tokens.resize(id + 1);
+        }
+        if (!tokens[id].empty()) {
+            throw std::runtime_error("Duplicate BPE token id " + std::to_string(id) + " in " + vocab_path);
+        }
+        tokens[id] = entry.first;
+    }
+
+    std::vector<std::pair<std::string, std::string>> merges;
+    std::vector<std::string> lines = readLines(merges_path);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const std::string& line = lines[i];
+        if (line.empty() || line.compare(0, 8, "#version") == 0) {
+            continue;
+        }
+        size_t space = line.find(' ');
+        if (space == std::string::npos || space == 0 || space + 1 >= line.size()) {
+            throw std::runtime_error("Invalid BPE merge at " + merges_path + ":" + std::to_string(i + 1));
+        }
+        merges.emplace_back(line.substr(0, space), line.substr(space + 1));
+    }
+    return std::make_unique<BpeTokenizer>(std::move(tokens), merges, options);
+}
+
+int32_t Tokenizer::tokenToId(std::string_view token) const {
+    auto it = ids_.find(token);
+    return it == ids_.end() ? -1 : it->second;
+}
+
+void Tokenizer::encode(std::string_view text, std::vector<int32_t>& ids) const {
+    const size_t first = ids.size();
+    const size_t specials = (bos_id_ >= 0) + (eos_id_ >= 0);
+    size_t limit = std::numeric_limits<size_t>::max();
+    if (options_.max_length > 0) {
+        limit = options_.max_length > specials ? options_.max_length - specials : 0;
+    }
+    if (bos_id_ >= 0) {
+        ids.push_back(bos_id_);
+    }
+    const size_t content = ids.size();
+
+    thread_local std::vector<PreTokenizer::Piece> pieces;
+    thread_local std::string lowered;
+    thread_local std::string key;
+    pieces.clear();
+    PreTokenizer::split(text, pieces);
+
+    WordCache* cache = options_.cache_words > 0 ? &threadCache(serial_) : nullptr;
+    for (const auto& piece : pieces) {
+        if (ids.size() - content >= limit) {
+            break;
+        }
+        std::string_view word = text.substr(piece.offset, piece.length);
+        if (options_.lowercase) {
+            lowered.assign(word);
+            for (char& c : lowered) {
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c + ('a' - 'A'));
+                }
+            }
+            word = lowered;
+        }
+        if (!cache) {
+            encodeWord(word, piece.space_before, ids);
+            continue;
+        }
+
+        key.assign(word);
+        key += piece.space_before ? '\1' : '\0';
+        auto it = cache->words.find(key);
+        if (it != cache->words.end()) {
+            ids.insert(ids.end(), it->second.begin(), it->second.end());
+            continue;
+        }
+        const size_t begin = ids.size();
+        encodeWord(word, piece.space_before, ids);
+        if (cache->words.size() >= options_.cache_words) {
+            cache->words.clear();
+        }
+        cache->words.emplace(key, std::vector<int32_t>(ids.begin() + begin, ids.end()));
+    }
+
+    if (ids.size() - content > limit) {
+        ids.resize(content + limit);
+    }
+    if (eos_id_ >= 0) {
+        ids.push_back(eos_id_);
+    }
+    if (options_.max_length > 0 && ids.size() - first > options_.max_length) {
+        ids.resize(first + options_.max_length);
+    }
+}
+
+std::vector<int32_t> Tokenizer::encode(std::string_view text) const {
+    std::vector<int32_t> ids;
+    encode(text, ids);
+    return ids;
+}
+
+TensorData Tokenizer::encodeToTensor(std::string_view text) const {
+    thread_local std::vector<int32_t> ids;
+    ids.clear();
+    encode(text, ids);
+    if (options_.dtype == DType::Int32) {
+        return TensorData::copyOf(ids.data(), {static_cast<int64_t>(ids.size())});
+    }
+    TensorData tensor(DType::Int64, {static_cast<int64_t>(ids.size())});
+    std::copy(ids.begin(), ids.end(), tensor.getDataAs<int64_t>());
+    return tensor;
+}
+
+std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>)> Tokenizer::processor() const {
+    return [this](std::unique_ptr<DataItem> item) -> std::unique_ptr<DataItem> {
+        const auto* text = dynamic_cast<const TextData*>(item.get());
+        if (!text) {
+            throw std::invalid_argument("Tokenizer can only process TextData items");
+        }
+        return std::make_unique<TensorData>(encodeToTensor(text->getTextView()));
+    };
+}
+
+std::string Tokenizer::decode(const std::vector<int32_t>& ids) const {
+    std::string text;
+    for (int32_t id : ids) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += idToToken(id);
+    }
+    return text;
+}
+
+// WordPieceTokenizer实现
+
+WordPieceTokenizer::WordPieceTokenizer(std::vector<std::string> tokens, const TokenizerOptions& options)
+    : Tokenizer(std::move(tokens), options, true) {
+    const std::string& prefix = options.continuing_subword_prefix;
+    for (size_t id = 0; id < vocabSize(); ++id) {
+        const std::string& token = idToToken(static_cast<int32_t>(id));
+        if (token.size() > prefix.size() && token.compare(0, prefix.size(), prefix) == 0) {
+            continuations_.emplace(std::string_view(token).substr(prefix.size()), static_cast<int32_t>(id));
+        }
+    }
+}
+
+void WordPieceTokenizer::encodeWord(std::string_view word, bool, std::vector<int32_t>& ids) const {
+    if (word.size() > options().max_word_bytes) {
+        ids.push_back(unk_id_);
+        return;
+    }
+    const size_t mark = ids.size();
+    size_t start = 0;
+    while (start < word.size()) {
+        // 从可能的最长子词开始逐个字符缩短，end总是落在UTF-8字符边界上
+        size_t end = std::min(word.size(), start + max_token_bytes_);
+        int32_t found = -1;
+        while (end > start) {
+            while (end < word.size() && end > start && isUtf8Continuation(static_cast<unsigned char>(word[end]))) {
+                --end;
+            }
+            if (end == start) {
+                break;
+            }
+            std::string_view piece = word.substr(start, end - start);
+            if (start == 0) {
+                found = tokenToId(piece);
+            } else {
+                auto it = continuations_.find(piece);
+                found = it == continuations_.end() ? -1 : it->second;
+            }
+            if (found >= 0) {
+                break;
+            }
+            --end;
+        }
+        if (found < 0) {
+            ids.resize(mark);
+            ids.push_back(unk_id_);
+            return;
+        }
+        ids.push_back(found);
+        start = end;
+    }
+}
+
+// BpeTokenizer实现
+
+BpeTokenizer::BpeTokenizer(std::vector<std::string> tokens,
+                           const std::vector<std::pair<std::string, std::string>>& merges,
+                           const TokenizerOptions& options)
+    : Tokenizer(std::move(tokens), options, false) {
+    merges_.reserve(merges.size());
+    for (size_t rank = 0; rank < merges.size(); ++rank) {
+        const auto& merge = merges[rank];
+        int32_t left = tokenToId(merge.first);
+        int32_t right = tokenToId(merge.second);
+        int32_t merged = tokenToId(merge.first + merge.second);
+        if (left < 0 || right < 0 || merged < 0) {
+            throw std::runtime_error("BPE merge '" + merge.first + " " + merge.second +
+                                     "' refers to tokens that are not in the vocabulary");
+        }
+        // 重复的规则以优先级高的为准
+        merges_.emplace(pairKey(left, right), Merge{static_cast<uint32_t>(rank), merged});
+    }
+    for (int byte = 0; byte < 256; ++byte) {
+        byte_ids_[byte] = tokenToId(byteSymbol(static_cast<unsigned char>(byte)));
+    }
+}
+
+const std::string& BpeTokenizer::byteSymbol(unsigned char byte) {
+    // 可打印的Latin-1字符映射为自身，其余字节依次映射到U+0100以后的字符
+    static const std::vector<std::string> symbols = [] {
+        std::vector<std::string> table(256);
+        uint32_t next = 256;
+        for (uint32_t b = 0; b < 256; ++b) {
+            bool printable = (b >= '!' && b <= '~') || (b >= 0xA1 && b <= 0xAC) || (b >= 0xAE);
+            appendUtf8(table[b], printable ? b : next++);
+        }
+        return table;
+    }();
+    return symbols[byte];
+}
+
+void BpeTokenizer::encodeWord(std::string_view word, bool space_before, std::vector<int32_t>& ids) const {
+    thread_local std::vector<int32_t> symbols;
+    thread_local std::string symbol;
+    symbols.clear();
+    if (options().byte_level) {
+        if (space_before) {
+            symbols.push_back(byte_ids_[static_cast<unsigned char>(' ')]);
+        }
+        for (char c : word) {
+            symbols.push_back(byte_ids_[static_cast<unsigned char>(c)]);
+        }
+    } else {
+        const std::string& suffix = options().end_of_word_suffix;
+        for (size_t i = 0; i < word.size();) {
+            size_t length = std::min(utf8Length(static_cast<unsigned char>(word[i])), word.size() - i);
+            symbol.assign(word.substr(i, length));
+            i += length;
+            if (i == word.size()) {
+                symbol += suffix;
+            }
+            symbols.push_back(tokenToId(symbol));
+        }
+    }
+    for (int32_t& id : symbols) {
+        if (id < 0) {
+            id = unk_id_;
+        }
+    }
+
+    // 每轮合并优先级最高（rank最小）的一对相邻符号；单词很短，逐轮扫描比维护优先队列更快
+    while (symbols.size() > 1) {
+        uint32_t best_rank = std::numeric_limits<uint32_t>::max();
+        size_t best = 0;
+        int32_t merged = -1;
+        for (size_t i = 0; i + 1 < symbols.size(); ++i) {
+            if (symbols[i] < 0 || symbols[i + 1] < 0) {
+                continue;
+            }
+            auto it = merges_.find(pairKey(symbols[i], symbols[i + 1]));
+            if (it != merges_.end() && it->second.rank < best_rank) {
+                best_rank = it->second.rank;
+                best = i;
+                merged = it->second.id;
+            }
+        }
+        if (merged < 0) {
+            break;
+        }
+        symbols[best] = merged;
+        symbols.erase(symbols.begin() + static_cast<std::ptrdiff_t>(best) + 1);
+    }
+    for (int32_t id : symbols) {
+        if (id >= 0) {
+            ids.push_back(id);
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include "tensor.h"
+#include "image_ops.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 预切分 - 把文本切分为单词和标点，分词器再对每个单词做子词切分
+ * 规则与BERT的基础切分相同（只区分ASCII字符类别）：
+ * - 空白和控制字符（0x00-0x20、0x7F）是分隔符，不输出
+ * - ASCII标点符号（!"#$%&'()*+,-./:;<=>?@[\]^_`{|}~）各自成为一个片段
+ * - 其余字节（字母、数字和所有非ASCII字节）连续的一段成为一个单词
+ *
+ * 字符分类在x86上按运行时检测到的指令集一次处理64、32或16个字节（AVX-512BW、AVX2、SSE4.1级别），
+ * 得到每个字节是否为空白和标点的位掩码，再由掩码找出片段的边界
+ */
+class PreTokenizer {
+public:
+    /**
+     * 片段在文本中的位置
+     */
+    struct Piece {
+        uint32_t offset;
+        uint32_t length;
+
+        // 片段前面紧挨着一个空格（字节级BPE据此在单词前加上空格符号）
+        bool space_before;
+    };
+
+    /**
+     * 切分文本
+     * @param text 文本，长度不超过4GB
+     * @param pieces 输出参数，片段依次追加到末尾
+     */
+    static void split(std::string_view text, std::vector<Piece>& pieces);
+
+    /**
+     * 获取当前使用的指令级别
+     */
+    static SimdLevel simdLevel();
+
+    /**
+     * 设置使用的指令级别，用于性能对比；超过CPU支持的级别时使用支持的最高级别
+     * @return 实际使用的级别
+     */
+    static SimdLevel setSimdLevel(SimdLevel level);
+};
+
+/**
+ * 分词器选项
+ */
+struct TokenizerOptions {
+    // 是否把ASCII大写字母转换为小写（对应uncased模型）
+    bool lowercase = false;
+
+    // 未登录词的词元
+    std::string unk_token = "[UNK]";
+
+    // 非空时加在序列开头和末尾的词元，例如BERT的"[CLS]"和"[SEP]"
+    std::string bos_token;
+    std::string eos_token;
+
+    // 输出的最大词元数（包括首尾词元），超过时截断；0表示不截断
+    size_t max_length = 0;
+
+    // 输出张量的元素类型，Int32或Int64
+    DType dtype = DType::Int32;
+
+    // 每个线程缓存的单词切分结果数量，缓存满时清空；0表示不缓存
+    size_t cache_words = 1 << 16;
+
+    // WordPiece：后续子词的前缀
+    std::string continuing_subword_prefix = "##";
+
+    // WordPiece：超过该字节数的单词直接作为未登录词
+    size_t max_word_bytes = 200;
+
+    // BPE：是否为字节级BPE（GPT-2、RoBERTa），单词的每个字节映射为一个可打印字符，不会产生未登录词
+    bool byte_level = true;
+
+    // BPE：非字节级时加在单词最后一个符号上的后缀，例如"</w>"
+    std::string end_of_word_suffix;
+};
+
+/**
+ * 分词器 - 把文本编码为词元ID，直接输出张量
+ * 文本先由PreTokenizer切分为单词，每个单词再由派生类切分为子词。
+ * 单词的切分结果缓存在线程本地的缓存中（自然语言中高频词占绝大多数），
+ * 多个预处理线程同时编码时不需要加锁。
+ *
+ * 词表在构造后只读，一个分词器实例可以被多个线程同时使用
+ */
+class Tokenizer {
+public:
+    virtual ~Tokenizer() = default;
+
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
+    /**
+     * 从vocab.txt（每行一个词元，行号为ID）加载WordPiece分词器（BERT）
+     * @throws std::runtime_error 文件无法读取或词表中没有unk_token时抛出
+     */
+    static std::unique_ptr<Tokenizer> wordPiece(const std::string& vocab_path,
+                                                const TokenizerOptions& options = TokenizerOptions());
+
+    /**
+     * 从vocab.json（词元到ID的映射）和merges.txt（每行一个合并规则"a b"，按优先级排列）加载BPE分词器
+     * @throws std::runtime_error 文件无法读取、格式不正确或合并规则引用了词表中没有的词元时抛出
+     */
+    static std::unique_ptr<Tokenizer> bpe(const std::string& vocab_path, const std::string& merges_path,
+                                          const TokenizerOptions& options = TokenizerOptions());
+
+    /**
+     * 把文本编码为词元ID
+     * @param text 文本
+     * @param ids 输出参数，词元ID依次追加到末尾
+     */
+    void encode(std::string_view text, std::vector<int32_t>& ids) const;
+
+    std::vector<int32_t> encode(std::string_view text) const;
+
+    /**
+     * 把文本编码为形状为{词元数}的张量，元素类型为options().dtype
+     */
+    TensorData encodeToTensor(std::string_view text) const;
+
+    /**
+     * 创建把TextData编码为词元ID张量的预处理函数，可以直接传给DataLoader::setProcessorFunction()
+     * 分词器的生命周期必须长于DataLoader
+     */
+    std::function<std::unique_ptr<DataItem>(std::unique_ptr<DataItem>)> processor() const;
+
+    /**
+     * 把词元ID解码为以空格分隔的词元（用于调试）
+     */
+    std::string decode(const std::vector<int32_t>& ids) const;
+
+    /**
+     * 查找词元的ID
+     * @return ID，不在词表中时返回-1
+     */
+    int32_t tokenToId(std::string_view token) const;
+
+    /**
+     * 获取ID对应的词元
+     * @throws std::out_of_range ID越界时抛出
+     */
+    const std::string& idToToken(int32_t id) const { return tokens_.at(static_cast<size_t>(id)); }
+
+    size_t vocabSize() const { return tokens_.size(); }
+    const TokenizerOptions& options() const { return options_; }
+
+protected:
+    /**
+     * 构造函数
+     * @param tokens 词表，下标为ID，不能有重复
+     * @param options 选项
+     * @param require_unk 词表中必须包含unk_token
+     */
+    Tokenizer(std::vector<std::string> tokens, TokenizerOptions options, bool require_unk);
+
+    /**
+     * 把一个单词切分为子词
+     * @param word 单词（已按选项转换为小写）
+     * @param space_before 单词前面紧挨着一个空格
+     * @param ids 输出参数，子词ID依次追加到末尾
+     */
+    virtual void encodeWord(std::string_view word, bool space_before, std::vector<int32_t>& ids) const = 0;
+
+    // 未登录词的ID，词表中没有unk_token时为-1
+    int32_t unk_id_ = -1;
+
+    // 最长词元的字节数
+    size_t max_token_bytes_ = 0;
+
+private:
+    std::vector<std::string> tokens_;
+    std::unordered_map<std::string_view, int32_t> ids_;
+    TokenizerOptions options_;
+    int32_t bos_id_ = -1;
+    int32_t eos_id_ = -1;
+
+    // 区分线程本地缓存属于哪个分词器实例（地址可能被复用，所以不用this）
+    uint64_t serial_;
+};
+
+/**
+ * WordPiece分词器（BERT）：从单词开头起每次取词表中最长的前缀，后续子词带有"##"前缀；
+ * 某一位置找不到任何子词时整个单词作为未登录词
+ */
+class WordPieceTokenizer : public Tokenizer {
+public:
+    WordPieceTokenizer(std::vector<std::string> tokens, const TokenizerOptions& options);
+
+protected:
+    void encodeWord(std::string_view word, bool space_before, std::vector<int32_t>& ids) const override;
+
+private:
+    // 去掉前缀后的后续子词到ID的映射，查找时不需要拼接前缀
+    std::unordered_map<std::string_view, int32_t> continuations_;
+};
+
+/**
+ * BPE分词器：单词先拆成字节（字节级）或UTF-8字符，再按合并规则的优先级反复合并相邻的一对符号，
+ * 直到没有可以合并的符号对
+ */
+class BpeTokenizer : public Tokenizer {
+public:
+    /**
+     * 构造函数
+     * @param tokens 词表，下标为ID
+     * @param merges 合并规则，按优先级从高到低排列
+     * @throws std::runtime_error 合并规则引用了词表中没有的词元时抛出
+     */
+    BpeTokenizer(std::vector<std::string> tokens, const std::vector<std::pair<std::string, std::string>>& merges,
+                 const TokenizerOptions& options);
+
+    /**
+     * 字节级BPE中字节对应的可打印字符（UTF-8编码），与GPT-2的bytes_to_unicode相同，例如空格为"Ġ"
+     */
+    static const std::string& byteSymbol(unsigned char byte);
+
+protected:
+    void encodeWord(std::string_view word, bool space_before, std::vector<int32_t>& ids) const override;
+
+private:
+    struct Merge {
+        uint32_t rank;
+        int32_t id;
+    };
+
+    static uint64_t pairKey(int32_t left, int32_t right) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(left)) << 32 | static_cast<uint32_t>(right);
+    }
+
+    // (左符号ID, 右符号ID) -> 合并优先级和合并后的ID
+    std::unordered_map<uint64_t, Merge> merges_;
+
+    // 字节级BPE中每个字节对应的符号ID
+    int32_t byte_ids_[256];
+};
+
+#endif // TOKENIZER_H
@@ -0,0 +1,59 @@
+#include "fake_hdfs_server.h"
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <unistd.h>
+
+/**
+ * 本地HDFS替身服务器：把一个目录作为HDFS文件系统提供（WebHDFS），用于在没有HDFS的环境中测试HDFSStorage
+ * 用法：fake_hdfs <目录> [名称节点端口] [数据节点数] [块大小MiB]
+ *
+ * 示例：
+ *   fake_hdfs ./data 9870 3 64
+ *   路径hdfs://127.0.0.1:9870/<相对路径>对应目录下的文件
+ */
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void onSignal(int) {
+    g_stop = 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <root_dir> [namenode_port] [datanodes] [block_size_mib]" << std::endl;
+        return 1;
+    }
+
+    FakeHdfsServer::Options options;
+    options.root_dir = argv[1];
+    options.port = argc > 2 ? std::stoi(argv[2]) : 9870;
+    if (argc > 3) {
+        options.datanodes = std::stoul(argv[3]);
+    }
+    if (argc > 4) {
+        options.block_size = std::stoull(argv[4]) << 20;
+    }
+
+    try {
+        FakeHdfsServer server(options);
+        server.start();
+        std::cout << "Serving " << options.root_dir << " at " << server.uri() << " with " << options.datanodes
+                  << " data nodes, " << (options.block_size >> 20) << " MiB blocks" << std::endl;
+
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        while (!g_stop) {
+            pause();
+        }
+
+        FakeHdfsServer::Stats stats = server.stats();
+        std::cout << "\n" << stats.namenode_requests << " namenode requests, " << stats.datanode_requests
+                  << " datanode requests on " << stats.connections << " connections, " << stats.bytes_sent
+                  << " bytes sent" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
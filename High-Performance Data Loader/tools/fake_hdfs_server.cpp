@@ -0,0 +1,379 @@
+#include "fake_hdfs_server.h"
+#include "json.h"
+#include "sigv4.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+FakeHttpResponse remoteException(int status, const std::string& exception, const std::string& message) {
+    FakeHttpResponse response;
+    response.status = status;
+    response.headers = {{"Content-Type", "application/json"}};
+    response.body = "{\"RemoteException\":{\"exception\":" + JsonValue::quote(exception) +
+                    ",\"javaClassName\":" + JsonValue::quote("java.io." + exception) +
+                    ",\"message\":" + JsonValue::quote(message) + "}}";
+    return response;
+}
+
+FakeHttpResponse json(const std::string& body) {
+    FakeHttpResponse response;
+    response.headers = {{"Content-Type", "application/json"}};
+    response.body = body;
+    return response;
+}
+
+// 解析非负整数参数，缺省时返回fallback
+bool numberParam(const FakeHttpRequest& request, const std::string& name, uint64_t fallback, uint64_t& value) {
+    std::string text = request.param(name);
+    if (text.empty()) {
+        value = fallback;
+        return true;
+    }
+    try {
+        size_t used = 0;
+        value = std::stoull(text, &used);
+        return used == text.size() && text[0] != '-';
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+struct FakeHdfsServer::Node {
+    bool directory = false;
+    uint64_t length = 0;
+    // 内存文件的内容；目录模式下为空，从file读取
+    std::shared_ptr<const std::string> data;
+    std::string file;
+};
+
+FakeHdfsServer::FakeHdfsServer(const Options& options) : options_(options) {
+    options_.datanodes = std::max<size_t>(options_.datanodes, 1);
+    options_.replication = std::min(std::max<size_t>(options_.replication, 1), options_.datanodes);
+    options_.block_size = std::max<uint64_t>(options_.block_size, 1);
+    options_.list_limit = std::max<size_t>(options_.list_limit, 1);
+
+    FakeHttpServer::Options http;
+    http.latency_ms = options_.latency_ms;
+    http.connect_latency_ms = options_.connect_latency_ms;
+    http.bandwidth = options_.bandwidth;
+    http.keep_alive = options_.keep_alive;
+    http.max_requests_per_connection = options_.max_requests_per_connection;
+    for (size_t i = 0; i < options_.datanodes; ++i) {
+        datanodes_.push_back(std::make_unique<FakeHttpServer>(
+            http, [this](const FakeHttpRequest& request) { return handleDatanode(request); }));
+    }
+    http.port = options_.port;
+    namenode_ = std::make_unique<FakeHttpServer>(
+        http, [this](const FakeHttpRequest& request) { return handleNamenode(request); });
+}
+
+FakeHdfsServer::~FakeHdfsServer() {
+    stop();
+}
+
+void FakeHdfsServer::start() {
+    for (auto& datanode : datanodes_) {
+        datanode->start();
+    }
+    namenode_->start();
+}
+
+void FakeHdfsServer::stop() {
+    namenode_->stop();
+    for (auto& datanode : datanodes_) {
+        datanode->stop();
+    }
+}
+
+void FakeHdfsServer::putFile(const std::string& path, std::string data) {
+    auto node = std::make_shared<Node>();
+    node->length = data.size();
+    node->data = std::make_shared<const std::string>(std::move(data));
+    std::lock_guard<std::mutex> lock(files_mutex_);
+    files_[path.compare(0, 1, "/") == 0 ? path : "/" + path] = std::move(node);
+}
+
+std::vector<size_t> FakeHdfsServer::replicas(const std::string& path, uint64_t block) const {
+    // 第一个副本由路径的哈希和块号决定，其余副本依次放在后面的数据节点上
+    size_t first = (std::hash<std::string>()(path) + static_cast<size_t>(block)) % options_.datanodes;
+    std::vector<size_t> nodes;
+    for (size_t r = 0; r < options_.replication; ++r) {
+        nodes.push_back((first + r) % options_.datanodes);
+    }
+    return nodes;
+}
+
+FakeHdfsServer::Stats FakeHdfsServer::stats() const {
+    Stats stats;
+    FakeHttpServer::Stats namenode = namenode_->stats();
+    stats.connections = namenode.connections;
+    stats.namenode_requests = namenode.requests;
+    stats.redirects = redirects_.load();
+    for (const auto& datanode : datanodes_) {
+        FakeHttpServer::Stats http = datanode->stats();
+        stats.connections += http.connections;
+        stats.datanode_requests += http.requests;
+        stats.bytes_sent += http.bytes_sent;
+        stats.datanode_bytes.push_back(http.bytes_sent);
+    }
+    return stats;
+}
+
+void FakeHdfsServer::resetStats() {
+    namenode_->resetStats();
+    for (auto& datanode : datanodes_) {
+        datanode->resetStats();
+    }
+    redirects_ = 0;
+}
+
+std::shared_ptr<const FakeHdfsServer::Node> FakeHdfsServer::findNode(const std::string& path) const {
+    if (options_.root_dir.empty()) {
+        auto directory = std::make_shared<Node>();
+        directory->directory = true;
+        if (path == "/") {
+            return directory;
+        }
+        std::lock_guard<std::mutex> lock(files_mutex_);
+        auto it = files_.find(path);
+        if (it != files_.end()) {
+            return it->second;
+        }
+        // 内存文件的目录由路径前缀隐含
+        std::string prefix = path + "/";
+        it = files_.lower_bound(prefix);
+        if (it != files_.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+            return directory;
+        }
+        return nullptr;
+    }
+
+    if (path.find("..") != std::string::npos) {
+        return nullptr;
+    }
+    std::error_code error;
+    fs::path local = fs::path(options_.root_dir) / path.substr(1);
+    fs::file_status status = fs::status(local, error);
+    if (error || !fs::exists(status)) {
+        return nullptr;
+    }
+    auto node = std::make_shared<Node>();
+    node->directory = fs::is_directory(status);
+    if (!node->directory) {
+        node->file = local.string();
+        node->length = fs::file_size(local, error);
+    }
+    return node;
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<const FakeHdfsServer::Node>>> FakeHdfsServer::children(
+    const std::string& path) const {
+    std::vector<std::pair<std::string, std::shared_ptr<const Node>>> entries;
+    std::string prefix = path == "/" ? path : path + "/";
+    if (options_.root_dir.empty()) {
+        std::lock_guard<std::mutex> lock(files_mutex_);
+        for (auto it = files_.lower_bound(prefix); it != files_.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+             ++it) {
+            size_t slash = it->first.find('/', prefix.size());
+            std::string name = it->first.substr(prefix.size(), slash == std::string::npos ? std::string::npos
+                                                                                         : slash - prefix.size());
+            if (!entries.empty() && entries.back().first == name) {
+                continue;
+            }
+            if (slash == std::string::npos) {
+                entries.emplace_back(name, it->second);
+            } else {
+                auto directory = std::make_shared<Node>();
+                directory->directory = true;
+                entries.emplace_back(name, directory);
+            }
+        }
+    } else {
+        std::error_code error;
+        for (auto it = fs::directory_iterator(fs::path(options_.root_dir) / path.substr(1), error);
+             !error && it != fs::directory_iterator(); it.increment(error)) {
+            auto node = std::make_shared<Node>();
+            node->directory = it->is_directory(error);
+            if (!node->directory) {
+                node->file = it->path().string();
+                node->length = it->file_size(error);
+            }
+            entries.emplace_back(it->path().filename().string(), node);
+        }
+    }
+    // 按名称排序；内存文件按完整路径排序时，"a.txt"排在目录"a/"之前
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return entries;
+}
+
+std::string FakeHdfsServer::fileStatusJson(const std::string& suffix, const Node& node) const {
+    return "{\"pathSuffix\":" + JsonValue::quote(suffix) + ",\"type\":\"" + (node.directory ? "DIRECTORY" : "FILE") +
+           "\",\"length\":" + std::to_string(node.length) +
+           ",\"blockSize\":" + std::to_string(node.directory ? 0 : options_.block_size) +
+           ",\"replication\":" + std::to_string(node.directory ? 0 : options_.replication) +
+           ",\"owner\":\"hdfs\",\"group\":\"supergroup\",\"permission\":\"" + (node.directory ? "755" : "644") +
+           "\",\"accessTime\":0,\"modificationTime\":0}";
+}
+
+FakeHttpResponse FakeHdfsServer::listStatus(const std::string& path, const FakeHttpRequest& request, bool batch) {
+    std::shared_ptr<const Node> node = findNode(path);
+    if (!node) {
+        return remoteException(404, "FileNotFoundException", "File " + path + " does not exist.");
+    }
+    std::vector<std::pair<std::string, std::shared_ptr<const Node>>> entries;
+    if (node->directory) {
+        entries = children(path);
+    } else {
+        // 列出文件时返回文件本身，pathSuffix为空
+        entries.emplace_back("", node);
+    }
+
+    std::string start_after = request.param("startAfter");
+    size_t begin = 0;
+    if (batch && !start_after.empty()) {
+        begin = static_cast<size_t>(std::upper_bound(entries.begin(), entries.end(), start_after,
+                                                     [](const std::string& name, const auto& entry) {
+                                                         return name < entry.first;
+                                                     }) -
+                                    entries.begin());
+    }
+    size_t end = batch ? std::min(entries.size(), begin + options_.list_limit) : entries.size();
+
+    std::string statuses;
+    for (size_t i = begin; i < end; ++i) {
+        statuses += (i == begin ? "" : ",") + fileStatusJson(entries[i].first, *entries[i].second);
+    }
+    std::string list = "{\"FileStatuses\":{\"FileStatus\":[" + statuses + "]}";
+    if (!batch) {
+        return json(list + "}");
+    }
+    return json("{\"DirectoryListing\":{\"partialListing\":" + list +
+                "},\"remainingEntries\":" + std::to_string(entries.size() - end) + "}}");
+}
+
+FakeHttpResponse FakeHdfsServer::blockLocations(const std::string& path, const Node& node,
+                                                const FakeHttpRequest& request) {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    if (!numberParam(request, "offset", 0, offset) || !numberParam(request, "length", node.length, length)) {
+        return remoteException(400, "IllegalArgumentException", "Invalid offset or length");
+    }
+    uint64_t end = std::min(node.length, offset + std::min(length, UINT64_MAX - offset));
+
+    std::string blocks;
+    for (uint64_t block = offset / options_.block_size; block * options_.block_size < end; ++block) {
+        uint64_t block_offset = block * options_.block_size;
+        uint64_t block_length = std::min(options_.block_size, node.length - block_offset);
+        std::string hosts;
+        std::string names;
+        for (size_t replica : replicas(path, block)) {
+            hosts += std::string(hosts.empty() ? "" : ",") + "\"datanode-" + std::to_string(replica) + "\"";
+            names += std::string(names.empty() ? "" : ",") + "\"127.0.0.1:" +
+                     std::to_string(datanodes_[replica]->port()) + "\"";
+        }
+        blocks += std::string(blocks.empty() ? "" : ",") + "{\"offset\":" + std::to_string(block_offset) +
+                  ",\"length\":" + std::to_string(block_length) + ",\"hosts\":[" + hosts + "],\"names\":[" + names +
+                  "],\"corrupt\":false,\"storageTypes\":[\"DISK\"]}";
+    }
+    return json("{\"BlockLocations\":{\"BlockLocation\":[" + blocks + "]}}");
+}
+
+FakeHttpResponse FakeHdfsServer::handleNamenode(const FakeHttpRequest& request) {
+    static const std::string kPrefix = "/webhdfs/v1";
+    if (request.method != "GET") {
+        return remoteException(405, "UnsupportedOperationException", "Only GET operations are supported");
+    }
+    if (request.path.compare(0, kPrefix.size(), kPrefix) != 0) {
+        return remoteException(404, "FileNotFoundException", "Not a WebHDFS path: " + request.path);
+    }
+    std::string path = request.path.substr(kPrefix.size());
+    if (path.empty()) {
+        path = "/";
+    } else if (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+    std::string op = request.param("op");
+
+    if (op == "LISTSTATUS" || (op == "LISTSTATUS_BATCH" && options_.list_batch)) {
+        return listStatus(path, request, op == "LISTSTATUS_BATCH");
+    }
+    if (op != "GETFILESTATUS" && op != "OPEN" && (op != "GETFILEBLOCKLOCATIONS" || !options_.block_locations)) {
+        return remoteException(400, "IllegalArgumentException",
+                               "Invalid value for webhdfs parameter \"op\": No enum constant " + op);
+    }
+
+    std::shared_ptr<const Node> node = findNode(path);
+    if (!node) {
+        return remoteException(404, "FileNotFoundException", "File " + path + " does not exist.");
+    }
+    if (op == "GETFILESTATUS") {
+        return json("{\"FileStatus\":" + fileStatusJson("", *node) + "}");
+    }
+    if (node->directory) {
+        return remoteException(404, "FileNotFoundException", "Path is not a file: " + path);
+    }
+    if (op == "GETFILEBLOCKLOCATIONS") {
+        return blockLocations(path, *node, request);
+    }
+
+    // OPEN：重定向到持有起始偏移所在数据块的一个副本，轮流选择副本以分散负载
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    if (!numberParam(request, "offset", 0, offset) || !numberParam(request, "length", node->length, length)) {
+        return remoteException(400, "IllegalArgumentException", "Invalid offset or length");
+    }
+    if (offset > node->length) {
+        return remoteException(403, "IOException", "Offset=" + std::to_string(offset) + " out of the range [0, " +
+                                                         std::to_string(node->length) + "]");
+    }
+    std::vector<size_t> nodes = replicas(path, offset / options_.block_size);
+    size_t datanode = nodes[next_replica_++ % nodes.size()];
+    ++redirects_;
+
+    FakeHttpResponse response;
+    response.status = 307;
+    response.headers = {{"Location", "http://127.0.0.1:" + std::to_string(datanodes_[datanode]->port()) + kPrefix +
+                                         uriEncode(path, false) + "?op=OPEN&namenoderpcaddress=localhost:8020&offset=" +
+                                         std::to_string(offset) + "&length=" + std::to_string(length)},
+                        {"Content-Type", "application/octet-stream"}};
+    return response;
+}
+
+FakeHttpResponse FakeHdfsServer::handleDatanode(const FakeHttpRequest& request) {
+    static const std::string kPrefix = "/webhdfs/v1";
+    if (request.method != "GET" || request.param("op") != "OPEN" ||
+        request.path.compare(0, kPrefix.size(), kPrefix) != 0) {
+        return remoteException(400, "IllegalArgumentException", "Data nodes only serve OPEN");
+    }
+    std::string path = request.path.substr(kPrefix.size());
+    std::shared_ptr<const Node> node = findNode(path);
+    if (!node || node->directory) {
+        return remoteException(404, "FileNotFoundException", "File " + path + " does not exist.");
+    }
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    if (!numberParam(request, "offset", 0, offset) || !numberParam(request, "length", node->length, length)) {
+        return remoteException(400, "IllegalArgumentException", "Invalid offset or length");
+    }
+    if (offset > node->length) {
+        return remoteException(403, "IOException", "Offset=" + std::to_string(offset) + " out of the range [0, " +
+                                                         std::to_string(node->length) + "]");
+    }
+
+    // 和真实的数据节点一样，区间跨越数据块时继续提供后面的块
+    FakeHttpResponse response;
+    response.headers = {{"Content-Type", "application/octet-stream"}};
+    response.data = node->data;
+    response.file = node->file;
+    response.offset = offset;
+    response.length = std::min(length, node->length - offset);
+    return response;
+}
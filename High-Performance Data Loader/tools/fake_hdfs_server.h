@@ -0,0 +1,153 @@
+#ifndef FAKE_HDFS_SERVER_H
+#define FAKE_HDFS_SERVER_H
+
+#include "fake_http_server.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 本地HDFS替身 - 在127.0.0.1上用一个名称节点和若干个数据节点实现WebHDFS REST API的一个子集，
+ * 供HDFSStorage的测试和性能测试使用
+ * 名称节点支持GETFILESTATUS、LISTSTATUS、LISTSTATUS_BATCH、GETFILEBLOCKLOCATIONS，
+ * 对OPEN返回307重定向到持有起始偏移所在数据块的一个数据节点；数据节点支持OPEN（offset、length）。
+ * 每个文件按block_size划分为数据块，每个块的replication个副本按轮转分布在各数据节点上，
+ * 数据节点的主机名为"datanode-<i>"。每个节点都是一个独立的FakeHttpServer，
+ * 网络特征（延迟、带宽等）对每个节点分别生效
+ */
+class FakeHdfsServer {
+public:
+    /**
+     * 服务器选项
+     */
+    struct Options {
+        // 名称节点的监听端口，0表示由系统分配；数据节点的端口总是由系统分配
+        int port = 0;
+
+        // 数据节点数量
+        size_t datanodes = 3;
+
+        // 每个数据块的副本数，不超过数据节点数量
+        size_t replication = 2;
+
+        // 数据块大小（dfs.blocksize）
+        uint64_t block_size = 128ull << 20;
+
+        // 不为空时从该目录提供文件（HDFS路径映射为目录下的相对路径），否则使用putFile()存入的内存文件
+        std::string root_dir;
+
+        // LISTSTATUS_BATCH每页最多返回的条目数（dfs.ls.limit）
+        size_t list_limit = 1000;
+
+        // 是否支持GETFILEBLOCKLOCATIONS和LISTSTATUS_BATCH，关闭时返回400，模拟旧版本的名称节点
+        bool block_locations = true;
+        bool list_batch = true;
+
+        // 每个节点的网络特征，含义与FakeHttpServer::Options相同
+        int latency_ms = 0;
+        int connect_latency_ms = 0;
+        size_t bandwidth = 0;
+        bool keep_alive = true;
+        size_t max_requests_per_connection = 0;
+    };
+
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t connections = 0;             // 所有节点接受的连接数
+        size_t namenode_requests = 0;       // 名称节点处理的请求数
+        size_t datanode_requests = 0;       // 数据节点处理的请求数
+        size_t redirects = 0;               // 名称节点返回的重定向数
+        uint64_t bytes_sent = 0;            // 数据节点发送的文件数据字节数
+        std::vector<uint64_t> datanode_bytes; // 每个数据节点发送的文件数据字节数
+    };
+
+    explicit FakeHdfsServer(const Options& options);
+
+    /**
+     * 析构函数，停止服务器
+     */
+    ~FakeHdfsServer();
+
+    FakeHdfsServer(const FakeHdfsServer&) = delete;
+    FakeHdfsServer& operator=(const FakeHdfsServer&) = delete;
+
+    /**
+     * 启动所有数据节点和名称节点
+     * @throws std::runtime_error 无法监听时抛出
+     */
+    void start();
+
+    /**
+     * 停止所有节点
+     */
+    void stop();
+
+    /**
+     * 存入内存文件，可以在运行期间调用
+     * @param path HDFS绝对路径，例如"/data/part-0"
+     * @param data 文件内容
+     */
+    void putFile(const std::string& path, std::string data);
+
+    /**
+     * 获取名称节点的WebHDFS端口
+     */
+    int port() const { return namenode_->port(); }
+
+    /**
+     * 获取名称节点的WebHDFS端点，例如"http://127.0.0.1:39261"
+     */
+    std::string endpoint() const { return namenode_->endpoint(); }
+
+    /**
+     * 获取HDFS路径前缀，例如"hdfs://127.0.0.1:39261"
+     */
+    std::string uri() const { return "hdfs://127.0.0.1:" + std::to_string(port()); }
+
+    /**
+     * 获取数据块的副本所在的数据节点编号
+     */
+    std::vector<size_t> replicas(const std::string& path, uint64_t block) const;
+
+    /**
+     * 获取统计信息
+     */
+    Stats stats() const;
+
+    /**
+     * 清零统计信息
+     */
+    void resetStats();
+
+private:
+    struct Node;
+
+    FakeHttpResponse handleNamenode(const FakeHttpRequest& request);
+    FakeHttpResponse handleDatanode(const FakeHttpRequest& request);
+    FakeHttpResponse listStatus(const std::string& path, const FakeHttpRequest& request, bool batch);
+    FakeHttpResponse blockLocations(const std::string& path, const Node& node, const FakeHttpRequest& request);
+    std::shared_ptr<const Node> findNode(const std::string& path) const;
+    std::vector<std::pair<std::string, std::shared_ptr<const Node>>> children(const std::string& path) const;
+    std::string fileStatusJson(const std::string& suffix, const Node& node) const;
+
+    Options options_;
+
+    mutable std::mutex files_mutex_;
+    std::map<std::string, std::shared_ptr<const Node>> files_;
+
+    std::atomic<size_t> redirects_{0};
+    std::atomic<size_t> next_replica_{0};
+
+    // 最后声明，析构时先停止服务器，再销毁处理请求用到的成员
+    std::vector<std::unique_ptr<FakeHttpServer>> datanodes_;
+    std::unique_ptr<FakeHttpServer> namenode_;
+};
+
+#endif // FAKE_HDFS_SERVER_H
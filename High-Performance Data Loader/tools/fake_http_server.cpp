@@ -0,0 +1,353 @@
+#include "fake_http_server.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::string lowercase(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+FakeHttpServer::FakeHttpServer(const Options& options, Handler handler)
+    : options_(options), handler_(std::move(handler)) {
+}
+
+FakeHttpServer::~FakeHttpServer() {
+    stop();
+}
+
+const char* FakeHttpServer::reasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 307: return "Temporary Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 416: return "Requested Range Not Satisfiable";
+        case 503: return "Service Unavailable";
+        default: return "Internal Server Error";
+    }
+}
+
+std::string FakeHttpServer::percentDecode(const std::string& value) {
+    std::string decoded;
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size() && std::isxdigit(static_cast<unsigned char>(value[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(value[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += value[i];
+        }
+    }
+    return decoded;
+}
+
+void FakeHttpServer::start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("socket failed: ") + strerror(errno));
+    }
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd_, 256) != 0) {
+        std::string error = strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        throw std::runtime_error("Failed to listen on port " + std::to_string(options_.port) + ": " + error);
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+    stopping_ = false;
+    accept_thread_ = std::thread(&FakeHttpServer::acceptLoop, this);
+}
+
+void FakeHttpServer::stop() {
+    if (listen_fd_ < 0) {
+        return;
+    }
+    stopping_ = true;
+    shutdown(listen_fd_, SHUT_RDWR);
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    close(listen_fd_);
+    listen_fd_ = -1;
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (int fd : connection_fds_) {
+            shutdown(fd, SHUT_RDWR);
+        }
+        threads.swap(connection_threads_);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+FakeHttpServer::Stats FakeHttpServer::stats() const {
+    Stats stats;
+    stats.connections = connections_.load();
+    stats.requests = requests_.load();
+    stats.bytes_sent = bytes_sent_.load();
+    return stats;
+}
+
+void FakeHttpServer::resetStats() {
+    connections_ = 0;
+    requests_ = 0;
+    bytes_sent_ = 0;
+}
+
+void FakeHttpServer::acceptLoop() {
+    while (!stopping_) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ++connections_;
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        if (stopping_) {
+            close(fd);
+            return;
+        }
+        connection_fds_.insert(fd);
+        connection_threads_.emplace_back(&FakeHttpServer::serveConnection, this, fd);
+    }
+}
+
+void FakeHttpServer::serveConnection(int fd) {
+    std::string buffer;
+    char chunk[16 * 1024];
+    size_t served = 0;
+
+    while (!stopping_) {
+        // 读取请求头部
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0) {
+                header_end = std::string::npos;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+        if (header_end == std::string::npos) {
+            break;
+        }
+
+        FakeHttpRequest request;
+        std::string head = buffer.substr(0, header_end);
+        buffer.erase(0, header_end + 4);
+        size_t line_end = head.find("\r\n");
+        std::string request_line = head.substr(0, line_end);
+        size_t space1 = request_line.find(' ');
+        size_t space2 = request_line.find(' ', space1 + 1);
+        if (space1 == std::string::npos || space2 == std::string::npos) {
+            break;
+        }
+        request.method = request_line.substr(0, space1);
+        request.target = request_line.substr(space1 + 1, space2 - space1 - 1);
+        bool keep_alive = options_.keep_alive && request_line.compare(space2 + 1, 8, "HTTP/1.0") != 0;
+
+        size_t pos = line_end == std::string::npos ? head.size() : line_end + 2;
+        while (pos < head.size()) {
+            size_t end = head.find("\r\n", pos);
+            if (end == std::string::npos) {
+                end = head.size();
+            }
+            std::string line = head.substr(pos, end - pos);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                request.headers[lowercase(line.substr(0, colon))] = trim(line.substr(colon + 1));
+            }
+            pos = end + 2;
+        }
+        if (const std::string* connection = request.header("connection")) {
+            keep_alive = lowercase(*connection) != "close" && keep_alive;
+        }
+
+        // 丢弃请求体
+        if (const std::string* content_length = request.header("content-length")) {
+            size_t length = std::stoull(*content_length);
+            while (buffer.size() < length) {
+                ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+                if (got <= 0) {
+                    break;
+                }
+                buffer.append(chunk, static_cast<size_t>(got));
+            }
+            buffer.erase(0, std::min(length, buffer.size()));
+        }
+
+        size_t question = request.target.find('?');
+        request.path = percentDecode(request.target.substr(0, question));
+        if (question != std::string::npos) {
+            std::string query = request.target.substr(question + 1);
+            size_t start = 0;
+            while (start <= query.size()) {
+                size_t end = query.find('&', start);
+                if (end == std::string::npos) {
+                    end = query.size();
+                }
+                std::string param = query.substr(start, end - start);
+                size_t equals = param.find('=');
+                if (!param.empty()) {
+                    request.query[percentDecode(param.substr(0, equals))] =
+                        equals == std::string::npos ? "" : percentDecode(param.substr(equals + 1));
+                }
+                start = end + 1;
+            }
+        }
+
+        if (served == 0 && options_.connect_latency_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options_.connect_latency_ms));
+        }
+        if (options_.latency_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options_.latency_ms));
+        }
+        ++requests_;
+        FakeHttpResponse response = handler_(request);
+        if (request.method == "HEAD") {
+            response.head_only = true;
+        }
+        send(fd, response, keep_alive);
+        ++served;
+
+        if (!keep_alive || (options_.max_requests_per_connection > 0 && served >= options_.max_requests_per_connection)) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connection_fds_.erase(fd);
+    close(fd);
+}
+
+void FakeHttpServer::send(int fd, const FakeHttpResponse& response, bool keep_alive) {
+    bool streamed = response.data || !response.file.empty();
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " + reasonPhrase(response.status) + "\r\n";
+    bool has_length = false;
+    for (const auto& header : response.headers) {
+        has_length = has_length || lowercase(header.first) == "content-length";
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    if (!has_length) {
+        head += "Content-Length: " + std::to_string(streamed ? response.length : response.body.size()) + "\r\n";
+    }
+    if (!keep_alive) {
+        head += "Connection: close\r\n";
+    }
+    head += "\r\n";
+    if (!response.head_only && !streamed) {
+        head += response.body;
+    }
+    if (!sendAll(fd, head.data(), head.size())) {
+        return;
+    }
+    if (!response.head_only && streamed) {
+        sendBody(fd, response);
+    }
+}
+
+void FakeHttpServer::sendBody(int fd, const FakeHttpResponse& response) {
+    // 分片发送，限速时每片发送后等待到按带宽计算的时间点
+    constexpr size_t kSlice = 256 * 1024;
+    std::vector<char> slice;
+    int file = -1;
+    if (!response.data) {
+        file = open(response.file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            return;
+        }
+        slice.resize(kSlice);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    while (sent < response.length) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(kSlice, response.length - sent));
+        const char* data;
+        if (file >= 0) {
+            ssize_t got = pread(file, slice.data(), size, static_cast<off_t>(response.offset + sent));
+            if (got <= 0) {
+                break;
+            }
+            size = static_cast<size_t>(got);
+            data = slice.data();
+        } else {
+            data = response.data->data() + response.offset + sent;
+        }
+        if (!sendAll(fd, data, size)) {
+            break;
+        }
+        sent += size;
+        bytes_sent_ += size;
+        if (options_.bandwidth > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sent * 1000000 / options_.bandwidth));
+        }
+    }
+    if (file >= 0) {
+        close(file);
+    }
+}
@@ -0,0 +1,173 @@
+#ifndef FAKE_HTTP_SERVER_H
+#define FAKE_HTTP_SERVER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 替身服务器收到的HTTP请求
+ */
+struct FakeHttpRequest {
+    std::string method;
+    // 原始请求目标（已编码的路径和查询字符串）
+    std::string target;
+    // 解码后的路径
+    std::string path;
+    // 解码后的查询参数
+    std::map<std::string, std::string> query;
+    // 请求头部，名称为小写
+    std::map<std::string, std::string> headers;
+
+    const std::string* header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * 获取查询参数，不存在时返回空字符串
+     */
+    std::string param(const std::string& name) const {
+        auto it = query.find(name);
+        return it == query.end() ? std::string() : it->second;
+    }
+};
+
+/**
+ * 替身服务器的HTTP响应
+ * 响应体可以是body中的字符串，也可以是内存数据（data）或文件（file）中的一段[offset, offset + length)，
+ * 后两者按带宽限制分片发送
+ */
+struct FakeHttpResponse {
+    int status = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    std::shared_ptr<const std::string> data;
+    std::string file;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+
+    // 只发送头部（HEAD请求），Content-Length仍按响应体计算
+    bool head_only = false;
+};
+
+/**
+ * 本地HTTP/1.1替身服务器 - S3、WebHDFS等协议替身的公共部分
+ * 在127.0.0.1上监听，每个连接一个线程，支持keep-alive；可以模拟每个请求的首字节延迟、
+ * 新连接的建立延迟（TCP/TLS握手）、每个连接的带宽上限，以及服务器主动关闭keep-alive连接。
+ * 请求由构造时传入的处理函数生成响应
+ */
+class FakeHttpServer {
+public:
+    using Handler = std::function<FakeHttpResponse(const FakeHttpRequest&)>;
+
+    /**
+     * 网络特征选项
+     */
+    struct Options {
+        // 监听端口，0表示由系统分配
+        int port = 0;
+
+        // 每个请求在发送响应之前等待的时间（毫秒）
+        int latency_ms = 0;
+
+        // 每个新连接在处理第一个请求之前额外等待的时间（毫秒），模拟握手往返
+        int connect_latency_ms = 0;
+
+        // 每个连接的发送带宽上限（字节/秒），0表示不限制
+        size_t bandwidth = 0;
+
+        // 是否保持连接，false时每个响应都带Connection: close
+        bool keep_alive = true;
+
+        // 每个连接处理这么多个请求后关闭（不发送Connection: close），0表示不限制
+        size_t max_requests_per_connection = 0;
+    };
+
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t connections = 0;  // 接受的连接数
+        size_t requests = 0;     // 处理的请求数
+        uint64_t bytes_sent = 0; // 发送的响应体字节数
+    };
+
+    FakeHttpServer(const Options& options, Handler handler);
+
+    /**
+     * 析构函数，停止服务器
+     */
+    ~FakeHttpServer();
+
+    FakeHttpServer(const FakeHttpServer&) = delete;
+    FakeHttpServer& operator=(const FakeHttpServer&) = delete;
+
+    /**
+     * 开始监听并在后台线程中接受连接
+     * @throws std::runtime_error 无法监听时抛出
+     */
+    void start();
+
+    /**
+     * 停止服务器，关闭所有连接并等待处理线程退出
+     */
+    void stop();
+
+    /**
+     * 获取监听端口
+     */
+    int port() const { return port_; }
+
+    /**
+     * 获取服务端点，例如"http://127.0.0.1:39261"
+     */
+    std::string endpoint() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    Stats stats() const;
+    void resetStats();
+
+    /**
+     * 获取HTTP状态码的原因短语
+     */
+    static const char* reasonPhrase(int status);
+
+    /**
+     * 百分号解码
+     */
+    static std::string percentDecode(const std::string& value);
+
+private:
+    void acceptLoop();
+    void serveConnection(int fd);
+    void send(int fd, const FakeHttpResponse& response, bool keep_alive);
+    void sendBody(int fd, const FakeHttpResponse& response);
+
+    Options options_;
+    Handler handler_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::thread accept_thread_;
+
+    // 连接处理线程及其套接字，停止时关闭套接字以唤醒阻塞的读取
+    std::mutex connections_mutex_;
+    std::vector<std::thread> connection_threads_;
+    std::set<int> connection_fds_;
+
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> requests_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+};
+
+#endif // FAKE_HTTP_SERVER_H
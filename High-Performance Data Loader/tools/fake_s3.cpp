@@ -0,0 +1,59 @@
+#include "fake_s3_server.h"
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <unistd.h>
+
+/**
+ * 本地S3替身服务器：把一个目录作为存储桶提供，用于在没有S3的环境中测试S3Storage
+ * 用法：fake_s3 <目录> [端口] [存储桶] [访问密钥 秘密密钥]
+ *
+ * 示例：
+ *   fake_s3 ./data 9000 my-bucket
+ *   AWS_ENDPOINT_URL=http://127.0.0.1:9000 ./data_loader_example
+ */
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void onSignal(int) {
+    g_stop = 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <root_dir> [port] [bucket] [access_key secret_key]" << std::endl;
+        return 1;
+    }
+
+    FakeS3Server::Options options;
+    options.root_dir = argv[1];
+    options.port = argc > 2 ? std::stoi(argv[2]) : 9000;
+    if (argc > 3) {
+        options.bucket = argv[3];
+    }
+    if (argc > 5) {
+        options.access_key = argv[4];
+        options.secret_key = argv[5];
+    }
+
+    try {
+        FakeS3Server server(options);
+        server.start();
+        std::cout << "Serving " << options.root_dir << " as bucket '" << options.bucket << "' at "
+                  << server.endpoint() << (options.access_key.empty() ? "" : " (SigV4 required)") << std::endl;
+
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        while (!g_stop) {
+            pause();
+        }
+
+        FakeS3Server::Stats stats = server.stats();
+        std::cout << "\n" << stats.requests << " requests on " << stats.connections << " connections, "
+                  << stats.bytes_sent << " bytes sent" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,344 @@
+#include "fake_s3_server.h"
+#include "sigv4.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+std::string trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+std::string xmlEscape(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            case '\'': escaped += "&apos;"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string errorXml(const std::string& code, const std::string& message) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Error><Code>" + code + "</Code><Message>" +
+           xmlEscape(message) + "</Message></Error>";
+}
+
+/**
+ * 解析Range头部（只支持单个区间）
+ * @return 格式无法识别时返回false，此时按普通GET处理
+ */
+bool parseRange(const std::string& value, uint64_t size, uint64_t& first, uint64_t& last, bool& satisfiable) {
+    if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos) {
+        return false;
+    }
+    std::string spec = value.substr(6);
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    try {
+        if (dash == 0) {
+            // 后缀区间：最后n个字节
+            uint64_t suffix = std::stoull(spec.substr(1));
+            satisfiable = suffix > 0 && size > 0;
+            first = size - std::min(suffix, size);
+            last = size - 1;
+            return true;
+        }
+        first = std::stoull(spec.substr(0, dash));
+        last = dash + 1 < spec.size() ? std::stoull(spec.substr(dash + 1)) : UINT64_MAX;
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (last < first) {
+        return false;
+    }
+    satisfiable = first < size;
+    last = std::min(last, size == 0 ? 0 : size - 1);
+    return true;
+}
+
+} // namespace
+
+struct FakeS3Server::Object {
+    // 内存对象的内容；目录模式下为空，从file读取
+    std::shared_ptr<const std::string> data;
+    std::string file;
+    uint64_t size = 0;
+};
+
+FakeS3Server::FakeS3Server(const Options& options) : options_(options) {
+    if (!options_.access_key.empty()) {
+        signer_ = std::make_unique<SigV4Signer>(options_.access_key, options_.secret_key, options_.region);
+    }
+    FakeHttpServer::Options http;
+    http.port = options_.port;
+    http.latency_ms = options_.latency_ms;
+    http.connect_latency_ms = options_.connect_latency_ms;
+    http.bandwidth = options_.bandwidth;
+    http.keep_alive = options_.keep_alive;
+    http.max_requests_per_connection = options_.max_requests_per_connection;
+    server_ = std::make_unique<FakeHttpServer>(http, [this](const FakeHttpRequest& request) { return handle(request); });
+}
+
+FakeS3Server::~FakeS3Server() {
+    stop();
+}
+
+void FakeS3Server::start() {
+    server_->start();
+}
+
+void FakeS3Server::stop() {
+    server_->stop();
+}
+
+void FakeS3Server::putObject(const std::string& key, std::string data) {
+    auto object = std::make_shared<Object>();
+    object->size = data.size();
+    object->data = std::make_shared<const std::string>(std::move(data));
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    objects_[key] = std::move(object);
+}
+
+FakeS3Server::Stats FakeS3Server::stats() const {
+    FakeHttpServer::Stats http = server_->stats();
+    Stats stats;
+    stats.connections = http.connections;
+    stats.requests = http.requests;
+    stats.range_requests = range_requests_.load();
+    stats.auth_failures = auth_failures_.load();
+    stats.bytes_sent = http.bytes_sent;
+    return stats;
+}
+
+void FakeS3Server::resetStats() {
+    server_->resetStats();
+    range_requests_ = 0;
+    auth_failures_ = 0;
+}
+
+bool FakeS3Server::authorized(const FakeHttpRequest& request) const {
+    if (!signer_) {
+        return true;
+    }
+    const std::string* authorization = request.header("authorization");
+    const std::string* amz_date = request.header("x-amz-date");
+    const std::string* payload_hash = request.header("x-amz-content-sha256");
+    if (!authorization || !amz_date || !payload_hash) {
+        return false;
+    }
+
+    // AWS4-HMAC-SHA256 Credential=<key>/<date>/<region>/s3/aws4_request, SignedHeaders=a;b, Signature=<hex>
+    auto field = [&](const std::string& name) {
+        size_t pos = authorization->find(name + "=");
+        if (pos == std::string::npos) {
+            return std::string();
+        }
+        pos += name.size() + 1;
+        size_t end = authorization->find(',', pos);
+        return trim(authorization->substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+    };
+    std::string credential = field("Credential");
+    std::string signed_names = field("SignedHeaders");
+    std::string signature = field("Signature");
+    if (credential.compare(0, options_.access_key.size() + 1, options_.access_key + "/") != 0) {
+        return false;
+    }
+
+    SigV4Signer::Headers signed_headers;
+    size_t start = 0;
+    while (start <= signed_names.size()) {
+        size_t end = signed_names.find(';', start);
+        if (end == std::string::npos) {
+            end = signed_names.size();
+        }
+        std::string name = signed_names.substr(start, end - start);
+        const std::string* value = request.header(name);
+        if (!value) {
+            return false;
+        }
+        signed_headers.emplace_back(name, *value);
+        start = end + 1;
+    }
+    return signer_->signature(request.method, request.target, signed_headers, *payload_hash, *amz_date) == signature;
+}
+
+std::shared_ptr<const FakeS3Server::Object> FakeS3Server::findObject(const std::string& key) const {
+    if (options_.root_dir.empty()) {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        auto it = objects_.find(key);
+        return it == objects_.end() ? nullptr : it->second;
+    }
+
+    if (key.empty() || key.find("..") != std::string::npos) {
+        return nullptr;
+    }
+    std::error_code error;
+    fs::path path = fs::path(options_.root_dir) / key;
+    if (!fs::is_regular_file(path, error)) {
+        return nullptr;
+    }
+    auto object = std::make_shared<Object>();
+    object->file = path.string();
+    object->size = fs::file_size(path, error);
+    return object;
+}
+
+std::vector<std::pair<std::string, uint64_t>> FakeS3Server::listObjects(const std::string& prefix) const {
+    std::vector<std::pair<std::string, uint64_t>> keys;
+    if (options_.root_dir.empty()) {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        for (auto it = objects_.lower_bound(prefix); it != objects_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            keys.emplace_back(it->first, it->second->size);
+        }
+        return keys;
+    }
+
+    std::error_code error;
+    for (auto it = fs::recursive_directory_iterator(options_.root_dir, error); !error && it != fs::recursive_directory_iterator();
+         it.increment(error)) {
+        if (it->is_regular_file(error)) {
+            std::string key = fs::relative(it->path(), options_.root_dir, error).generic_string();
+            if (key.compare(0, prefix.size(), prefix) == 0) {
+                keys.emplace_back(key, it->file_size(error));
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+FakeHttpResponse FakeS3Server::handle(const FakeHttpRequest& request) {
+    FakeHttpResponse response;
+    response.headers = {{"Server", "FakeS3"}};
+    auto error = [&](int status, const std::string& code, const std::string& message) {
+        response.status = status;
+        response.body = errorXml(code, message);
+        return response;
+    };
+    if (request.method != "GET" && request.method != "HEAD") {
+        return error(405, "MethodNotAllowed", "Only GET and HEAD are supported");
+    }
+    if (!authorized(request)) {
+        ++auth_failures_;
+        return error(403, "SignatureDoesNotMatch", "The request signature we calculated does not match");
+    }
+
+    // 路径风格：/<bucket>[/<key>]
+    std::string bucket_path = "/" + options_.bucket;
+    if (request.path.compare(0, bucket_path.size(), bucket_path) != 0 ||
+        (request.path.size() > bucket_path.size() && request.path[bucket_path.size()] != '/')) {
+        return error(404, "NoSuchBucket", "The specified bucket does not exist");
+    }
+    std::string key = request.path.size() > bucket_path.size() ? request.path.substr(bucket_path.size() + 1) : "";
+
+    if (key.empty()) {
+        if (request.method == "HEAD") {
+            return response;
+        }
+        return listBucket(request);
+    }
+
+    std::shared_ptr<const Object> object = findObject(key);
+    if (!object) {
+        return error(404, "NoSuchKey", "The specified key does not exist.");
+    }
+    response.headers.emplace_back("Accept-Ranges", "bytes");
+    response.headers.emplace_back("Content-Type", "application/octet-stream");
+
+    uint64_t first = 0;
+    uint64_t last = object->size == 0 ? 0 : object->size - 1;
+    const std::string* range = request.method == "HEAD" ? nullptr : request.header("range");
+    bool satisfiable = true;
+    if (range && parseRange(*range, object->size, first, last, satisfiable)) {
+        ++range_requests_;
+        if (!satisfiable) {
+            response.headers.emplace_back("Content-Range", "bytes */" + std::to_string(object->size));
+            return error(416, "InvalidRange", "The requested range is not satisfiable");
+        }
+        response.status = 206;
+        response.headers.emplace_back("Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) +
+                                                           "/" + std::to_string(object->size));
+    }
+    response.data = object->data;
+    response.file = object->file;
+    response.offset = first;
+    response.length = object->size == 0 ? 0 : last - first + 1;
+    return response;
+}
+
+FakeHttpResponse FakeS3Server::listBucket(const FakeHttpRequest& request) {
+    FakeHttpResponse response;
+    response.headers = {{"Server", "FakeS3"}};
+    if (request.param("list-type") != "2") {
+        response.status = 400;
+        response.body = errorXml("InvalidRequest", "Only ListObjectsV2 is supported");
+        return response;
+    }
+    std::string prefix = request.param("prefix");
+    std::string delimiter = request.param("delimiter");
+    std::string token = request.param("continuation-token");
+    if (token.empty()) {
+        token = request.param("start-after");
+    }
+
+    // 分隔符之后还有内容的键归并为公共前缀；翻页令牌为上一页最后一个键或公共前缀
+    std::string contents;
+    std::string common_prefixes;
+    std::string last;
+    size_t count = 0;
+    bool truncated = false;
+    for (const auto& entry : listObjects(prefix)) {
+        const std::string& name = entry.first;
+        if (!token.empty() && (name <= token || (!delimiter.empty() && token.back() == delimiter.back() &&
+                                                 name.compare(0, token.size(), token) == 0))) {
+            continue;
+        }
+        size_t split = delimiter.empty() ? std::string::npos : name.find(delimiter, prefix.size());
+        std::string item = split == std::string::npos ? name : name.substr(0, split + delimiter.size());
+        if (item == last) {
+            continue;
+        }
+        if (count == options_.max_keys) {
+            truncated = true;
+            break;
+        }
+        if (split == std::string::npos) {
+            contents += "<Contents><Key>" + xmlEscape(name) + "</Key><Size>" + std::to_string(entry.second) +
+                        "</Size><StorageClass>STANDARD</StorageClass></Contents>";
+        } else {
+            common_prefixes += "<CommonPrefixes><Prefix>" + xmlEscape(item) + "</Prefix></CommonPrefixes>";
+        }
+        last = item;
+        ++count;
+    }
+
+    std::string body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\"><Name>" +
+                       xmlEscape(options_.bucket) + "</Name><Prefix>" + xmlEscape(prefix) + "</Prefix><KeyCount>" +
+                       std::to_string(count) + "</KeyCount><MaxKeys>" + std::to_string(options_.max_keys) +
+                       "</MaxKeys><IsTruncated>" + (truncated ? "true" : "false") + "</IsTruncated>";
+    if (truncated) {
+        body += "<NextContinuationToken>" + xmlEscape(last) + "</NextContinuationToken>";
+    }
+    response.body = body + contents + common_prefixes + "</ListBucketResult>";
+    response.headers.emplace_back("Content-Type", "application/xml");
+    return response;
+}
@@ -0,0 +1,141 @@
+#ifndef FAKE_S3_SERVER_H
+#define FAKE_S3_SERVER_H
+
+#include "fake_http_server.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class SigV4Signer;
+
+/**
+ * 本地S3替身 - 在127.0.0.1上实现S3 REST API的一个子集，供S3Storage的测试和性能测试使用
+ * 支持：HEAD存储桶、HEAD/GET对象（含Range）、ListObjectsV2（prefix、delimiter、翻页），
+ * 只支持路径风格的URL。设置了密钥时校验每个请求的SigV4签名。
+ * 可以模拟网络特征：每个请求的首字节延迟、新连接的建立延迟（TCP/TLS握手）、
+ * 每个连接的带宽上限，以及服务器主动关闭keep-alive连接
+ */
+class FakeS3Server {
+public:
+    /**
+     * 服务器选项
+     */
+    struct Options {
+        // 存储桶名称
+        std::string bucket = "test-bucket";
+
+        // 区域和凭证；access_key为空时不校验签名
+        std::string region = "us-east-1";
+        std::string access_key;
+        std::string secret_key;
+
+        // 监听端口，0表示由系统分配
+        int port = 0;
+
+        // 不为空时从该目录提供对象（键为相对路径），否则使用putObject()存入的内存对象
+        std::string root_dir;
+
+        // 每个请求在发送响应之前等待的时间（毫秒）
+        int latency_ms = 0;
+
+        // 每个新连接在处理第一个请求之前额外等待的时间（毫秒），模拟握手往返
+        int connect_latency_ms = 0;
+
+        // 每个连接的发送带宽上限（字节/秒），0表示不限制
+        size_t bandwidth = 0;
+
+        // 是否保持连接，false时每个响应都带Connection: close
+        bool keep_alive = true;
+
+        // 每个连接处理这么多个请求后关闭（不发送Connection: close），0表示不限制
+        size_t max_requests_per_connection = 0;
+
+        // ListObjectsV2每页最多返回的对象数
+        size_t max_keys = 1000;
+    };
+
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t connections = 0;       // 接受的连接数
+        size_t requests = 0;          // 处理的请求数
+        size_t range_requests = 0;    // 带Range头部的GET请求数
+        size_t auth_failures = 0;     // 签名校验失败的请求数
+        uint64_t bytes_sent = 0;      // 发送的响应体字节数
+    };
+
+    explicit FakeS3Server(const Options& options);
+
+    /**
+     * 析构函数，停止服务器
+     */
+    ~FakeS3Server();
+
+    FakeS3Server(const FakeS3Server&) = delete;
+    FakeS3Server& operator=(const FakeS3Server&) = delete;
+
+    /**
+     * 开始监听并在后台线程中接受连接
+     * @throws std::runtime_error 无法监听时抛出
+     */
+    void start();
+
+    /**
+     * 停止服务器，关闭所有连接并等待处理线程退出
+     */
+    void stop();
+
+    /**
+     * 存入内存对象，可以在运行期间调用
+     */
+    void putObject(const std::string& key, std::string data);
+
+    /**
+     * 获取监听端口
+     */
+    int port() const { return server_->port(); }
+
+    /**
+     * 获取服务端点，例如"http://127.0.0.1:39261"
+     */
+    std::string endpoint() const { return server_->endpoint(); }
+
+    /**
+     * 获取统计信息
+     */
+    Stats stats() const;
+
+    /**
+     * 清零统计信息
+     */
+    void resetStats();
+
+private:
+    struct Object;
+
+    FakeHttpResponse handle(const FakeHttpRequest& request);
+    FakeHttpResponse listBucket(const FakeHttpRequest& request);
+    bool authorized(const FakeHttpRequest& request) const;
+    std::shared_ptr<const Object> findObject(const std::string& key) const;
+    std::vector<std::pair<std::string, uint64_t>> listObjects(const std::string& prefix) const;
+
+    Options options_;
+    std::unique_ptr<SigV4Signer> signer_;
+
+    mutable std::mutex objects_mutex_;
+    std::map<std::string, std::shared_ptr<const Object>> objects_;
+
+    std::atomic<size_t> range_requests_{0};
+    std::atomic<size_t> auth_failures_{0};
+
+    // 最后声明，析构时先停止服务器，再销毁处理请求用到的成员
+    std::unique_ptr<FakeHttpServer> server_;
+};
+
+#endif // FAKE_S3_SERVER_H
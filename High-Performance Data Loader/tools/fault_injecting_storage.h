@@ -0,0 +1,148 @@
+#ifndef FAULT_INJECTING_STORAGE_H
+#define FAULT_INJECTING_STORAGE_H
+
+#include "storage.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdint>
+
+/**
+ * 故障模型 - 模拟远程存储的延迟分布和暂时性错误
+ */
+struct FaultProfile {
+    // 正常请求的延迟及其相对抖动（在latency * (1 ± jitter)内均匀分布）
+    std::chrono::microseconds latency = std::chrono::milliseconds(2);
+    double jitter = 0.2;
+
+    // 慢请求的概率和延迟，模拟长尾
+    double slow_probability = 0.0;
+    std::chrono::microseconds slow_latency = std::chrono::milliseconds(100);
+
+    // 请求失败（抛出TransientStorageError）的概率
+    double failure_probability = 0.0;
+
+    // 前slow_first个请求一定是慢请求，前fail_first个请求一定失败，用于在测试中构造确定的故障
+    size_t slow_first = 0;
+    size_t fail_first = 0;
+
+    // 随机数种子
+    uint64_t seed = 42;
+};
+
+/**
+ * 注入故障的存储 - 包装另一个存储，在每次读取之前按FaultProfile等待并随机失败
+ * 用于在本地复现远程存储的长尾延迟和暂时性错误，测量HedgedStorage等策略对批次延迟的影响。
+ * 读取操作（readFile、readRange、readInto、readFilePooled、readTextFile）注入故障，其余操作直接转发
+ */
+class FaultInjectingStorage : public Storage {
+public:
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t reads = 0;     // 读取请求数
+        size_t slow = 0;      // 其中的慢请求数
+        size_t failures = 0;  // 其中注入失败的请求数
+    };
+
+    FaultInjectingStorage(std::unique_ptr<Storage> inner, const FaultProfile& profile)
+        : inner_(std::move(inner)), profile_(profile) {
+    }
+
+    std::vector<unsigned char> readFile(const std::string& file_path) override {
+        inject(file_path);
+        return inner_->readFile(file_path);
+    }
+
+    std::vector<unsigned char> readRange(const std::string& file_path, uint64_t offset, size_t length) override {
+        inject(file_path);
+        return inner_->readRange(file_path, offset, length);
+    }
+
+    size_t readInto(const std::string& file_path, uint64_t offset, unsigned char* buffer, size_t length) override {
+        inject(file_path);
+        return inner_->readInto(file_path, offset, buffer, length);
+    }
+
+    PooledBuffer readFilePooled(const std::string& file_path) override {
+        inject(file_path);
+        return inner_->readFilePooled(file_path);
+    }
+
+    std::string readTextFile(const std::string& file_path) override {
+        inject(file_path);
+        return inner_->readTextFile(file_path);
+    }
+
+    bool fileExists(const std::string& file_path) override {
+        return inner_->fileExists(file_path);
+    }
+
+    size_t getFileSize(const std::string& file_path) override {
+        return inner_->getFileSize(file_path);
+    }
+
+    std::vector<std::string> listFiles(const std::string& dir_path) override {
+        return inner_->listFiles(dir_path);
+    }
+
+    std::vector<BlockLocation> getBlockLocations(const std::string& file_path) override {
+        return inner_->getBlockLocations(file_path);
+    }
+
+    /**
+     * 获取统计信息
+     */
+    Stats stats() const {
+        Stats stats;
+        stats.reads = reads_.load(std::memory_order_relaxed);
+        stats.slow = slow_.load(std::memory_order_relaxed);
+        stats.failures = failures_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    /**
+     * splitmix64，每个请求由种子和请求序号确定一串随机数，结果不受线程调度影响
+     */
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static double uniform(uint64_t bits) {
+        return (bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    void inject(const std::string& file_path) {
+        uint64_t sequence = reads_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t state = mix(profile_.seed ^ mix(sequence));
+
+        std::chrono::microseconds delay;
+        if (sequence < profile_.slow_first || uniform(state = mix(state)) < profile_.slow_probability) {
+            slow_.fetch_add(1, std::memory_order_relaxed);
+            delay = profile_.slow_latency;
+        } else {
+            double scale = 1.0 + profile_.jitter * (2.0 * uniform(state = mix(state)) - 1.0);
+            delay = std::chrono::microseconds(static_cast<int64_t>(profile_.latency.count() * scale));
+        }
+        std::this_thread::sleep_for(delay);
+
+        if (sequence < profile_.fail_first || uniform(state = mix(state)) < profile_.failure_probability) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            throw TransientStorageError("Injected transient failure reading " + file_path);
+        }
+    }
+
+    std::unique_ptr<Storage> inner_;
+    FaultProfile profile_;
+    std::atomic<uint64_t> reads_{0};
+    std::atomic<size_t> slow_{0};
+    std::atomic<size_t> failures_{0};
+};
+
+#endif // FAULT_INJECTING_STORAGE_H
@@ -0,0 +1,100 @@
+#include "shard.h"
+#include "file_io.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+/**
+ * 分片生成工具：把一个目录（递归）或一个路径列表文件中的文件打包为分片
+ * 用法：make_shards <输出前缀> <输入目录 | @路径列表文件> [单个分片大小(MB)]
+ *
+ * 输入为目录时，记录键为文件相对于该目录的路径，文件按路径排序后写入；
+ * 输入为路径列表文件时（每行一个路径），记录键为列表中的路径，保持列表中的顺序
+ */
+
+namespace fs = std::filesystem;
+
+struct Input {
+    std::string path;
+    std::string key;
+};
+
+static std::vector<Input> collectInputs(const std::string& source) {
+    std::vector<Input> inputs;
+
+    if (!source.empty() && source[0] == '@') {
+        std::ifstream list(source.substr(1));
+        if (!list) {
+            throw std::runtime_error("Failed to open path list: " + source.substr(1));
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                inputs.push_back(Input{line, line});
+            }
+        }
+        return inputs;
+    }
+
+    fs::path root(source);
+    if (!fs::is_directory(root)) {
+        throw std::runtime_error("Not a directory: " + source);
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            inputs.push_back(Input{entry.path().string(), entry.path().lexically_relative(root).generic_string()});
+        }
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) {
+        return a.key < b.key;
+    });
+    return inputs;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: make_shards <output_prefix> <input_dir | @path_list> [shard_size_mb=256]" << std::endl;
+        return 1;
+    }
+    std::string prefix = argv[1];
+    std::string source = argv[2];
+    uint64_t shard_mb = argc > 3 ? std::stoull(argv[3]) : 256;
+
+    try {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<Input> inputs = collectInputs(source);
+        fs::path parent = fs::path(prefix).parent_path();
+        if (!parent.empty()) {
+            fs::create_directories(parent);
+        }
+
+        ShardWriter writer(prefix, shard_mb << 20);
+        uint64_t bytes = 0;
+        for (const auto& input : inputs) {
+            std::vector<unsigned char> data = FileIO::readFile(input.path);
+            writer.add(input.key, data.data(), data.size());
+            bytes += data.size();
+        }
+        std::vector<std::string> shards = writer.finish();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "Wrote " << writer.recordCount() << " records (" << bytes / (1024.0 * 1024.0) << " MB) into "
+                  << shards.size() << " shards in " << seconds << " s" << std::endl;
+        for (const auto& shard : shards) {
+            std::cout << "  " << shard << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}